@@ -4,12 +4,12 @@
 # specify `all` as our default rule
 all:
 
-# directory for built output
-BUILDDIR ?= build
-
 # Build settings
 include $(TOCK_USERLAND_BASE_DIR)/Configuration.mk
 
+# directory for built output
+BUILDDIR ?= build$(TOCK_BUILD_VARIANT)
+
 # Helper functions
 include $(TOCK_USERLAND_BASE_DIR)/Helpers.mk
 
@@ -40,8 +40,13 @@ ifneq "$$(wildcard $(1)/include)" ""
 endif
 
 # Add arch-specific rules for each library
-# Use the $(LIBNAME)_BUILDDIR as build directory, if set.
-$$(notdir $(1))_BUILDDIR ?= $(1)/build
+# Use the $(LIBNAME)_BUILDDIR as build directory, if set. Prefer a build for
+# the current TOCK_BUILD_VARIANT, falling back to the regular one.
+ifneq "$$(wildcard $(1)/build$(TOCK_BUILD_VARIANT))" ""
+  $$(notdir $(1))_BUILDDIR ?= $(1)/build$(TOCK_BUILD_VARIANT)
+else
+  $$(notdir $(1))_BUILDDIR ?= $(1)/build
+endif
 $$(foreach arch, $$(TOCK_ARCHS), $$(eval LIBS_$$(arch) += $$($(notdir $(1))_BUILDDIR)/$$(arch)/$(notdir $(1)).a))
 
 endef
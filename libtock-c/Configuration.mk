@@ -20,6 +20,24 @@ RANLIB := -ranlib
 READELF := -readelf
 SIZE := -size
 
+# Link-time optimization
+#
+# `make TOCK_LTO=1` compiles the app, libtock, and any library rebuilt the same
+# way as GCC LTO objects, and optimizes them together when linking. This lets
+# GCC inline small libtock wrappers (e.g. `led_on()` -> `command()`) into app
+# code across the archive boundary, which separate compilation never can.
+#
+# LTO objects go to `build-lto` directories (see TOCK_BUILD_VARIANT) so that
+# switching modes never links stale objects. External libraries that have no
+# `build-lto` directory yet are linked from their regular prebuilt archives.
+# Archives of LTO objects need the plugin-aware gcc-ar/gcc-ranlib wrappers.
+ifneq ($(TOCK_LTO),)
+  TOCK_BUILD_VARIANT := -lto
+  AR := -gcc-ar
+  RANLIB := -gcc-ranlib
+  override CPPFLAGS += -flto
+endif
+
 # Set default region sizes
 STACK_SIZE       ?= 2048
 APP_HEAP_SIZE    ?= 1024
@@ -157,6 +175,16 @@ override CPPFLAGS_cortex-m0 += $(CPPFLAGS_cortex-m) \
       -mcpu=cortex-m0\
       -march=armv6s-m
 
+# Architecture-tuned memcpy/memmove/memset (libtock/memfuncs.c). libtock is
+# linked ahead of newlib, so on the architectures listed here these replace
+# newlib's -Os builds. Define TOCK_NO_OPT_MEMFUNCS to use newlib's everywhere.
+ifndef TOCK_NO_OPT_MEMFUNCS
+override CPPFLAGS_cortex-m7 += -DTOCK_OPT_MEMFUNCS
+override CPPFLAGS_cortex-m4 += -DTOCK_OPT_MEMFUNCS
+override CPPFLAGS_rv32imc   += -DTOCK_OPT_MEMFUNCS
+override CPPFLAGS_rv32imac  += -DTOCK_OPT_MEMFUNCS
+endif
+
 # Single-arch libraries, to be phased out
 override LEGACY_LIBS_cortex-m += \
       $(TOCK_USERLAND_BASE_DIR)/newlib/cortex-m/libc.a\
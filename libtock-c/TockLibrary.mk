@@ -19,7 +19,7 @@ ifeq ($(strip $($(LIBNAME)_SRCS)),)
 endif
 
 # directory for built output
-$(LIBNAME)_BUILDDIR ?= $($(LIBNAME)_DIR)/build
+$(LIBNAME)_BUILDDIR ?= $($(LIBNAME)_DIR)/build$(TOCK_BUILD_VARIANT)
 
 # Handle complex paths
 #
@@ -1,16 +1,13 @@
 #include "advertisement_list.h"
 
 AdvertisementList::AdvertisementList()
-  : currentSize_(0)
 {
-  list_.resize(MAX_SIZE);
 }
 
 bool AdvertisementList::tryAdd(const Advertisement& advertisement)
 {
-  if (currentSize_ < MAX_SIZE && !containsDevice(advertisement)) {
-    list_.push_front(advertisement);
-    currentSize_ += 1;
+  if (!list_.full() && !containsDevice(advertisement)) {
+    list_.insert(list_.begin(), advertisement);
     return true;
   } else {
     return false;
@@ -30,9 +27,9 @@ bool AdvertisementList::containsDevice(const Advertisement& advertisement) const
 bool AdvertisementList::tryUpdateData(const Advertisement& advertisement)
 {
   for (auto it = list_.begin(); it != list_.end(); ++it) {
-    if (*it != advertisement) {
-      list_.remove(*it);
-      list_.push_front(advertisement);
+    if (it->device_detected(advertisement) && *it != advertisement) {
+      list_.erase(it);
+      list_.insert(list_.begin(), advertisement);
       return true;
     }
   }
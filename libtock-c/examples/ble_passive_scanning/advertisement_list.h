@@ -1,6 +1,6 @@
 #pragma once
 
-#include <forward_list>
+#include <static_vector.h>
 #include "advertisement.h"
 
 // this is left outside the class because it doesn't work
@@ -9,8 +9,7 @@ const int MAX_SIZE = 10;
 
 class AdvertisementList {
   private:
-    int currentSize_;
-    std::forward_list<Advertisement> list_;
+    tock::static_vector<Advertisement, MAX_SIZE> list_;
     bool containsDevice(const Advertisement& advertisement) const;
   
   public:
@@ -2,6 +2,7 @@
 #include <stdio.h>
 
 #include <ambient_light.h>
+#include <cbor.h>
 #include <humidity.h>
 #include <temperature.h>
 #include <timer.h>
@@ -9,6 +10,18 @@
 #include <ieee802154.h>
 #include <udp.h>
 
+// Readings are sampled once per interval and sent in batches, each packet
+// carrying the CBOR array [seq, [[temp, humi, lux], ...]] with temperature
+// and humidity in hundredths.
+#define SAMPLE_INTERVAL_MS   1000
+#define READINGS_PER_PACKET  4
+
+typedef struct {
+  int temp;
+  unsigned int humi;
+  int lux;
+} reading_t;
+
 static unsigned char BUF_BIND_CFG[2 * sizeof(sock_addr_t)];
 
 void print_ipv6(ipv6_addr_t *);
@@ -24,10 +37,9 @@ int main(void) {
   printf("[IPv6_Sense] Starting IPv6 Sensors App.\n");
   printf("[IPv6_Sense] Sensors will be sampled and transmitted.\n");
 
-  unsigned int humi = 0;
-  int temp = 0;
-  int lux  = 0;
-  char packet[64];
+  reading_t readings[READINGS_PER_PACKET];
+  uint32_t seq = 0;
+  uint8_t packet[64];
 
   ieee802154_set_pan(0xABCD);
   ieee802154_config_commit();
@@ -58,14 +70,29 @@ int main(void) {
   };
 
   while (1) {
-    temperature_read_sync(&temp);
-    humidity_read_sync(&humi);
-    ambient_light_read_intensity_sync(&lux);
+    for (int i = 0; i < READINGS_PER_PACKET; i++) {
+      temperature_read_sync(&readings[i].temp);
+      humidity_read_sync(&readings[i].humi);
+      ambient_light_read_intensity_sync(&readings[i].lux);
+      if (i + 1 < READINGS_PER_PACKET) {
+        delay_ms(SAMPLE_INTERVAL_MS);
+      }
+    }
 
-    int len = snprintf(packet, sizeof(packet), "%d deg C; %d%% humidity; %d lux;\n",
-                       temp / 100, humi / 100, lux);
     int max_tx_len = udp_get_max_tx_len();
-    if (len > max_tx_len) {
+    cbor_writer_t w;
+    cbor_writer_init(&w, packet, (size_t) max_tx_len < sizeof(packet) ? (size_t) max_tx_len : sizeof(packet));
+    cbor_put_array(&w, 2);
+    cbor_put_uint(&w, seq++);
+    cbor_put_array(&w, READINGS_PER_PACKET);
+    for (int i = 0; i < READINGS_PER_PACKET; i++) {
+      cbor_put_array(&w, 3);
+      cbor_put_int(&w, readings[i].temp);
+      cbor_put_uint(&w, readings[i].humi);
+      cbor_put_int(&w, readings[i].lux);
+    }
+    int len = cbor_writer_finish(&w);
+    if (len < 0) {
       printf("Cannot send packets longer than %d bytes without changing"
              " constants in kernel\n", max_tx_len);
       return 0;
@@ -83,6 +110,6 @@ int main(void) {
         printf("Error sending packet %d\n\n", result);
     }
 
-    delay_ms(4000);
+    delay_ms(SAMPLE_INTERVAL_MS);
   }
 }
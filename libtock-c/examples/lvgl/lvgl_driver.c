@@ -2,8 +2,10 @@
 
 static lv_disp_buf_t disp_buf;
 lv_disp_drv_t disp_drv;
+lv_indev_drv_t indev_drv;
 
 void screen_lvgl_driver(lv_disp_drv_t * disp, const lv_area_t * area, lv_color_t * color_p);
+bool touch_lvgl_driver(lv_indev_drv_t * indev, lv_indev_data_t * data);
 
 /* screen driver */
 void screen_lvgl_driver(lv_disp_drv_t * disp, const lv_area_t * area,
@@ -20,6 +22,34 @@ void screen_lvgl_driver(lv_disp_drv_t * disp, const lv_area_t * area,
   lv_disp_flush_ready(disp);           /* Indicate you are ready with the flushing*/
 }
 
+/* touch driver
+ * LittlevGL polls this once per lv_task_handler, so it only samples the
+ * tracked touch state. The tracker acknowledges the kernel batch on every
+ * read, which with coalescing leaves one position per finger per frame.
+ * LittlevGL follows the first touch. */
+bool touch_lvgl_driver(__attribute__ ((unused)) lv_indev_drv_t * indev,
+                       lv_indev_data_t * data)
+{
+  static lv_coord_t last_x = 0;
+  static lv_coord_t last_y = 0;
+  touch_state_t state;
+
+  touch_track_read (&state);
+  if (state.num_touches > 0) {
+    last_x      = state.touches[0].x;
+    last_y      = state.touches[0].y;
+    data->state = state.touches[0].status == TOUCH_STATUS_RELEASED ?
+                  LV_INDEV_STATE_REL : LV_INDEV_STATE_PR;
+  } else {
+    data->state = LV_INDEV_STATE_REL;
+  }
+  data->point.x = last_x;
+  data->point.y = last_y;
+
+  /* a release queued behind the press just reported: read again */
+  return state.more;
+}
+
 int lvgl_driver_init (int buffer_lines)
 {
   size_t width, height;
@@ -40,6 +70,15 @@ int lvgl_driver_init (int buffer_lines)
       lv_disp_buf_init(&disp_buf, buf, NULL, width * buffer_lines);
       disp_drv.buffer = &disp_buf;
       lv_disp_drv_register(&disp_drv);
+
+      /* the touch panel, if any, is the pointer */
+      if (touch_exists () &&
+          touch_track_start (TOUCH_BATCH_HOLD | TOUCH_BATCH_COALESCE) == TOCK_SUCCESS) {
+        lv_indev_drv_init(&indev_drv);
+        indev_drv.type    = LV_INDEV_TYPE_POINTER;
+        indev_drv.read_cb = touch_lvgl_driver;
+        lv_indev_drv_register(&indev_drv);
+      }
     }
   }
   return error;
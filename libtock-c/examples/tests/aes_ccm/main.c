@@ -0,0 +1,152 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <aes_ccm.h>
+#include <internal/alarm.h>
+#include <timer.h>
+
+// RFC 3610, Packet Vector #1.
+static const uint8_t key[AES_CCM_KEY_LEN] = {
+  0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+  0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+};
+static const uint8_t nonce[AES_CCM_NONCE_LEN] = {
+  0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5,
+};
+static const uint8_t expected[39] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x58, 0x8c, 0x97, 0x9a, 0x61,
+  0xc6, 0x63, 0xd2, 0xf0, 0x66, 0xd0, 0xc2, 0xc0, 0xf9, 0x89, 0x80, 0x6d, 0x5f,
+  0x6b, 0x61, 0xda, 0xc3, 0x84, 0x17, 0xe8, 0xd1, 0x2c, 0xfd, 0xf9, 0x26, 0xe0,
+};
+
+#define HDR_LEN     8
+#define PAYLOAD_LEN 23
+#define MIC_LEN     8
+
+#define BENCH_PACKETS 8
+#define BENCH_PAYLOAD 64
+#define BENCH_ROUNDS  16
+
+static uint8_t batch_storage[BENCH_PACKETS * (AES_CCM_RECORD_HEADER + HDR_LEN + BENCH_PAYLOAD + MIC_LEN)];
+
+static bool test_vector(void) {
+  uint8_t buf[sizeof(expected)];
+  for (int i = 0; i < HDR_LEN + PAYLOAD_LEN; i++) {
+    buf[i] = i;
+  }
+
+  if (aes_ccm_encrypt_sync(nonce, buf, HDR_LEN, PAYLOAD_LEN, MIC_LEN) != TOCK_SUCCESS ||
+      memcmp(buf, expected, sizeof(expected)) != 0) {
+    return false;
+  }
+  if (aes_ccm_decrypt_sync(nonce, buf, HDR_LEN, PAYLOAD_LEN, MIC_LEN) != TOCK_SUCCESS) {
+    return false;
+  }
+  for (int i = 0; i < HDR_LEN + PAYLOAD_LEN; i++) {
+    if (buf[i] != i) return false;
+  }
+  return true;
+}
+
+static bool test_tamper(void) {
+  uint8_t buf[sizeof(expected)];
+  memcpy(buf, expected, sizeof(expected));
+  // Flip one bit of the authenticated-only header.
+  buf[3] ^= 0x10;
+  if (aes_ccm_decrypt_sync(nonce, buf, HDR_LEN, PAYLOAD_LEN, MIC_LEN) != TOCK_FAIL) {
+    return false;
+  }
+  // A rejected packet is left as received.
+  buf[3] ^= 0x10;
+  return memcmp(buf, expected, sizeof(expected)) == 0;
+}
+
+static void fill_batch(aes_ccm_batch_t* batch) {
+  aes_ccm_batch_init(batch, batch_storage, sizeof(batch_storage));
+  for (int i = 0; i < BENCH_PACKETS; i++) {
+    uint8_t packet_nonce[AES_CCM_NONCE_LEN];
+    memcpy(packet_nonce, nonce, sizeof(packet_nonce));
+    packet_nonce[AES_CCM_NONCE_LEN - 1] = i;
+    uint8_t* p = aes_ccm_batch_add(batch, packet_nonce, HDR_LEN, BENCH_PAYLOAD - i, MIC_LEN);
+    for (int j = 0; j < HDR_LEN + BENCH_PAYLOAD - i; j++) {
+      p[j] = i + j;
+    }
+  }
+}
+
+static bool test_batch(void) {
+  aes_ccm_batch_t batch;
+  fill_batch(&batch);
+  if (aes_ccm_encrypt_batch_sync(&batch) != TOCK_SUCCESS) return false;
+
+  // Corrupt the tag of packet 5 only.
+  size_t a_len, m_len, mic_len;
+  uint8_t* p = aes_ccm_batch_packet(&batch, 5, &a_len, &m_len, &mic_len);
+  p[a_len + m_len] ^= 1;
+
+  if (aes_ccm_decrypt_batch_sync(&batch) != TOCK_FAIL || batch.failed != (1u << 5)) {
+    return false;
+  }
+  for (int i = 0; i < BENCH_PACKETS; i++) {
+    if (i == 5) continue;
+    p = aes_ccm_batch_packet(&batch, i, &a_len, &m_len, &mic_len);
+    for (size_t j = 0; j < a_len + m_len; j++) {
+      if (p[j] != (uint8_t) (i + j)) return false;
+    }
+  }
+  return true;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[AES-CCM] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+static void bench(const char* name) {
+  aes_ccm_batch_t batch;
+  uint32_t single = 0, batched = 0;
+
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    fill_batch(&batch);
+    uint32_t start = alarm_read();
+    for (int i = 0; i < BENCH_PACKETS; i++) {
+      size_t a_len, m_len, mic_len;
+      uint8_t* p = aes_ccm_batch_packet(&batch, i, &a_len, &m_len, &mic_len);
+      TOCK_EXPECT(TOCK_SUCCESS, aes_ccm_encrypt_sync(p - AES_CCM_RECORD_HEADER, p, a_len, m_len, mic_len));
+    }
+    single += alarm_read() - start;
+
+    fill_batch(&batch);
+    start = alarm_read();
+    TOCK_EXPECT(TOCK_SUCCESS, aes_ccm_encrypt_batch_sync(&batch));
+    batched += alarm_read() - start;
+  }
+
+  printf("[AES-CCM] %s: %d x %d-byte packets, %lu ticks one at a time, %lu ticks batched"
+         " (alarm %u Hz)\n", name, BENCH_PACKETS * BENCH_ROUNDS, BENCH_PAYLOAD,
+         single, batched, alarm_internal_frequency());
+}
+
+int main(void) {
+  bool ok = true;
+
+  aes_ccm_set_key(key);
+  printf("[AES-CCM] kernel engine %s\n", aes_ccm_hardware_available() ? "present" : "absent");
+
+  ok &= run("RFC 3610 vector", test_vector);
+  ok &= run("tampered packet", test_tamper);
+  ok &= run("batch", test_batch);
+  if (!ok) {
+    exit(-1);
+  }
+
+  if (aes_ccm_hardware_available()) {
+    bench("kernel");
+    aes_ccm_force_software(true);
+  }
+  bench("software");
+  return 0;
+}
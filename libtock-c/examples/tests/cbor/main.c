@@ -0,0 +1,156 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cbor.h>
+
+// Encodings from RFC 8949, Appendix A.
+typedef struct {
+  int32_t value;
+  const char* hex;
+} int_vector_t;
+
+static const int_vector_t int_vectors[] = {
+  { 0, "00" },
+  { 1, "01" },
+  { 10, "0a" },
+  { 23, "17" },
+  { 24, "1818" },
+  { 25, "1819" },
+  { 100, "1864" },
+  { 1000, "1903e8" },
+  { 1000000, "1a000f4240" },
+  { -1, "20" },
+  { -10, "29" },
+  { -100, "3863" },
+  { -1000, "3903e7" },
+  { INT32_MIN, "3a7fffffff" },
+};
+
+static uint8_t buf[64];
+
+static bool matches(const char* hex, int len) {
+  if (len < 0 || (size_t) len * 2 != strlen(hex)) return false;
+  for (int i = 0; i < len; i++) {
+    unsigned byte;
+    sscanf(hex + 2 * i, "%2x", &byte);
+    if (buf[i] != byte) return false;
+  }
+  return true;
+}
+
+static bool test_ints(void) {
+  for (size_t i = 0; i < sizeof(int_vectors) / sizeof(int_vectors[0]); i++) {
+    cbor_writer_t w;
+    cbor_writer_init(&w, buf, sizeof(buf));
+    cbor_put_int(&w, int_vectors[i].value);
+    int len = cbor_writer_finish(&w);
+    if (!matches(int_vectors[i].hex, len)) {
+      printf("  encode %ld: expected %s\n", (long) int_vectors[i].value, int_vectors[i].hex);
+      return false;
+    }
+
+    cbor_reader_t r;
+    int32_t value;
+    cbor_reader_init(&r, buf, len);
+    if (cbor_get_int(&r, &value) != TOCK_SUCCESS || value != int_vectors[i].value ||
+        !cbor_reader_done(&r)) {
+      printf("  decode %s failed\n", int_vectors[i].hex);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool test_structures(void) {
+  // {"a": 1, "b": [2, 3]}, then true, null and h'01020304'.
+  static const uint8_t bytes[] = { 1, 2, 3, 4 };
+  cbor_writer_t w;
+  cbor_writer_init(&w, buf, sizeof(buf));
+  cbor_put_map(&w, 2);
+  cbor_put_text(&w, "a");
+  cbor_put_uint(&w, 1);
+  cbor_put_text(&w, "b");
+  cbor_put_array(&w, 2);
+  cbor_put_uint(&w, 2);
+  cbor_put_uint(&w, 3);
+  cbor_put_bool(&w, true);
+  cbor_put_null(&w);
+  cbor_put_bytes(&w, bytes, sizeof(bytes));
+  int len = cbor_writer_finish(&w);
+  if (!matches("a26161016162820203f5f64401020304", len)) return false;
+
+  cbor_reader_t r;
+  size_t count, text_len, bytes_len;
+  const char* text;
+  const uint8_t* data;
+  uint32_t value;
+  bool flag;
+  cbor_reader_init(&r, buf, len);
+  if (cbor_get_map(&r, &count) != TOCK_SUCCESS || count != 2) return false;
+  if (cbor_get_text(&r, &text, &text_len) != TOCK_SUCCESS || text_len != 1 || text[0] != 'a') return false;
+  if (cbor_get_uint(&r, &value) != TOCK_SUCCESS || value != 1) return false;
+  // A wrong type must fail without consuming anything.
+  if (cbor_get_uint(&r, &value) != TOCK_EINVAL) return false;
+  if (cbor_peek_type(&r) != CBOR_TYPE_TEXT) return false;
+  if (cbor_skip(&r) != TOCK_SUCCESS || cbor_skip(&r) != TOCK_SUCCESS) return false;
+  if (cbor_get_bool(&r, &flag) != TOCK_SUCCESS || !flag) return false;
+  if (cbor_skip(&r) != TOCK_SUCCESS) return false;
+  if (cbor_get_bytes(&r, &data, &bytes_len) != TOCK_SUCCESS || bytes_len != 4 || data[3] != 4) return false;
+  return cbor_reader_done(&r) && cbor_peek_type(&r) == TOCK_ESIZE;
+}
+
+static bool test_limits(void) {
+  cbor_writer_t w;
+  cbor_writer_init(&w, buf, 4);
+  cbor_put_array(&w, 2);
+  cbor_put_uint(&w, 1);
+  size_t mark = cbor_writer_mark(&w);
+  cbor_put_uint(&w, 1000000);
+  if (cbor_writer_finish(&w) != TOCK_ESIZE) return false;
+  // Later items are dropped once one has failed, even if they would fit.
+  cbor_put_uint(&w, 1);
+  if (cbor_writer_finish(&w) != TOCK_ESIZE) return false;
+  cbor_writer_rewind(&w, mark);
+  cbor_put_uint(&w, 2);
+  if (!matches("820102", cbor_writer_finish(&w))) return false;
+
+  // Truncated and malformed input.
+  static const uint8_t truncated[] = { 0x82, 0x19, 0x03 };
+  static const uint8_t long_text[] = { 0x65, 'a', 'b' };
+  static const uint8_t indefinite[] = { 0x9f, 0x01, 0xff };
+  static const uint8_t nested_bomb[] = { 0x9a, 0xff, 0xff, 0xff, 0xff, 0x80 };
+  static const uint8_t wide_uint[] = { 0x1b, 0, 0, 0, 1, 0, 0, 0, 0 };
+  cbor_reader_t r;
+  uint32_t value;
+
+  cbor_reader_init(&r, truncated, sizeof(truncated));
+  if (cbor_skip(&r) != TOCK_ESIZE || r.pos != 0) return false;
+  cbor_reader_init(&r, long_text, sizeof(long_text));
+  if (cbor_skip(&r) != TOCK_ESIZE) return false;
+  cbor_reader_init(&r, indefinite, sizeof(indefinite));
+  if (cbor_skip(&r) != TOCK_EINVAL) return false;
+  cbor_reader_init(&r, nested_bomb, sizeof(nested_bomb));
+  if (cbor_skip(&r) != TOCK_ESIZE) return false;
+  cbor_reader_init(&r, wide_uint, sizeof(wide_uint));
+  if (cbor_get_uint(&r, &value) != TOCK_EINVAL) return false;
+  return cbor_skip(&r) == TOCK_SUCCESS && cbor_reader_done(&r);
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[CBOR] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  bool ok = true;
+  ok &= run("integers", test_ints);
+  ok &= run("structures", test_structures);
+  ok &= run("limits", test_limits);
+  if (!ok) {
+    exit(-1);
+  }
+  return 0;
+}
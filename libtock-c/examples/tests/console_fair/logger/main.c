@@ -0,0 +1,27 @@
+#include <stdio.h>
+
+#include "console.h"
+
+// Console fairness test: the chatty side.
+// Writes bursts of long multi-line records as fast as the console takes
+// them, with each line prefixed by the process name, and reports its
+// counters every few bursts.
+
+#define RECORD_LINES 8
+
+int main(void) {
+  console_set_line_prefix(true);
+
+  for (int burst = 0; ; burst++) {
+    for (int i = 0; i < RECORD_LINES; i++) {
+      printf("burst %d line %d: the quick brown fox jumps over the lazy dog\n", burst, i);
+    }
+    if (burst % 16 == 15) {
+      console_stats_t stats;
+      if (console_stats(&stats) == TOCK_SUCCESS) {
+        printf("%lu bytes in %lu writes, longest wait %lu us\n",
+               stats.bytes, stats.writes, stats.max_wait_us);
+      }
+    }
+  }
+}
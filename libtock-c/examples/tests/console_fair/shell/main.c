@@ -0,0 +1,36 @@
+#include <stdio.h>
+
+#include "console.h"
+#include "timer.h"
+
+// Console fairness test: the latency-sensitive side.
+// Prints a short prompt-like line every 200 ms while the logger app floods
+// the console, and reports how long its lines waited for the console. Run
+// with the priority raised (PRIORITY 1) and at the default (PRIORITY 0) to
+// compare.
+
+#ifndef PRIORITY
+#define PRIORITY 1
+#endif
+
+#define LINES 50
+
+int main(void) {
+  int err = console_set_priority(PRIORITY);
+  if (err < TOCK_SUCCESS) {
+    printf("shell> cannot set priority %d: %s\n", PRIORITY, tock_strerror(err));
+  }
+
+  for (int i = 0; i < LINES; i++) {
+    printf("shell> %d\n", i);
+    delay_ms(200);
+  }
+
+  putstr_flush();
+  console_stats_t stats;
+  if (console_stats(&stats) == TOCK_SUCCESS) {
+    printf("shell> priority %d: %lu lines, average wait %lu us, longest %lu us\n",
+           PRIORITY, stats.writes, stats.wait_us / stats.writes, stats.max_wait_us);
+  }
+  return 0;
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "console.h"
+#include "internal/alarm.h"
+
+// Console throughput test.
+// Prints LINES lines of multi-line-style output with printf, waits for the
+// console to drain, and reports the achieved rate against the 115200 baud
+// (8N1, 11520 bytes/s) ceiling of the UART.
+
+#define LINES     64
+#define LINE_LEN  72
+#define BAUD_RATE 115200
+
+int main(void) {
+  char line[LINE_LEN + 1];
+  memset(line, '.', LINE_LEN - 1);
+  line[LINE_LEN - 1] = '\n';
+  line[LINE_LEN]     = '\0';
+
+  putstr_flush();
+  uint32_t start = alarm_read();
+  for (int i = 0; i < LINES; i++) {
+    // Numbered so dropped or reordered lines are easy to spot.
+    line[0] = '0' + (i / 10) % 10;
+    line[1] = '0' + i % 10;
+    printf("%s", line);
+  }
+  putstr_flush();
+  uint32_t ticks = alarm_read() - start;
+
+  uint32_t bytes   = LINES * LINE_LEN;
+  uint32_t us      = (uint32_t) (((uint64_t) ticks * 1000000) / alarm_internal_frequency());
+  uint32_t rate    = (uint32_t) (((uint64_t) bytes * 1000000) / us);
+  uint32_t ceiling = BAUD_RATE / 10;
+  printf("[CONSOLE] %lu bytes in %lu ms: %lu bytes/s, %lu%% of %d baud\n",
+         bytes, us / 1000, rate, rate * 100 / ceiling, BAUD_RATE);
+  return 0;
+}
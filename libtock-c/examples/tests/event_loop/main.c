@@ -0,0 +1,124 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <event.h>
+#include <internal/alarm.h>
+#include <rng.h>
+#include <timer.h>
+
+static event_loop_t loop;
+static event_source_t fast, slow, posted, random_source;
+
+static void on_slow(event_source_t* source,
+                    __attribute__ ((unused)) int now,
+                    __attribute__ ((unused)) int arg1,
+                    __attribute__ ((unused)) int arg2) {
+  if (source->count == 5) {
+    event_loop_stop(source->loop);
+  }
+}
+
+// Nothing is due, so the wait times out.
+static bool test_timeout(void) {
+  event_loop_init(&loop);
+  uint32_t start = alarm_read();
+  if (event_wait_any(&loop, 20) != NULL) return false;
+  uint32_t ms = (alarm_read() - start) / (alarm_internal_frequency() / 1000);
+  return ms >= 20 && ms < 40 && event_wait_any(&loop, 0) == NULL;
+}
+
+// Posted events come out in order, with their arguments.
+static bool test_post(void) {
+  event_loop_init(&loop);
+  event_source_init(&loop, &posted, NULL, NULL);
+  event_source_init(&loop, &fast, NULL, NULL);
+  for (int i = 0; i < 3; i++) {
+    TOCK_EXPECT(TOCK_SUCCESS, event_post(&posted, i, i * 2, i * 3));
+  }
+  TOCK_EXPECT(TOCK_SUCCESS, event_post(&fast, 7, 8, 9));
+
+  for (int i = 0; i < 3; i++) {
+    event_source_t* source = event_wait_any(&loop, 100);
+    if (source != &posted || source->arg0 != i || source->arg1 != i * 2 || source->arg2 != i * 3) {
+      return false;
+    }
+  }
+  event_source_t* source = event_wait_any(&loop, 100);
+  return source == &fast && fast.arg2 == 9 && posted.count == 3;
+}
+
+// Events of a removed source are dropped, even if already queued.
+static bool test_remove(void) {
+  event_loop_init(&loop);
+  event_source_init(&loop, &posted, NULL, NULL);
+  event_source_init(&loop, &fast, NULL, NULL);
+  TOCK_EXPECT(TOCK_SUCCESS, event_post(&posted, 1, 0, 0));
+  TOCK_EXPECT(TOCK_SUCCESS, event_post(&fast, 2, 0, 0));
+  TOCK_EXPECT(TOCK_SUCCESS, event_post(&posted, 3, 0, 0));
+  // Each yield runs one queued task, moving an event into the loop.
+  yield();
+  yield();
+  yield();
+  TOCK_EXPECT(TOCK_SUCCESS, event_source_remove(&posted));
+  event_source_t* source = event_wait_any(&loop, 100);
+  return source == &fast && event_wait_any(&loop, 0) == NULL && posted.count == 0;
+}
+
+// Two timers run side by side until the slow one has fired five times.
+static bool test_timers(void) {
+  tock_timer_t fast_timer, slow_timer;
+  event_loop_init(&loop);
+  event_source_init(&loop, &fast, NULL, NULL);
+  event_source_init(&loop, &slow, on_slow, NULL);
+  timer_every(50, event_source_cb, &fast, &fast_timer);
+  timer_every(120, event_source_cb, &slow, &slow_timer);
+
+  event_loop_run(&loop);
+  timer_cancel(&fast_timer);
+  timer_cancel(&slow_timer);
+  printf("[EVENT] fast timer %lu, slow timer %lu, dropped %lu\n",
+         fast.count, slow.count, loop.dropped);
+  return slow.count == 5 && fast.count >= 11 && fast.count <= 12 && loop.dropped == 0;
+}
+
+// Random bytes arrive while a timer keeps firing.
+static bool test_driver(void) {
+  static uint8_t buf[16];
+  tock_timer_t timer;
+  event_loop_init(&loop);
+  event_source_init(&loop, &fast, NULL, NULL);
+  event_source_init(&loop, &random_source, NULL, NULL);
+  TOCK_EXPECT(TOCK_SUCCESS, event_source_subscribe(&random_source, DRIVER_NUM_RNG, 0));
+  TOCK_EXPECT(TOCK_SUCCESS, rng_set_buffer(buf, sizeof(buf)));
+  timer_every(1, event_source_cb, &fast, &timer);
+  TOCK_EXPECT(TOCK_SUCCESS, rng_get_random(sizeof(buf)));
+
+  event_source_t* source;
+  while ((source = event_wait_any(&loop, 1000)) == &fast) ;
+  timer_cancel(&timer);
+  event_source_remove(&random_source);
+  printf("[EVENT] %lu timer events before the random bytes\n", fast.count);
+  return source == &random_source && random_source.arg1 == sizeof(buf);
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[EVENT] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  bool ok = true;
+  ok &= run("timeout", test_timeout);
+  ok &= run("post", test_post);
+  ok &= run("remove", test_remove);
+  ok &= run("timers", test_timers);
+  if (driver_exists(DRIVER_NUM_RNG)) {
+    ok &= run("driver", test_driver);
+  }
+  if (!ok) {
+    exit(-1);
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hmac.h>
+#include <internal/alarm.h>
+#include <sha256.h>
+#include <timer.h>
+
+typedef struct {
+  const char* message;
+  const char* digest;
+} sha256_vector_t;
+
+// FIPS 180-4 examples.
+static const sha256_vector_t sha256_vectors[] = {
+  { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+  { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+  { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+    "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+};
+
+static uint8_t big[1024];
+
+static bool matches(const uint8_t* digest, const char* hex) {
+  for (int i = 0; i < SHA256_DIGEST_LEN; i++) {
+    unsigned byte;
+    sscanf(hex + 2 * i, "%2x", &byte);
+    if (digest[i] != byte) return false;
+  }
+  return true;
+}
+
+static bool test_sha256(void) {
+  uint8_t digest[SHA256_DIGEST_LEN];
+  for (size_t i = 0; i < sizeof(sha256_vectors) / sizeof(sha256_vectors[0]); i++) {
+    const char* m = sha256_vectors[i].message;
+    sha256(m, strlen(m), digest);
+    if (!matches(digest, sha256_vectors[i].digest)) return false;
+  }
+
+  // One million 'a's, fed in uneven pieces.
+  sha256_ctx_t ctx;
+  memset(big, 'a', sizeof(big));
+  sha256_init(&ctx);
+  for (size_t left = 1000000, n = 1; left > 0; left -= n, n = n % 997 + 1) {
+    if (n > left) n = left;
+    sha256_update(&ctx, big, n);
+  }
+  sha256_finish(&ctx, digest);
+  return matches(digest, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+static bool test_chunks(void) {
+  uint8_t one_shot[SHA256_DIGEST_LEN], gathered[SHA256_DIGEST_LEN];
+  for (size_t i = 0; i < sizeof(big); i++) {
+    big[i] = i * 7;
+  }
+  sha256(big, sizeof(big), one_shot);
+
+  sha256_chunk_t chunks[] = {
+    { big, 1 }, { big + 1, 62 }, { big + 63, 0 }, { big + 63, 130 }, { big + 193, sizeof(big) - 193 },
+  };
+  sha256_ctx_t ctx;
+  sha256_init(&ctx);
+  sha256_update_chunks(&ctx, chunks, sizeof(chunks) / sizeof(chunks[0]));
+  sha256_finish(&ctx, gathered);
+  return memcmp(one_shot, gathered, sizeof(one_shot)) == 0;
+}
+
+typedef struct {
+  const uint8_t* key;
+  size_t key_len;
+  const char* message;
+  const char* mac;
+} hmac_vector_t;
+
+static bool test_hmac(void) {
+  // RFC 4231 test cases 1, 2 and 6.
+  static uint8_t key1[20], key6[131];
+  memset(key1, 0x0b, sizeof(key1));
+  memset(key6, 0xaa, sizeof(key6));
+  const hmac_vector_t vectors[] = {
+    { key1, sizeof(key1), "Hi There",
+      "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+    { (const uint8_t*) "Jefe", 4, "what do ya want for nothing?",
+      "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+    { key6, sizeof(key6), "Test Using Larger Than Block-Size Key - Hash Key First",
+      "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" },
+  };
+
+  for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    const hmac_vector_t* v = &vectors[i];
+    uint8_t mac[HMAC_SHA256_LEN];
+
+    hmac_sha256_ctx_t ctx;
+    hmac_sha256_init(&ctx, v->key, v->key_len);
+    hmac_sha256_update(&ctx, v->message, strlen(v->message));
+    hmac_sha256_finish(&ctx, mac);
+    if (!matches(mac, v->mac)) return false;
+
+    // Through the kernel engine where available.
+    memset(mac, 0, sizeof(mac));
+    if (hmac_sha256_digest_sync(v->key, v->key_len, v->message, strlen(v->message), mac) != TOCK_SUCCESS ||
+        !matches(mac, v->mac)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[HMAC] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  bool ok = true;
+
+  printf("[HMAC] kernel engine %s\n", hmac_sha256_exists() ? "present" : "absent");
+  ok &= run("SHA-256 vectors", test_sha256);
+  ok &= run("scatter-gather", test_chunks);
+  ok &= run("HMAC vectors", test_hmac);
+  if (!ok) {
+    exit(-1);
+  }
+
+  uint8_t digest[SHA256_DIGEST_LEN];
+  uint32_t start = alarm_read();
+  for (int i = 0; i < 16; i++) {
+    sha256(big, sizeof(big), digest);
+  }
+  uint32_t sw = alarm_read() - start;
+  printf("[HMAC] software SHA-256: %lu ticks per KiB (alarm %u Hz)\n", sw / 16,
+         alarm_internal_frequency());
+
+  if (hmac_sha256_exists()) {
+    static const uint8_t key[32] = { 1 };
+    start = alarm_read();
+    for (int i = 0; i < 16; i++) {
+      TOCK_EXPECT(TOCK_SUCCESS, hmac_sha256_digest_sync(key, sizeof(key), big, sizeof(big), digest));
+    }
+    printf("[HMAC] kernel HMAC-SHA256: %lu ticks per KiB\n", (alarm_read() - start) / 16);
+  }
+  return 0;
+}
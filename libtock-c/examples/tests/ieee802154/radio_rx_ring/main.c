@@ -0,0 +1,67 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "ieee802154.h"
+#include "led.h"
+#include "timer.h"
+#include "tock.h"
+
+// IEEE 802.15.4 receive ring test.
+// Receives frames into a ring of RING_SLOTS slots and prints one line per
+// frame. The handler deliberately sleeps every few frames, as a slow consumer
+// would, so that frames pile up in the ring instead of being lost; the drop
+// counter shows when even the ring overflows.
+
+#define RING_SLOTS 8
+
+static char ring[IEEE802154_RING_LEN(RING_SLOTS)];
+static bool frames_ready = false;
+static uint32_t last_dropped = 0;
+
+static void ring_callback(__attribute__ ((unused)) int available,
+                          __attribute__ ((unused)) int dropped,
+                          __attribute__ ((unused)) int unused,
+                          __attribute__ ((unused)) void* ud) {
+  frames_ready = true;
+}
+
+int main(void) {
+  ieee802154_set_address(0x0802);
+  ieee802154_set_pan(0xABCD);
+  ieee802154_config_commit();
+  ieee802154_up();
+
+  int err = ieee802154_receive_ring(ring, sizeof(ring), ring_callback, NULL);
+  if (err < 0) {
+    printf("[RX ring] unable to set up the ring: %d\n", err);
+    return err;
+  }
+
+  int handled = 0;
+  while (1) {
+    yield_for(&frames_ready);
+    frames_ready = false;
+
+    const char *frame;
+    ieee802154_rx_info_t info;
+    while ((frame = ieee802154_ring_peek(ring, &info)) != NULL) {
+      unsigned short src = 0;
+      ieee802154_frame_get_src_addr(frame, &src, NULL);
+      int backlog = ieee802154_ring_available(ring) - 1;
+      printf("[RX ring] %d bytes from 0x%04x at %lu, %d more waiting\n",
+             ieee802154_frame_get_payload_length(frame), src, info.timestamp, backlog);
+      ieee802154_ring_release(ring);
+      led_toggle(0);
+
+      if (++handled % 4 == 0) {
+        delay_ms(200);
+      }
+    }
+
+    uint32_t dropped = ieee802154_ring_dropped(ring);
+    if (dropped != last_dropped) {
+      printf("[RX ring] %lu frames dropped so far\n", dropped);
+      last_dropped = dropped;
+    }
+  }
+}
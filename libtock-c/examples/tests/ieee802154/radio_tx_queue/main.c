@@ -0,0 +1,100 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "ieee802154.h"
+#include "internal/alarm.h"
+#include "led.h"
+#include "timer.h"
+#include "tock.h"
+
+// IEEE 802.15.4 queued transmission test.
+// Keeps QUEUE_DEPTH frames queued at a time, alternating between an address
+// that acks and one that does not, and prints the per-destination statistics
+// after every burst.
+
+#define BURST       32
+#define QUEUE_DEPTH 4
+#define BUF_SIZE    60
+
+static char packets[QUEUE_DEPTH][BUF_SIZE];
+static ieee802154_tx_frame_t frames[QUEUE_DEPTH];
+static int queued;
+static int completed;
+
+static uint32_t ticks_to_ms(uint32_t ticks) {
+  return (uint32_t) (((uint64_t) ticks * 1000) / alarm_internal_frequency());
+}
+
+static void queue_next(ieee802154_tx_frame_t *frame);
+
+static void frame_done(int status,
+                       __attribute__ ((unused)) int attempts,
+                       __attribute__ ((unused)) int latency,
+                       void* ud) {
+  if (status == TOCK_SUCCESS) {
+    led_toggle(0);
+  }
+  completed++;
+  queue_next((ieee802154_tx_frame_t*) ud);
+}
+
+static void queue_next(ieee802154_tx_frame_t *frame) {
+  if (queued == BURST) return;
+
+  char *packet = (char*) frame->payload;
+  packet[0] = queued;
+
+  frame->addr        = (queued & 1) ? 0x0803 : 0x0802;
+  frame->level       = SEC_LEVEL_NONE;
+  frame->max_retries = 2;
+  frame->callback    = frame_done;
+  frame->ud          = frame;
+  if (ieee802154_send_async(frame) == TOCK_SUCCESS) {
+    queued++;
+  }
+}
+
+static void print_stats(void) {
+  ieee802154_tx_stats_t stats;
+  for (int i = 0; ieee802154_tx_stats_at(i, &stats) == TOCK_SUCCESS; i++) {
+    uint32_t avg = stats.frames ? stats.latency_total / stats.frames : 0;
+    printf("  0x%04x: %lu frames, %lu acked, %lu no ack, %lu failed, %lu retries, "
+           "avg %lu ms, max %lu ms\n",
+           stats.addr, stats.frames, stats.acked, stats.no_ack, stats.failed,
+           stats.retries, ticks_to_ms(avg), ticks_to_ms(stats.latency_max));
+  }
+}
+
+int main(void) {
+  for (int i = 0; i < QUEUE_DEPTH; i++) {
+    for (int j = 0; j < BUF_SIZE; j++) {
+      packets[i][j] = j;
+    }
+    frames[i].payload = packets[i];
+    frames[i].len     = BUF_SIZE;
+  }
+
+  ieee802154_set_address(0x1540);
+  ieee802154_set_pan(0xABCD);
+  ieee802154_config_commit();
+  ieee802154_up();
+
+  while (1) {
+    queued    = 0;
+    completed = 0;
+    ieee802154_tx_stats_reset();
+
+    uint32_t start = alarm_read();
+    for (int i = 0; i < QUEUE_DEPTH; i++) {
+      queue_next(&frames[i]);
+    }
+    while (completed < queued) {
+      yield();
+    }
+
+    printf("[TX queue] burst of %d frames in %lu ms\n", completed,
+           ticks_to_ms(alarm_read() - start));
+    print_stats();
+    delay_ms(4000);
+  }
+}
@@ -0,0 +1,134 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "alarm.h"
+#include "internal/alarm.h"
+#include "timer.h"
+#include "tock.h"
+
+// Kernel timer test.
+// Runs TIMERS repeating timers with different periods for RUN_MS, first with
+// timer_every (kernel timers, re-armed by the kernel) and then re-armed from
+// each callback in userspace (how timer_every works without kernel timers).
+// For each it reports how many times the timers fired against how many
+// periods fit in the run, and the latest a callback ran after its
+// expiration. It then checks that a cancelled timer whose id is reused does
+// not fire for the new timer.
+
+#define TIMERS 4
+#define RUN_MS 2000
+
+static const uint32_t periods_ms[TIMERS] = { 7, 10, 13, 20 };
+
+typedef struct {
+  tock_timer_t timer;
+  alarm_t alarm;
+  uint32_t interval;
+  int fired;
+} test_timer_t;
+
+static test_timer_t timers[TIMERS];
+static uint32_t max_late;
+
+static uint32_t ticks_to_us(uint32_t ticks) {
+  return (uint32_t) (((uint64_t) ticks * 1000000) / alarm_internal_frequency());
+}
+
+static void fired(test_timer_t* t, uint32_t now, uint32_t expiration) {
+  t->fired++;
+  if (now - expiration > max_late) max_late = now - expiration;
+}
+
+static void report(const char* name) {
+  int fired = 0, expected = 0;
+  for (int i = 0; i < TIMERS; i++) {
+    fired    += timers[i].fired;
+    expected += RUN_MS / periods_ms[i];
+  }
+  printf("[Timers] %s: %d of %d periods, latest callback %lu us\n", name, fired, expected,
+         ticks_to_us(max_late));
+}
+
+// ***** Kernel timers *****
+
+static void kernel_cb(int now, int expiration, __attribute__ ((unused)) int unused, void* ud) {
+  fired((test_timer_t*) ud, now, expiration);
+}
+
+static void run_kernel(void) {
+  max_late = 0;
+  for (int i = 0; i < TIMERS; i++) {
+    timers[i].fired = 0;
+    timer_every(periods_ms[i], kernel_cb, &timers[i], &timers[i].timer);
+  }
+  delay_ms(RUN_MS);
+  for (int i = 0; i < TIMERS; i++) {
+    timer_cancel(&timers[i].timer);
+  }
+}
+
+// ***** Userspace re-arming *****
+
+static void userspace_cb(int now, int expiration, __attribute__ ((unused)) int unused, void* ud) {
+  test_timer_t* t = (test_timer_t*) ud;
+  alarm_at(now + t->interval, userspace_cb, t, &t->alarm);
+  fired(t, now, expiration);
+}
+
+static void run_userspace(void) {
+  uint32_t frequency = alarm_internal_frequency();
+
+  max_late = 0;
+  for (int i = 0; i < TIMERS; i++) {
+    timers[i].fired    = 0;
+    timers[i].interval = periods_ms[i] * (frequency / 1000);
+    alarm_at(alarm_read() + timers[i].interval, userspace_cb, &timers[i], &timers[i].alarm);
+  }
+  delay_ms(RUN_MS);
+  for (int i = 0; i < TIMERS; i++) {
+    alarm_cancel(&timers[i].alarm);
+  }
+}
+
+// ***** Reusing a cancelled timer *****
+
+static bool early;
+
+static void stale_cb(__attribute__ ((unused)) int now,
+                     __attribute__ ((unused)) int expiration,
+                     __attribute__ ((unused)) int unused,
+                     __attribute__ ((unused)) void* ud) {
+  early = true;
+}
+
+static void check_reuse(void) {
+  tock_timer_t old_timer, new_timer;
+
+  // Cancel right after the timer expired, while its callback may still be
+  // queued, and immediately start a much slower timer on the same id.
+  timer_every(1, stale_cb, NULL, &old_timer);
+  delay_ms(5);
+  timer_cancel(&old_timer);
+  early = false;
+  timer_every(1000, stale_cb, NULL, &new_timer);
+  delay_ms(100);
+  timer_cancel(&new_timer);
+
+  printf("[Timers] reused id: %s\n", early ? "FAIL (stale callback)" : "ok");
+}
+
+int main(void) {
+  int num = alarm_internal_timer_count();
+  if (num < TOCK_SUCCESS) {
+    printf("[Timers] No kernel timers, timer_every multiplexes in userspace\n");
+  } else {
+    printf("[Timers] %d kernel timers\n", num);
+  }
+
+  run_kernel();
+  report("timer_every");
+  run_userspace();
+  report("userspace re-arm");
+  check_reuse();
+  return 0;
+}
@@ -0,0 +1,141 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <internal/alarm.h>
+#include <kv_store.h>
+#include <timer.h>
+
+KV_STORE_DECLARE(4096, 64);
+
+#define CALIBRATION_KEYS 32
+#define LOOKUP_ROUNDS 100
+
+// The same calibration table kept as a struct array and searched in order.
+typedef struct {
+  char name[12];
+  int32_t value;
+} calibration_t;
+
+static calibration_t table[CALIBRATION_KEYS];
+
+static void key_name(int i, char* name) {
+  sprintf(name, "cal.%02d", i);
+}
+
+static const calibration_t* table_find(const char* name) {
+  for (int i = 0; i < CALIBRATION_KEYS; i++) {
+    if (strcmp(table[i].name, name) == 0) return &table[i];
+  }
+  return NULL;
+}
+
+static bool test_values(void) {
+  for (int i = 0; i < CALIBRATION_KEYS; i++) {
+    key_name(i, table[i].name);
+    table[i].value = i * 1000 - 7;
+    int32_t value = table[i].value;
+    TOCK_EXPECT(TOCK_SUCCESS, kv_store_put(table[i].name, strlen(table[i].name), &value,
+                                           sizeof(value)));
+  }
+
+  for (int i = 0; i < CALIBRATION_KEYS; i++) {
+    const void* value;
+    int len = kv_store_get(table[i].name, strlen(table[i].name), &value);
+    if (len != sizeof(int32_t) || *(const int32_t*) value != table[i].value) {
+      printf("[KV] %s: length %d\n", table[i].name, len);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool test_delete(void) {
+  const void* value;
+  TOCK_EXPECT(TOCK_SUCCESS, kv_store_put("tmp", 3, "x", 1));
+  TOCK_EXPECT(TOCK_SUCCESS, kv_store_delete("tmp", 3));
+  return kv_store_get("tmp", 3, &value) == TOCK_EINVAL;
+}
+
+// Rewrites one key until the log has been compacted several times.
+static bool test_compaction(void) {
+  kv_store_info_t info;
+  kv_store_info(&info);
+  uint32_t generation = info.generation;
+
+  for (uint32_t i = 0; info.generation < generation + 3; i++) {
+    TOCK_EXPECT(TOCK_SUCCESS, kv_store_put("counter", 7, &i, sizeof(i)));
+    kv_store_info(&info);
+  }
+  return test_values();
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[KV] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+static void bench(void) {
+  char names[CALIBRATION_KEYS][12];
+  for (int i = 0; i < CALIBRATION_KEYS; i++) {
+    key_name(i, names[i]);
+  }
+
+  int32_t sum    = 0;
+  uint32_t start = alarm_read();
+  for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+    for (int i = 0; i < CALIBRATION_KEYS; i++) {
+      sum += table_find(names[i])->value;
+    }
+  }
+  uint32_t linear = alarm_read() - start;
+
+  start = alarm_read();
+  for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+    for (int i = 0; i < CALIBRATION_KEYS; i++) {
+      const void* value;
+      kv_store_get(names[i], strlen(names[i]), &value);
+      sum -= *(const int32_t*) value;
+    }
+  }
+  uint32_t hashed = alarm_read() - start;
+
+  printf("[KV] %d lookups: %lu ticks linear scan, %lu ticks kv_store (alarm %u Hz)%s\n",
+         LOOKUP_ROUNDS * CALIBRATION_KEYS, linear, hashed, alarm_internal_frequency(),
+         sum == 0 ? "" : " MISMATCH");
+}
+
+int main(void) {
+  int err = kv_store_init();
+  if (err < TOCK_SUCCESS) {
+    printf("[KV] init failed: %s\n", tock_strerror(err));
+    exit(-1);
+  }
+
+  uint32_t boots = 0;
+  const void* value;
+  if (kv_store_get("boots", 5, &value) == sizeof(boots)) {
+    boots = *(const uint32_t*) value;
+  }
+  printf("[KV] boot %lu\n", boots + 1);
+  boots++;
+  TOCK_EXPECT(TOCK_SUCCESS, kv_store_put("boots", 5, &boots, sizeof(boots)));
+
+  bool ok = true;
+  ok &= run("put and get", test_values);
+  ok &= run("delete", test_delete);
+  ok &= run("compaction", test_compaction);
+  if (!ok) {
+    exit(-1);
+  }
+
+  bench();
+
+  kv_store_info_t info;
+  kv_store_info(&info);
+  printf("[KV] %u keys, %u bytes used, %u free, generation %lu\n", info.entries, info.used,
+         info.free, info.generation);
+  return 0;
+}
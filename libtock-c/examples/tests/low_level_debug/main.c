@@ -0,0 +1,48 @@
+#include <stdio.h>
+
+#include "alarm.h"
+#include "low_level_debug.h"
+#include "tock.h"
+#include "workload.h"
+
+// Low-level debug test.
+// Times the same loop with its trace points compiled out, printing through
+// the low-level debug driver, and printing the same values with printf, to
+// show how much each way of tracing disturbs the code being traced.
+
+static uint32_t workload_printf(void) {
+  uint32_t acc = 1;
+  for (int i = 0; i < WORKLOAD_ITERATIONS; i++) {
+    acc = acc * 1664525 + 1013904223;
+    if (i % WORKLOAD_TRACE_EVERY == 0) {
+      printf("LOOP 0x%lx\n", acc);
+    }
+  }
+  return acc;
+}
+
+static uint32_t time_workload(const char* name, uint32_t (*workload)(void)) {
+  uint32_t start  = alarm_read();
+  uint32_t result = workload();
+  uint32_t ticks  = alarm_read() - start;
+  printf("[LLD] %-8s %lu ticks (result 0x%lx)\n", name, ticks, result);
+  return ticks;
+}
+
+int main(void) {
+  if (!low_level_debug_exists()) {
+    printf("[LLD] no low-level debug driver\n");
+    return 0;
+  }
+
+  low_level_debug_print_tagged(TRACE_TAG('L', 'L', 'D', ' '), 0x1234);
+
+  uint32_t off    = time_workload("off", workload_untraced);
+  uint32_t traced = time_workload("lowlevel", workload_traced);
+  uint32_t print  = time_workload("printf", workload_printf);
+
+  printf("[LLD] overhead per trace point: lowlevel %lu ticks, printf %lu ticks\n",
+         (traced - off) * WORKLOAD_TRACE_EVERY / WORKLOAD_ITERATIONS,
+         (print - off) * WORKLOAD_TRACE_EVERY / WORKLOAD_ITERATIONS);
+  return 0;
+}
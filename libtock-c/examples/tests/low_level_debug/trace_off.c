@@ -0,0 +1,7 @@
+#define NDEBUG
+
+#include "low_level_debug.h"
+#include "workload.h"
+
+#define WORKLOAD_FN workload_untraced
+#include "workload.inc"
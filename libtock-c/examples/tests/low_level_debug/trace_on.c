@@ -0,0 +1,7 @@
+#undef NDEBUG
+
+#include "low_level_debug.h"
+#include "workload.h"
+
+#define WORKLOAD_FN workload_traced
+#include "workload.inc"
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+// The same traced loop built with trace points on (trace_on.c) and compiled
+// out (trace_off.c, which defines NDEBUG).
+
+#define WORKLOAD_ITERATIONS 4000
+#define WORKLOAD_TRACE_EVERY 1000
+
+uint32_t workload_traced(void);
+uint32_t workload_untraced(void);
@@ -0,0 +1,129 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <internal/alarm.h>
+#include <lzss.h>
+#include <timer.h>
+
+#define MAX_INPUT 4096
+
+static lzss_encoder_t enc;
+static lzss_decoder_t dec;
+
+static uint8_t input[MAX_INPUT];
+static uint8_t compressed[MAX_INPUT + MAX_INPUT / 8 + 16];
+static uint8_t output[MAX_INPUT];
+
+static uint32_t seed = 7;
+
+static uint32_t next_rand(void) {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+// Something that looks like what our nodes actually log.
+static size_t make_log_text(uint8_t* buf, size_t len) {
+  size_t n = 0;
+  for (int i = 0; n + 80 < len; i++) {
+    n += snprintf((char*) buf + n, len - n,
+                  "[%7d] node %d: temp=%d.%02d C hum=%d%% lux=%d rssi=-%d ok\n",
+                  i * 125, i % 4, 21 + i % 3, (i * 17) % 100, 40 + i % 9,
+                  300 + (i * 7) % 50, 60 + i % 20);
+  }
+  return n;
+}
+
+// Streams `len` bytes through the encoder and decoder using irregular chunk
+// sizes on both sides. Returns the compressed size, or -1 on mismatch.
+static int stream_round_trip(size_t len) {
+  size_t in_pos = 0, comp_len = 0;
+  lzss_encoder_init(&enc);
+  while (!lzss_encoder_done(&enc)) {
+    if (in_pos < len) {
+      size_t chunk = 1 + next_rand() % 61;
+      if (chunk > len - in_pos) chunk = len - in_pos;
+      in_pos += lzss_encoder_sink(&enc, input + in_pos, chunk);
+    } else {
+      lzss_encoder_finish(&enc);
+    }
+    size_t n;
+    while ((n = lzss_encoder_poll(&enc, compressed + comp_len, 1 + next_rand() % 13)) > 0) {
+      comp_len += n;
+    }
+  }
+
+  size_t comp_pos = 0, out_len = 0;
+  lzss_decoder_init(&dec);
+  while (true) {
+    size_t chunk = 1 + next_rand() % 17;
+    if (chunk > comp_len - comp_pos) chunk = comp_len - comp_pos;
+    comp_pos += lzss_decoder_sink(&dec, compressed + comp_pos, chunk);
+
+    size_t n, total = 0;
+    while ((n = lzss_decoder_poll(&dec, output + out_len, 1 + next_rand() % 29)) > 0) {
+      out_len += n;
+      total   += n;
+    }
+    if (comp_pos == comp_len && total == 0) break;
+  }
+
+  if (out_len != len || memcmp(input, output, len) != 0) {
+    return -1;
+  }
+  return comp_len;
+}
+
+static bool check_round_trip(const char* name, size_t len) {
+  int r = stream_round_trip(len);
+  printf("[LZSS] round trip %s (%u bytes): %s\n", name, (unsigned) len, r < 0 ? "FAIL" : "OK");
+  return r >= 0;
+}
+
+static bool check_size_limits(size_t log_len) {
+  int full = lzss_compress(&enc, input, log_len, compressed, sizeof(compressed));
+  if (full <= 0) return false;
+  // One byte short of the compressed size must be rejected, not truncated.
+  if (lzss_compress(&enc, input, log_len, compressed, full - 1) != TOCK_ESIZE) return false;
+  if (lzss_compress(&enc, input, log_len, compressed, full) != full) return false;
+  if (lzss_decompress(&dec, compressed, full, output, log_len - 1) != TOCK_ESIZE) return false;
+  return lzss_decompress(&dec, compressed, full, output, log_len) == (int) log_len &&
+         memcmp(input, output, log_len) == 0;
+}
+
+int main(void) {
+  bool ok = true;
+
+  for (size_t i = 0; i < 1024; i++) {
+    input[i] = next_rand();
+  }
+  ok &= check_round_trip("random", 1024);
+  ok &= check_round_trip("empty", 0);
+  ok &= check_round_trip("single", 1);
+
+  size_t log_len = make_log_text(input, sizeof(input));
+  ok &= check_round_trip("log text", log_len);
+
+  bool limits = check_size_limits(log_len);
+  printf("[LZSS] one-shot size limits: %s\n", limits ? "OK" : "FAIL");
+  ok &= limits;
+
+  if (!ok) {
+    exit(-1);
+  }
+
+  uint32_t start = alarm_read();
+  int comp_len   = lzss_compress(&enc, input, log_len, compressed, sizeof(compressed));
+  uint32_t mid   = alarm_read();
+  lzss_decompress(&dec, compressed, comp_len, output, sizeof(output));
+  uint32_t end = alarm_read();
+
+  printf("[LZSS] log text %u -> %d bytes (%d%%)\n", (unsigned) log_len, comp_len,
+         (int) (comp_len * 100 / log_len));
+  printf("[LZSS] encode %lu ticks, decode %lu ticks (alarm %u Hz)\n",
+         mid - start, end - mid, alarm_internal_frequency());
+  return 0;
+}
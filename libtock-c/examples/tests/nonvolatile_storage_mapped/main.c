@@ -0,0 +1,162 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <internal/alarm.h>
+#include <internal/nonvolatile_storage.h>
+#include <nonvolatile_storage.h>
+#include <timer.h>
+
+// A calibration table of 1024 values at the start of the storage.
+#define ENTRIES 1024
+#define LOOKUPS 1000
+
+static int32_t table[ENTRIES];
+
+static void fill(int32_t seed) {
+  for (int i = 0; i < ENTRIES; i++) {
+    table[i] = i * 1000 + seed;
+  }
+}
+
+// Pseudo-random entries to look up.
+static uint32_t next_index(uint32_t* state) {
+  *state = *state * 1103515245 + 12345;
+  return (*state >> 16) % ENTRIES;
+}
+
+// ***** Through the kernel with the internal API *****
+
+static bool single_done;
+
+static void single_cb(__attribute__ ((unused)) int length,
+                      __attribute__ ((unused)) int unused1,
+                      __attribute__ ((unused)) int unused2,
+                      __attribute__ ((unused)) void* ud) {
+  single_done = true;
+}
+
+static uint8_t single_buffer[NONVOLATILE_STORAGE_CHUNK_SIZE];
+
+// Runs before the library is used: the library allows its own buffers and
+// subscribes once, when it is first called. Writes the table and returns
+// the time to look up LOOKUPS values with one read each.
+static uint32_t bench_syscall(int32_t* sum) {
+  nonvolatile_storage_internal_write_buffer(single_buffer, sizeof(single_buffer));
+  nonvolatile_storage_internal_read_buffer(single_buffer, sizeof(single_buffer));
+  nonvolatile_storage_internal_write_done_subscribe(single_cb, NULL);
+  nonvolatile_storage_internal_read_done_subscribe(single_cb, NULL);
+
+  for (size_t offset = 0; offset < sizeof(table); offset += sizeof(single_buffer)) {
+    memcpy(single_buffer, (uint8_t*) table + offset, sizeof(single_buffer));
+    single_done = false;
+    TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_internal_write(offset, sizeof(single_buffer)));
+    yield_for(&single_done);
+  }
+
+  uint32_t state = 1;
+  uint32_t start = alarm_read();
+  for (int i = 0; i < LOOKUPS; i++) {
+    single_done = false;
+    nonvolatile_storage_internal_read(next_index(&state) * sizeof(int32_t), sizeof(int32_t));
+    yield_for(&single_done);
+    int32_t value;
+    memcpy(&value, single_buffer, sizeof(value));
+    *sum += value;
+  }
+  return alarm_read() - start;
+}
+
+// ***** Through the library *****
+
+static const int32_t* mapped;
+
+static bool test_mapped(void) {
+  return memcmp(mapped, table, sizeof(table)) == 0;
+}
+
+// A write shows through the mapping once it completes, and a read queued
+// behind a write sees it.
+static bool test_write(void) {
+  int32_t value = -17;
+  TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_write_sync(17 * sizeof(int32_t),
+                                                           (const uint8_t*) &value,
+                                                           sizeof(value)));
+  if (mapped[17] != value) return false;
+
+  nonvolatile_storage_request_t write;
+  int32_t readback = 0;
+  value = 1234567;
+  TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_write(&write, 18 * sizeof(int32_t),
+                                                      (const uint8_t*) &value, sizeof(value),
+                                                      NULL, NULL));
+  TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_read_sync(18 * sizeof(int32_t),
+                                                          (uint8_t*) &readback,
+                                                          sizeof(readback)));
+  return readback == value && mapped[18] == value;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[NV Mapped] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+static uint32_t bench_read_sync(int32_t* sum) {
+  uint32_t state = 1;
+  uint32_t start = alarm_read();
+  for (int i = 0; i < LOOKUPS; i++) {
+    int32_t value;
+    nonvolatile_storage_read_sync(next_index(&state) * sizeof(int32_t), (uint8_t*) &value,
+                                  sizeof(value));
+    *sum += value;
+  }
+  return alarm_read() - start;
+}
+
+static uint32_t bench_pointer(int32_t* sum) {
+  uint32_t state = 1;
+  uint32_t start = alarm_read();
+  for (int i = 0; i < LOOKUPS; i++) {
+    *sum += mapped[next_index(&state)];
+  }
+  return alarm_read() - start;
+}
+
+int main(void) {
+  if (!nonvolatile_storage_exists()) {
+    printf("[NV Mapped] no nonvolatile storage\n");
+    exit(-1);
+  }
+  if (nonvolatile_storage_size() < (int) sizeof(table)) {
+    printf("[NV Mapped] need %u bytes\n", sizeof(table));
+    exit(-1);
+  }
+
+  fill(7);
+  int32_t sums[3]  = { 0, 0, 0 };
+  uint32_t syscall = bench_syscall(&sums[0]);
+
+  mapped = (const int32_t*) nonvolatile_storage_mapped();
+  if (mapped == NULL) {
+    printf("[NV Mapped] storage is not mapped on this board\n");
+    exit(-1);
+  }
+  printf("[NV Mapped] storage at %p\n", mapped);
+
+  bool ok = true;
+  ok &= run("mapped contents", test_mapped);
+  uint32_t read_sync = bench_read_sync(&sums[1]);
+  uint32_t pointer   = bench_pointer(&sums[2]);
+  ok &= run("write then read", test_write);
+  if (!ok) {
+    exit(-1);
+  }
+
+  printf("[NV Mapped] %d lookups: %lu ticks through the kernel, %lu ticks read_sync,"
+         " %lu ticks pointer (alarm %u Hz)%s\n", LOOKUPS, syscall, read_sync, pointer,
+         alarm_internal_frequency(),
+         sums[0] == sums[1] && sums[1] == sums[2] ? "" : " MISMATCH");
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <internal/alarm.h>
+#include <internal/nonvolatile_storage.h>
+#include <nonvolatile_storage.h>
+#include <timer.h>
+
+#define REQUESTS 4
+#define REQUEST_LEN 1200
+#define BENCH_LEN (REQUESTS * REQUEST_LEN)
+
+static uint8_t written[BENCH_LEN];
+static uint8_t readback[BENCH_LEN];
+
+static int done;
+static int failures;
+static int order[REQUESTS * 2];
+
+static void request_cb(int result, int length, __attribute__ ((unused)) int unused, void* ud) {
+  int id = (int) ud;
+  if (result != TOCK_SUCCESS || length != REQUEST_LEN) {
+    printf("[NV Queue] request %d: result %d, %d bytes\n", id, result, length);
+    failures++;
+  }
+  order[done++] = id;
+}
+
+static void fill(uint8_t* buffer, size_t length, uint8_t seed) {
+  for (size_t i = 0; i < length; i++) {
+    buffer[i] = (uint8_t) (i * 7 + seed);
+  }
+}
+
+// Queues every write and then every read back at once, and checks that they
+// complete in order with the right data.
+static bool test_queue(void) {
+  nonvolatile_storage_request_t requests[REQUESTS * 2];
+
+  fill(written, BENCH_LEN, 3);
+  memset(readback, 0, BENCH_LEN);
+  done     = 0;
+  failures = 0;
+
+  for (int i = 0; i < REQUESTS; i++) {
+    TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_write(&requests[i], i * REQUEST_LEN,
+                                                        written + i * REQUEST_LEN, REQUEST_LEN,
+                                                        request_cb, (void*) i));
+  }
+  for (int i = 0; i < REQUESTS; i++) {
+    TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_read(&requests[REQUESTS + i], i * REQUEST_LEN,
+                                                       readback + i * REQUEST_LEN, REQUEST_LEN,
+                                                       request_cb, (void*) (REQUESTS + i)));
+  }
+
+  while (done < REQUESTS * 2) {
+    yield();
+  }
+
+  for (int i = 0; i < REQUESTS * 2; i++) {
+    if (order[i] != i) {
+      printf("[NV Queue] request %d completed %dth\n", order[i], i);
+      return false;
+    }
+  }
+  return failures == 0 && memcmp(written, readback, BENCH_LEN) == 0;
+}
+
+static bool increment(uint8_t* buffer, size_t length, __attribute__ ((unused)) void* ud) {
+  for (size_t i = 0; i < length; i++) {
+    buffer[i]++;
+  }
+  return true;
+}
+
+// A write queued right behind a read-modify-write of the same range must
+// land after it.
+static bool test_modify(void) {
+  static uint8_t modify_buffer[100];
+  static const uint8_t overwrite[10] = { 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA };
+  nonvolatile_storage_request_t modify, write;
+
+  done     = 0;
+  failures = 0;
+  TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_modify(&modify, 550, modify_buffer,
+                                                       sizeof(modify_buffer), increment,
+                                                       NULL, NULL));
+  TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_write(&write, 560, overwrite, sizeof(overwrite),
+                                                      NULL, NULL));
+  TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_read_sync(0, readback, BENCH_LEN));
+
+  for (size_t i = 0; i < BENCH_LEN; i++) {
+    uint8_t expected = written[i];
+    if (i >= 550 && i < 650) expected++;
+    if (i >= 560 && i < 570) expected = 0xAA;
+    if (readback[i] != expected) {
+      printf("[NV Queue] byte %u is 0x%02x, expected 0x%02x\n", i, readback[i], expected);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[NV Queue] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+// ***** One transfer at a time through the internal API *****
+
+static bool single_done;
+
+static void single_cb(__attribute__ ((unused)) int length,
+                      __attribute__ ((unused)) int unused1,
+                      __attribute__ ((unused)) int unused2,
+                      __attribute__ ((unused)) void* ud) {
+  single_done = true;
+}
+
+static uint8_t single_buffer[NONVOLATILE_STORAGE_CHUNK_SIZE];
+
+static void single_write(size_t offset, const uint8_t* buffer, size_t length) {
+  for (size_t done_len = 0; done_len < length; done_len += sizeof(single_buffer)) {
+    size_t chunk = length - done_len < sizeof(single_buffer) ?
+                   length - done_len : sizeof(single_buffer);
+    memcpy(single_buffer, buffer + done_len, chunk);
+    single_done = false;
+    TOCK_EXPECT(TOCK_SUCCESS, nonvolatile_storage_internal_write(offset + done_len, chunk));
+    yield_for(&single_done);
+  }
+}
+
+// Runs before the library is used: the library allows its own buffer and
+// subscribes once, when it is first called.
+static uint32_t bench_single(void) {
+  fill(written, BENCH_LEN, 5);
+
+  nonvolatile_storage_internal_write_buffer(single_buffer, sizeof(single_buffer));
+  nonvolatile_storage_internal_write_done_subscribe(single_cb, NULL);
+  uint32_t start = alarm_read();
+  single_write(0, written, BENCH_LEN);
+  return alarm_read() - start;
+}
+
+static uint32_t bench_queued(void) {
+  nonvolatile_storage_request_t requests[REQUESTS];
+
+  fill(written, BENCH_LEN, 5);
+  done     = 0;
+  failures = 0;
+  uint32_t start = alarm_read();
+  for (int i = 0; i < REQUESTS; i++) {
+    nonvolatile_storage_write(&requests[i], i * REQUEST_LEN, written + i * REQUEST_LEN,
+                              REQUEST_LEN, request_cb, (void*) i);
+  }
+  while (done < REQUESTS) {
+    yield();
+  }
+  return alarm_read() - start;
+}
+
+int main(void) {
+  if (!nonvolatile_storage_exists()) {
+    printf("[NV Queue] no nonvolatile storage\n");
+    exit(-1);
+  }
+  int size = nonvolatile_storage_size();
+  printf("[NV Queue] %d bytes of storage\n", size);
+  if (size < BENCH_LEN) {
+    printf("[NV Queue] need %d bytes\n", BENCH_LEN);
+    exit(-1);
+  }
+
+  uint32_t single = bench_single();
+
+  bool ok = true;
+  ok &= run("queued writes and reads", test_queue);
+  ok &= run("read-modify-write", test_modify);
+  if (!ok) {
+    exit(-1);
+  }
+
+  uint32_t queued = bench_queued();
+  printf("[NV Queue] %d bytes: %lu ticks one transfer at a time, %lu ticks queued"
+         " (alarm %u Hz)\n", BENCH_LEN, single, queued, alarm_internal_frequency());
+  return 0;
+}
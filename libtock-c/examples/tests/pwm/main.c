@@ -0,0 +1,127 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "alarm.h"
+#include "internal/alarm.h"
+#include "pwm.h"
+#include "timer.h"
+#include "tock.h"
+
+// PWM fade benchmark.
+// Fades channel 0 from off to full over one second with a 1 kHz PWM, one
+// duty step per period, twice: once as a kernel-run sequence and once by
+// calling pwm_start from a 1 ms timer. For each it reports how long the fade
+// took, how often the app was woken and how many syscalls it made, and the
+// alarm ticks the app itself spent starting and stepping the fade.
+
+#define CHANNEL      0
+#define FREQUENCY_HZ 1000
+#define STEPS        1000
+
+static uint16_t fade[STEPS];
+
+typedef struct {
+  uint32_t elapsed;
+  uint32_t busy;
+  int wakeups;
+  int syscalls;
+} bench_t;
+
+static uint32_t ticks_to_us(uint32_t ticks) {
+  return (uint32_t) (((uint64_t) ticks * 1000000) / alarm_internal_frequency());
+}
+
+static void report(const char* name, bench_t* bench) {
+  printf("[PWM] %s: %lu ms, %d wakeups, %d syscalls, app busy %lu us\n", name,
+         ticks_to_us(bench->elapsed) / 1000, bench->wakeups, bench->syscalls,
+         ticks_to_us(bench->busy));
+}
+
+// ***** Kernel sequence *****
+
+static bool sequence_done;
+
+static void sequence_cb(__attribute__ ((unused)) int channel,
+                        __attribute__ ((unused)) int applied,
+                        __attribute__ ((unused)) int unused,
+                        __attribute__ ((unused)) void* ud) {
+  sequence_done = true;
+}
+
+static int bench_sequence(bench_t* bench) {
+  sequence_done = false;
+
+  uint32_t start = alarm_read();
+  int err = pwm_sequence_start(CHANNEL, FREQUENCY_HZ, fade, STEPS, 1, false, sequence_cb, NULL);
+  bench->busy = alarm_read() - start;
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&sequence_done);
+  bench->elapsed  = alarm_read() - start;
+  bench->wakeups  = 1;
+  bench->syscalls = 3;
+  return TOCK_SUCCESS;
+}
+
+// ***** Timer stepping *****
+
+static tock_timer_t step_timer;
+static int step;
+static bench_t* timer_bench;
+
+static void step_cb(__attribute__ ((unused)) int now,
+                    __attribute__ ((unused)) int unused1,
+                    __attribute__ ((unused)) int unused2,
+                    __attribute__ ((unused)) void* ud) {
+  uint32_t entry = alarm_read();
+  if (step < STEPS) {
+    int err = pwm_start(CHANNEL, FREQUENCY_HZ, fade[step]);
+    if (err < TOCK_SUCCESS) step = STEPS;
+    step++;
+    timer_bench->syscalls++;
+  }
+  timer_bench->wakeups++;
+  timer_bench->busy += alarm_read() - entry;
+}
+
+static void bench_timer(bench_t* bench) {
+  timer_bench = bench;
+  step        = 0;
+
+  uint32_t start = alarm_read();
+  timer_every(1, step_cb, NULL, &step_timer);
+  while (step < STEPS) {
+    yield();
+  }
+  timer_cancel(&step_timer);
+  bench->elapsed = alarm_read() - start;
+}
+
+int main(void) {
+  if (!pwm_exists()) {
+    printf("[PWM] no PWM driver\n");
+    return 0;
+  }
+
+  uint32_t max_frequency = 0;
+  pwm_get_maximum_frequency(CHANNEL, &max_frequency);
+  printf("[PWM] %d channel(s), channel %d up to %lu Hz\n", pwm_count(), CHANNEL,
+         max_frequency);
+
+  pwm_fill_ramp(fade, STEPS, 0, PWM_DUTY_MAX);
+
+  bench_t sequence = { 0 };
+  int err = bench_sequence(&sequence);
+  if (err < TOCK_SUCCESS) {
+    printf("[PWM] sequence failed: %s\n", tock_strerror(err));
+    return -1;
+  }
+  report("sequence", &sequence);
+
+  bench_t timer = { 0 };
+  bench_timer(&timer);
+  report("timer", &timer);
+
+  pwm_stop(CHANNEL);
+  return 0;
+}
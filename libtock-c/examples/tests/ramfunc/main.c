@@ -0,0 +1,80 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <timer.h>
+#include <tock.h>
+
+#define SAMPLES 512
+#define TAPS    16
+#define ROUNDS  64
+
+static int16_t samples[SAMPLES];
+static const int16_t taps[TAPS] = {
+  -3, -7, 12, 41, 88, 140, 181, 200, 200, 181, 140, 88, 41, 12, -7, -3,
+};
+
+// The same FIR accumulation, once in flash and once in RAM. Neither calls any
+// other function, so the RAM copy needs no long calls.
+static uint32_t __attribute__((noinline)) flash_fir(const int16_t* in, const int16_t* h) {
+  uint32_t acc = 0;
+  for (int i = 0; i + TAPS <= SAMPLES; i++) {
+    int32_t y = 0;
+    for (int j = 0; j < TAPS; j++) {
+      y += in[i + j] * h[j];
+    }
+    acc ^= (uint32_t) y + (acc << 1);
+  }
+  return acc;
+}
+
+static uint32_t TOCK_RAMFUNC ram_fir(const int16_t* in, const int16_t* h) {
+  uint32_t acc = 0;
+  for (int i = 0; i + TAPS <= SAMPLES; i++) {
+    int32_t y = 0;
+    for (int j = 0; j < TAPS; j++) {
+      y += in[i + j] * h[j];
+    }
+    acc ^= (uint32_t) y + (acc << 1);
+  }
+  return acc;
+}
+
+int main(void) {
+  printf("[TEST] RAM functions\n");
+
+  uintptr_t fn        = (uintptr_t) ram_fir;
+  uintptr_t ram_start = (uintptr_t) tock_app_memory_begins_at();
+  uintptr_t ram_end   = (uintptr_t) tock_app_memory_ends_at();
+  printf("ram_fir at %p (RAM %p-%p)\n", (void*) fn, (void*) ram_start, (void*) ram_end);
+  if (fn < ram_start || fn >= ram_end) {
+    printf("FAIL: ram_fir is not in RAM\n");
+    exit(-1);
+  }
+
+  for (int i = 0; i < SAMPLES; i++) {
+    samples[i] = (int16_t) ((i * 7919) & 0x3ff) - 512;
+  }
+
+  uint32_t flash_result = 0, ram_result = 0;
+
+  uint32_t start = alarm_read();
+  for (int r = 0; r < ROUNDS; r++) {
+    flash_result = flash_fir(samples, taps);
+  }
+  uint32_t flash_ticks = alarm_read() - start;
+
+  start = alarm_read();
+  for (int r = 0; r < ROUNDS; r++) {
+    ram_result = ram_fir(samples, taps);
+  }
+  uint32_t ram_ticks = alarm_read() - start;
+
+  printf("flash: %lu ticks, ram: %lu ticks\n", flash_ticks, ram_ticks);
+  if (flash_result != ram_result) {
+    printf("FAIL: results differ: 0x%08lx vs 0x%08lx\n", flash_result, ram_result);
+    exit(-1);
+  }
+  printf("results match: 0x%08lx\n", ram_result);
+  return 0;
+}
@@ -0,0 +1,246 @@
+// Host test for the userspace RF233 driver: runs rf233.c against the
+// register-level radio model in rf233-model.c, checking what reaches the
+// receive callback, how frames are read over SPI, and what is transmitted.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rf233-const.h"
+#include "rf233.h"
+
+#include "rf233-model.h"
+
+#define CHANNEL 0xab
+#define ADDRESS 0xbc
+#define PAN     0xcd
+
+#define HEADER_SIZE 9
+#define FCS_SIZE    2
+#define POOL_SIZE   4
+
+// ***** Checks *****
+
+static int failures;
+
+#define CHECK(_c) check((_c), #_c, __LINE__)
+
+static bool check(bool ok, const char* what, int line) {
+  if (!ok) {
+    printf("  line %d: %s\n", line, what);
+    failures++;
+  }
+  return ok;
+}
+
+// ***** Receive callback *****
+
+static struct {
+  int frames;
+  uint8_t payload[127];
+  int len;
+  uint16_t src, dest, pan;
+  uint8_t lqi, ed;
+  // Buffers the callback keeps, while `keep` is set.
+  bool keep;
+  void* held[POOL_SIZE + 1];
+  int num_held;
+} rx;
+
+static int rx_callback(void* payload, int len, uint16_t src, uint16_t dest, uint16_t pan) {
+  rx.frames++;
+  rx.len = len;
+  memcpy(rx.payload, payload, len);
+  rx.src  = src;
+  rx.dest = dest;
+  rx.pan  = pan;
+  rx.lqi  = rf233_rx_lqi(payload);
+  rx.ed   = rf233_rx_ed(payload);
+  if (rx.keep) {
+    rx.held[rx.num_held++] = payload;
+    return 1;
+  }
+  return 0;
+}
+
+// Builds a data frame as another node would send it, with `len` bytes of
+// payload starting at `first`, and puts it on the air.
+static bool send_to_radio(uint8_t first, int len, bool crc_ok) {
+  uint8_t psdu[127];
+  uint8_t header[HEADER_SIZE] = { 0x61, 0xAA, 0x11, PAN, 0x00, ADDRESS, 0x00, 0x34, 0x12 };
+  memcpy(psdu, header, HEADER_SIZE);
+  for (int i = 0; i < len; i++) {
+    psdu[HEADER_SIZE + i] = first + i;
+  }
+  // The FCS is not checked by the driver; the radio reports it in RX_STATUS.
+  psdu[HEADER_SIZE + len]     = 0;
+  psdu[HEADER_SIZE + len + 1] = 0;
+  return rf233_model_receive(psdu, HEADER_SIZE + len + FCS_SIZE, crc_ok, 0xE5, 0x20);
+}
+
+static bool payload_is(uint8_t first, int len) {
+  if (rx.len != len) return false;
+  for (int i = 0; i < len; i++) {
+    if (rx.payload[i] != (uint8_t) (first + i)) return false;
+  }
+  return true;
+}
+
+// ***** Tests *****
+
+static void test_init(void) {
+  printf("init\n");
+  CHECK(rf233_init(CHANNEL, ADDRESS, PAN) == 0);
+  CHECK(rf233_rx_data(rx_callback) == 0);
+  CHECK(rf233_model_state() == STATE_RX_ON);
+}
+
+// A frame is read in one SPI transaction after the IRQ_STATUS read, and
+// handed to the callback in place.
+static void test_receive(void) {
+  printf("receive\n");
+  CHECK(send_to_radio(0x40, 20, true));
+  rf233_model_stats_t before = rf233_model_stats;
+  rf233_model_run();
+  CHECK(rx.frames == 1);
+  CHECK(payload_is(0x40, 20));
+  CHECK(rx.src == 0x1234 && rx.dest == ADDRESS && rx.pan == PAN);
+  CHECK(rx.lqi == 0xE5 && rx.ed == 0x20);
+  uint32_t transactions = rf233_model_stats.transactions - before.transactions;
+  uint32_t bytes        = rf233_model_stats.bytes - before.bytes;
+  printf("  one 20 byte frame: %u SPI transactions, %u bytes\n", transactions, bytes);
+  // IRQ_STATUS (2 bytes), then command, length, PSDU and footer.
+  CHECK(transactions == 2);
+  CHECK(bytes == 2 + 2 + HEADER_SIZE + 20 + FCS_SIZE + 3);
+
+  // The largest frame fits the pool buffers.
+  CHECK(send_to_radio(0, 127 - HEADER_SIZE - FCS_SIZE, true));
+  rf233_model_run();
+  CHECK(rx.frames == 2);
+  CHECK(payload_is(0, 127 - HEADER_SIZE - FCS_SIZE));
+  CHECK(rf233_rx_dropped() == 0);
+}
+
+// Frames with a bad CRC or length are dropped without reaching the
+// callback, and the radio is free to receive the next frame.
+static void test_bad_frames(void) {
+  printf("bad frames\n");
+  int frames = rx.frames;
+  CHECK(send_to_radio(0x10, 8, false));
+  rf233_model_run();
+  CHECK(rx.frames == frames);
+  CHECK(rf233_rx_dropped() == 1);
+
+  uint8_t runt[4] = { 1, 2, 3, 4 };
+  CHECK(rf233_model_receive(runt, sizeof(runt), true, 0, 0));
+  rf233_model_run();
+  CHECK(rx.frames == frames);
+  CHECK(rf233_rx_dropped() == 2);
+
+  CHECK(send_to_radio(0x20, 8, true));
+  rf233_model_run();
+  CHECK(rx.frames == frames + 1);
+}
+
+// The radio holds an unread frame (RX safe mode), so a second frame before
+// the interrupt is handled is missed at the radio, not corrupted.
+static void test_safe_mode(void) {
+  printf("rx safe mode\n");
+  uint32_t missed = rf233_model_stats.frames_missed;
+  CHECK(send_to_radio(0x30, 8, true));
+  CHECK(!send_to_radio(0x50, 8, true));
+  CHECK(rf233_model_stats.frames_missed == missed + 1);
+  rf233_model_run();
+  CHECK(payload_is(0x30, 8));
+  CHECK(send_to_radio(0x50, 8, true));
+  rf233_model_run();
+  CHECK(payload_is(0x50, 8));
+}
+
+// Buffers the callback keeps stay valid until released. With every buffer
+// held, frames are dropped but still read out of the radio.
+static void test_pool(void) {
+  printf("receive pool\n");
+  uint32_t dropped = rf233_rx_dropped();
+  rx.keep     = true;
+  rx.num_held = 0;
+  for (int i = 0; i < POOL_SIZE; i++) {
+    CHECK(send_to_radio(0x60 + 16 * i, 12, true));
+    rf233_model_run();
+  }
+  CHECK(rx.num_held == POOL_SIZE);
+  int frames = rx.frames;
+  CHECK(send_to_radio(0xA0, 12, true));
+  rf233_model_run();
+  CHECK(rx.frames == frames);
+  CHECK(rf233_rx_dropped() == dropped + 1);
+
+  // The held payloads were not overwritten.
+  for (int i = 0; i < POOL_SIZE; i++) {
+    CHECK(((uint8_t*) rx.held[i])[0] == 0x60 + 16 * i);
+  }
+
+  rx.keep = false;
+  CHECK(rf233_rx_release(rx.held[1]) == 0);
+  CHECK(rf233_rx_release(rx.held[1]) == -1);
+  CHECK(rf233_rx_release(rx.payload) == -1);
+  CHECK(send_to_radio(0xB0, 12, true));
+  rf233_model_run();
+  CHECK(rx.frames == frames + 1);
+  CHECK(payload_is(0xB0, 12));
+  CHECK(rf233_rx_release(rx.held[0]) == 0);
+  CHECK(rf233_rx_release(rx.held[2]) == 0);
+  CHECK(rf233_rx_release(rx.held[3]) == 0);
+}
+
+static void test_transmit(void) {
+  printf("transmit\n");
+  uint8_t payload[3] = { 0xde, 0xad, 0x01 };
+  CHECK(rf233_tx_data(0x0802, payload, sizeof(payload)) == 0);
+  uint8_t len;
+  const uint8_t* sent = rf233_model_sent(&len);
+  CHECK(len == HEADER_SIZE + sizeof(payload) + FCS_SIZE);
+  CHECK(sent[0] == 0x61 && sent[1] == 0xAA);
+  CHECK(sent[3] == PAN && sent[4] == 0x00);
+  CHECK(sent[5] == 0x02 && sent[6] == 0x08);
+  CHECK(sent[7] == ADDRESS && sent[8] == 0x00);
+  CHECK(memcmp(sent + HEADER_SIZE, payload, sizeof(payload)) == 0);
+  CHECK(rf233_model_state() == STATE_RX_ON);
+
+  // Still receiving after the transmission.
+  CHECK(send_to_radio(0x70, 5, true));
+  rf233_model_run();
+  CHECK(payload_is(0x70, 5));
+}
+
+// The test app's cycle: sleep, then back on.
+static void test_sleep(void) {
+  printf("sleep\n");
+  CHECK(rf233_sleep() == 0);
+  CHECK(rf233_model_state() == STATE_SLEEP);
+  CHECK(!send_to_radio(0x80, 5, true));
+  CHECK(rf233_on() == 0);
+  CHECK(rf233_model_state() == STATE_RX_ON);
+  CHECK(send_to_radio(0x80, 5, true));
+  rf233_model_run();
+  CHECK(payload_is(0x80, 5));
+}
+
+int main(void) {
+  test_init();
+  test_receive();
+  test_bad_frames();
+  test_safe_mode();
+  test_pool();
+  test_transmit();
+  test_sleep();
+
+  CHECK(rf233_model_stats.bad_register_accesses == 0);
+  printf("  %u SPI transactions, %u bytes in all\n", rf233_model_stats.transactions,
+         rf233_model_stats.bytes);
+  if (failures > 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,290 @@
+// Register-level model of the RF233. See rf233-model.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rf233-arch.h"
+#include "rf233-const.h"
+#include "trx_access.h"
+
+#include "rf233-model.h"
+
+rf233_model_stats_t rf233_model_stats;
+
+static uint8_t regs[64];
+// PHR (frame length), PSDU, then the LQI, ED and RX_STATUS bytes of a
+// received frame.
+static uint8_t frame[1 + 127 + 3];
+// In RX safe mode, a received frame is kept from being overwritten until a
+// frame read of it ends.
+static bool frame_protected;
+
+static uint8_t sent[127];
+static uint8_t sent_len;
+
+static void (*irq_handler)(void);
+// A rising edge on the IRQ line that the driver has not been told about.
+static bool irq_edge;
+
+// The SPI transaction in progress.
+static bool selected;
+static enum {
+  SPI_COMMAND,
+  SPI_REGISTER_READ,
+  SPI_REGISTER_WRITE,
+  SPI_FRAME_READ,
+  SPI_FRAME_WRITE,
+  SPI_SRAM_ADDRESS,
+  SPI_SRAM_READ,
+  SPI_SRAM_WRITE,
+  SPI_DONE,
+} spi_state;
+static uint8_t spi_address;
+static size_t spi_pos;
+
+static uint8_t state(void) {
+  return regs[RF233_REG_TRX_STATUS] & TRX_STATUS;
+}
+
+static void set_state(uint8_t s) {
+  regs[RF233_REG_TRX_STATUS] = (regs[RF233_REG_TRX_STATUS] & ~TRX_STATUS) | s;
+}
+
+static void raise(uint8_t irq) {
+  bool line = regs[RF233_REG_IRQ_STATUS] != 0;
+  // Only interrupts enabled in IRQ_MASK are shown.
+  regs[RF233_REG_IRQ_STATUS] |= irq & regs[RF233_REG_IRQ_MASK];
+  if (!line && regs[RF233_REG_IRQ_STATUS] != 0) {
+    irq_edge = true;
+  }
+}
+
+static void transmit(void) {
+  sent_len = frame[0] < sizeof(sent) ? frame[0] : sizeof(sent);
+  memcpy(sent, frame + 1, sent_len);
+  // Extended mode reports the result in TRAC_STATUS; the channel is always
+  // clear and the frame acknowledged.
+  regs[RF233_REG_TRX_STATE] = (regs[RF233_REG_TRX_STATE] & ~TRX_STATE_TRAC_STATUS) | TRAC_SUCCESS;
+  raise(IRQ_TRX_END);
+}
+
+static void command(uint8_t cmd) {
+  uint8_t from = state();
+  switch (cmd) {
+    case TRXCMD_TRX_OFF:
+    case TRXCMD_FORCE_TRX_OFF:
+      set_state(STATE_TRX_OFF);
+      break;
+    case TRXCMD_PLL_ON:
+    case TRXCMD_FORCE_PLL_ON:
+    case TRXCMD_RX_ON:
+    case TRXCMD_TX_ARET_ON:
+      if (from == STATE_SLEEP || from == STATE_P_ON) return;
+      set_state(cmd == TRXCMD_FORCE_PLL_ON ? STATE_PLL_ON : cmd);
+      if (from == STATE_TRX_OFF) {
+        raise(IRQ_PLL_LOCK);
+      }
+      break;
+    case TRXCMD_TX_START:
+      if (from == STATE_PLL_ON || from == STATE_TX_ARET_ON) {
+        transmit();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void register_write(uint8_t address, uint8_t value) {
+  switch (address) {
+    case RF233_REG_TRX_STATUS:
+    case RF233_REG_IRQ_STATUS:
+    case RF233_REG_PART_NUM:
+      // Read only.
+      break;
+    case RF233_REG_TRX_STATE:
+      regs[address] = (regs[address] & TRX_STATE_TRAC_STATUS) | (value & TRX_STATE_TRX_COMMAND);
+      command(value & TRX_STATE_TRX_COMMAND);
+      break;
+    default:
+      regs[address] = value;
+      break;
+  }
+}
+
+static uint8_t register_read(uint8_t address) {
+  uint8_t value = regs[address];
+  if (address == RF233_REG_IRQ_STATUS) {
+    regs[address] = 0;
+  }
+  return value;
+}
+
+static uint8_t spi_byte(uint8_t in) {
+  switch (spi_state) {
+    case SPI_COMMAND:
+      spi_pos = 0;
+      if ((in & 0xC0) == READ_ACCESS_COMMAND) {
+        spi_address = in & 0x3F;
+        spi_state   = SPI_REGISTER_READ;
+      } else if ((in & 0xC0) == WRITE_ACCESS_COMMAND) {
+        spi_address = in & 0x3F;
+        spi_state   = SPI_REGISTER_WRITE;
+      } else if (in == TRX_CMD_FR) {
+        spi_state = SPI_FRAME_READ;
+      } else if (in == TRX_CMD_FW) {
+        spi_state = SPI_FRAME_WRITE;
+      } else if (in == TRX_CMD_SR || in == TRX_CMD_SW) {
+        spi_address = in;
+        spi_state   = SPI_SRAM_ADDRESS;
+      } else {
+        spi_state = SPI_DONE;
+      }
+      // The driver configures the first byte out to be TRX_STATUS.
+      return regs[RF233_REG_TRX_STATUS];
+
+    case SPI_REGISTER_READ:
+      if (spi_pos++ > 0) {
+        rf233_model_stats.bad_register_accesses++;
+        return 0;
+      }
+      return register_read(spi_address);
+
+    case SPI_REGISTER_WRITE:
+      if (spi_pos++ > 0) {
+        rf233_model_stats.bad_register_accesses++;
+        return 0;
+      }
+      register_write(spi_address, in);
+      return 0;
+
+    case SPI_FRAME_READ:
+      return spi_pos < sizeof(frame) ? frame[spi_pos++] : 0;
+
+    case SPI_FRAME_WRITE:
+      if (spi_pos < sizeof(frame)) frame[spi_pos++] = in;
+      return 0;
+
+    case SPI_SRAM_ADDRESS:
+      spi_state = spi_address == TRX_CMD_SR ? SPI_SRAM_READ : SPI_SRAM_WRITE;
+      spi_pos   = in;
+      return 0;
+
+    case SPI_SRAM_READ:
+      return spi_pos < sizeof(frame) ? frame[spi_pos++] : 0;
+
+    case SPI_SRAM_WRITE:
+      if (spi_pos < sizeof(frame)) frame[spi_pos++] = in;
+      return 0;
+
+    case SPI_DONE:
+    default:
+      return 0;
+  }
+}
+
+static void spi_end(void) {
+  if (spi_state == SPI_FRAME_READ) {
+    // Reading the frame, however much of it, lets the radio receive again.
+    frame_protected = false;
+  }
+  selected = false;
+}
+
+// ***** rf233-arch.h *****
+
+void rf233_arch_init(void) {
+  selected = false;
+}
+
+void rf233_arch_reset(void) {
+  memset(regs, 0, sizeof(regs));
+  set_state(STATE_TRX_OFF);
+  regs[RF233_REG_PART_NUM] = 0x0B;
+  frame_protected = false;
+  irq_edge        = false;
+}
+
+void rf233_arch_set_slp_tr(bool high) {
+  if (high && state() == STATE_TRX_OFF) {
+    set_state(STATE_SLEEP);
+  } else if (!high && state() == STATE_SLEEP) {
+    set_state(STATE_TRX_OFF);
+  }
+}
+
+void rf233_arch_set_irq_handler(void (*handler)(void)) {
+  irq_handler = handler;
+}
+
+int rf233_arch_transfer(const uint8_t *tx, uint8_t *rx, size_t len, bool hold) {
+  if (!selected) {
+    selected  = true;
+    spi_state = SPI_COMMAND;
+    rf233_model_stats.transactions++;
+  }
+  // `rx` may be `tx`: each byte is read before its reply is stored.
+  for (size_t i = 0; i < len; i++) {
+    uint8_t out = spi_byte(tx[i]);
+    if (rx != NULL) rx[i] = out;
+  }
+  rf233_model_stats.bytes += len;
+  if (!hold) {
+    spi_end();
+  }
+  return 0;
+}
+
+// ***** Test hooks *****
+
+bool rf233_model_receive(const uint8_t* psdu, uint8_t len, bool crc_ok, uint8_t lqi,
+                         uint8_t ed) {
+  uint8_t s = state();
+  if ((s != STATE_RX_ON && s != STATE_RX_AACK_ON) || frame_protected || len > 127) {
+    rf233_model_stats.frames_missed++;
+    return false;
+  }
+  frame[0] = len;
+  memcpy(frame + 1, psdu, len);
+  frame[1 + len] = lqi;
+  frame[2 + len] = ed;
+  frame[3 + len] = crc_ok ? RX_STATUS_CRC_OK : 0;
+  if (regs[RF233_REG_TRX_CTRL_2] & TRX_CTRL_2_RX_SAFE_MODE) {
+    frame_protected = true;
+  }
+  raise(IRQ_TRX_END);
+  return true;
+}
+
+void rf233_model_run(void) {
+  while (irq_edge && irq_handler != NULL) {
+    irq_edge = false;
+    irq_handler();
+  }
+}
+
+uint8_t rf233_model_state(void) {
+  return state();
+}
+
+const uint8_t* rf233_model_sent(uint8_t* len) {
+  *len = sent_len;
+  return sent;
+}
+
+// ***** libtock calls made by rf233.c *****
+
+void delay_ms(__attribute__ ((unused)) uint32_t ms) {
+  rf233_model_run();
+}
+
+void yield_for(bool* cond) {
+  while (!*cond) {
+    if (!irq_edge) {
+      printf("yield_for: waiting for an interrupt the radio will never raise\n");
+      exit(1);
+    }
+    rf233_model_run();
+  }
+}
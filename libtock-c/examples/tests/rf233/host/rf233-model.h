@@ -0,0 +1,38 @@
+#pragma once
+
+// Register-level model of the RF233, for running rf233.c on a host. It
+// implements rf233-arch.h in place of rf233-arch-tock.c, and the delay_ms
+// and yield_for calls the driver makes, which deliver the radio's
+// interrupts as a yield on a board would.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  // SPI transactions (chip select asserted to released) and bytes clocked.
+  uint32_t transactions;
+  uint32_t bytes;
+  // Register accesses that carried more than one data byte; the RF233 only
+  // takes one register per transaction.
+  uint32_t bad_register_accesses;
+  // Frames on the air the radio could not receive, because it was not
+  // listening or still held an unread frame (RX safe mode).
+  uint32_t frames_missed;
+} rf233_model_stats_t;
+
+extern rf233_model_stats_t rf233_model_stats;
+
+// Puts a frame on the air. `psdu` is the frame without its length byte,
+// including the two FCS bytes. Returns false if the radio missed it.
+bool rf233_model_receive(const uint8_t* psdu, uint8_t len, bool crc_ok, uint8_t lqi,
+                         uint8_t ed);
+
+// Calls the driver's interrupt handler for every interrupt raised since the
+// last call, as yield() would.
+void rf233_model_run(void);
+
+// The radio's state, as in the TRX_STATUS register.
+uint8_t rf233_model_state(void);
+
+// The last frame transmitted, without its length byte, and its length.
+const uint8_t* rf233_model_sent(uint8_t* len);
@@ -44,7 +44,7 @@ int callback(void* buffer,
              __attribute__ ((unused)) uint16_t src,
              __attribute__ ((unused)) uint16_t dest,
              __attribute__ ((unused)) uint16_t pan_id) {
-  printf("Rx callback!\n");
+  printf("Rx callback! LQI %u, %lu frames dropped\n", rf233_rx_lqi(buffer), rf233_rx_dropped());
   uint8_t* bytes = (uint8_t*) buffer;
   for (int i = 0; i < buffer_len; i++) {
     printf("  Byte %i = %02x\n", i, bytes[i]);
@@ -0,0 +1,79 @@
+// Bus and pin access for the RF233 on imix, through the Tock SPI and GPIO
+// drivers. See rf233-arch.h.
+
+#include <gpio.h>
+#include <spi.h>
+#include <timer.h>
+
+#include "rf233-arch.h"
+
+#define RADIO_SLP 8
+#define RADIO_RST 9
+#define RADIO_IRQ 10
+
+// The rate the driver ran at before SPI was configured in one place.
+#define RADIO_SPI_RATE 400000
+
+static void (*irq_handler)(void) = NULL;
+static bool holding = false;
+
+static void irq_callback(__attribute__ ((unused)) int pin,
+                         __attribute__ ((unused)) int state,
+                         __attribute__ ((unused)) int unused,
+                         __attribute__ ((unused)) void* ud) {
+  if (irq_handler) {
+    irq_handler();
+  }
+}
+
+void rf233_arch_init(void) {
+  // The bus is configured once here; every transfer after this is a single
+  // read-write operation.
+  spi_init();
+  // RF233 expects line low for CS, this is default SAM4L behavior
+  spi_set_chip_select(3);
+  spi_set_rate(RADIO_SPI_RATE);
+  // POL = 0 means idle is low
+  spi_set_polarity(0);
+  // PHASE = 0 means sample leading edge
+  spi_set_phase(0);
+
+  gpio_enable_output(RADIO_RST);
+  gpio_enable_output(RADIO_SLP);
+}
+
+void rf233_arch_reset(void) {
+  // Reset will put the radio into TRX_OFF state
+  gpio_clear(RADIO_RST);
+  delay_ms(1);
+  gpio_set(RADIO_RST);
+  gpio_clear(RADIO_SLP); /* be awake from sleep*/
+}
+
+void rf233_arch_set_slp_tr(bool high) {
+  if (high) {
+    gpio_set(RADIO_SLP);
+  } else {
+    gpio_clear(RADIO_SLP);
+  }
+}
+
+void rf233_arch_set_irq_handler(void (*handler)(void)) {
+  irq_handler = handler;
+  gpio_interrupt_callback(irq_callback, NULL);
+  gpio_enable_input(RADIO_IRQ, PullNone);
+  gpio_enable_interrupt(RADIO_IRQ, RisingEdge);
+}
+
+int rf233_arch_transfer(const uint8_t *tx, uint8_t *rx, size_t len, bool hold) {
+  if (hold && !holding) {
+    spi_hold_low();
+    holding = true;
+  }
+  int err = spi_read_write_sync((const char*) tx, (char*) rx, len);
+  if (!hold && holding) {
+    spi_release_low();
+    holding = false;
+  }
+  return err;
+}
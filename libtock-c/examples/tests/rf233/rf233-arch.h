@@ -33,22 +33,27 @@
 #ifndef _RF233_ARCH_H_
 #define _RF233_ARCH_H_
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
 void wake_from_sleep(void);
 void goto_sleep(void);
-/*
-void     rf233_arch_init(void);
-void     rf233_arch_reset(void);
-uint8_t  rf233_arch_status(void);
 
-int      rf233_arch_spi_busy(void);
-uint8_t  rf233_arch_read_reg(uint8_t reg);
-int      rf233_arch_write_reg(uint8_t reg, uint8_t val);
-int      rf233_arch_read_frame(uint8_t *buf, uint8_t len);
-int      rf233_arch_write_frame(uint8_t *buf, uint8_t len);
-int      rf233_arch_burstread_sram(uint8_t *buf, uint8_t offset, uint8_t len);
-int      rf233_arch_burstwrite_sram(uint8_t *buf, uint8_t offset, uint8_t len);*/
+/*
+ * Bus and pin access used by rf233.c. rf233-arch-tock.c implements these
+ * with the Tock SPI and GPIO drivers; a host build can link a register-level
+ * model of the radio in its place.
+ */
+void rf233_arch_init(void);
+void rf233_arch_reset(void);
+void rf233_arch_set_slp_tr(bool high);
+void rf233_arch_set_irq_handler(void (*handler)(void));
+/*
+ * Clocks `len` bytes out of `tx` and into `rx` (which may be `tx`). If `hold`
+ * is set, chip select stays asserted so that the next transfer continues the
+ * same SPI transaction.
+ */
+int rf233_arch_transfer(const uint8_t *tx, uint8_t *rx, size_t len, bool hold);
 
 #endif  /* _RF233_ARCH_H_ */
@@ -7,8 +7,6 @@
 // Date: April 18 2016
 
 
-#include <gpio.h>
-#include <spi.h>
 #include <stdint.h>
 #include <timer.h>
 
@@ -18,20 +16,16 @@
 #include "rf233.h"
 #include "trx_access.h"
 
-#define RADIO_SLP 8
-#define RADIO_RST 9
-#define RADIO_IRQ 10
-
 /*---------------------------------------------------------------------------*/
 static int on(void);
 static int off(void);
 static void rf_generate_random_seed(void);
-static void flush_buffer(void);
 static uint8_t flag_transmit      = 0;
 static uint8_t ack_status         = 0;
 static volatile int radio_is_on   = 0;
 static volatile int pending_frame = 0;
 static volatile int sleep_on      = 0;
+static void rf233_rx_frame(void);
 static int rf233_prepare_without_header(const uint8_t *data, unsigned short data_len);
 static int rf233_setup(void);
 static int rf233_prepare(const void *payload, unsigned short payload_len);
@@ -60,7 +54,6 @@ typedef struct {
 static header_t radio_header;
 
 /*---------------------------------------------------------------------------*/
-int rf233_read(void *buf, unsigned short bufsize);
 int rf233_receiving_packet(void);
 int rf233_pending_packet(void);
 
@@ -72,8 +65,9 @@ int rf233_pending_packet(void);
 /* each frame has a footer consisting of LQI, ED, RX_STATUS added by the radio */
 // #define FOOTER_LEN                        3   /* bytes */
 #define MAX_PACKET_LEN                    127 /* bytes, excluding the length (first) byte */
-#define PACKETBUF_SIZE                    128 /* bytes, for even int writes */
 #define HEADER_SIZE                       9 /* bytes */
+#define FCS_SIZE                          2 /* bytes */
+#define FOOTER_SIZE                       3 /* bytes: LQI, ED, RX_STATUS */
 
 /*---------------------------------------------------------------------------*/
 #define _DEBUG_               0
@@ -130,26 +124,55 @@ static void calibrate_filters(void) {
   while (trx_reg_read(RF233_REG_FTN_CTRL) & 0x80) ;
 }
 
-uint8_t recv_data[PACKETBUF_SIZE];
-uint8_t packetbuf[PACKETBUF_SIZE];
+/*---------------------------------------------------------------------------*/
+/*
+ * Received frames are read straight from the radio into one of a small pool
+ * of buffers, which is then handed to the receive callback. A callback that
+ * returns nonzero keeps the buffer until it calls rf233_rx_release(), so the
+ * radio can keep receiving into the rest of the pool in the meantime.
+ */
+#define RX_POOL_SIZE 4
 
-static void* packetbuf_dataptr(void) {
-  return (void*)packetbuf;
+typedef struct {
+  bool busy;
+  // [0]: status byte clocked out with the command, [1]: PHR (frame length),
+  // then the PSDU and the LQI, ED and RX_STATUS bytes.
+  uint8_t data[2 + MAX_PACKET_LEN + FOOTER_SIZE];
+} rx_buf_t;
+
+static rx_buf_t rx_pool[RX_POOL_SIZE];
+static uint32_t rx_dropped = 0;
+
+#define RX_PSDU(b)    ((b)->data + 2)
+#define RX_PAYLOAD(b) (RX_PSDU(b) + HEADER_SIZE)
+
+static rx_buf_t* rx_buf_alloc(void) {
+  for (int i = 0; i < RX_POOL_SIZE; i++) {
+    if (!rx_pool[i].busy) {
+      rx_pool[i].busy = true;
+      return &rx_pool[i];
+    }
+  }
+  return NULL;
 }
 
-static void packetbuf_clear(void) {
-  int* ptr = (int*)packetbuf;
-  for (int i = 0; i < PACKETBUF_SIZE / 4; i++) {
-    *ptr++ = 0x00000000;
+static rx_buf_t* rx_buf_from_payload(const void* payload) {
+  for (int i = 0; i < RX_POOL_SIZE; i++) {
+    if (payload == RX_PAYLOAD(&rx_pool[i])) {
+      return &rx_pool[i];
+    }
   }
+  return NULL;
 }
 
+/*---------------------------------------------------------------------------*/
+/*
+ * The RF233 takes one register per SPI transaction (two bytes), while frame
+ * buffer and SRAM accesses stream any number of bytes after the command.
+ */
 uint8_t trx_reg_read(uint8_t addr) {
-  uint8_t command = addr | READ_ACCESS_COMMAND;
-  char buf[2];
-  buf[0] = command;
-  buf[1] = 0;
-  spi_read_write_sync(buf, buf, 2);
+  uint8_t buf[2] = { addr | READ_ACCESS_COMMAND, 0 };
+  rf233_arch_transfer(buf, buf, 2, false);
   return buf[1];
 }
 
@@ -162,12 +185,8 @@ uint8_t trx_bit_read(uint8_t addr, uint8_t mask, uint8_t pos) {
 }
 
 void trx_reg_write(uint8_t addr, uint8_t data) {
-  uint8_t command = addr | WRITE_ACCESS_COMMAND;
-  char buf[2];
-  buf[0] = command;
-  buf[1] = data;
-  spi_write_sync(buf, 2);
-  return;
+  uint8_t buf[2] = { addr | WRITE_ACCESS_COMMAND, data };
+  rf233_arch_transfer(buf, buf, 2, false);
 }
 
 void trx_bit_write(uint8_t reg_addr,
@@ -184,40 +203,21 @@ void trx_bit_write(uint8_t reg_addr,
 }
 
 void trx_sram_read(uint8_t addr, uint8_t *data, uint8_t length)  {
-  spi_hold_low();
-  /* Send the command byte */
-  uint8_t __attribute__ ((unused)) tmp1 = spi_write_byte(TRX_CMD_SR);
-  /* Send the command byte */
-  uint8_t __attribute__ ((unused)) tmp2 = spi_write_byte(addr);
-  PRINTF("RF233: SRAM read");
-  PRINTF("0x%x 0x%x, ", tmp1, tmp2);
-  /* Send the address from which the read operation should start */
-  /* Upload the received byte in the user provided location */
-  for (uint8_t i = 0; i < length; i++) {
-    PRINTF("%02x ", data[i]);
-    data[i] = spi_write_byte(0);
-  }
-  spi_release_low();
-  PRINTF("\n");
-
+  uint8_t cmd[2] = { TRX_CMD_SR, addr };
+  rf233_arch_transfer(cmd, cmd, 2, true);
+  rf233_arch_transfer(data, data, length, false);
 }
 
 void trx_frame_read(uint8_t *data, uint8_t length)  {
-  spi_hold_low();
-  spi_write_byte(TRX_CMD_FR);
-  for (uint8_t i = 0; i < length; i++) {
-    data[i] = spi_write_byte(0);
-  }
-  spi_release_low();
+  uint8_t cmd = TRX_CMD_FR;
+  rf233_arch_transfer(&cmd, &cmd, 1, true);
+  rf233_arch_transfer(data, data, length, false);
 }
 
 void trx_frame_write(uint8_t *data, uint8_t length) {
-  spi_hold_low();
-  spi_write_byte(TRX_CMD_FW);
-  for (uint8_t i = 0; i < length; i++) {
-    spi_write_byte(data[i]);
-  }
-  spi_release_low();
+  uint8_t cmd = TRX_CMD_FW;
+  rf233_arch_transfer(&cmd, &cmd, 1, true);
+  rf233_arch_transfer(data, data, length, false);
 }
 
 
@@ -284,11 +284,7 @@ static bool radio_pll;
 static bool radio_tx;
 static bool radio_rx;
 
-static void interrupt_callback(int _a __attribute__((unused)),
-                               int _b __attribute__((unused)),
-                               int _c __attribute__((unused)),
-                               void* _ud __attribute__((unused))
-                               ) {
+static void interrupt_handler(void) {
   volatile uint8_t irq_source;
   PRINTF("RF233: interrupt handler.\n");
   /* handle IRQ source (for what IRQs are enabled, see rf233-config.h) */
@@ -308,22 +304,15 @@ static void interrupt_callback(int _a __attribute__((unused)),
       PRINTF("RF233: Interrupt transmit.\n");
       flag_transmit = 0;
       if (!(trx_reg_read(RF233_REG_TRX_STATE) & TRX_STATE_TRAC_STATUS)) {
-        flag_transmit = ack_status = 1;
+        ack_status = 1;
       }
       RF233_COMMAND(TRXCMD_RX_ON);
       PRINTF("RF233: TX complete, go back to RX with acks on.\n");
       radio_tx = true;
       return;
     } else {
-      // PRINTF("RF233: Interrupt receive.\n");
-      packetbuf_clear();
       pending_frame = 1;
-      int len = rf233_read(packetbuf_dataptr(), MAX_PACKET_LEN);
-      if (len > 0) {
-        PRINTF("RF233: Received packet and read from device.\n\n");
-      } else {
-        PRINTF("RF233: Read failed.\n\n");
-      }
+      rf233_rx_frame();
       radio_rx = true;
       return;
     }
@@ -343,10 +332,6 @@ int rf233_init(uint16_t channel, uint16_t from_addr, uint16_t pan_id) {
   radio_header.fcf  = 0xAA61; // TODO verify
   radio_header.src  = from_addr;
   radio_header.pan  = pan_id;
-  spi_set_chip_select(1);
-  spi_set_rate(1000000);
-  spi_set_phase(0);
-  spi_set_polarity(0);
   return rf233_setup();
 }
 
@@ -388,23 +373,11 @@ int rf233_setup(void) {
   volatile uint8_t radio_state;  /* don't optimize this away, it's important */
 
   /* init SPI and GPIOs, wake up from sleep/power up. */
-  spi_init();
-  // RF233 expects line low for CS, this is default SAM4L behavior
-  // POL = 0 means idle is low
-  spi_set_chip_select(3);
-  spi_set_rate(400000);
-  spi_set_polarity(0);
-  // PHASE = 0 means sample leading edge
-  spi_set_phase(0);
+  rf233_arch_init();
 
   /* reset will put us into TRX_OFF state */
   /* reset the radio core */
-  gpio_enable_output(RADIO_RST);
-  gpio_enable_output(RADIO_SLP);
-  gpio_clear(RADIO_RST);
-  delay_ms(1);
-  gpio_set(RADIO_RST);
-  gpio_clear(RADIO_SLP); /* be awake from sleep*/
+  rf233_arch_reset();
 
   /* Read the PART_NUM register to verify that the radio is
    * working/responding. Could check in software, I just look at
@@ -427,11 +400,7 @@ int rf233_setup(void) {
   /* Assign regtemp to regtemp to avoid compiler warnings */
   regtemp = regtemp;
   // Set up interrupts
-  gpio_interrupt_callback(interrupt_callback, NULL);
-  gpio_enable_input(RADIO_IRQ, PullNone);
-  gpio_clear(RADIO_IRQ);
-  gpio_enable_input(RADIO_IRQ, PullNone);
-  gpio_enable_interrupt(RADIO_IRQ, RisingEdge);
+  rf233_arch_set_irq_handler(interrupt_handler);
 
   /* Configure the radio using the default values except these. */
   trx_reg_write(RF233_REG_TRX_CTRL_1,      RF233_REG_TRX_CTRL_1_CONF);
@@ -617,100 +586,88 @@ static int rf233_transmit(void) {
 
 /*---------------------------------------------------------------------------*/
 /**
- * \brief      read a received frame out of the radio buffer
- * \param buf         pointer to where to copy received data
- * \param bufsize     Maximum size we can copy into bufsize
- * \return     Returns length of data read (> 0) if successful
- * \retval -1  Failed, was transmitting so FIFO is invalid
- * \retval -2  Failed, rx timed out (stuck in rx?)
- * \retval -3  Failed, too large frame for buffer
- * \retval -4  Failed, CRC/FCS failed (if USE_HW_FCS_CHECK is true)
+ * \brief      Read a received frame out of the radio into a pool buffer and
+ *             hand it to the receive callback.
+ *
+ * The frame is read in one SPI transaction: the command and length byte,
+ * then exactly as many bytes as the frame and its footer occupy. In RX safe
+ * mode the radio keeps the frame buffer until this read completes, and then
+ * goes on receiving by itself.
  */
-int rf233_read(void *buf, unsigned short bufsize) {
-  // uint8_t radio_state;
-  // uint8_t ed;       /* frame metadata */
-  uint8_t frame_len = 0;
-  uint8_t len       = 0;
-
-  PRINTF("RF233: Receiving.\n");
-
+static void rf233_rx_frame(void) {
   if (pending_frame == 0) {
     PRINTF("RF233: No frame pending, abort.\n");
-    return 0;
+    return;
   }
   pending_frame = 0;
 
-  /* get length of data in FIFO */
-  spi_hold_low();
-  spi_write_byte(TRX_CMD_FR);
-  frame_len = spi_write_byte(0);
+  rx_buf_t *buf = rx_buf_alloc();
+  if (buf == NULL) {
+    /* every buffer is held by the application: a short frame read drops the
+     * frame and lets the radio receive the next one */
+    uint8_t cmd[2] = { TRX_CMD_FR, 0 };
+    rf233_arch_transfer(cmd, cmd, 2, false);
+    rx_dropped++;
+    return;
+  }
 
-  if (frame_len <= 2 ||
-      (frame_len - 2) > bufsize) {
-    spi_release_low();
-    flush_buffer();
-    PRINTF("Frame (is not long enough or too large for buffer, abort.\n");
-    return 0;
+  buf->data[0] = TRX_CMD_FR;
+  rf233_arch_transfer(buf->data, buf->data, 2, true);
+  uint8_t frame_len = buf->data[1];
+  if (frame_len < HEADER_SIZE + FCS_SIZE || frame_len > MAX_PACKET_LEN) {
+    /* not a frame we understand: end the transaction to release the buffer */
+    rf233_arch_transfer(buf->data + 2, buf->data + 2, 1, false);
+    PRINTF("RF233: bad frame length %u, dropping.\n", frame_len);
+    rx_dropped++;
+    buf->busy = false;
+    return;
   }
+  rf233_arch_transfer(buf->data + 2, buf->data + 2, frame_len + FOOTER_SIZE, false);
 
-  len = frame_len - 2;
+  uint8_t rx_status = RX_PSDU(buf)[frame_len + 2];
+  if (!(rx_status & RX_STATUS_CRC_OK)) {
+    PRINTF("RF233: CRC failed, dropping.\n");
+    rx_dropped++;
+    buf->busy = false;
+    return;
+  }
 
-  if (len > bufsize) {
-    spi_release_low();
-    /* too large frame for the buffer, drop */
-    PRINTF("RF233: too large frame for buffer, dropping (%u > %u).\n", frame_len, bufsize);
+  const uint8_t *psdu = RX_PSDU(buf);
+  uint16_t pan  = psdu[3] | (psdu[4] << 8);
+  uint16_t dest = psdu[5] | (psdu[6] << 8);
+  uint16_t src  = psdu[7] | (psdu[8] << 8);
+  PRINTF("RF233: frame of %u bytes from %x.\n", frame_len, src);
 
-    return 0;
+  int keep = 0;
+  if (set_callback) {
+    keep = rx_callback(RX_PAYLOAD(buf), frame_len - HEADER_SIZE - FCS_SIZE, src, dest, pan);
   }
-
-  /* read out the data into the buffer, disregarding the length and metadata bytes */
-  // spi_read_write_sync(wbuf, (char*)buf, len - 1);
-  // TODO len or len - 1
-  for (uint8_t i = 0; i < len; i++) {
-    uint8_t val = spi_write_byte(0);
-    ((uint8_t*)buf)[i] = val;
-    PRINTF("%02x ", ((uint8_t*)buf)[i]);
-    if (i % 10 == 9) {
-      PRINTF("\n");
-    }
+  if (!keep) {
+    buf->busy = false;
   }
+}
 
-  PRINTF("\n");
-  spi_release_low();
-
-  // trx_sram_read(1, (uint8_t *)buf, len);
-  if (len >= 10) {
-    header_t* header = (header_t*)buf;
-    PRINTF("  FCF: %x\n", header->fcf);
-    PRINTF("  SEQ: %x\n", header->seq);
-    PRINTF("  PAN: %x\n", header->pan);
-    PRINTF("  DST: %x\n", header->dest);
-    PRINTF("  SRC: %x\n", header->src);
-
-    // skip first 9 bytes of header
-    for (int i = 0; i < PACKETBUF_SIZE; i++) {
-      recv_data[i] = 0;
-    }
-    for (int i = 0; i < len; i++) {
-      recv_data[i] = header->payload[i];
-    }
-    // Call user callback function
-    if (set_callback) {
-      rx_callback(recv_data, len, header->src, header->dest, header->pan);
-    }
+int rf233_rx_release(void* payload) {
+  rx_buf_t *buf = rx_buf_from_payload(payload);
+  if (buf == NULL || !buf->busy) {
+    return -1;
   }
-  // PRINTF("RF233: Final state = %s = %i\n", state_str(rf233_status()), rf233_status());
+  buf->busy = false;
+  return 0;
+}
 
-  flush_buffer();
+uint8_t rf233_rx_lqi(const void* payload) {
+  rx_buf_t *buf = rx_buf_from_payload(payload);
+  return buf ? RX_PSDU(buf)[buf->data[1]] : 0;
+}
 
-  rf233_off();
-  delay_ms(100);
-  rf233_sleep();
-  delay_ms(100);
-  rf233_on();
-  delay_ms(100);
+uint8_t rf233_rx_ed(const void* payload) {
+  rx_buf_t *buf = rx_buf_from_payload(payload);
+  return buf ? RX_PSDU(buf)[buf->data[1] + 1] : 0;
+}
 
-  return len;
+uint32_t rf233_rx_dropped(void) {
+  return rx_dropped;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -805,7 +762,7 @@ int on(void) {
   /* Check whether radio is in sleep */
   if (sleep_on) {
     /* Wake the radio. It'll move to TRX_OFF state */
-    gpio_clear(RADIO_SLP);
+    rf233_arch_set_slp_tr(false);
     delay_ms(1);
     PRINTF("RF233: Wake from sleep\n");
     sleep_on = 0;
@@ -855,24 +812,12 @@ int rf233_sleep(void) {
     /* Turn off the Radio */
     rf233_off();
     /* Set the SLP_PIN to high */
-    gpio_set(RADIO_SLP);
+    rf233_arch_set_slp_tr(true);
   }
 
   return 0;
 }
 
-/*---------------------------------------------------------------------------*/
-/*
- * Crude way of flushing the Tx/Rx FIFO: write the first byte as 0, indicating
- * a zero-length frame in the buffer. This is interpreted by the driver as an
- * empty buffer.
- */
-static void flush_buffer(void) {
-  /* NB: tentative untested implementation */
-  uint8_t temp = 0;
-  trx_frame_write(&temp, 1);
-}
-
 void goto_sleep(void) {}
 
 void wake_from_sleep(void) {
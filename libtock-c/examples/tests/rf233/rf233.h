@@ -38,8 +38,17 @@
 
 int rf233_init(uint16_t channel, uint16_t from_addr, uint16_t pan_id); 
 int rf233_tx_data(uint16_t to_addr, void* payload, int payload_len); 
+// The callback gets the payload, its length and the source, destination and
+// PAN of each frame. The payload points into the driver's receive pool; if
+// the callback returns nonzero it keeps the buffer, and must pass the
+// payload to rf233_rx_release() once done with it.
 int rf233_rx_data(int (*callback)(void*, int, uint16_t, uint16_t, uint16_t)); 
-// TODO assume callback passes buffer that is long enough? 
+int rf233_rx_release(void* payload);
+// Link quality and energy detect level of a frame handed to the callback.
+uint8_t rf233_rx_lqi(const void* payload);
+uint8_t rf233_rx_ed(const void* payload);
+// Frames dropped because every buffer was held, or the frame was corrupt.
+uint32_t rf233_rx_dropped(void);
 
 // TODO moved to .h 
 int rf233_on(void);
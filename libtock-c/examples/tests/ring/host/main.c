@@ -0,0 +1,213 @@
+// Host stress test for ring.h: a producer thread and a consumer thread push
+// and pop as fast as they can through small rings, so the two sides race
+// on every slot. Each stream carries sequence numbers, and the consumer
+// checks that every element arrives once, in order and intact.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <ring.h>
+
+#define ELEMENTS 2000000u
+
+// ***** Checks *****
+
+static int failures;
+
+#define CHECK(_c) check((_c), #_c, __LINE__)
+
+static bool check(bool ok, const char* what, int line) {
+  if (!ok) {
+    printf("  line %d: %s\n", line, what);
+    failures++;
+  }
+  return ok;
+}
+
+// xorshift, one state per thread.
+static uint32_t next_rand(uint32_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static double seconds_since(const struct timespec* start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// ***** Streams *****
+
+// Elements wider than a word, so a torn copy shows up as a mismatch.
+typedef struct {
+  uint32_t seq;
+  uint32_t check;
+  uint8_t fill[8];
+} element_t;
+
+static element_t make_element(uint32_t seq) {
+  element_t e = { seq, ~seq * 2654435761u, { 0 } };
+  memset(e.fill, (uint8_t) seq, sizeof(e.fill));
+  return e;
+}
+
+static bool element_ok(const element_t* e, uint32_t seq) {
+  element_t expected = make_element(seq);
+  return memcmp(e, &expected, sizeof(expected)) == 0;
+}
+
+// How each side moves elements: one at a time, in uneven batches, or in
+// place through reserve/commit and peek/release.
+typedef enum { SINGLE, BATCH, IN_PLACE } mode_t_;
+
+static const char* mode_names[] = { "push/pop", "write/read", "reserve/peek" };
+
+typedef struct {
+  ring_t ring;
+  mode_t_ mode;
+  bool stop;  // Set by the consumer when it is done.
+  element_t slots[16];
+} stream_t;
+
+static void* producer(void* arg) {
+  stream_t* s    = (stream_t*) arg;
+  uint32_t state = 12345;
+  element_t batch[7];
+  for (uint32_t seq = 0; seq < ELEMENTS && !__atomic_load_n(&s->stop, __ATOMIC_RELAXED); ) {
+    size_t n = 0;
+    switch (s->mode) {
+      case SINGLE: {
+        element_t e = make_element(seq);
+        n = ring_push(&s->ring, &e) ? 1 : 0;
+        break;
+      }
+      case BATCH: {
+        size_t want = 1 + next_rand(&state) % 7;
+        if (want > ELEMENTS - seq) want = ELEMENTS - seq;
+        for (size_t i = 0; i < want; i++) batch[i] = make_element(seq + i);
+        n = ring_write(&s->ring, batch, want);
+        break;
+      }
+      case IN_PLACE: {
+        void* slots;
+        n = ring_reserve(&s->ring, &slots);
+        size_t want = 1 + next_rand(&state) % 7;
+        if (n > want) n = want;
+        if (n > ELEMENTS - seq) n = ELEMENTS - seq;
+        for (size_t i = 0; i < n; i++) ((element_t*) slots)[i] = make_element(seq + i);
+        ring_commit(&s->ring, n);
+        break;
+      }
+    }
+    if (n == 0) sched_yield();
+    seq += n;
+  }
+  return NULL;
+}
+
+// Returns the number of elements that arrived as sent.
+static uint32_t consume(stream_t* s) {
+  uint32_t state = 54321;
+  element_t batch[5];
+  uint32_t seq = 0;
+  while (seq < ELEMENTS) {
+    size_t n = 0;
+    bool ok  = true;
+    switch (s->mode) {
+      case SINGLE:
+        if (ring_pop(&s->ring, &batch[0])) {
+          n  = 1;
+          ok = element_ok(&batch[0], seq);
+        }
+        break;
+      case BATCH:
+        n = ring_read(&s->ring, batch, 1 + next_rand(&state) % 5);
+        for (size_t i = 0; i < n; i++) ok &= element_ok(&batch[i], seq + i);
+        break;
+      case IN_PLACE: {
+        void* slots;
+        n = ring_peek(&s->ring, 0, &slots);
+        size_t want = 1 + next_rand(&state) % 5;
+        if (n > want) n = want;
+        for (size_t i = 0; i < n; i++) ok &= element_ok(&((element_t*) slots)[i], seq + i);
+        ring_release(&s->ring, n);
+        break;
+      }
+    }
+    if (!ok) return seq;
+    if (n == 0) sched_yield();
+    seq += n;
+  }
+  return seq;
+}
+
+static void run_stream(mode_t_ mode, uint32_t start) {
+  static stream_t s;
+  memset(&s, 0, sizeof(s));
+  s.mode = mode;
+  CHECK(ring_init(&s.ring, s.slots, sizeof(element_t), 16) == TOCK_SUCCESS);
+  // Start near the wrap of the 32-bit indices, as after a long run.
+  s.ring.head = start;
+  s.ring.tail = start;
+
+  struct timespec begin;
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, producer, &s) != 0) {
+    printf("  cannot start the producer thread\n");
+    failures++;
+    return;
+  }
+  uint32_t received = consume(&s);
+  double seconds    = seconds_since(&begin);
+  // The producer may be waiting for room after a mismatch.
+  __atomic_store_n(&s.stop, true, __ATOMIC_RELAXED);
+  pthread_join(thread, NULL);
+
+  printf("  %-12s from index 0x%08x: %u of %u elements in order, %.1f M/s\n",
+         mode_names[mode], start, received, ELEMENTS, ELEMENTS / seconds / 1e6);
+  CHECK(received == ELEMENTS);
+  CHECK(ring_count(&s.ring) == 0);
+  CHECK(s.ring.tail == start + ELEMENTS);
+}
+
+// ***** Shared memory *****
+
+// A ring and its slots copied elsewhere, as another process would see them
+// at a different address, still hold the same elements.
+static void test_relocated(void) {
+  printf("relocated ring\n");
+  static struct {
+    ring_t ring;
+    uint32_t slots[8];
+  } a, b;
+  CHECK(ring_init(&a.ring, a.slots, sizeof(uint32_t), 8) == TOCK_SUCCESS);
+  for (uint32_t i = 0; i < 5; i++) CHECK(ring_push(&a.ring, &i));
+  memcpy(&b, &a, sizeof(a));
+  uint32_t v;
+  for (uint32_t i = 0; i < 5; i++) CHECK(ring_pop(&b.ring, &v) && v == i);
+  CHECK(!ring_pop(&b.ring, &v));
+  CHECK(ring_count(&a.ring) == 5);
+}
+
+int main(void) {
+  test_relocated();
+
+  printf("threads\n");
+  for (mode_t_ mode = SINGLE; mode <= IN_PLACE; mode++) {
+    run_stream(mode, 0);
+    run_stream(mode, 0xFFFFFFFF - ELEMENTS / 2);
+  }
+
+  if (failures > 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <internal/alarm.h>
+#include <ring.h>
+#include <timer.h>
+
+#define ELEMS 100000
+#define CALLBACK_ELEMS 2000
+#define BATCH 7
+
+static ring_t seq_ring;
+static uint32_t seq_slots[16];
+static uint32_t seq_next;
+static uint32_t seq_full;
+
+// Pushes the next few sequence numbers from a timer callback, counting the
+// pushes that find the ring full.
+static void producer_cb(__attribute__ ((unused)) int now,
+                        __attribute__ ((unused)) int arg1,
+                        __attribute__ ((unused)) int arg2,
+                        __attribute__ ((unused)) void* ud) {
+  for (int i = 0; i < BATCH && seq_next < CALLBACK_ELEMS; i++) {
+    if (!ring_push(&seq_ring, &seq_next)) {
+      seq_full++;
+      return;
+    }
+    seq_next++;
+  }
+}
+
+static bool test_init(void) {
+  ring_t ring;
+  uint32_t slots[8];
+  return ring_init(&ring, slots, sizeof(uint32_t), 6) == TOCK_EINVAL &&
+         ring_init(&ring, slots, sizeof(uint32_t), 0) == TOCK_EINVAL &&
+         ring_init(&ring, slots, sizeof(uint32_t), 8) == TOCK_SUCCESS &&
+         ring_capacity(&ring) == 8 && ring_count(&ring) == 0 && ring_space(&ring) == 8;
+}
+
+// Fills and drains the ring in every phase of the indices against the end of
+// the slots, including across the 32-bit wrap of the free-running indices.
+static bool test_wrap(void) {
+  ring_t ring;
+  uint32_t slots[8];
+  ring_init(&ring, slots, sizeof(uint32_t), 8);
+  ring.head = ring.tail = 0xfffffff0;
+
+  uint32_t in = 0, out = 0;
+  for (int round = 0; round < 64; round++) {
+    uint32_t n = 1 + round % 8;
+    for (uint32_t i = 0; i < n; i++) {
+      if (!ring_push(&ring, &in)) return false;
+      in++;
+    }
+    if (ring_count(&ring) != n) return false;
+    if (n == 8 && ring_push(&ring, &in)) return false;
+    for (uint32_t i = 0; i < n; i++) {
+      uint32_t value;
+      if (!ring_pop(&ring, &value) || value != out) return false;
+      out++;
+    }
+    uint32_t value;
+    if (ring_pop(&ring, &value)) return false;
+  }
+  return true;
+}
+
+// Writes and reads bytes in uneven pieces, in place and by copying.
+static bool test_bulk(void) {
+  static ring_t ring;
+  static uint8_t slots[64];
+  ring_init(&ring, slots, 1, 64);
+
+  uint8_t in = 0, out = 0;
+  for (int round = 0; round < 1000; round++) {
+    uint8_t buf[50];
+    size_t n = 1 + (round * 13) % 50;
+    for (size_t i = 0; i < n; i++) buf[i] = in + i;
+    size_t written = ring_write(&ring, buf, n);
+    in += written;
+
+    // Read half through peek/release and the rest by copying.
+    void* slot;
+    size_t avail = ring_peek(&ring, 0, &slot);
+    size_t half  = avail / 2;
+    for (size_t i = 0; i < half; i++) {
+      if (((uint8_t*) slot)[i] != out++) return false;
+    }
+    ring_release(&ring, half);
+    size_t read = ring_read(&ring, buf, sizeof(buf));
+    for (size_t i = 0; i < read; i++) {
+      if (buf[i] != out++) return false;
+    }
+  }
+  return ring_count(&ring) == 0 && in == out;
+}
+
+// Pops sequence numbers pushed by a timer callback until all have arrived.
+static bool test_callback(void) {
+  ring_init(&seq_ring, seq_slots, sizeof(uint32_t), 16);
+  tock_timer_t timer;
+  timer_every(1, producer_cb, NULL, &timer);
+
+  uint32_t expect = 0;
+  while (expect < CALLBACK_ELEMS) {
+    uint32_t value;
+    if (!ring_pop(&seq_ring, &value)) {
+      yield();
+      continue;
+    }
+    if (value != expect) {
+      timer_cancel(&timer);
+      return false;
+    }
+    expect++;
+  }
+  timer_cancel(&timer);
+  printf("[RING] %lu elements from callbacks, %lu pushes found the ring full\n",
+         expect, seq_full);
+  return true;
+}
+
+// Moves ELEMS words through the ring and through a queue indexed modulo a
+// capacity that is not a power of two, as libtock's queues were.
+static bool test_throughput(void) {
+  static ring_t ring;
+  static uint32_t slots[16];
+  ring_init(&ring, slots, sizeof(uint32_t), 16);
+
+  uint32_t sum   = 0;
+  uint32_t start = alarm_read();
+  for (uint32_t i = 0; i < ELEMS; i++) {
+    uint32_t value;
+    ring_push(&ring, &i);
+    ring_pop(&ring, &value);
+    sum += value;
+  }
+  uint32_t ring_ticks = alarm_read() - start;
+
+  static uint32_t queue[15];
+  volatile int head = 0, tail = 0;
+  uint32_t queue_sum = 0;
+  start = alarm_read();
+  for (uint32_t i = 0; i < ELEMS; i++) {
+    queue[tail] = i;
+    tail        = (tail + 1) % 15;
+    queue_sum  += queue[head];
+    head        = (head + 1) % 15;
+  }
+  uint32_t queue_ticks = alarm_read() - start;
+
+  printf("[RING] %d push/pop: ring %lu ticks, modulo queue %lu ticks\n",
+         ELEMS, ring_ticks, queue_ticks);
+  return sum == queue_sum;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[RING] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  bool ok = true;
+  ok &= run("init", test_init);
+  ok &= run("wrap", test_wrap);
+  ok &= run("bulk", test_bulk);
+  ok &= run("callback", test_callback);
+  ok &= run("throughput", test_throughput);
+  if (!ok) {
+    exit(-1);
+  }
+
+  printf("[RING] alarm %u Hz\n", alarm_internal_frequency());
+  return 0;
+}
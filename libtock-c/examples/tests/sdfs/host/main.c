@@ -0,0 +1,473 @@
+// Host test for sdfs: runs the filesystem against a block device backed by
+// a file, and cuts the power at random points to check that every file
+// comes back as it was at its last sync or at a later state it passed
+// through, and that the filesystem stays consistent.
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sdfs.h>
+
+#define IMAGE "build/sdfs_host_test.img"
+
+// ***** File-backed block device *****
+
+// Operations complete when the filesystem waits for them, as with the SD
+// card, so a buffer used before its operation completes shows up as bad
+// data.
+static struct {
+  FILE* file;
+  bool pending;
+  bool write;
+  uint32_t block;
+  uint8_t* buffer;
+  sdfs_io_t* io;
+  // Writes until the power is cut, or 0 for never.
+  uint32_t cut_after;
+  uint32_t* wear;
+  uint32_t writes;
+} dev;
+
+static jmp_buf power_cut;
+
+static int dev_read(sdfs_device_t* device, uint32_t block, uint8_t* buffer, sdfs_io_t* io) {
+  if (dev.pending || block >= device->block_count) return TOCK_EINVAL;
+  dev.pending = true;
+  dev.write   = false;
+  dev.block   = block;
+  dev.buffer  = buffer;
+  dev.io      = io;
+  return TOCK_SUCCESS;
+}
+
+static int dev_write(sdfs_device_t* device, uint32_t block, const uint8_t* buffer,
+                     sdfs_io_t* io) {
+  int err = dev_read(device, block, (uint8_t*) buffer, io);
+  dev.write = true;
+  return err;
+}
+
+static void dev_wait(__attribute__ ((unused)) sdfs_device_t* device, sdfs_io_t* io) {
+  if (!dev.pending || io != dev.io) {
+    printf("wait without an operation\n");
+    exit(1);
+  }
+  dev.pending = false;
+  fseek(dev.file, (long) dev.block * SDFS_BLOCK_SIZE, SEEK_SET);
+
+  if (dev.write) {
+    if (dev.cut_after > 0 && --dev.cut_after == 0) {
+      // Tear the block: nothing, the start of it, or the start followed by
+      // garbage reaches the card.
+      int tear = rand() % 3;
+      if (tear > 0) {
+        fwrite(dev.buffer, 1, SDFS_BLOCK_SIZE / 2, dev.file);
+      }
+      if (tear == 2) {
+        uint8_t garbage[SDFS_BLOCK_SIZE / 2];
+        for (size_t i = 0; i < sizeof(garbage); i++) garbage[i] = rand();
+        fwrite(garbage, 1, sizeof(garbage), dev.file);
+      }
+      fflush(dev.file);
+      longjmp(power_cut, 1);
+    }
+    fwrite(dev.buffer, 1, SDFS_BLOCK_SIZE, dev.file);
+    dev.wear[dev.block]++;
+    dev.writes++;
+  } else if (fread(dev.buffer, 1, SDFS_BLOCK_SIZE, dev.file) != SDFS_BLOCK_SIZE) {
+    memset(dev.buffer, 0, SDFS_BLOCK_SIZE);
+  }
+  io->result = TOCK_SUCCESS;
+  io->done   = true;
+}
+
+static sdfs_device_t device = { 0, dev_read, dev_write, dev_wait, NULL };
+
+static void dev_create(uint32_t block_count) {
+  if (dev.file != NULL) fclose(dev.file);
+  free(dev.wear);
+  memset(&dev, 0, sizeof(dev));
+  dev.file = fopen(IMAGE, "w+b");
+  if (dev.file == NULL) {
+    perror(IMAGE);
+    exit(1);
+  }
+  dev.wear = calloc(block_count, sizeof(uint32_t));
+  device.block_count = block_count;
+}
+
+// ***** Checks *****
+
+static int failures;
+
+#define CHECK(_c) check((_c), #_c, __LINE__)
+
+static bool check(bool ok, const char* what, int line) {
+  if (!ok) {
+    printf("  line %d: %s\n", line, what);
+    failures++;
+  }
+  return ok;
+}
+
+// Byte `offset` of the data written to a file in the given epoch (each
+// truncation or recreation starts a new epoch).
+static uint8_t stream_byte(int file, uint32_t epoch, uint32_t offset) {
+  uint32_t x = offset * 2654435761u + epoch * 40503u + file * 97u;
+  return (x >> 13) ^ (x >> 24);
+}
+
+static void stream(int file, uint32_t epoch, uint32_t offset, uint8_t* buffer, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buffer[i] = stream_byte(file, epoch, offset + i);
+  }
+}
+
+// Walks every file's tree, checking that blocks are in range, used once,
+// and that the tree holds exactly the blocks the size needs.
+static uint8_t* seen;
+
+static bool fsck_block(sdfs_t* fs, uint32_t block) {
+  if (block < 2 || block >= fs->block_count || seen[block]) return false;
+  seen[block] = 1;
+  return true;
+}
+
+static uint32_t fsck_tree(sdfs_t* fs, uint32_t block, uint32_t height, bool* ok) {
+  if (block == 0) return 0;
+  if (!fsck_block(fs, block)) {
+    *ok = false;
+    return 0;
+  }
+  if (height == 0) return 1;
+
+  uint32_t pointers[SDFS_BLOCK_SIZE / 4];
+  fseek(dev.file, (long) block * SDFS_BLOCK_SIZE, SEEK_SET);
+  if (fread(pointers, 1, SDFS_BLOCK_SIZE, dev.file) != SDFS_BLOCK_SIZE) {
+    *ok = false;
+    return 0;
+  }
+  uint32_t data = 0;
+  for (int i = 0; i < SDFS_BLOCK_SIZE / 4; i++) {
+    data += fsck_tree(fs, pointers[i], height - 1, ok);
+  }
+  return data;
+}
+
+static bool fsck(sdfs_t* fs) {
+  bool ok = true;
+  seen = calloc(fs->block_count, 1);
+  ok &= fsck_block(fs, fs->meta[0]) && fsck_block(fs, fs->meta[1]);
+  for (int i = 0; i < SDFS_MAX_FILES; i++) {
+    sdfs_entry_t* entry = &fs->files[i];
+    if (entry->name[0] == '\0') continue;
+    uint32_t blocks = fsck_tree(fs, entry->root, entry->height, &ok);
+    ok &= blocks == (entry->size + SDFS_BLOCK_SIZE - 1) / SDFS_BLOCK_SIZE;
+  }
+  free(seen);
+  return ok;
+}
+
+// Reads a whole file in pieces of random size and compares it with the
+// stream of `epoch`.
+static bool read_matches(sdfs_t* fs, const char* name, int index, uint32_t epoch) {
+  sdfs_file_t file;
+  if (sdfs_open(fs, &file, name, 0) < 0) return false;
+  uint32_t size = sdfs_size(&file);
+  uint32_t pos  = 0;
+  uint8_t buffer[1500], expected[1500];
+  while (pos < size) {
+    int len = sdfs_read(&file, buffer, 1 + rand() % sizeof(buffer));
+    if (len <= 0) return false;
+    stream(index, epoch, pos, expected, len);
+    if (memcmp(buffer, expected, len) != 0) return false;
+    pos += len;
+  }
+  return sdfs_read(&file, buffer, 1) == 0;
+}
+
+// ***** Functional tests *****
+
+static sdfs_t fs;
+static sdfs_cache_block_t cache[8];
+
+static void write_stream(sdfs_file_t* file, int index, uint32_t epoch, size_t len,
+                         size_t piece) {
+  uint8_t buffer[4096];
+  size_t done = 0;
+  while (done < len) {
+    size_t n = len - done < piece ? len - done : piece;
+    stream(index, epoch, sdfs_size(file), buffer, n);
+    if (!CHECK(sdfs_write(file, buffer, n) == (int) n)) return;
+    done += n;
+  }
+}
+
+static void test_basic(void) {
+  printf("basic\n");
+  dev_create(4096);
+  CHECK(sdfs_mount(&fs, &device, cache, 4) == TOCK_EINVAL);
+  CHECK(sdfs_format(&fs, &device, cache, 4) == TOCK_SUCCESS);
+
+  sdfs_file_t file;
+  CHECK(sdfs_open(&fs, &file, "missing", 0) == TOCK_EINVAL);
+  CHECK(sdfs_open(&fs, &file, "name-that-is-too-long", SDFS_CREATE) == TOCK_EINVAL);
+
+  // Grows the tree to two levels of index blocks.
+  CHECK(sdfs_open(&fs, &file, "big", SDFS_CREATE) == TOCK_SUCCESS);
+  write_stream(&file, 0, 0, 1000000, 3000);
+  CHECK(sdfs_close(&file) == TOCK_SUCCESS);
+  CHECK(fs.files[file.file].height == 2);
+  CHECK(read_matches(&fs, "big", 0, 0));
+
+  // Overwrite the middle of the synced file.
+  CHECK(sdfs_open(&fs, &file, "big", 0) == TOCK_SUCCESS);
+  CHECK(sdfs_seek(&file, 300000) == TOCK_SUCCESS);
+  uint8_t patch[2000];
+  stream(0, 1, 300000, patch, sizeof(patch));
+  CHECK(sdfs_write(&file, patch, sizeof(patch)) == sizeof(patch));
+  CHECK(sdfs_seek(&file, 2000000) == TOCK_EINVAL);
+  CHECK(sdfs_unmount(&fs) == TOCK_SUCCESS);
+
+  CHECK(sdfs_mount(&fs, &device, cache, 3) == TOCK_SUCCESS);
+  CHECK(fsck(&fs));
+  CHECK(sdfs_stat(&fs, "big") == 1000000);
+  CHECK(sdfs_open(&fs, &file, "big", 0) == TOCK_SUCCESS);
+  uint8_t buffer[4000], expected[4000];
+  CHECK(sdfs_seek(&file, 299000) == TOCK_SUCCESS);
+  CHECK(sdfs_read(&file, buffer, sizeof(buffer)) == sizeof(buffer));
+  stream(0, 0, 299000, expected, sizeof(expected));
+  memcpy(expected + 1000, patch, sizeof(patch));
+  CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0);
+
+  // Fill the device, then free space by removing a file.
+  sdfs_file_t fill;
+  CHECK(sdfs_open(&fs, &fill, "fill", SDFS_CREATE | SDFS_APPEND) == TOCK_SUCCESS);
+  memset(buffer, 0xA5, sizeof(buffer));
+  int err;
+  while ((err = sdfs_write(&fill, buffer, sizeof(buffer))) > 0) {}
+  CHECK(err == TOCK_ENOMEM);
+  CHECK(sdfs_remove(&fs, "big") == TOCK_SUCCESS);
+  CHECK(sdfs_write(&fill, buffer, sizeof(buffer)) == sizeof(buffer));
+  CHECK(sdfs_close(&fill) == TOCK_SUCCESS);
+  CHECK(fsck(&fs));
+  CHECK(sdfs_stat(&fs, "big") == TOCK_EINVAL);
+}
+
+// A tree three levels of index blocks deep (over 8 MB).
+static void test_deep(void) {
+  printf("deep tree\n");
+  dev_create(20000);
+  CHECK(sdfs_format(&fs, &device, cache, 4) == TOCK_SUCCESS);
+  sdfs_file_t file;
+  CHECK(sdfs_open(&fs, &file, "deep", SDFS_CREATE) == TOCK_SUCCESS);
+  write_stream(&file, 1, 0, 8500000, 4096);
+  CHECK(sdfs_close(&file) == TOCK_SUCCESS);
+  CHECK(fs.files[file.file].height == 3);
+  CHECK(sdfs_mount(&fs, &device, cache, 4) == TOCK_SUCCESS);
+  CHECK(fsck(&fs));
+  CHECK(read_matches(&fs, "deep", 1, 0));
+}
+
+// Small appends are gathered into whole blocks, and sequential reads read
+// ahead.
+static void test_cache(void) {
+  printf("cache\n");
+  dev_create(4096);
+  CHECK(sdfs_format(&fs, &device, cache, 4) == TOCK_SUCCESS);
+  sdfs_file_t file;
+  CHECK(sdfs_open(&fs, &file, "log", SDFS_CREATE | SDFS_APPEND) == TOCK_SUCCESS);
+
+  uint32_t writes = fs.block_writes;
+  write_stream(&file, 2, 0, 256 * 1024, 16);
+  CHECK(sdfs_sync(&file) == TOCK_SUCCESS);
+  writes = fs.block_writes - writes;
+  printf("  256 kB in 16 byte appends: %u block writes\n", writes);
+  CHECK(writes < 512 + 16);
+
+  CHECK(sdfs_mount(&fs, &device, cache, 4) == TOCK_SUCCESS);
+  CHECK(read_matches(&fs, "log", 2, 0));
+  printf("  read 512 blocks: %u reads, %u read ahead\n", fs.block_reads, fs.prefetches);
+  CHECK(fs.prefetches >= 500);
+}
+
+// ***** Power cuts *****
+
+#define FILES 3
+#define CANDIDATES 64
+
+// What a file may hold after a power cut: absent, or a prefix of the
+// stream of `epoch` between `min` and `max` bytes long.
+typedef struct {
+  bool present;
+  uint32_t epoch;
+  uint32_t min;
+  uint32_t max;
+} candidate_t;
+
+static struct {
+  candidate_t candidates[CANDIDATES];
+  int count;
+} model[FILES];
+
+static uint32_t next_epoch = 1;
+
+// Bytes of file data checked after power cuts.
+static uint32_t verified;
+
+static const char* names[FILES] = { "log0", "log1", "log2" };
+
+static candidate_t* current(int f) {
+  return &model[f].candidates[model[f].count - 1];
+}
+
+static void model_push(int f, candidate_t candidate) {
+  if (model[f].count == CANDIDATES) {
+    printf("too many states\n");
+    exit(1);
+  }
+  model[f].candidates[model[f].count++] = candidate;
+}
+
+// After a sync only the current state is possible.
+static void model_synced(void) {
+  for (int f = 0; f < FILES; f++) {
+    candidate_t now = *current(f);
+    now.min         = now.max;
+    model[f].candidates[0] = now;
+    model[f].count         = 1;
+  }
+}
+
+static bool file_matches(int f) {
+  int size = sdfs_stat(&fs, names[f]);
+  for (int i = 0; i < model[f].count; i++) {
+    candidate_t* c = &model[f].candidates[i];
+    if (!c->present) {
+      if (size == TOCK_EINVAL) {
+        model[f].candidates[0] = *c;
+        model[f].count         = 1;
+        return true;
+      }
+      continue;
+    }
+    if (size < 0 || (uint32_t) size < c->min || (uint32_t) size > c->max) continue;
+    if (read_matches(&fs, names[f], f, c->epoch)) {
+      verified += size;
+      model[f].candidates[0] = (candidate_t) { true, c->epoch, size, size };
+      model[f].count         = 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void open_current(int f, sdfs_file_t* file, int flags) {
+  if (!current(f)->present || (flags & SDFS_TRUNCATE)) {
+    model_push(f, (candidate_t) { true, next_epoch++, 0, 0 });
+  }
+  if (sdfs_open(&fs, file, names[f], flags | SDFS_CREATE) < 0) {
+    printf("open failed\n");
+    exit(1);
+  }
+}
+
+static void step(void) {
+  int f = rand() % FILES;
+  int action = rand() % 100;
+  sdfs_file_t file;
+
+  if (action < 70) {
+    open_current(f, &file, SDFS_APPEND);
+    uint8_t buffer[1500];
+    size_t len = 1 + rand() % sizeof(buffer);
+    stream(f, current(f)->epoch, sdfs_size(&file), buffer, len);
+    int err = sdfs_write(&file, buffer, len);
+    uint32_t size = sdfs_size(&file);
+    if (size > current(f)->max) current(f)->max = size;
+    if (err == TOCK_ENOMEM) {
+      // Full: make room like a logger would.
+      model_push(f, (candidate_t) { false, 0, 0, 0 });
+      if (sdfs_remove(&fs, names[f]) == TOCK_SUCCESS) model_synced();
+    } else if (err < 0) {
+      printf("write failed: %d\n", err);
+      exit(1);
+    }
+  } else if (action < 85) {
+    open_current(f, &file, 0);
+    if (sdfs_sync(&file) == TOCK_SUCCESS) model_synced();
+  } else if (action < 90) {
+    open_current(f, &file, SDFS_TRUNCATE);
+  } else if (action < 93) {
+    if (current(f)->present) {
+      model_push(f, (candidate_t) { false, 0, 0, 0 });
+      if (sdfs_remove(&fs, names[f]) == TOCK_SUCCESS) model_synced();
+    }
+  } else if (current(f)->present) {
+    CHECK(read_matches(&fs, names[f], f, current(f)->epoch));
+  }
+}
+
+static void test_power_cuts(int cuts) {
+  printf("power cuts\n");
+  dev_create(1024);
+  CHECK(sdfs_format(&fs, &device, cache, 4) == TOCK_SUCCESS);
+  for (int f = 0; f < FILES; f++) {
+    model[f].candidates[0] = (candidate_t) { false, 0, 0, 0 };
+    model[f].count         = 1;
+  }
+
+  // Kept out of registers across the longjmp.
+  static uint32_t steps;
+  for (int cut = 0; cut < cuts; cut++) {
+    dev.cut_after = 1 + rand() % 600;
+    if (setjmp(power_cut) == 0) {
+      while (true) {
+        step();
+        steps++;
+      }
+    }
+
+    // Power is back.
+    dev.pending   = false;
+    dev.cut_after = 0;
+    size_t cache_blocks = 2 + rand() % 7;
+    if (!CHECK(sdfs_mount(&fs, &device, cache, cache_blocks) == TOCK_SUCCESS)) return;
+    if (!CHECK(fsck(&fs))) return;
+    for (int f = 0; f < FILES; f++) {
+      if (!file_matches(f)) {
+        printf("  cut %d: %s does not match any state since its last sync\n", cut, names[f]);
+        failures++;
+        return;
+      }
+    }
+  }
+
+  uint32_t most = 0, total = 0;
+  for (uint32_t i = 0; i < device.block_count; i++) {
+    if (dev.wear[i] > most) most = dev.wear[i];
+    total += dev.wear[i];
+  }
+  printf("  %d cuts in %u steps, %u kB checked after them\n", cuts, steps, verified / 1024);
+  printf("  %u block writes, %u on the most written block (%u on average)\n", total, most,
+         total / device.block_count);
+}
+
+int main(void) {
+  srand(1);
+  test_basic();
+  test_deep();
+  test_cache();
+  test_power_cuts(1000);
+
+  fclose(dev.file);
+  remove(IMAGE);
+  if (failures > 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all tests passed\n");
+  return 0;
+}
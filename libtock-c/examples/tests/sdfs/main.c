@@ -0,0 +1,152 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <internal/alarm.h>
+#include <sdfs.h>
+#include <timer.h>
+
+// The filesystem takes 4 MB of the card from 32 MB on, out of the way of
+// the partition table and the start of a FAT partition.
+#define FIRST_BLOCK 65536
+#define BLOCK_COUNT 8192
+
+#define RECORDS 2000
+#define SYNC_EVERY 100
+
+typedef struct {
+  uint32_t seq;
+  uint32_t check;
+  uint8_t payload[24];
+} record_t;
+
+static sdfs_device_t sd;
+static sdfs_t fs;
+static sdfs_cache_block_t cache[4];
+
+static void make_record(record_t* record, uint32_t seq) {
+  record->seq   = seq;
+  record->check = seq * 2654435761u;
+  memset(record->payload, seq, sizeof(record->payload));
+}
+
+static uint32_t boot_count(void) {
+  sdfs_file_t file;
+  uint32_t boots = 0;
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_open(&fs, &file, "boots", SDFS_CREATE));
+  sdfs_read(&file, &boots, sizeof(boots));
+  boots++;
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_seek(&file, 0));
+  TOCK_EXPECT(sizeof(boots), sdfs_write(&file, &boots, sizeof(boots)));
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_close(&file));
+  return boots;
+}
+
+// Appends records one at a time, syncing every SYNC_EVERY.
+static bool test_write(void) {
+  sdfs_file_t file;
+  record_t record;
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_open(&fs, &file, "log", SDFS_CREATE | SDFS_TRUNCATE |
+                                      SDFS_APPEND));
+
+  uint32_t writes = fs.block_writes;
+  uint32_t start  = alarm_read();
+  for (uint32_t i = 0; i < RECORDS; i++) {
+    make_record(&record, i);
+    int len = sdfs_write(&file, &record, sizeof(record));
+    if (len != sizeof(record)) {
+      printf("[SDFS] write %lu: %s\n", i, tock_strerror(len));
+      return false;
+    }
+    if ((i + 1) % SYNC_EVERY == 0 && sdfs_sync(&file) != TOCK_SUCCESS) return false;
+  }
+  if (sdfs_close(&file) != TOCK_SUCCESS) return false;
+  uint32_t ticks = alarm_read() - start;
+
+  printf("[SDFS] wrote %u records of %u bytes in %lu ticks, %lu block writes\n", RECORDS,
+         sizeof(record), ticks, fs.block_writes - writes);
+  return true;
+}
+
+// Reads the records back in pieces of a few records.
+static bool test_read(void) {
+  sdfs_file_t file;
+  record_t records[5], expected;
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_open(&fs, &file, "log", 0));
+  if (sdfs_size(&file) != RECORDS * sizeof(expected)) return false;
+
+  uint32_t reads      = fs.block_reads;
+  uint32_t prefetches = fs.prefetches;
+  uint32_t start      = alarm_read();
+  uint32_t seq        = 0;
+  int len;
+  while ((len = sdfs_read(&file, records, sizeof(records))) > 0) {
+    for (size_t i = 0; i < len / sizeof(expected); i++) {
+      make_record(&expected, seq++);
+      if (memcmp(&records[i], &expected, sizeof(expected)) != 0) {
+        printf("[SDFS] record %lu does not match\n", seq - 1);
+        return false;
+      }
+    }
+  }
+  uint32_t ticks = alarm_read() - start;
+
+  printf("[SDFS] read %lu records in %lu ticks, %lu block reads (%lu ahead)\n", seq, ticks,
+         fs.block_reads - reads, fs.prefetches - prefetches);
+  return len == 0 && seq == RECORDS;
+}
+
+// Overwrites records in place, and checks the change after mounting again.
+static bool test_overwrite(void) {
+  sdfs_file_t file;
+  record_t record;
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_open(&fs, &file, "log", 0));
+  make_record(&record, 0xBEEF);
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_seek(&file, 1000 * sizeof(record)));
+  TOCK_EXPECT(sizeof(record), sdfs_write(&file, &record, sizeof(record)));
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_close(&file));
+
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_mount(&fs, &sd, cache, 4));
+  record_t read;
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_open(&fs, &file, "log", 0));
+  TOCK_EXPECT(TOCK_SUCCESS, sdfs_seek(&file, 1000 * sizeof(read)));
+  TOCK_EXPECT(sizeof(read), sdfs_read(&file, &read, sizeof(read)));
+  return memcmp(&read, &record, sizeof(record)) == 0 &&
+         sdfs_stat(&fs, "log") == RECORDS * sizeof(record);
+}
+
+static bool test_remove(void) {
+  return sdfs_remove(&fs, "log") == TOCK_SUCCESS && sdfs_stat(&fs, "log") == TOCK_EINVAL;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[SDFS] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  int err = sdfs_sdcard_device(&sd, FIRST_BLOCK, BLOCK_COUNT);
+  if (err < TOCK_SUCCESS) {
+    printf("[SDFS] no SD card: %s\n", tock_strerror(err));
+    exit(-1);
+  }
+  if (sdfs_mount(&fs, &sd, cache, 4) < TOCK_SUCCESS) {
+    printf("[SDFS] formatting\n");
+    TOCK_EXPECT(TOCK_SUCCESS, sdfs_format(&fs, &sd, cache, 4));
+  }
+  printf("[SDFS] boot %lu, revision %lu\n", boot_count(), fs.rev);
+
+  bool ok = true;
+  ok &= run("write", test_write);
+  ok &= run("read", test_read);
+  ok &= run("overwrite", test_overwrite);
+  ok &= run("remove", test_remove);
+  if (!ok) {
+    exit(-1);
+  }
+
+  printf("[SDFS] alarm %u Hz\n", alarm_internal_frequency());
+  return 0;
+}
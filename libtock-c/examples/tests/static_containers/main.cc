@@ -0,0 +1,282 @@
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <deque>
+#include <list>
+#include <map>
+#include <numeric>
+#include <vector>
+
+#include <alarm.h>
+#include <flat_map.h>
+#include <internal/alarm.h>
+#include <intrusive_list.h>
+#include <static_ring.h>
+#include <static_vector.h>
+
+#define ROUNDS 200
+
+// Counts live objects, to check that containers destroy what they hold.
+static int live;
+
+struct counted {
+  int value;
+  explicit counted(int v) : value(v) {
+    live++;
+  }
+  counted(const counted& other) : value(other.value) {
+    live++;
+  }
+  counted& operator=(const counted&) = default;
+  ~counted() {
+    live--;
+  }
+};
+
+struct node : tock::intrusive_list_hook<> {
+  int value;
+  explicit node(int v = 0) : value(v) {}
+};
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      printf("[CONTAINERS] line %d: %s\n", __LINE__, #cond); \
+      return false; \
+    } \
+} while (0)
+
+// ***** Behaviour *****
+
+static bool test_vector(void) {
+  {
+    tock::static_vector<counted, 4> v;
+    CHECK(v.push_back(counted(1)));
+    CHECK(v.emplace_back(3) != nullptr);
+    CHECK(v.insert(v.begin() + 1, counted(2)) == v.begin() + 1);
+    CHECK(v.insert(v.begin(), counted(0)) == v.begin());
+    CHECK(v.full() && !v.push_back(counted(4)));
+    CHECK(v.insert(v.begin(), counted(4)) == v.end());
+    for (int i = 0; i < 4; i++) CHECK(v[i].value == i);
+    CHECK(live == 4);
+    v.erase(v.begin() + 1);
+    CHECK(v.size() == 3 && v[1].value == 2 && live == 3);
+    tock::static_vector<counted, 4> copy = v;
+    CHECK(live == 6 && copy.back().value == 3);
+  }
+  CHECK(live == 0);
+  return true;
+}
+
+static bool test_ring(void) {
+  {
+    tock::static_ring<counted, 4> r;
+    // Go round the slots a few times.
+    for (int round = 0; round < 6; round++) {
+      CHECK(r.push_back(counted(2)) && r.push_front(counted(1)));
+      CHECK(r.emplace_back(3) != nullptr && r.emplace_front(0) != nullptr);
+      CHECK(r.full() && !r.push_back(counted(4)));
+      int i = 0;
+      for (const counted& c : r) CHECK(c.value == i++);
+      CHECK(r.end() - r.begin() == 4 && r[3].value == 3);
+      r.pop_front();
+      r.pop_back();
+      CHECK(r.front().value == 1 && r.back().value == 2 && live == 2);
+      r.pop_front();
+      r.pop_front();
+      r.push_back(counted(0));
+      r.pop_front();
+    }
+    r.push_back(counted(0));
+  }
+  CHECK(live == 0);
+
+  tock::static_ring<int, 8> last;
+  for (int i = 0; i < 20; i++) {
+    if (last.full()) last.pop_front();
+    last.push_back(i);
+  }
+  CHECK(std::accumulate(last.begin(), last.end(), 0) == 12 + 13 + 14 + 15 + 16 + 17 + 18 + 19);
+  return true;
+}
+
+static bool test_flat_map(void) {
+  tock::flat_map<int, int, 4> m;
+  CHECK(m.insert(std::make_pair(3, 30)).second);
+  CHECK(m.try_emplace(1, 10).second);
+  CHECK(m.insert(std::make_pair(2, 20)).second);
+  CHECK(!m.insert(std::make_pair(2, 99)).second && m.find(2)->second == 20);
+  CHECK(m.insert_or_assign(2, 21).first->second == 21);
+  CHECK(m.try_emplace(0, 0).second);
+  CHECK(m.try_emplace(5, 50).first == m.end());
+  int key = 0;
+  for (const auto& entry : m) CHECK(entry.first == key++);
+  CHECK(m.erase(1) == 1 && m.erase(1) == 0 && !m.contains(1));
+  CHECK(m.lower_bound(1)->first == 2 && m.upper_bound(2)->first == 3);
+  return true;
+}
+
+static bool test_intrusive_list(void) {
+  node a(1), b(2), c(3);
+  tock::intrusive_list<node> l;
+  l.push_back(b);
+  l.push_front(a);
+  l.push_back(c);
+  int i = 1;
+  for (const node& n : l) CHECK(n.value == i++);
+  l.remove(b);
+  CHECK(l.size() == 2 && !b.is_linked());
+  l.insert(l.iterator_to(c), b);
+  i = 1;
+  for (const node& n : l) CHECK(n.value == i++);
+  l.pop_front();
+  CHECK(l.front().value == 2 && l.back().value == 3);
+  l.clear();
+  CHECK(l.empty() && !c.is_linked());
+  return true;
+}
+
+// ***** Comparison with std *****
+
+static uint32_t heap_in_use(void) {
+  return mallinfo().uordblks;
+}
+
+static void report(const char* name, uint32_t ticks, uint32_t std_ticks, uint32_t std_heap) {
+  printf("[CONTAINERS] %-14s %6lu ticks, std %6lu ticks, %4lu bytes of heap\n",
+         name, ticks, std_ticks, std_heap);
+}
+
+// Builds a vector of 32 ints and sums it.
+static bool compare_vector(void) {
+  uint32_t sum = 0, std_sum = 0, heap = 0;
+  uint32_t start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    tock::static_vector<int, 32> v;
+    for (int i = 0; i < 32; i++) v.push_back(i);
+    sum += std::accumulate(v.begin(), v.end(), 0);
+  }
+  uint32_t ticks = alarm_read() - start;
+
+  uint32_t before = heap_in_use();
+  start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    std::vector<int> v;
+    for (int i = 0; i < 32; i++) v.push_back(i);
+    heap     = heap_in_use() - before;
+    std_sum += std::accumulate(v.begin(), v.end(), 0);
+  }
+  report("vector", ticks, alarm_read() - start, heap);
+  return sum == std_sum;
+}
+
+// Runs a queue 8 deep through 64 elements.
+static bool compare_ring(void) {
+  uint32_t sum = 0, std_sum = 0, heap = 0;
+  uint32_t start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    tock::static_ring<int, 8> q;
+    for (int i = 0; i < 64; i++) {
+      if (q.full()) {
+        sum += q.front();
+        q.pop_front();
+      }
+      q.push_back(i);
+    }
+  }
+  uint32_t ticks = alarm_read() - start;
+
+  uint32_t before = heap_in_use();
+  start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    std::deque<int> q;
+    for (int i = 0; i < 64; i++) {
+      if (q.size() == 8) {
+        std_sum += q.front();
+        q.pop_front();
+      }
+      q.push_back(i);
+    }
+    heap = heap_in_use() - before;
+  }
+  report("ring/deque", ticks, alarm_read() - start, heap);
+  return sum == std_sum;
+}
+
+// Fills a map with 24 keys in scrambled order and looks each one up.
+static bool compare_map(void) {
+  uint32_t sum = 0, std_sum = 0, heap = 0;
+  uint32_t start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    tock::flat_map<int, int, 24> m;
+    for (int i = 0; i < 24; i++) m.try_emplace((i * 7) % 24, i);
+    for (int i = 0; i < 24; i++) sum += m.find(i)->second;
+  }
+  uint32_t ticks = alarm_read() - start;
+
+  uint32_t before = heap_in_use();
+  start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    std::map<int, int> m;
+    for (int i = 0; i < 24; i++) m.emplace((i * 7) % 24, i);
+    heap = heap_in_use() - before;
+    for (int i = 0; i < 24; i++) std_sum += m.find(i)->second;
+  }
+  report("flat_map/map", ticks, alarm_read() - start, heap);
+  return sum == std_sum;
+}
+
+// Links 16 objects, removes every other one and walks the rest.
+static bool compare_list(void) {
+  static node nodes[16];
+  uint32_t sum = 0, std_sum = 0, heap = 0;
+  uint32_t start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    tock::intrusive_list<node> l;
+    for (int i = 0; i < 16; i++) {
+      nodes[i].value = i;
+      l.push_back(nodes[i]);
+    }
+    for (int i = 0; i < 16; i += 2) l.remove(nodes[i]);
+    for (const node& n : l) sum += n.value;
+  }
+  uint32_t ticks = alarm_read() - start;
+
+  uint32_t before = heap_in_use();
+  start = alarm_read();
+  for (int round = 0; round < ROUNDS; round++) {
+    std::list<int> l;
+    for (int i = 0; i < 16; i++) l.push_back(i);
+    heap = heap_in_use() - before;
+    l.remove_if([](int value) { return value % 2 == 0; });
+    for (int value : l) std_sum += value;
+  }
+  report("intrusive/list", ticks, alarm_read() - start, heap);
+  return sum == std_sum;
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[CONTAINERS] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  bool ok = true;
+  ok &= run("static_vector", test_vector);
+  ok &= run("static_ring", test_ring);
+  ok &= run("flat_map", test_flat_map);
+  ok &= run("intrusive_list", test_intrusive_list);
+  printf("[CONTAINERS] %d rounds each:\n", ROUNDS);
+  ok &= compare_vector();
+  ok &= compare_ring();
+  ok &= compare_map();
+  ok &= compare_list();
+  if (!ok) {
+    printf("[CONTAINERS] FAIL\n");
+    exit(-1);
+  }
+
+  printf("[CONTAINERS] alarm %u Hz\n", alarm_internal_frequency());
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rng.h>
+#include <timer.h>
+#include <tock.h>
+
+static uint8_t outer_buf[64];
+static uint8_t inner_buf[8];
+
+static int inner_result;
+static bool inner_ran;
+
+// Queued tasks run from the first yield of the _sync call made after
+// queueing them, so they always run while that call waits.
+static bool start_nested(subscribe_cb task) {
+  inner_ran = false;
+  return tock_enqueue(task, 0, 0, 0, NULL) >= 0;
+}
+
+static void busy_task(__attribute__ ((unused)) int arg0,
+                      __attribute__ ((unused)) int arg1,
+                      __attribute__ ((unused)) int arg2,
+                      __attribute__ ((unused)) void* ud) {
+  inner_result = rng_sync(inner_buf, sizeof(inner_buf), sizeof(inner_buf));
+  inner_ran    = true;
+}
+
+static void delay_task(__attribute__ ((unused)) int arg0,
+                       __attribute__ ((unused)) int arg1,
+                       __attribute__ ((unused)) int arg2,
+                       __attribute__ ((unused)) void* ud) {
+  // The outer call's random bytes arrive during this wait.
+  delay_ms(20);
+  inner_ran = true;
+}
+
+// A _sync call on the subscription an outer call waits on is refused, and
+// the outer call still gets its callback.
+static bool test_busy(void) {
+  if (!start_nested(busy_task)) return false;
+  int received = rng_sync(outer_buf, sizeof(outer_buf), sizeof(outer_buf));
+  return inner_ran && inner_result == TOCK_EBUSY && received == sizeof(outer_buf);
+}
+
+// The outer call's callback comes while a callback it ran waits on
+// something else, and is kept for it.
+static bool test_inner_wait(void) {
+  if (!start_nested(delay_task)) return false;
+  int received = rng_sync(outer_buf, sizeof(outer_buf), sizeof(outer_buf));
+  return inner_ran && received == sizeof(outer_buf);
+}
+
+// An operation that fails to start does not leave its subscription marked
+// as waited on.
+static bool test_start_error(void) {
+  tock_completion_t done;
+  TOCK_EXPECT(TOCK_SUCCESS, tock_completion_subscribe(&done, DRIVER_NUM_RNG, 0));
+  if (tock_completion_wait(&done, TOCK_FAIL) != TOCK_FAIL) return false;
+  return rng_sync(inner_buf, sizeof(inner_buf), sizeof(inner_buf)) == sizeof(inner_buf);
+}
+
+static bool run(const char* name, bool (*test)(void)) {
+  bool ok = test();
+  printf("[SYNC] %s: %s\n", name, ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(void) {
+  if (!driver_exists(DRIVER_NUM_RNG)) {
+    printf("[SYNC] No RNG driver, nothing to test\n");
+    return 0;
+  }
+
+  bool ok = true;
+  ok &= run("busy", test_busy);
+  ok &= run("inner wait", test_inner_wait);
+  ok &= run("start error", test_start_error);
+  if (!ok) {
+    exit(-1);
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+
+#include <timer.h>
+#include <touch.h>
+
+// Samples the tracked touch state once per 50 ms "frame", the way a UI loop
+// would, and prints every change. With coalescing the kernel sends at most
+// one batch per frame however fast the fingers move.
+
+#define FRAME_MS 50
+
+static const char* status_name(int status) {
+  switch (status) {
+    case TOUCH_STATUS_RELEASED: return "released";
+    case TOUCH_STATUS_PRESSED:  return "pressed";
+    case TOUCH_STATUS_MOVED:    return "moved";
+    default:                    return "unstarted";
+  }
+}
+
+int main(void) {
+  int touches = 0;
+
+  if (!touch_exists()) {
+    printf("[TOUCH] no touch panel\n");
+    return 0;
+  }
+  touch_get_number_of_touches(&touches);
+  printf("[TOUCH] panel reports %d touch(es)\n", touches);
+
+  int err = touch_track_start(TOUCH_BATCH_HOLD | TOUCH_BATCH_COALESCE);
+  if (err < TOCK_SUCCESS) {
+    printf("[TOUCH] tracking failed: %s\n", tock_strerror(err));
+    return -1;
+  }
+
+  uint32_t dropped = 0;
+  while (1) {
+    touch_state_t state;
+    do {
+      if (touch_track_read(&state)) {
+        for (int i = 0; i < state.num_touches; i++) {
+          printf("[TOUCH] %d: %s (%u, %u)\n", state.touches[i].id,
+                 status_name(state.touches[i].status),
+                 state.touches[i].x, state.touches[i].y);
+        }
+      }
+    } while (state.more);
+    if (state.dropped != dropped) {
+      dropped = state.dropped;
+      printf("[TOUCH] %lu event(s) dropped\n", dropped);
+    }
+    delay_ms(FRAME_MS);
+  }
+}
@@ -43,8 +43,8 @@ static void callback(int payload_len,
   printf(" : %d\n", (uint16_t)(BUF_BIND_CFG[16]) + ((uint16_t)(BUF_BIND_CFG[17]) << 8));
   printf("Packet Payload: %.*s\n", payload_len, packet_rx);
 #else
-  for (i = 0; i < payload_len; i++) {
-    printf("%02x%c", packet_rx[i],
+  for (int i = 0; i < payload_len; i++) {
+    printf("%02x%c", (uint8_t) packet_rx[i],
            ((i + 1) % 16 == 0 || i + 1 == payload_len) ? '\n' : ' ');
   }
 #endif // PRINT_STRING
@@ -5,6 +5,7 @@
 
 #include <timer.h>
 #include <gpio.h>
+#include <ring.h>
 
 #include "nrf.h"
 #include "ser_phy.h"
@@ -19,10 +20,9 @@
 
 // Circular queue for event packets. Event packets are generated asynchronously
 // from the nRF (e.g. advertisement discovery or read requests).
-#define RX_BUFFER_SIZE 5
+#define RX_BUFFER_SIZE 4
 static uint8_t rx_event_buffers[RX_BUFFER_SIZE][SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE];
-static uint8_t _head_event = 0;
-static uint8_t _tail_event = 0;
+static ring_t rx_events;
 
 // Single entry queue for receiving response packets after sending commands.
 static uint8_t rx_rsp_buffer[SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE];
@@ -156,16 +156,18 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
                     }
                     break;
 
-                case SER_PKT_TYPE_EVT:
+                case SER_PKT_TYPE_EVT: {
+                    void* slot;
                     // Check if there is room
-                    if ((_tail_event + 1) % RX_BUFFER_SIZE == _head_event) {
+                    if (ring_reserve(&rx_events, &slot) == 0) {
                         // No empty slots in the queue
                         break;
                     }
-                    // Copy into open slot and increment the pointer.
-                    memcpy(rx_event_buffers[_tail_event], rx+offset, pktlen);
-                    _tail_event = (_tail_event + 1) % RX_BUFFER_SIZE;
+                    // Copy into open slot and queue it.
+                    memcpy(slot, rx+offset, pktlen);
+                    ring_commit(&rx_events, 1);
                     break;
+                }
             }
 
             // Check for another packet in the buffer.
@@ -184,13 +186,16 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
             // library.
             if (_have_rsp_packet) {
                 buf_len = (rx_rsp_buffer[0] | rx_rsp_buffer[1] << 8);
-            } else if (!ser_sd_transport_is_busy() && _head_event != _tail_event) {
+            } else if (!ser_sd_transport_is_busy() && ring_count(&rx_events) > 0) {
                 // DO NOT PROCESS EVENTS IF THERE IS A CMD/RSP PAIR STILL
                 // OUTSTANDING. Processing an events can generate a new command
                 // and things break. We use ser_sd_transport_is_busy() to do
                 // this check because it is essentially contingent on there
                 // being an outstanding response for a request.
-                buf_len = (rx_event_buffers[_head_event][0] | rx_event_buffers[_head_event][1] << 8);
+                void* slot;
+                ring_peek(&rx_events, 0, &slot);
+                uint8_t* event = (uint8_t*) slot;
+                buf_len = (event[0] | event[1] << 8);
             }
 
             if (buf_len > 0) {
@@ -217,18 +222,20 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
         // This buffer MUST be the same buffer that it passed us.
         if (hal_rx_buf) {
             uint16_t buf_len = 0;
+            void* slot;
 
             if (_have_rsp_packet) {
                 _have_rsp_packet = false;
                 buf_len = (rx_rsp_buffer[0] | rx_rsp_buffer[1] << 8);
                 memcpy(hal_rx_buf, rx_rsp_buffer+SER_PHY_HEADER_SIZE, buf_len);
 
-            } else {
-                buf_len = rx_event_buffers[_head_event][0] | (((uint16_t) rx_event_buffers[_head_event][1]) << 8);
-                memcpy(hal_rx_buf, rx_event_buffers[_head_event]+SER_PHY_HEADER_SIZE, buf_len);
+            } else if (ring_peek(&rx_events, 0, &slot) > 0) {
+                uint8_t* event = (uint8_t*) slot;
+                buf_len = event[0] | (((uint16_t) event[1]) << 8);
+                memcpy(hal_rx_buf, event+SER_PHY_HEADER_SIZE, buf_len);
 
                 // Remove this packet from our queue.
-                _head_event = (_head_event + 1) % RX_BUFFER_SIZE;
+                ring_release(&rx_events, 1);
             }
 
             _ser_phy_rx_event.evt_type = SER_PHY_EVT_RX_PKT_RECEIVED;
@@ -238,7 +245,7 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
             hal_rx_buf = NULL;
 
             // Check if there are more packets in the queue.
-            if (_head_event != _tail_event || _have_rsp_packet) {
+            if (ring_count(&rx_events) > 0 || _have_rsp_packet) {
                 _queued_packets = true;
             }
 
@@ -321,6 +328,8 @@ uint32_t ser_phy_open (ser_phy_events_handler_t events_handler) {
         return NRF_ERROR_INVALID_STATE;
     }
 
+    ring_init(&rx_events, rx_event_buffers, SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE, RX_BUFFER_SIZE);
+
     // Start by doing a reset.
     ret = nrf51_serialization_reset();
     if (ret < 0) return NRF_ERROR_INTERNAL;
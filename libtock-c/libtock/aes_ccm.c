@@ -0,0 +1,477 @@
+#include <string.h>
+
+#include "aes_ccm.h"
+
+#define AES_CCM_CMD_ENCRYPT 1
+#define AES_CCM_CMD_DECRYPT 2
+
+#define BLOCK 16
+
+// Largest single packet accepted by aes_ccm_{en,de}crypt_sync() when they go
+// through the kernel: a full 802.15.4 frame plus the largest tag.
+#define SINGLE_PACKET_MAX 144
+
+static uint8_t key_copy[AES_CCM_KEY_LEN];
+static bool key_set = false;
+static bool force_software = false;
+
+// ***** Software AES-128 *****
+//
+// A single 1 KiB T-table (rotated for the other three rows) keeps the
+// implementation reasonably fast without the 4 KiB of the full four-table
+// form. Only the forward cipher is needed for CCM.
+
+static const uint8_t sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b,
+  0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+  0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26,
+  0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2,
+  0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+  0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed,
+  0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f,
+  0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+  0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec,
+  0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14,
+  0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+  0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d,
+  0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f,
+  0x4b, 0xbd, 0x8b, 0x8a, 0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+  0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+  0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f,
+  0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint32_t te0[256] = {
+  0xa56363c6, 0x847c7cf8, 0x997777ee, 0x8d7b7bf6, 0x0df2f2ff, 0xbd6b6bd6,
+  0xb16f6fde, 0x54c5c591, 0x50303060, 0x03010102, 0xa96767ce, 0x7d2b2b56,
+  0x19fefee7, 0x62d7d7b5, 0xe6abab4d, 0x9a7676ec, 0x45caca8f, 0x9d82821f,
+  0x40c9c989, 0x877d7dfa, 0x15fafaef, 0xeb5959b2, 0xc947478e, 0x0bf0f0fb,
+  0xecadad41, 0x67d4d4b3, 0xfda2a25f, 0xeaafaf45, 0xbf9c9c23, 0xf7a4a453,
+  0x967272e4, 0x5bc0c09b, 0xc2b7b775, 0x1cfdfde1, 0xae93933d, 0x6a26264c,
+  0x5a36366c, 0x413f3f7e, 0x02f7f7f5, 0x4fcccc83, 0x5c343468, 0xf4a5a551,
+  0x34e5e5d1, 0x08f1f1f9, 0x937171e2, 0x73d8d8ab, 0x53313162, 0x3f15152a,
+  0x0c040408, 0x52c7c795, 0x65232346, 0x5ec3c39d, 0x28181830, 0xa1969637,
+  0x0f05050a, 0xb59a9a2f, 0x0907070e, 0x36121224, 0x9b80801b, 0x3de2e2df,
+  0x26ebebcd, 0x6927274e, 0xcdb2b27f, 0x9f7575ea, 0x1b090912, 0x9e83831d,
+  0x742c2c58, 0x2e1a1a34, 0x2d1b1b36, 0xb26e6edc, 0xee5a5ab4, 0xfba0a05b,
+  0xf65252a4, 0x4d3b3b76, 0x61d6d6b7, 0xceb3b37d, 0x7b292952, 0x3ee3e3dd,
+  0x712f2f5e, 0x97848413, 0xf55353a6, 0x68d1d1b9, 0x00000000, 0x2cededc1,
+  0x60202040, 0x1ffcfce3, 0xc8b1b179, 0xed5b5bb6, 0xbe6a6ad4, 0x46cbcb8d,
+  0xd9bebe67, 0x4b393972, 0xde4a4a94, 0xd44c4c98, 0xe85858b0, 0x4acfcf85,
+  0x6bd0d0bb, 0x2aefefc5, 0xe5aaaa4f, 0x16fbfbed, 0xc5434386, 0xd74d4d9a,
+  0x55333366, 0x94858511, 0xcf45458a, 0x10f9f9e9, 0x06020204, 0x817f7ffe,
+  0xf05050a0, 0x443c3c78, 0xba9f9f25, 0xe3a8a84b, 0xf35151a2, 0xfea3a35d,
+  0xc0404080, 0x8a8f8f05, 0xad92923f, 0xbc9d9d21, 0x48383870, 0x04f5f5f1,
+  0xdfbcbc63, 0xc1b6b677, 0x75dadaaf, 0x63212142, 0x30101020, 0x1affffe5,
+  0x0ef3f3fd, 0x6dd2d2bf, 0x4ccdcd81, 0x140c0c18, 0x35131326, 0x2fececc3,
+  0xe15f5fbe, 0xa2979735, 0xcc444488, 0x3917172e, 0x57c4c493, 0xf2a7a755,
+  0x827e7efc, 0x473d3d7a, 0xac6464c8, 0xe75d5dba, 0x2b191932, 0x957373e6,
+  0xa06060c0, 0x98818119, 0xd14f4f9e, 0x7fdcdca3, 0x66222244, 0x7e2a2a54,
+  0xab90903b, 0x8388880b, 0xca46468c, 0x29eeeec7, 0xd3b8b86b, 0x3c141428,
+  0x79dedea7, 0xe25e5ebc, 0x1d0b0b16, 0x76dbdbad, 0x3be0e0db, 0x56323264,
+  0x4e3a3a74, 0x1e0a0a14, 0xdb494992, 0x0a06060c, 0x6c242448, 0xe45c5cb8,
+  0x5dc2c29f, 0x6ed3d3bd, 0xefacac43, 0xa66262c4, 0xa8919139, 0xa4959531,
+  0x37e4e4d3, 0x8b7979f2, 0x32e7e7d5, 0x43c8c88b, 0x5937376e, 0xb76d6dda,
+  0x8c8d8d01, 0x64d5d5b1, 0xd24e4e9c, 0xe0a9a949, 0xb46c6cd8, 0xfa5656ac,
+  0x07f4f4f3, 0x25eaeacf, 0xaf6565ca, 0x8e7a7af4, 0xe9aeae47, 0x18080810,
+  0xd5baba6f, 0x887878f0, 0x6f25254a, 0x722e2e5c, 0x241c1c38, 0xf1a6a657,
+  0xc7b4b473, 0x51c6c697, 0x23e8e8cb, 0x7cdddda1, 0x9c7474e8, 0x211f1f3e,
+  0xdd4b4b96, 0xdcbdbd61, 0x868b8b0d, 0x858a8a0f, 0x907070e0, 0x423e3e7c,
+  0xc4b5b571, 0xaa6666cc, 0xd8484890, 0x05030306, 0x01f6f6f7, 0x120e0e1c,
+  0xa36161c2, 0x5f35356a, 0xf95757ae, 0xd0b9b969, 0x91868617, 0x58c1c199,
+  0x271d1d3a, 0xb99e9e27, 0x38e1e1d9, 0x13f8f8eb, 0xb398982b, 0x33111122,
+  0xbb6969d2, 0x70d9d9a9, 0x898e8e07, 0xa7949433, 0xb69b9b2d, 0x221e1e3c,
+  0x92878715, 0x20e9e9c9, 0x49cece87, 0xff5555aa, 0x78282850, 0x7adfdfa5,
+  0x8f8c8c03, 0xf8a1a159, 0x80898909, 0x170d0d1a, 0xdabfbf65, 0x31e6e6d7,
+  0xc6424284, 0xb86868d0, 0xc3414182, 0xb0999929, 0x772d2d5a, 0x110f0f1e,
+  0xcbb0b07b, 0xfc5454a8, 0xd6bbbb6d, 0x3a16162c,
+};
+
+static uint32_t round_keys[44];
+
+static inline uint32_t rotl(uint32_t x, int n) {
+  return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t load_le32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void store_le32(uint8_t* p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static inline uint32_t sub_word(uint32_t w) {
+  return sbox[w & 0xff] | (sbox[(w >> 8) & 0xff] << 8) |
+         (sbox[(w >> 16) & 0xff] << 16) | ((uint32_t) sbox[w >> 24] << 24);
+}
+
+static void aes128_expand_key(const uint8_t* key) {
+  uint8_t rcon = 1;
+  for (int i = 0; i < 4; i++) {
+    round_keys[i] = load_le32(key + 4 * i);
+  }
+  for (int i = 4; i < 44; i++) {
+    uint32_t t = round_keys[i - 1];
+    if (i % 4 == 0) {
+      // RotWord is a right rotation in little-endian word order.
+      t    = sub_word(rotl(t, 24)) ^ rcon;
+      rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0);
+    }
+    round_keys[i] = round_keys[i - 4] ^ t;
+  }
+}
+
+static void aes128_encrypt_block(const uint8_t* in, uint8_t* out) {
+  const uint32_t* rk = round_keys;
+  uint32_t s0        = load_le32(in) ^ rk[0];
+  uint32_t s1        = load_le32(in + 4) ^ rk[1];
+  uint32_t s2        = load_le32(in + 8) ^ rk[2];
+  uint32_t s3        = load_le32(in + 12) ^ rk[3];
+
+#define ROUND_COLUMN(a, b, c, d, k)                                     \
+  (te0[(a) & 0xff] ^ rotl(te0[((b) >> 8) & 0xff], 8) ^                 \
+   rotl(te0[((c) >> 16) & 0xff], 16) ^ rotl(te0[(d) >> 24], 24) ^ (k))
+
+  for (int round = 1; round < 10; round++) {
+    rk += 4;
+    uint32_t t0 = ROUND_COLUMN(s0, s1, s2, s3, rk[0]);
+    uint32_t t1 = ROUND_COLUMN(s1, s2, s3, s0, rk[1]);
+    uint32_t t2 = ROUND_COLUMN(s2, s3, s0, s1, rk[2]);
+    uint32_t t3 = ROUND_COLUMN(s3, s0, s1, s2, rk[3]);
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+#undef ROUND_COLUMN
+
+  // The last round has no MixColumns.
+#define FINAL_COLUMN(a, b, c, d, k)                                       \
+  ((sbox[(a) & 0xff] | (sbox[((b) >> 8) & 0xff] << 8) |                   \
+    (sbox[((c) >> 16) & 0xff] << 16) | ((uint32_t) sbox[(d) >> 24] << 24)) ^ (k))
+
+  rk += 4;
+  store_le32(out, FINAL_COLUMN(s0, s1, s2, s3, rk[0]));
+  store_le32(out + 4, FINAL_COLUMN(s1, s2, s3, s0, rk[1]));
+  store_le32(out + 8, FINAL_COLUMN(s2, s3, s0, s1, rk[2]));
+  store_le32(out + 12, FINAL_COLUMN(s3, s0, s1, s2, rk[3]));
+#undef FINAL_COLUMN
+}
+
+// ***** Software CCM *****
+
+static void xor_block(uint8_t* dst, const uint8_t* src, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    dst[i] ^= src[i];
+  }
+}
+
+// Folds `len` bytes of `data`, zero-padded to a whole block, into the
+// CBC-MAC state `x`.
+static void cbc_mac(uint8_t* x, const uint8_t* data, size_t len) {
+  while (len > 0) {
+    size_t n = len < BLOCK ? len : BLOCK;
+    xor_block(x, data, n);
+    aes128_encrypt_block(x, x);
+    data += n;
+    len  -= n;
+  }
+}
+
+// Applies the CTR keystream A_1, A_2, ... to `data` in place.
+static void ctr_crypt(const uint8_t* nonce, uint8_t* data, size_t len) {
+  uint8_t ctr[BLOCK], stream[BLOCK];
+  ctr[0] = 1; // L - 1
+  memcpy(ctr + 1, nonce, AES_CCM_NONCE_LEN);
+  for (uint16_t i = 1; len > 0; i++) {
+    ctr[14] = i >> 8;
+    ctr[15] = i;
+    aes128_encrypt_block(ctr, stream);
+    size_t n = len < BLOCK ? len : BLOCK;
+    xor_block(data, stream, n);
+    data += n;
+    len  -= n;
+  }
+}
+
+// Computes the encrypted tag U over `a_data` and plaintext `m_data`.
+static void ccm_tag(const uint8_t* nonce, const uint8_t* a_data, size_t a_len,
+                    const uint8_t* m_data, size_t m_len, size_t mic_len, uint8_t* tag) {
+  uint8_t x[BLOCK];
+
+  x[0] = ((a_len > 0) << 6) | (((mic_len - 2) / 2) << 3) | 1;
+  memcpy(x + 1, nonce, AES_CCM_NONCE_LEN);
+  x[14] = m_len >> 8;
+  x[15] = m_len;
+  aes128_encrypt_block(x, x);
+
+  if (a_len > 0) {
+    // The first block carries the 2-byte length of a_data.
+    size_t n = a_len < BLOCK - 2 ? a_len : BLOCK - 2;
+    x[0] ^= a_len >> 8;
+    x[1] ^= a_len;
+    xor_block(x + 2, a_data, n);
+    aes128_encrypt_block(x, x);
+    cbc_mac(x, a_data + n, a_len - n);
+  }
+  cbc_mac(x, m_data, m_len);
+
+  uint8_t s0[BLOCK];
+  s0[0] = 1;
+  memcpy(s0 + 1, nonce, AES_CCM_NONCE_LEN);
+  s0[14] = 0;
+  s0[15] = 0;
+  aes128_encrypt_block(s0, s0);
+  for (size_t i = 0; i < mic_len; i++) {
+    tag[i] = x[i] ^ s0[i];
+  }
+}
+
+static void sw_encrypt(const uint8_t* nonce, uint8_t* buf, size_t a_len, size_t m_len,
+                       size_t mic_len) {
+  uint8_t* m_data = buf + a_len;
+  ccm_tag(nonce, buf, a_len, m_data, m_len, mic_len, m_data + m_len);
+  ctr_crypt(nonce, m_data, m_len);
+}
+
+static bool sw_decrypt(const uint8_t* nonce, uint8_t* buf, size_t a_len, size_t m_len,
+                       size_t mic_len) {
+  uint8_t* m_data = buf + a_len;
+  uint8_t tag[BLOCK];
+
+  ctr_crypt(nonce, m_data, m_len);
+  ccm_tag(nonce, buf, a_len, m_data, m_len, mic_len, tag);
+
+  // Compare without an early exit so timing does not reveal the match length.
+  uint8_t diff = 0;
+  for (size_t i = 0; i < mic_len; i++) {
+    diff |= tag[i] ^ m_data[m_len + i];
+  }
+  if (diff != 0) {
+    // CTR is its own inverse: restore the ciphertext.
+    ctr_crypt(nonce, m_data, m_len);
+    return false;
+  }
+  return true;
+}
+
+// ***** Batches *****
+
+void aes_ccm_batch_init(aes_ccm_batch_t* batch, uint8_t* buf, size_t len) {
+  batch->buf    = buf;
+  batch->len    = len;
+  batch->used   = 0;
+  batch->count  = 0;
+  batch->failed = 0;
+}
+
+uint8_t* aes_ccm_batch_add(aes_ccm_batch_t* batch, const uint8_t* nonce,
+                           size_t a_len, size_t m_len, size_t mic_len) {
+  if (batch->count == AES_CCM_MAX_BATCH || a_len > 255 || m_len > 255) return NULL;
+  if (mic_len != 4 && mic_len != 8 && mic_len != 16) return NULL;
+
+  size_t size = AES_CCM_RECORD_HEADER + a_len + m_len + mic_len;
+  if (size > batch->len - batch->used) return NULL;
+
+  uint8_t* record = batch->buf + batch->used;
+  memcpy(record, nonce, AES_CCM_NONCE_LEN);
+  record[AES_CCM_NONCE_LEN]     = a_len;
+  record[AES_CCM_NONCE_LEN + 1] = m_len;
+  record[AES_CCM_NONCE_LEN + 2] = mic_len;
+  batch->used += size;
+  batch->count++;
+  return record + AES_CCM_RECORD_HEADER;
+}
+
+uint8_t* aes_ccm_batch_packet(const aes_ccm_batch_t* batch, int index,
+                              size_t* a_len, size_t* m_len, size_t* mic_len) {
+  if (index < 0 || index >= batch->count) return NULL;
+
+  uint8_t* record = batch->buf;
+  for (int i = 0; ; i++) {
+    const uint8_t* lens = record + AES_CCM_NONCE_LEN;
+    if (i == index) {
+      if (a_len != NULL) *a_len = lens[0];
+      if (m_len != NULL) *m_len = lens[1];
+      if (mic_len != NULL) *mic_len = lens[2];
+      return record + AES_CCM_RECORD_HEADER;
+    }
+    record += AES_CCM_RECORD_HEADER + lens[0] + lens[1] + lens[2];
+  }
+}
+
+// Runs a whole batch in software, returning the bitmask of packets that
+// failed to authenticate.
+static uint32_t sw_batch(aes_ccm_batch_t* batch, bool encrypt) {
+  uint32_t failed = 0;
+  for (int i = 0; i < batch->count; i++) {
+    size_t a_len, m_len, mic_len;
+    uint8_t* packet = aes_ccm_batch_packet(batch, i, &a_len, &m_len, &mic_len);
+    const uint8_t* nonce = packet - AES_CCM_RECORD_HEADER;
+    if (encrypt) {
+      sw_encrypt(nonce, packet, a_len, m_len, mic_len);
+    } else if (!sw_decrypt(nonce, packet, a_len, m_len, mic_len)) {
+      failed |= 1u << i;
+    }
+  }
+  return failed;
+}
+
+// ***** System Call Interface *****
+
+bool aes_ccm_hardware_available(void) {
+  return !force_software && driver_exists(DRIVER_NUM_AES_CCM);
+}
+
+void aes_ccm_force_software(bool force) {
+  force_software = force;
+}
+
+int aes_ccm_set_key(const uint8_t* key) {
+  memcpy(key_copy, key, AES_CCM_KEY_LEN);
+  aes128_expand_key(key_copy);
+  key_set = true;
+
+  if (driver_exists(DRIVER_NUM_AES_CCM)) {
+    return allow(DRIVER_NUM_AES_CCM, 0, key_copy, AES_CCM_KEY_LEN);
+  }
+  return TOCK_SUCCESS;
+}
+
+typedef struct {
+  aes_ccm_batch_t* batch;
+  subscribe_cb* callback;
+  void* ud;
+} batch_request_t;
+
+static batch_request_t pending;
+
+static void batch_cb(int status, int processed, int failed, void* ud) {
+  batch_request_t* request = (batch_request_t*) ud;
+  request->batch->failed = failed;
+  request->callback(status, processed, failed, request->ud);
+}
+
+static int start_batch(aes_ccm_batch_t* batch, bool encrypt, subscribe_cb callback, void* ud) {
+  if (!key_set) return TOCK_ERESERVE;
+  if (batch->count == 0) return TOCK_EINVAL;
+  batch->failed = 0;
+
+  if (!aes_ccm_hardware_available()) {
+    // Keep the asynchronous contract: the callback still runs from yield().
+    uint32_t failed = sw_batch(batch, encrypt);
+    batch->failed = failed;
+    return tock_enqueue(callback, TOCK_SUCCESS, batch->count, failed, ud) < 0 ? TOCK_FAIL : TOCK_SUCCESS;
+  }
+
+  pending.batch    = batch;
+  pending.callback = callback;
+  pending.ud       = ud;
+
+  int err = subscribe(DRIVER_NUM_AES_CCM, 0, batch_cb, &pending);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(DRIVER_NUM_AES_CCM, 1, batch->buf, batch->used);
+  if (err < TOCK_SUCCESS) return err;
+
+  return command(DRIVER_NUM_AES_CCM, encrypt ? AES_CCM_CMD_ENCRYPT : AES_CCM_CMD_DECRYPT,
+                 batch->count, 0);
+}
+
+int aes_ccm_encrypt_batch(aes_ccm_batch_t* batch, subscribe_cb callback, void* ud) {
+  return start_batch(batch, true, callback, ud);
+}
+
+int aes_ccm_decrypt_batch(aes_ccm_batch_t* batch, subscribe_cb callback, void* ud) {
+  return start_batch(batch, false, callback, ud);
+}
+
+// ***** Synchronous Calls *****
+
+typedef struct {
+  bool fired;
+  int status;
+} aes_ccm_result_t;
+
+static void sync_cb(int status,
+                    __attribute__ ((unused)) int processed,
+                    __attribute__ ((unused)) int failed,
+                    void* ud) {
+  aes_ccm_result_t* result = (aes_ccm_result_t*) ud;
+  result->status = status;
+  result->fired  = true;
+}
+
+static int batch_sync(aes_ccm_batch_t* batch, bool encrypt) {
+  if (!aes_ccm_hardware_available()) {
+    // No need to go through the callback queue.
+    if (!key_set) return TOCK_ERESERVE;
+    batch->failed = sw_batch(batch, encrypt);
+    return batch->failed ? TOCK_FAIL : TOCK_SUCCESS;
+  }
+
+  aes_ccm_result_t result = { .fired = false };
+  int err = start_batch(batch, encrypt, sync_cb, &result);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&result.fired);
+  if (result.status < TOCK_SUCCESS) return result.status;
+  return batch->failed ? TOCK_FAIL : TOCK_SUCCESS;
+}
+
+int aes_ccm_encrypt_batch_sync(aes_ccm_batch_t* batch) {
+  return batch_sync(batch, true);
+}
+
+int aes_ccm_decrypt_batch_sync(aes_ccm_batch_t* batch) {
+  return batch_sync(batch, false);
+}
+
+// Runs one packet through the kernel by copying it into a one-record batch.
+static int single_sync(const uint8_t* nonce, uint8_t* buf, size_t a_len, size_t m_len,
+                       size_t mic_len, bool encrypt) {
+  static uint8_t record[AES_CCM_RECORD_HEADER + SINGLE_PACKET_MAX];
+  aes_ccm_batch_t batch;
+  size_t len = a_len + m_len + mic_len;
+
+  if (!aes_ccm_hardware_available()) {
+    if (!key_set) return TOCK_ERESERVE;
+    if (mic_len != 4 && mic_len != 8 && mic_len != 16) return TOCK_EINVAL;
+    if (encrypt) {
+      sw_encrypt(nonce, buf, a_len, m_len, mic_len);
+      return TOCK_SUCCESS;
+    }
+    return sw_decrypt(nonce, buf, a_len, m_len, mic_len) ? TOCK_SUCCESS : TOCK_FAIL;
+  }
+
+  if (len > SINGLE_PACKET_MAX) return TOCK_ESIZE;
+  aes_ccm_batch_init(&batch, record, sizeof(record));
+  uint8_t* packet = aes_ccm_batch_add(&batch, nonce, a_len, m_len, mic_len);
+  if (packet == NULL) return TOCK_EINVAL;
+  memcpy(packet, buf, encrypt ? a_len + m_len : len);
+
+  int err = batch_sync(&batch, encrypt);
+  if (err == TOCK_SUCCESS) {
+    memcpy(buf, packet, len);
+  }
+  return err;
+}
+
+int aes_ccm_encrypt_sync(const uint8_t* nonce, uint8_t* buf, size_t a_len,
+                         size_t m_len, size_t mic_len) {
+  return single_sync(nonce, buf, a_len, m_len, mic_len, true);
+}
+
+int aes_ccm_decrypt_sync(const uint8_t* nonce, uint8_t* buf, size_t a_len,
+                         size_t m_len, size_t mic_len) {
+  return single_sync(nonce, buf, a_len, m_len, mic_len, false);
+}
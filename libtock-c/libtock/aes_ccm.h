@@ -0,0 +1,123 @@
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRIVER_NUM_AES_CCM 0x40005
+
+#define AES_CCM_KEY_LEN       16
+#define AES_CCM_NONCE_LEN     13
+#define AES_CCM_MAX_BATCH     32
+#define AES_CCM_RECORD_HEADER (AES_CCM_NONCE_LEN + 3)
+
+// AES-128-CCM* authenticated encryption (IEEE 802.15.4 / RFC 3610, with a
+// 13-byte nonce).
+//
+// Each packet is `a_data | m_data | mic`: `a_data` (e.g. a header) is
+// authenticated, `m_data` is encrypted and authenticated, and the 4, 8 or
+// 16-byte `mic` follows it. Packets are processed in place.
+//
+// Several packets can be submitted as one batch, which costs a single system
+// call and callback. Packets are added to a caller-provided batch buffer and
+// filled in place, so nothing is copied on the way to the kernel:
+//
+//     static uint8_t storage[4 * (AES_CCM_RECORD_HEADER + 80)];
+//     aes_ccm_batch_t batch;
+//     aes_ccm_batch_init(&batch, storage, sizeof(storage));
+//     for (int i = 0; i < 4; i++) {
+//       uint8_t* p = aes_ccm_batch_add(&batch, nonce[i], HDR_LEN, len[i], 8);
+//       memcpy(p, hdr[i], HDR_LEN);
+//       memcpy(p + HDR_LEN, payload[i], len[i]);
+//     }
+//     aes_ccm_encrypt_batch_sync(&batch);
+//
+// When the board has no CCM engine (or aes_ccm_force_software() is set), the
+// same calls run a software implementation instead.
+
+typedef struct {
+  uint8_t* buf;
+  size_t len;
+  size_t used;
+  int count;
+  // Bit `i` is set if packet `i` failed to authenticate on decryption.
+  uint32_t failed;
+} aes_ccm_batch_t;
+
+/* aes_ccm_set_key
+ *  Sets the 16-byte key used for all subsequent operations. The key is
+ *  copied.
+ */
+int aes_ccm_set_key(const uint8_t* key);
+
+/* aes_ccm_batch_init
+ *  Starts an empty batch stored in `buf`.
+ */
+void aes_ccm_batch_init(aes_ccm_batch_t* batch, uint8_t* buf, size_t len);
+
+/* aes_ccm_batch_add
+ *  Reserves space for a packet with `a_len` bytes of authenticated data,
+ *  `m_len` bytes of message and a `mic_len`-byte tag (4, 8 or 16).
+ *  returns a pointer to the packet's `a_data | m_data | mic` region, to be
+ *  filled in by the caller, or NULL if the batch is full or the lengths are
+ *  invalid. Each of `a_len` and `m_len` must be at most 255.
+ */
+uint8_t* aes_ccm_batch_add(aes_ccm_batch_t* batch, const uint8_t* nonce,
+                           size_t a_len, size_t m_len, size_t mic_len);
+
+/* aes_ccm_batch_packet
+ *  returns the `a_data | m_data | mic` region of packet `index`, storing its
+ *  lengths in any non-NULL length arguments, or NULL if there is no such
+ *  packet.
+ */
+uint8_t* aes_ccm_batch_packet(const aes_ccm_batch_t* batch, int index,
+                              size_t* a_len, size_t* m_len, size_t* mic_len);
+
+/* aes_ccm_encrypt_batch / aes_ccm_decrypt_batch
+ *  Starts processing every packet in the batch. `callback` receives the
+ *  status, the number of packets processed and the bitmask of packets whose
+ *  tag did not verify (also stored in `batch->failed`). Packets that fail
+ *  to verify are left encrypted.
+ */
+int aes_ccm_encrypt_batch(aes_ccm_batch_t* batch, subscribe_cb callback, void* ud);
+int aes_ccm_decrypt_batch(aes_ccm_batch_t* batch, subscribe_cb callback, void* ud);
+
+/* aes_ccm_encrypt_batch_sync / aes_ccm_decrypt_batch_sync
+ *  Synchronous versions of the above.
+ *  returns TOCK_SUCCESS, TOCK_FAIL if any packet failed to authenticate
+ *  (see `batch->failed`), or another negative error.
+ */
+int aes_ccm_encrypt_batch_sync(aes_ccm_batch_t* batch);
+int aes_ccm_decrypt_batch_sync(aes_ccm_batch_t* batch);
+
+/* aes_ccm_encrypt_sync
+ *  Encrypts a single packet in `buf` (`a_data | m_data`, with room for the
+ *  tag after it) and appends the tag.
+ */
+int aes_ccm_encrypt_sync(const uint8_t* nonce, uint8_t* buf, size_t a_len,
+                         size_t m_len, size_t mic_len);
+
+/* aes_ccm_decrypt_sync
+ *  Verifies and decrypts a single packet in `buf`.
+ *  returns TOCK_SUCCESS, or TOCK_FAIL if the tag does not match, in which
+ *  case `buf` is left unchanged.
+ */
+int aes_ccm_decrypt_sync(const uint8_t* nonce, uint8_t* buf, size_t a_len,
+                         size_t m_len, size_t mic_len);
+
+/* aes_ccm_hardware_available
+ *  returns true if operations go to the kernel's CCM engine.
+ */
+bool aes_ccm_hardware_available(void);
+
+/* aes_ccm_force_software
+ *  Selects the software implementation even if the kernel driver exists,
+ *  e.g. for benchmarking.
+ */
+void aes_ccm_force_software(bool force);
+
+#ifdef __cplusplus
+}
+#endif
@@ -127,14 +127,86 @@ uint32_t alarm_read(void) {
 
 // Timer implementation
 
+static void kernel_timer_release(tock_timer_t* timer);
+
+// Takes the timer's alarm out of the list, if it is there. The timer may be
+// new, with links that hold anything, so they are only followed once the
+// alarm is found in the list.
+static void timer_alarm_cancel(tock_timer_t* timer) {
+  for (alarm_t* cur = root; cur != NULL; cur = cur->next) {
+    if (cur == &timer->alarm) {
+      alarm_cancel(cur);
+      return;
+    }
+  }
+}
+
 void timer_in(uint32_t ms, subscribe_cb cb, void* ud, tock_timer_t *timer) {
   uint32_t frequency  = alarm_internal_frequency();
   uint32_t interval   = (ms / 1000) * frequency + (ms % 1000) * (frequency / 1000);
   uint32_t now        = alarm_read();
   uint32_t expiration = now + interval;
+  kernel_timer_release(timer);
+  timer_alarm_cancel(timer);
   alarm_at(expiration, cb, ud, &timer->alarm);
 }
 
+// Repeating timers on kernel timers. Each use of a kernel timer is tagged
+// with a generation in the bits above the id, so a callback still queued
+// from a cancelled timer is not delivered to the next timer using the id.
+
+#define KERNEL_TIMERS_MAX 8
+#define KERNEL_TIMER_ID(timer) ((timer) & 0xff)
+
+// Kernel timers this process uses, or -1 before the kernel was asked.
+static int kernel_timers_num = -1;
+static tock_timer_t* kernel_timers[KERNEL_TIMERS_MAX];
+static uint32_t kernel_timer_generation;
+
+static void kernel_timer_cb(int now, int expiration, int kernel_timer,
+                            __attribute__ ((unused)) void* ud) {
+  tock_timer_t* timer = kernel_timers[KERNEL_TIMER_ID(kernel_timer)];
+  if (timer != NULL && timer->kernel_timer == (uint32_t) kernel_timer) {
+    timer->cb(now, expiration, 0, timer->ud);
+  }
+}
+
+// Stops the kernel timer `timer` runs on, if any. The timer may be new, with
+// fields that hold anything, so it is only trusted if it is the registered
+// user of its id.
+static void kernel_timer_release(tock_timer_t* timer) {
+  int id = KERNEL_TIMER_ID(timer->kernel_timer);
+  if (id < kernel_timers_num && kernel_timers[id] == timer) {
+    alarm_internal_timer_stop(id);
+    kernel_timers[id] = NULL;
+  }
+  timer->kernel_timer = 0;
+}
+
+static bool kernel_timer_start(uint32_t interval, tock_timer_t* timer) {
+  if (kernel_timers_num < 0) {
+    int num = alarm_internal_timer_count();
+    if (num > KERNEL_TIMERS_MAX) num = KERNEL_TIMERS_MAX;
+    if (num > 0 && alarm_internal_timer_subscribe(kernel_timer_cb, NULL) < TOCK_SUCCESS) num = 0;
+    kernel_timers_num = num > 0 ? num : 0;
+  }
+
+  for (int id = 0; id < kernel_timers_num; id++) {
+    if (kernel_timers[id] != NULL) continue;
+
+    kernel_timer_generation = (kernel_timer_generation + 1) & 0xffffff;
+    if (kernel_timer_generation == 0) kernel_timer_generation = 1;
+    uint32_t kernel_timer = (kernel_timer_generation << 8) | id;
+    if (alarm_internal_timer_every(kernel_timer, interval) < TOCK_SUCCESS) {
+      return false;
+    }
+    timer->kernel_timer = kernel_timer;
+    kernel_timers[id]   = timer;
+    return true;
+  }
+  return false;
+}
+
 static void repeating_cb( uint32_t now,
                           __attribute__ ((unused)) int unused1,
                           __attribute__ ((unused)) int unused2,
@@ -152,9 +224,15 @@ void timer_every(uint32_t ms, subscribe_cb cb, void* ud, tock_timer_t* repeating
   uint32_t frequency = alarm_internal_frequency();
   uint32_t interval  = (ms / 1000) * frequency + (ms % 1000) * (frequency / 1000);
 
-  repeating->interval = interval;
-  repeating->cb       = cb;
-  repeating->ud       = ud;
+  repeating->interval     = interval;
+  repeating->cb           = cb;
+  repeating->ud           = ud;
+  kernel_timer_release(repeating);
+  timer_alarm_cancel(repeating);
+
+  if (kernel_timer_start(interval, repeating)) {
+    return;
+  }
 
   uint32_t now        = alarm_read();
   uint32_t expiration = now + interval;
@@ -164,7 +242,8 @@ void timer_every(uint32_t ms, subscribe_cb cb, void* ud, tock_timer_t* repeating
 }
 
 void timer_cancel(tock_timer_t* timer) {
-  alarm_cancel(&timer->alarm);
+  kernel_timer_release(timer);
+  timer_alarm_cancel(timer);
 }
 
 void delay_ms(uint32_t ms) {
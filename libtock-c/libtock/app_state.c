@@ -3,21 +3,8 @@
 #include "app_state.h"
 #include "tock.h"
 
-// Internal callback for synchronous interfaces
-static void app_state_sync_cb(__attribute__ ((unused)) int callback_type,
-                              __attribute__ ((unused)) int value,
-                              __attribute__ ((unused)) int unused,
-                              void* ud) {
-  *((bool*) ud) = true;
-}
-
-
 static bool _app_state_inited = false;
 static int app_state_init(void) {
-  int err;
-  err = allow(DRIVER_NUM_APP_FLASH, 0, _app_state_ram_pointer, _app_state_size);
-  if (err < 0) return err;
-
   // Check that we have a region to use for this.
   int number_regions = tock_app_number_writeable_flash_regions();
   if (number_regions == 0) return TOCK_ENOMEM;
@@ -41,7 +28,8 @@ int app_state_load_sync(void) {
   return 0;
 }
 
-int app_state_save(subscribe_cb callback, void* callback_args) {
+// Allows the RAM copy and starts writing it to flash.
+static int app_state_start_save(void) {
   int err;
 
   if (!_app_state_inited) {
@@ -49,23 +37,29 @@ int app_state_save(subscribe_cb callback, void* callback_args) {
     if (err < 0) return err;
   }
 
-  err = subscribe(DRIVER_NUM_APP_FLASH, 0, callback, callback_args);
+  // Other libraries (e.g. kv_store) share the driver, so allow the buffer
+  // for every save.
+  err = allow(DRIVER_NUM_APP_FLASH, 0, _app_state_ram_pointer, _app_state_size);
   if (err < 0) return err;
 
   return command(DRIVER_NUM_APP_FLASH, 1, (uint32_t) _app_state_flash_pointer, 0);
 }
 
+int app_state_save(subscribe_cb callback, void* callback_args) {
+  int err = subscribe(DRIVER_NUM_APP_FLASH, 0, callback, callback_args);
+  if (err < 0) return err;
+
+  return app_state_start_save();
+}
 
-static bool save_sync_flag;
-int app_state_save_sync(void) {
-  int err;
-  save_sync_flag = false;
 
-  err = app_state_save(app_state_sync_cb, (void*) &save_sync_flag);
+int app_state_save_sync(void) {
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_APP_FLASH, 0);
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&save_sync_flag);
+  err = tock_completion_wait(&done, app_state_start_save());
+  if (err < 0) return err;
 
   return 0;
 }
@@ -1,14 +1,6 @@
 #include "buzzer.h"
 #include "tock.h"
 
-// Internal callback for faking synchronous reads
-static void callback_sync (__attribute__ ((unused)) int unused,
-                           __attribute__ ((unused)) int unused1,
-                           __attribute__ ((unused)) int unused2,
-                           void* ud) {
-  *(bool*)ud = true;
-}
-
 static void callback(__attribute__ ((unused)) int unused,
                      __attribute__ ((unused)) int unused1,
                      __attribute__ ((unused)) int unused2,
@@ -21,11 +13,10 @@ int buzzer_exists (void) {
 }
 
 int tone_sync (size_t frequency_hz, size_t duration_ms) {
-  bool done = false;
-  int ret   = subscribe (BUZZER_DRIVER, 0, callback_sync, &done);
+  tock_completion_t done;
+  int ret = tock_completion_subscribe (&done, BUZZER_DRIVER, 0);
   if (ret == TOCK_SUCCESS) {
-    ret = command (BUZZER_DRIVER, 1, frequency_hz, duration_ms);
-    if (ret == TOCK_SUCCESS) yield_for (&done);
+    ret = tock_completion_wait (&done, command (BUZZER_DRIVER, 1, frequency_hz, duration_ms));
   }
   return ret;
 }
@@ -0,0 +1,295 @@
+#include <string.h>
+
+#include "cbor.h"
+
+#define CBOR_FALSE 20
+#define CBOR_TRUE  21
+#define CBOR_NULL  22
+
+void cbor_writer_init(cbor_writer_t* w, void* buf, size_t len) {
+  w->buf = buf;
+  w->len = len;
+  w->pos = 0;
+  w->err = TOCK_SUCCESS;
+}
+
+// Reserves `len` bytes, returning NULL (and latching the error) if they do
+// not fit.
+static uint8_t* writer_reserve(cbor_writer_t* w, size_t len) {
+  if (w->err != TOCK_SUCCESS) return NULL;
+  if (len > w->len - w->pos) {
+    w->err = TOCK_ESIZE;
+    return NULL;
+  }
+  uint8_t* p = w->buf + w->pos;
+  w->pos += len;
+  return p;
+}
+
+// Writes an item head using the shortest argument encoding, as required for
+// preferred serialization.
+static void writer_head(cbor_writer_t* w, cbor_type_t type, uint32_t arg) {
+  uint8_t major = type << 5;
+  uint8_t* p;
+
+  if (arg < 24) {
+    if ((p = writer_reserve(w, 1)) == NULL) return;
+    p[0] = major | arg;
+  } else if (arg <= 0xff) {
+    if ((p = writer_reserve(w, 2)) == NULL) return;
+    p[0] = major | 24;
+    p[1] = arg;
+  } else if (arg <= 0xffff) {
+    if ((p = writer_reserve(w, 3)) == NULL) return;
+    p[0] = major | 25;
+    p[1] = arg >> 8;
+    p[2] = arg;
+  } else {
+    if ((p = writer_reserve(w, 5)) == NULL) return;
+    p[0] = major | 26;
+    p[1] = arg >> 24;
+    p[2] = arg >> 16;
+    p[3] = arg >> 8;
+    p[4] = arg;
+  }
+}
+
+void cbor_put_uint(cbor_writer_t* w, uint32_t value) {
+  writer_head(w, CBOR_TYPE_UINT, value);
+}
+
+void cbor_put_int(cbor_writer_t* w, int32_t value) {
+  if (value >= 0) {
+    writer_head(w, CBOR_TYPE_UINT, value);
+  } else {
+    // -1 - value, computed without overflowing on INT32_MIN.
+    writer_head(w, CBOR_TYPE_NEGINT, ~(uint32_t) value);
+  }
+}
+
+void cbor_put_bytes(cbor_writer_t* w, const void* data, size_t len) {
+  writer_head(w, CBOR_TYPE_BYTES, len);
+  uint8_t* p = writer_reserve(w, len);
+  if (p != NULL) memcpy(p, data, len);
+}
+
+void cbor_put_text(cbor_writer_t* w, const char* str) {
+  size_t len = strlen(str);
+  writer_head(w, CBOR_TYPE_TEXT, len);
+  uint8_t* p = writer_reserve(w, len);
+  if (p != NULL) memcpy(p, str, len);
+}
+
+void cbor_put_array(cbor_writer_t* w, size_t count) {
+  writer_head(w, CBOR_TYPE_ARRAY, count);
+}
+
+void cbor_put_map(cbor_writer_t* w, size_t count) {
+  writer_head(w, CBOR_TYPE_MAP, count);
+}
+
+void cbor_put_bool(cbor_writer_t* w, bool value) {
+  writer_head(w, CBOR_TYPE_SIMPLE, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_put_null(cbor_writer_t* w) {
+  writer_head(w, CBOR_TYPE_SIMPLE, CBOR_NULL);
+}
+
+size_t cbor_writer_mark(const cbor_writer_t* w) {
+  return w->pos;
+}
+
+void cbor_writer_rewind(cbor_writer_t* w, size_t mark) {
+  w->pos = mark;
+  w->err = TOCK_SUCCESS;
+}
+
+int cbor_writer_finish(const cbor_writer_t* w) {
+  if (w->err != TOCK_SUCCESS) return w->err;
+  return w->pos;
+}
+
+void cbor_reader_init(cbor_reader_t* r, const void* buf, size_t len) {
+  r->buf = buf;
+  r->len = len;
+  r->pos = 0;
+}
+
+bool cbor_reader_done(const cbor_reader_t* r) {
+  return r->pos == r->len;
+}
+
+// Parses the item head at `*pos`, advancing `*pos` past it. Arguments wider
+// than 32 bits are reported through `wide` so callers that cannot represent
+// them can reject them, while cbor_skip can still step over them.
+static int reader_head(const cbor_reader_t* r, size_t* pos, uint8_t* type,
+                       uint32_t* arg, bool* wide) {
+  if (*pos >= r->len) return TOCK_ESIZE;
+
+  uint8_t initial = r->buf[*pos];
+  uint8_t info    = initial & 0x1f;
+  size_t extra;
+
+  *type = initial >> 5;
+  *wide = false;
+  if (info < 24) {
+    *arg  = info;
+    *pos += 1;
+    return TOCK_SUCCESS;
+  } else if (info <= 27) {
+    extra = 1 << (info - 24);
+  } else {
+    // Reserved values and indefinite lengths.
+    return TOCK_EINVAL;
+  }
+
+  if (extra > r->len - *pos - 1) return TOCK_ESIZE;
+
+  const uint8_t* p = r->buf + *pos + 1;
+  uint32_t value   = 0;
+  for (size_t i = 0; i < extra; i++) {
+    if (extra == 8 && i < 4 && p[i] != 0) *wide = true;
+    value = (value << 8) | p[i];
+  }
+  *arg  = value;
+  *pos += 1 + extra;
+  return TOCK_SUCCESS;
+}
+
+// Reads a head of the given type. The reader only advances on success.
+static int reader_expect(cbor_reader_t* r, cbor_type_t expected, uint32_t* arg) {
+  size_t pos = r->pos;
+  uint8_t type;
+  bool wide;
+  int err = reader_head(r, &pos, &type, arg, &wide);
+  if (err < 0) return err;
+  if (type != expected || wide) return TOCK_EINVAL;
+  r->pos = pos;
+  return TOCK_SUCCESS;
+}
+
+int cbor_peek_type(const cbor_reader_t* r) {
+  size_t pos = r->pos;
+  uint8_t type;
+  uint32_t arg;
+  bool wide;
+  int err = reader_head(r, &pos, &type, &arg, &wide);
+  if (err < 0) return err;
+  return type;
+}
+
+int cbor_get_uint(cbor_reader_t* r, uint32_t* value) {
+  return reader_expect(r, CBOR_TYPE_UINT, value);
+}
+
+int cbor_get_int(cbor_reader_t* r, int32_t* value) {
+  size_t pos = r->pos;
+  uint8_t type;
+  uint32_t arg;
+  bool wide;
+  int err = reader_head(r, &pos, &type, &arg, &wide);
+  if (err < 0) return err;
+  if ((type != CBOR_TYPE_UINT && type != CBOR_TYPE_NEGINT) || wide || arg > INT32_MAX) {
+    return TOCK_EINVAL;
+  }
+  *value = (type == CBOR_TYPE_UINT) ? (int32_t) arg : -1 - (int32_t) arg;
+  r->pos = pos;
+  return TOCK_SUCCESS;
+}
+
+static int reader_string(cbor_reader_t* r, cbor_type_t type, const uint8_t** data,
+                         size_t* len) {
+  size_t start = r->pos;
+  uint32_t arg;
+  int err = reader_expect(r, type, &arg);
+  if (err < 0) return err;
+  if (arg > r->len - r->pos) {
+    r->pos = start;
+    return TOCK_ESIZE;
+  }
+  *data   = r->buf + r->pos;
+  *len    = arg;
+  r->pos += arg;
+  return TOCK_SUCCESS;
+}
+
+int cbor_get_bytes(cbor_reader_t* r, const uint8_t** data, size_t* len) {
+  return reader_string(r, CBOR_TYPE_BYTES, data, len);
+}
+
+int cbor_get_text(cbor_reader_t* r, const char** str, size_t* len) {
+  return reader_string(r, CBOR_TYPE_TEXT, (const uint8_t**) str, len);
+}
+
+int cbor_get_array(cbor_reader_t* r, size_t* count) {
+  uint32_t arg;
+  int err = reader_expect(r, CBOR_TYPE_ARRAY, &arg);
+  if (err < 0) return err;
+  *count = arg;
+  return TOCK_SUCCESS;
+}
+
+int cbor_get_map(cbor_reader_t* r, size_t* count) {
+  uint32_t arg;
+  int err = reader_expect(r, CBOR_TYPE_MAP, &arg);
+  if (err < 0) return err;
+  *count = arg;
+  return TOCK_SUCCESS;
+}
+
+int cbor_get_bool(cbor_reader_t* r, bool* value) {
+  size_t start = r->pos;
+  uint32_t arg;
+  int err = reader_expect(r, CBOR_TYPE_SIMPLE, &arg);
+  if (err < 0) return err;
+  if (arg != CBOR_FALSE && arg != CBOR_TRUE) {
+    r->pos = start;
+    return TOCK_EINVAL;
+  }
+  *value = (arg == CBOR_TRUE);
+  return TOCK_SUCCESS;
+}
+
+int cbor_skip(cbor_reader_t* r) {
+  // Counting the items still to consume, rather than recursing, keeps stack
+  // use constant however deeply a (possibly hostile) packet nests.
+  size_t pos       = r->pos;
+  size_t remaining = 1;
+
+  while (remaining > 0) {
+    uint8_t type;
+    uint32_t arg;
+    bool wide;
+    int err = reader_head(r, &pos, &type, &arg, &wide);
+    if (err < 0) return err;
+    remaining--;
+
+    size_t left = r->len - pos;
+    switch (type) {
+      case CBOR_TYPE_BYTES:
+      case CBOR_TYPE_TEXT:
+        if (wide || arg > left) return TOCK_ESIZE;
+        pos += arg;
+        break;
+      case CBOR_TYPE_ARRAY:
+      case CBOR_TYPE_MAP:
+        if (wide || arg > left) return TOCK_ESIZE;
+        remaining += (type == CBOR_TYPE_MAP) ? 2 * arg : arg;
+        break;
+      case CBOR_TYPE_TAG:
+        remaining += 1;
+        break;
+      default:
+        // Integers and simple values are entirely contained in the head.
+        break;
+    }
+
+    // Every item takes at least one byte, which also keeps `remaining` from
+    // overflowing.
+    if (remaining > r->len - pos) return TOCK_ESIZE;
+  }
+
+  r->pos = pos;
+  return TOCK_SUCCESS;
+}
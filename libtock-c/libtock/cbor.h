@@ -0,0 +1,130 @@
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimal CBOR (RFC 8949) encoding and decoding for sensor packets.
+//
+// The writer encodes directly into a caller-provided buffer (typically the
+// payload passed to `udp_send_to`) and the reader decodes in place, returning
+// pointers into the received buffer for strings. Neither allocates.
+//
+// Only definite-length items are supported: integers, byte and text strings,
+// arrays, maps, booleans and null. Indefinite lengths, tags and floats are
+// not; encode fixed-point values as integers instead (e.g. centidegrees).
+//
+// Writer errors are sticky, so a packet can be built with a run of `cbor_put_*`
+// calls and checked once at the end:
+//
+//     cbor_writer_t w;
+//     cbor_writer_init(&w, packet, udp_get_max_tx_len());
+//     cbor_put_array(&w, 3);
+//     cbor_put_int(&w, temp);
+//     cbor_put_uint(&w, humi);
+//     cbor_put_int(&w, lux);
+//     int len = cbor_writer_finish(&w);
+//     if (len > 0) udp_send_to(packet, len, &dest);
+//
+// `tools/cbor_decode.py` prints received payloads on a host.
+
+typedef enum {
+  CBOR_TYPE_UINT   = 0,
+  CBOR_TYPE_NEGINT = 1,
+  CBOR_TYPE_BYTES  = 2,
+  CBOR_TYPE_TEXT   = 3,
+  CBOR_TYPE_ARRAY  = 4,
+  CBOR_TYPE_MAP    = 5,
+  CBOR_TYPE_TAG    = 6,
+  CBOR_TYPE_SIMPLE = 7,
+} cbor_type_t;
+
+typedef struct {
+  uint8_t* buf;
+  size_t len;
+  size_t pos;
+  int err;
+} cbor_writer_t;
+
+typedef struct {
+  const uint8_t* buf;
+  size_t len;
+  size_t pos;
+} cbor_reader_t;
+
+/* cbor_writer_init
+ *  Starts encoding into `buf`, which holds at most `len` bytes.
+ */
+void cbor_writer_init(cbor_writer_t* w, void* buf, size_t len);
+
+/* cbor_put_*
+ *  Append one item. Arrays and maps take the number of elements (or
+ *  key/value pairs) that follow. Once an item does not fit, every later call
+ *  is ignored and cbor_writer_finish() reports TOCK_ESIZE.
+ */
+void cbor_put_uint(cbor_writer_t* w, uint32_t value);
+void cbor_put_int(cbor_writer_t* w, int32_t value);
+void cbor_put_bytes(cbor_writer_t* w, const void* data, size_t len);
+void cbor_put_text(cbor_writer_t* w, const char* str);
+void cbor_put_array(cbor_writer_t* w, size_t count);
+void cbor_put_map(cbor_writer_t* w, size_t count);
+void cbor_put_bool(cbor_writer_t* w, bool value);
+void cbor_put_null(cbor_writer_t* w);
+
+/* cbor_writer_mark / cbor_writer_rewind
+ *  Save and restore the write position, e.g. to drop a reading that turned
+ *  out not to fit and send the ones before it. Rewinding clears any error.
+ */
+size_t cbor_writer_mark(const cbor_writer_t* w);
+void cbor_writer_rewind(cbor_writer_t* w, size_t mark);
+
+/* cbor_writer_finish
+ *  returns the number of bytes written, or TOCK_ESIZE if anything was
+ *  dropped for lack of space.
+ */
+int cbor_writer_finish(const cbor_writer_t* w);
+
+/* cbor_reader_init
+ *  Starts decoding the `len` bytes at `buf`.
+ */
+void cbor_reader_init(cbor_reader_t* r, const void* buf, size_t len);
+
+/* cbor_peek_type
+ *  returns the major type of the next item, TOCK_ESIZE at the end of the
+ *  buffer, or TOCK_EINVAL if it is malformed.
+ */
+int cbor_peek_type(const cbor_reader_t* r);
+
+/* cbor_get_*
+ *  Consume the next item if it has the expected type.
+ *  returns TOCK_SUCCESS, TOCK_EINVAL on a type mismatch, malformed item or
+ *  value out of range, or TOCK_ESIZE if the item runs past the buffer. On
+ *  failure the reader is left unchanged.
+ *
+ *  Strings are not copied: `data`/`str` point into the reader's buffer and
+ *  text is not NUL-terminated.
+ */
+int cbor_get_uint(cbor_reader_t* r, uint32_t* value);
+int cbor_get_int(cbor_reader_t* r, int32_t* value);
+int cbor_get_bytes(cbor_reader_t* r, const uint8_t** data, size_t* len);
+int cbor_get_text(cbor_reader_t* r, const char** str, size_t* len);
+int cbor_get_array(cbor_reader_t* r, size_t* count);
+int cbor_get_map(cbor_reader_t* r, size_t* count);
+int cbor_get_bool(cbor_reader_t* r, bool* value);
+
+/* cbor_skip
+ *  Consumes the next item, including everything nested inside it.
+ *  returns TOCK_SUCCESS or a negative error as for cbor_get_*.
+ */
+int cbor_skip(cbor_reader_t* r);
+
+/* cbor_reader_done
+ *  returns true once every byte has been consumed.
+ */
+bool cbor_reader_done(const cbor_reader_t* r);
+
+#ifdef __cplusplus
+}
+#endif
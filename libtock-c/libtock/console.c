@@ -3,72 +3,115 @@
 #include <unistd.h>
 
 #include "console.h"
+#include "ring.h"
+
+// putnstr copies each write into a ring and returns once the kernel has
+// taken it, so the app can prepare its next output while this one is
+// transmitted. Writes made while the kernel is busy wait next to each other
+// in the ring and go to the kernel together.
+#define PUTSTR_BUFFER_SIZE 256
+static char putstr_slots[PUTSTR_BUFFER_SIZE];
+static ring_t putstr_ring;
+
+// The kernel accepts a second write while it transmits the first, and sends
+// it without a gap, so up to two pieces of the ring are handed over at a
+// time. Their lengths are kept here, oldest first, until their callbacks.
+#define PUTSTR_KERNEL_SLOTS 2
+static size_t putstr_kernel_slots[PUTSTR_KERNEL_SLOTS];
+static ring_t putstr_kernel;
+static size_t putstr_kernel_bytes = 0;
+
+static bool putstr_ready = false;
+
+// Bytes handed to the kernel (or dropped) since boot, and the last range of
+// bytes dropped because the kernel refused them, so each caller can tell
+// when its bytes are gone and whether they were sent.
+static uint32_t putstr_taken = 0;
+static uint32_t putstr_dropped_start = 0;
+static uint32_t putstr_dropped_end   = 0;
+static int putstr_error = TOCK_SUCCESS;
+
+static void putstr_cb(int _x, int _y, int _z, void* ud);
+
+static void putstr_submit(void) {
+  while (ring_count(&putstr_kernel) < PUTSTR_KERNEL_SLOTS) {
+    void* bytes;
+    size_t len = ring_peek(&putstr_ring, putstr_kernel_bytes, &bytes);
+    if (len == 0) return;
+
+    int ret = putnstr_async((const char*) bytes, len, putstr_cb, NULL);
+    if (ret < 0) {
+      if (putstr_kernel_bytes > 0) {
+        // Retry once the kernel has finished a write.
+        return;
+      }
+      // Nothing in flight, so drop everything queued.
+      size_t dropped = ring_count(&putstr_ring);
+      ring_release(&putstr_ring, dropped);
+      putstr_dropped_start = putstr_taken;
+      putstr_taken        += dropped;
+      putstr_dropped_end   = putstr_taken;
+      putstr_error         = ret;
+      return;
+    }
 
-typedef struct putstr_data {
-  char* buf;
-  int len;
-  bool called;
-  struct putstr_data* next;
-} putstr_data_t;
-
-static putstr_data_t *putstr_head = NULL;
-static putstr_data_t *putstr_tail = NULL;
+    ring_push(&putstr_kernel, &len);
+    putstr_kernel_bytes += len;
+    putstr_taken        += len;
+  }
+}
 
 static void putstr_cb(int _x __attribute__ ((unused)),
                       int _y __attribute__ ((unused)),
                       int _z __attribute__ ((unused)),
                       void* ud __attribute__ ((unused))) {
-  putstr_data_t* data = putstr_head;
-  data->called = true;
-  putstr_head  = data->next;
-
-  if (putstr_head == NULL) {
-    putstr_tail = NULL;
-  } else {
-    int ret;
-    ret = putnstr_async(putstr_head->buf, putstr_head->len, putstr_cb, NULL);
-    if (ret < 0) {
-      // XXX There's no path to report errors currently, so just drop it
-      putstr_cb(0, 0, 0, NULL);
-    }
+  size_t len;
+  if (ring_pop(&putstr_kernel, &len)) {
+    putstr_kernel_bytes -= len;
+    ring_release(&putstr_ring, len);
   }
+  putstr_submit();
 }
 
-int putnstr(const char *str, size_t len) {
-  int ret = TOCK_SUCCESS;
-
-  putstr_data_t* data = (putstr_data_t*)malloc(sizeof(putstr_data_t));
-  if (data == NULL) return TOCK_ENOMEM;
+static void putstr_init(void) {
+  if (putstr_ready) return;
+  ring_init(&putstr_ring, putstr_slots, 1, PUTSTR_BUFFER_SIZE);
+  ring_init(&putstr_kernel, putstr_kernel_slots, sizeof(size_t), PUTSTR_KERNEL_SLOTS);
+  putstr_ready = true;
+}
 
-  data->len    = len;
-  data->called = false;
-  data->buf    = (char*)malloc(len * sizeof(char));
-  if (data->buf == NULL) {
-    ret = TOCK_ENOMEM;
-    goto putnstr_fail_buf_alloc;
-  }
-  strncpy(data->buf, str, len);
-  data->next = NULL;
-
-  if (putstr_tail == NULL) {
-    // Invariant, if tail is NULL, head is also NULL
-    ret = putnstr_async(data->buf, data->len, putstr_cb, NULL);
-    if (ret < 0) goto putnstr_fail_async;
-    putstr_head = data;
-    putstr_tail = data;
-  } else {
-    putstr_tail->next = data;
-    putstr_tail       = data;
+int putnstr(const char *str, size_t len) {
+  putstr_init();
+
+  // Bytes before ours in the ring, whether or not handed over yet.
+  uint32_t start = putstr_taken + ring_count(&putstr_ring) - putstr_kernel_bytes;
+  size_t done    = 0;
+  while (true) {
+    done += ring_write(&putstr_ring, str + done, len - done);
+    putstr_submit();
+    if (done == len) break;
+    // Wait for the kernel to finish a write and free up room.
+    yield();
   }
 
-  yield_for(&data->called);
+  uint32_t end = start + len;
+  while ((int32_t) (putstr_taken - end) < 0) {
+    yield();
+  }
 
-putnstr_fail_async:
-  free(data->buf);
-putnstr_fail_buf_alloc:
-  free(data);
+  // Dropped ranges do not overlap what was sent, so checking one end is
+  // enough.
+  if (len > 0 && (int32_t) (end - putstr_dropped_start) > 0 &&
+      (int32_t) (putstr_dropped_end - end) >= 0) {
+    return putstr_error;
+  }
+  return TOCK_SUCCESS;
+}
 
-  return ret;
+void putstr_flush(void) {
+  while (putstr_ready && ring_count(&putstr_ring) > 0) {
+    yield();
+  }
 }
 
 int putnstr_async(const char *str, size_t len, subscribe_cb cb, void* userdata) {
@@ -91,49 +134,34 @@ int putnstr_async(const char *str, size_t len, subscribe_cb cb, void* userdata)
   return ret;
 }
 
-int getnstr_async(char *str, size_t len, subscribe_cb cb, void* userdata) {
-  int ret;
-
-  ret = allow(DRIVER_NUM_CONSOLE, 2, str, len);
+// Allows `str` and starts reading into it.
+static int getnstr_start(char *str, size_t len) {
+  int ret = allow(DRIVER_NUM_CONSOLE, 2, str, len);
   if (ret < 0) return ret;
 
-  ret = subscribe(DRIVER_NUM_CONSOLE, 2, cb, userdata);
-  if (ret < 0) return ret;
-
-  ret = command(DRIVER_NUM_CONSOLE, 2, len, 0);
-  return ret;
+  return command(DRIVER_NUM_CONSOLE, 2, len, 0);
 }
 
-typedef struct getnstr_data {
-  bool called;
-  int result;
-} getnstr_data_t;
-
-static getnstr_data_t getnstr_data = { true, 0 };
+int getnstr_async(char *str, size_t len, subscribe_cb cb, void* userdata) {
+  int ret = subscribe(DRIVER_NUM_CONSOLE, 2, cb, userdata);
+  if (ret < 0) return ret;
 
-static void getnstr_cb(int result,
-                       int _y __attribute__ ((unused)),
-                       int _z __attribute__ ((unused)),
-                       void* ud __attribute__ ((unused))) {
-  getnstr_data.result = result;
-  getnstr_data.called = true;
+  return getnstr_start(str, len);
 }
 
 int getnstr(char *str, size_t len) {
-  int ret;
-
-  if (!getnstr_data.called) {
+  tock_completion_t done;
+  int ret = tock_completion_subscribe(&done, DRIVER_NUM_CONSOLE, 2);
+  if (ret == TOCK_EBUSY) {
     // A call is already in progress
     return TOCK_EALREADY;
   }
-  getnstr_data.called = false;
-
-  ret = getnstr_async(str, len, getnstr_cb, NULL);
   if (ret < 0) return ret;
 
-  yield_for(&getnstr_data.called);
+  ret = tock_completion_wait(&done, getnstr_start(str, len));
+  if (ret < 0) return ret;
 
-  return getnstr_data.result;
+  return done.arg0;
 }
 
 int getch(void) {
@@ -148,3 +176,35 @@ int getch(void) {
 int getnstr_abort(void) {
   return command(DRIVER_NUM_CONSOLE, 3, 0, 0);
 }
+
+int console_set_priority(int priority) {
+  return command(DRIVER_NUM_CONSOLE, 4, priority, 0);
+}
+
+int console_set_line_prefix(bool enable) {
+  return command(DRIVER_NUM_CONSOLE, 5, enable, 0);
+}
+
+#define CONSOLE_STAT_BYTES     0
+#define CONSOLE_STAT_WRITES    1
+#define CONSOLE_STAT_WAIT      2
+#define CONSOLE_STAT_MAX_WAIT  3
+#define CONSOLE_STAT_FREQUENCY 4
+
+static uint32_t ticks_to_us(uint32_t ticks, uint32_t frequency) {
+  if (frequency == 0) return 0;
+  return (uint32_t) (((uint64_t) ticks * 1000000) / frequency);
+}
+
+int console_stats(console_stats_t* stats) {
+  int values[5];
+  for (int i = 0; i < 5; i++) {
+    values[i] = command(DRIVER_NUM_CONSOLE, 6, i, 0);
+    if (values[i] < 0) return values[i];
+  }
+  stats->bytes       = values[CONSOLE_STAT_BYTES];
+  stats->writes      = values[CONSOLE_STAT_WRITES];
+  stats->wait_us     = ticks_to_us(values[CONSOLE_STAT_WAIT], values[CONSOLE_STAT_FREQUENCY]);
+  stats->max_wait_us = ticks_to_us(values[CONSOLE_STAT_MAX_WAIT], values[CONSOLE_STAT_FREQUENCY]);
+  return TOCK_SUCCESS;
+}
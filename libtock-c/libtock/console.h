@@ -8,10 +8,38 @@ extern "C" {
 
 #define DRIVER_NUM_CONSOLE 0x1
 
+// putstr and putnstr copy the string and return once the kernel has accepted
+// it, which may be before it has been transmitted; use putstr_flush to wait
+// for all output to be sent. The kernel takes a second write while the first
+// is in flight, so consecutive writes go out back to back.
 int putstr(const char* str);
 int putnstr(const char* str, size_t len);
 int putnstr_async(const char* str, size_t len, subscribe_cb cb, void* userdata);
 
+// Waits until everything written with putstr/putnstr has been transmitted.
+void putstr_flush(void);
+
+// When several apps write to the console, the kernel takes turns between
+// them a line at a time. An app with a higher priority (default 0) is always
+// served first, e.g. an interactive shell sharing the console with loggers.
+// The board sets how high each app may go; above that this returns
+// TOCK_EINVAL.
+int console_set_priority(int priority);
+
+// Prefix each of this app's lines with "[<process name>] ".
+int console_set_line_prefix(bool enable);
+
+typedef struct {
+  uint32_t bytes;       // bytes transmitted
+  uint32_t writes;      // writes completed
+  uint32_t wait_us;     // total time writes waited for their first byte to be sent
+  uint32_t max_wait_us; // longest such wait
+} console_stats_t;
+
+// This app's console counters. Wait times are 0 if the board's console has
+// no clock.
+int console_stats(console_stats_t* stats);
+
 int getnstr(char *str, size_t len);
 int getnstr_async(char *str, size_t len, subscribe_cb cb, void* userdata);
 
@@ -16,32 +16,23 @@ int crc_set_buffer(const void* buf, size_t len) {
   return allow(DRIVER_NUM_CRC, 0, (void*) buf, len);
 }
 
-struct data {
-  bool fired;
-  int status;
-  uint32_t result;
-};
-
-static void callback(int status, int v1, __attribute__((unused)) int v2, void *data)
-{
-  struct data *d = data;
-
-  d->fired  = true;
-  d->status = status;
-  d->result = v1;
-}
-
 int crc_compute(const void *buf, size_t buflen, enum crc_alg alg, uint32_t *result)
 {
-  struct data d = { .fired = false };
-
-  crc_set_buffer(buf, buflen);
-  crc_subscribe(callback, (void *) &d);
-  crc_request(alg);
-  yield_for(&d.fired);
-
-  if (d.status == TOCK_SUCCESS)
-    *result = d.result;
-
-  return d.status;
+  tock_completion_t done;
+  int err;
+
+  err = tock_completion_subscribe(&done, DRIVER_NUM_CRC, 0);
+  if (err < 0)
+    return err;
+  err = crc_set_buffer(buf, buflen);
+  if (err >= 0)
+    err = crc_request(alg);
+  err = tock_completion_wait(&done, err);
+  if (err < 0)
+    return err;
+
+  if (done.arg0 == TOCK_SUCCESS)
+    *result = done.arg1;
+
+  return done.arg0;
 }
@@ -61,6 +61,11 @@ struct reldata {
   uint32_t data[];
 };
 
+// ELF relocation types (the low byte of `r_info`) that crt0 fixes up. The
+// linker resolves R_ARM_TARGET1 (used for .init_array) as an absolute word.
+#define R_ARM_ABS32   2
+#define R_ARM_TARGET1 38
+
 __attribute__ ((section(".start"), used))
 __attribute__ ((weak))
 __attribute__ ((naked))
@@ -246,14 +251,15 @@ void _start(void* app_start __attribute__((unused)),
 }
 
 // C startup routine that configures memory for the process. This also handles
-// PIC fixups that are required for the application.
+// PIC fixups that are required for the application. It is only referenced from
+// the assembly in `_start`, hence `used` to keep LTO from discarding it.
 //
 // Arguments:
 // - `app_start`: The address of where the app binary starts in flash. This does
 //   not include the TBF header or any padding before the app.
 // - `mem_start`: The starting address of the memory region assigned to this
 //   app.
-__attribute__((noreturn))
+__attribute__((noreturn, used))
 void _c_start_pic(uint32_t app_start, uint32_t mem_start) {
   struct hdr* myhdr = (struct hdr*)app_start;
 
@@ -304,8 +310,17 @@ void _c_start_pic(uint32_t app_start, uint32_t mem_start) {
   // The data structure used for these is `struct reldata`, where a 32 bit
   // length field is followed by that many entries. We iterate each entry and
   // correct addresses.
+  //
+  // Only absolute word relocations hold addresses that need fixing. Code
+  // placed in RAM with `TOCK_RAMFUNC` also brings PC-relative relocations
+  // (e.g. calls between RAM functions) into .rel.data, and those are already
+  // correct wherever the section lands.
   struct reldata* rd = (struct reldata*)(myhdr->reldata_start + (uint32_t)app_start);
   for (uint32_t i = 0; i < (rd->len / (int)sizeof(uint32_t)); i += 2) {
+    uint32_t type = rd->data[i + 1] & 0xff;
+    if (type != R_ARM_ABS32 && type != R_ARM_TARGET1) {
+      continue;
+    }
     // The entries are offsets from the beginning of the app's memory region.
     // First, we get a pointer to the location of the address we need to fix.
     uint32_t* target = (uint32_t*)(rd->data[i] + mem_start);
@@ -324,6 +339,14 @@ void _c_start_pic(uint32_t app_start, uint32_t mem_start) {
     }
   }
 
+  // The data copy above may have placed code (`TOCK_RAMFUNC`) in RAM. Make
+  // sure those stores complete before any of it is fetched.
+#if defined(__thumb__)
+  asm volatile ("dsb\n"
+                "isb\n"
+                ::: "memory");
+#endif
+
   main();
   while (1) {
     yield();
@@ -337,7 +360,7 @@ void _c_start_pic(uint32_t app_start, uint32_t mem_start) {
 //   not include the TBF header or any padding before the app.
 // - `mem_start`: The starting address of the memory region assigned to this
 //   app.
-__attribute__((noreturn))
+__attribute__((noreturn, used))
 void _c_start_nopic(uint32_t app_start, uint32_t mem_start) {
   struct hdr* myhdr = (struct hdr*)app_start;
 
@@ -361,6 +384,12 @@ void _c_start_nopic(uint32_t app_start, uint32_t mem_start) {
   char* bss_start = (char*)(myhdr->bss_start + mem_start);
   memset(bss_start, 0, myhdr->bss_size);
 
+#if defined(__riscv)
+  // Synchronize instruction fetch with any code (`TOCK_RAMFUNC`) that the data
+  // copy placed in RAM.
+  asm volatile ("fence.i" ::: "memory");
+#endif
+
   main();
   while (1) {
     yield();
@@ -0,0 +1,134 @@
+#include "event.h"
+#include "timer.h"
+
+void event_loop_init(event_loop_t* loop) {
+  ring_init(&loop->queue, loop->slots, sizeof(event_t), EVENT_QUEUE_SIZE);
+  loop->dropped = 0;
+  loop->running = false;
+}
+
+void event_source_init(event_loop_t* loop, event_source_t* source, event_handler handler,
+                       void* ud) {
+  source->loop       = loop;
+  source->handler    = handler;
+  source->ud         = ud;
+  source->subscribed = false;
+  source->arg0       = 0;
+  source->arg1       = 0;
+  source->arg2       = 0;
+  source->count      = 0;
+}
+
+void event_source_cb(int arg0, int arg1, int arg2, void* ud) {
+  event_source_t* source = (event_source_t*) ud;
+  // Removed, but something still calls back with it.
+  if (source->loop == NULL) return;
+
+  event_t event = { source, arg0, arg1, arg2 };
+  if (!ring_push(&source->loop->queue, &event)) {
+    source->loop->dropped++;
+  }
+}
+
+int event_source_subscribe(event_source_t* source, uint32_t driver, uint32_t subscribe_num) {
+  int err = subscribe(driver, subscribe_num, event_source_cb, source);
+  if (err < TOCK_SUCCESS) return err;
+  source->subscribed    = true;
+  source->driver        = driver;
+  source->subscribe_num = subscribe_num;
+  return TOCK_SUCCESS;
+}
+
+int event_source_remove(event_source_t* source) {
+  int err = TOCK_SUCCESS;
+  if (source->subscribed) {
+    err = subscribe(source->driver, source->subscribe_num, TOCK_DEACTIVATE_CALLBACK, NULL);
+    source->subscribed = false;
+  }
+
+  // Blank out the source's queued events; dispatch skips them.
+  event_loop_t* loop = source->loop;
+  if (loop != NULL) {
+    size_t skip = 0;
+    void* slots;
+    size_t n;
+    while ((n = ring_peek(&loop->queue, skip, &slots)) > 0) {
+      event_t* events = (event_t*) slots;
+      for (size_t i = 0; i < n; i++) {
+        if (events[i].source == source) events[i].source = NULL;
+      }
+      skip += n;
+    }
+  }
+  source->loop = NULL;
+  return err;
+}
+
+int event_post(event_source_t* source, int arg0, int arg1, int arg2) {
+  if (tock_enqueue(event_source_cb, arg0, arg1, arg2, source) < 0) {
+    return TOCK_ENOMEM;
+  }
+  return TOCK_SUCCESS;
+}
+
+// Runs the handler of the oldest queued event.
+// returns its source, or NULL if no event is queued.
+static event_source_t* dispatch(event_loop_t* loop) {
+  event_t event;
+  while (ring_pop(&loop->queue, &event)) {
+    event_source_t* source = event.source;
+    if (source == NULL) continue;
+
+    source->arg0 = event.arg0;
+    source->arg1 = event.arg1;
+    source->arg2 = event.arg2;
+    source->count++;
+    if (source->handler != NULL) {
+      source->handler(source, event.arg0, event.arg1, event.arg2);
+    }
+    return source;
+  }
+  return NULL;
+}
+
+static void timeout_cb(__attribute__ ((unused)) int now,
+                       __attribute__ ((unused)) int arg1,
+                       __attribute__ ((unused)) int arg2,
+                       void* ud) {
+  *((bool*) ud) = true;
+}
+
+event_source_t* event_wait_any(event_loop_t* loop, uint32_t timeout_ms) {
+  if (ring_count(&loop->queue) > 0 || timeout_ms == 0) {
+    return dispatch(loop);
+  }
+
+  bool timeout = false;
+  tock_timer_t timer;
+  if (timeout_ms != EVENT_WAIT_FOREVER) {
+    timer_in(timeout_ms, timeout_cb, &timeout, &timer);
+  }
+
+  event_source_t* source = NULL;
+  while (source == NULL && !timeout) {
+    yield();
+    // The queue may hold only events of removed sources.
+    source = dispatch(loop);
+  }
+
+  if (timeout_ms != EVENT_WAIT_FOREVER && !timeout) {
+    timer_cancel(&timer);
+  }
+  return source;
+}
+
+void event_loop_run(event_loop_t* loop) {
+  loop->running = true;
+  while (loop->running) {
+    event_wait_any(loop, EVENT_WAIT_FOREVER);
+  }
+}
+
+void event_loop_stop(event_loop_t* loop) {
+  loop->running = false;
+}
@@ -0,0 +1,147 @@
+// Event loop
+//
+// An event loop waits on several event sources at once and runs a handler
+// for each event as it comes, so an app can keep several operations going
+// (a sensor read, a radio receive, a timer, ...) and react to whichever
+// finishes first, instead of completing them one at a time with the `_sync`
+// calls.
+//
+// An event source stands for one kind of callback. It can be subscribed to
+// a driver's subscribe number directly with `event_source_subscribe`, or be
+// handed to any libtock function that takes a callback and its user data as
+// `event_source_cb` and the source (for example `timer_every` or
+// `rng_set_callback`). `event_post` queues an event from the app itself,
+// through the libtock task queue (see `tock_enqueue`), so it keeps its place
+// among callbacks that libtock defers.
+//
+// Callbacks only record the event: the events of all sources of a loop go
+// into one queue, in the order they came, and handlers run from
+// `event_wait_any` or `event_loop_run`, one at a time. A handler can call
+// `_sync` functions or wait on other things; events that come meanwhile are
+// queued and handled after it returns.
+//
+// Usage:
+//
+//   static event_loop_t loop;
+//   static event_source_t tick, random;
+//   static tock_timer_t timer;
+//
+//   event_loop_init(&loop);
+//   event_source_init(&loop, &tick, on_tick, NULL);
+//   timer_every(100, event_source_cb, &tick, &timer);
+//   event_source_init(&loop, &random, on_random, NULL);
+//   event_source_subscribe(&random, DRIVER_NUM_RNG, 0);
+//   ...
+//   event_loop_run(&loop);
+
+#pragma once
+
+#include "ring.h"
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Events a loop holds before it drops new ones.
+#define EVENT_QUEUE_SIZE 16
+
+// For event_wait_any: wait without a timeout.
+#define EVENT_WAIT_FOREVER 0xffffffff
+
+struct event_loop;
+struct event_source;
+
+// Handles an event with the arguments of the callback that brought it.
+typedef void (event_handler)(struct event_source* source, int arg0, int arg1, int arg2);
+
+typedef struct event_source {
+  struct event_loop* loop;
+  event_handler* handler;
+  void* ud;
+  // The driver and subscribe number, if subscribed by
+  // event_source_subscribe.
+  bool subscribed;
+  uint32_t driver;
+  uint32_t subscribe_num;
+  // Arguments of the last event handled.
+  int arg0;
+  int arg1;
+  int arg2;
+  // Events handled.
+  uint32_t count;
+} event_source_t;
+
+typedef struct {
+  event_source_t* source;
+  int arg0;
+  int arg1;
+  int arg2;
+} event_t;
+
+typedef struct event_loop {
+  ring_t queue;
+  event_t slots[EVENT_QUEUE_SIZE];
+  // Events dropped because the queue was full.
+  uint32_t dropped;
+  bool running;
+} event_loop_t;
+
+/* event_loop_init
+ *  Sets up an event loop with no sources.
+ */
+void event_loop_init(event_loop_t* loop);
+
+/* event_source_init
+ *  Adds `source` to `loop`, to run `handler` (which may be NULL) on its
+ *  events. `ud` is for the app, and is not used by the loop.
+ */
+void event_source_init(event_loop_t* loop, event_source_t* source, event_handler handler,
+                       void* ud);
+
+/* event_source_cb
+ *  The callback to give libtock functions (or subscribe) along with a
+ *  source as the user data, to make their callbacks events of the source.
+ */
+void event_source_cb(int arg0, int arg1, int arg2, void* source);
+
+/* event_source_subscribe
+ *  Subscribes `source` to `subscribe_num` of `driver`.
+ */
+int event_source_subscribe(event_source_t* source, uint32_t driver, uint32_t subscribe_num);
+
+/* event_source_remove
+ *  Unsubscribes `source`, if it was subscribed, and takes it out of its
+ *  loop. Its queued events are dropped. Stop anything else that calls
+ *  event_source_cb with it (cancel its timer, ...) first.
+ */
+int event_source_remove(event_source_t* source);
+
+/* event_post
+ *  Queues an event for `source` as if its callback had been called.
+ *  returns TOCK_ENOMEM if the task queue is full.
+ */
+int event_post(event_source_t* source, int arg0, int arg1, int arg2);
+
+/* event_wait_any
+ *  Waits up to `timeout_ms` (or forever, with EVENT_WAIT_FOREVER) for an
+ *  event of any source of `loop`, and runs its handler. A timeout of 0 only
+ *  handles an event that is already queued.
+ *  returns the event's source, with its arguments in `arg0` to `arg2`, or
+ *  NULL if the timeout passed first.
+ */
+event_source_t* event_wait_any(event_loop_t* loop, uint32_t timeout_ms);
+
+/* event_loop_run
+ *  Handles events until a handler calls event_loop_stop.
+ */
+void event_loop_run(event_loop_t* loop);
+
+/* event_loop_stop
+ *  Makes event_loop_run return once the current handler returns.
+ */
+void event_loop_stop(event_loop_t* loop);
+
+#ifdef __cplusplus
+}
+#endif
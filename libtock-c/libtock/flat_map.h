@@ -0,0 +1,228 @@
+// Fixed-capacity sorted map for C++ apps
+//
+// tock::flat_map<Key, T, N> maps up to N keys to values, keeping the
+// entries sorted by key in a tock::static_vector. Lookups are a binary
+// search over one contiguous array, with no nodes to allocate or chase, and
+// iterating visits the entries in key order. Inserting and erasing move the
+// entries after the one changed, which is cheap for the small maps apps
+// keep (device tables, settings, handles).
+//
+// The interface follows std::map, except that entries are std::pair<Key, T>
+// (the key is not const, so entries can be moved around; do not change the
+// key of an entry in place) and inserting into a full map fails instead of
+// throwing: insert and try_emplace return {end(), false}, and there is no
+// operator[], since it would have nothing to return. Iterators, pointers and
+// references to entries are invalidated by inserting and erasing.
+//
+// Usage:
+//
+//   tock::flat_map<uint16_t, const char*, 8> names;
+//   names.insert({0x2a19, "Battery Level"});
+//   auto it = names.find(uuid);
+//   if (it != names.end()) printf("%s\n", it->second);
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <stddef.h>
+#include <tuple>
+#include <utility>
+
+#include "static_vector.h"
+
+namespace tock {
+
+template <typename Key, typename T, size_t N, typename Compare = std::less<Key>>
+class flat_map final {
+public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<Key, T> value_type;
+  typedef Compare key_compare;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef typename static_vector<value_type, N>::iterator iterator;
+  typedef typename static_vector<value_type, N>::const_iterator const_iterator;
+  typedef typename static_vector<value_type, N>::reverse_iterator reverse_iterator;
+  typedef typename static_vector<value_type, N>::const_reverse_iterator const_reverse_iterator;
+
+  flat_map() {}
+
+  // Takes the entries of `values` until the map is full. Later entries with
+  // the same key as an earlier one are ignored, as with std::map.
+  flat_map(std::initializer_list<value_type> values) {
+    for (const value_type& value : values) insert(value);
+  }
+
+  // ***** Iterators *****
+
+  iterator begin() {
+    return entries_.begin();
+  }
+  const_iterator begin() const {
+    return entries_.begin();
+  }
+  const_iterator cbegin() const {
+    return entries_.cbegin();
+  }
+  iterator end() {
+    return entries_.end();
+  }
+  const_iterator end() const {
+    return entries_.end();
+  }
+  const_iterator cend() const {
+    return entries_.cend();
+  }
+  reverse_iterator rbegin() {
+    return entries_.rbegin();
+  }
+  const_reverse_iterator rbegin() const {
+    return entries_.rbegin();
+  }
+  reverse_iterator rend() {
+    return entries_.rend();
+  }
+  const_reverse_iterator rend() const {
+    return entries_.rend();
+  }
+
+  // ***** Capacity *****
+
+  bool empty() const {
+    return entries_.empty();
+  }
+  bool full() const {
+    return entries_.full();
+  }
+  size_type size() const {
+    return entries_.size();
+  }
+  static constexpr size_type capacity() {
+    return N;
+  }
+  static constexpr size_type max_size() {
+    return N;
+  }
+
+  // ***** Lookup *****
+
+  // The first entry whose key is not less than `key`.
+  iterator lower_bound(const Key& key) {
+    return std::lower_bound(begin(), end(), key, key_less());
+  }
+  const_iterator lower_bound(const Key& key) const {
+    return std::lower_bound(begin(), end(), key, key_less());
+  }
+
+  // The first entry whose key is greater than `key`.
+  iterator upper_bound(const Key& key) {
+    return std::upper_bound(begin(), end(), key, less_key());
+  }
+  const_iterator upper_bound(const Key& key) const {
+    return std::upper_bound(begin(), end(), key, less_key());
+  }
+
+  iterator find(const Key& key) {
+    iterator it = lower_bound(key);
+    return it != end() && !compare_(key, it->first) ? it : end();
+  }
+  const_iterator find(const Key& key) const {
+    const_iterator it = lower_bound(key);
+    return it != end() && !compare_(key, it->first) ? it : end();
+  }
+
+  bool contains(const Key& key) const {
+    return find(key) != end();
+  }
+
+  size_type count(const Key& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  // ***** Modifiers *****
+
+  void clear() {
+    entries_.clear();
+  }
+
+  // Adds an entry for `key` with a value constructed from `args`, unless
+  // there is one already.
+  // returns the entry for `key` and whether it was added, or {end(), false}
+  // if the map is full.
+  template <typename ... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&& ... args) {
+    iterator it = lower_bound(key);
+    if (it != end() && !compare_(key, it->first)) {
+      return std::make_pair(it, false);
+    }
+    if (full()) {
+      return std::make_pair(end(), false);
+    }
+    it = entries_.emplace(it, std::piecewise_construct, std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args) ...));
+    return std::make_pair(it, true);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  // Like insert, but replaces the value if there is an entry for `key`.
+  template <typename Value>
+  std::pair<iterator, bool> insert_or_assign(const Key& key, Value&& value) {
+    std::pair<iterator, bool> result = try_emplace(key, std::forward<Value>(value));
+    if (!result.second && result.first != end()) {
+      result.first->second = std::forward<Value>(value);
+    }
+    return result;
+  }
+
+  iterator erase(const_iterator pos) {
+    return entries_.erase(pos);
+  }
+
+  // returns the number of entries removed.
+  size_type erase(const Key& key) {
+    iterator it = find(key);
+    if (it == end()) return 0;
+    entries_.erase(it);
+    return 1;
+  }
+
+private:
+  struct key_less {
+    bool operator()(const value_type& entry, const Key& key) const {
+      return Compare()(entry.first, key);
+    }
+  };
+
+  struct less_key {
+    bool operator()(const Key& key, const value_type& entry) const {
+      return Compare()(key, entry.first);
+    }
+  };
+
+  static_vector<value_type, N> entries_;
+  Compare compare_;
+};
+
+template <typename Key, typename T, size_t N, typename Compare>
+bool operator==(const flat_map<Key, T, N, Compare>& a, const flat_map<Key, T, N, Compare>& b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename Key, typename T, size_t N, typename Compare>
+bool operator!=(const flat_map<Key, T, N, Compare>& a, const flat_map<Key, T, N, Compare>& b) {
+  return !(a == b);
+}
+
+}  // namespace tock
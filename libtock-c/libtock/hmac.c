@@ -0,0 +1,136 @@
+#include <string.h>
+
+#include "hmac.h"
+
+#define HMAC_ALLOW_KEY  0
+#define HMAC_ALLOW_DATA 1
+#define HMAC_ALLOW_DEST 2
+
+#define HMAC_CMD_SET_ALGORITHM 0
+#define HMAC_CMD_RUN           1
+
+#define HMAC_ALG_SHA256 0
+
+// The kernel driver takes exactly this many key bytes.
+#define HMAC_KERNEL_KEY_LEN 32
+
+// ***** Software HMAC *****
+
+void hmac_sha256_init(hmac_sha256_ctx_t* ctx, const uint8_t* key, size_t key_len) {
+  uint8_t block[SHA256_BLOCK_LEN] = { 0 };
+
+  if (key_len > SHA256_BLOCK_LEN) {
+    sha256(key, key_len, block);
+  } else {
+    memcpy(block, key, key_len);
+  }
+
+  for (int i = 0; i < SHA256_BLOCK_LEN; i++) {
+    block[i] ^= 0x36;
+  }
+  sha256_init(&ctx->inner);
+  sha256_update(&ctx->inner, block, SHA256_BLOCK_LEN);
+
+  // 0x36 ^ 0x5c turns the inner pad into the outer pad.
+  for (int i = 0; i < SHA256_BLOCK_LEN; i++) {
+    block[i] ^= 0x36 ^ 0x5c;
+  }
+  sha256_init(&ctx->outer);
+  sha256_update(&ctx->outer, block, SHA256_BLOCK_LEN);
+
+  memset(block, 0, sizeof(block));
+}
+
+void hmac_sha256_update(hmac_sha256_ctx_t* ctx, const void* data, size_t len) {
+  sha256_update(&ctx->inner, data, len);
+}
+
+void hmac_sha256_update_chunks(hmac_sha256_ctx_t* ctx, const sha256_chunk_t* chunks,
+                               size_t count) {
+  sha256_update_chunks(&ctx->inner, chunks, count);
+}
+
+void hmac_sha256_finish(hmac_sha256_ctx_t* ctx, uint8_t* mac) {
+  uint8_t inner[SHA256_DIGEST_LEN];
+  sha256_finish(&ctx->inner, inner);
+  sha256_update(&ctx->outer, inner, sizeof(inner));
+  sha256_finish(&ctx->outer, mac);
+}
+
+bool hmac_sha256_verify(const uint8_t* a, const uint8_t* b) {
+  uint8_t diff = 0;
+  for (int i = 0; i < HMAC_SHA256_LEN; i++) {
+    diff |= a[i] ^ b[i];
+  }
+  return diff == 0;
+}
+
+// ***** System Call Interface *****
+
+// Keys shorter than the kernel's fixed length are zero-padded, which HMAC
+// does anyway, so the result is unchanged.
+static uint8_t kernel_key[HMAC_KERNEL_KEY_LEN];
+
+bool hmac_sha256_exists(void) {
+  return driver_exists(DRIVER_NUM_HMAC);
+}
+
+int hmac_sha256_digest(const uint8_t* key, size_t key_len, const void* data, size_t len,
+                       uint8_t* mac, subscribe_cb callback, void* ud) {
+  int err;
+
+  if (key_len > HMAC_KERNEL_KEY_LEN || len == 0 || !hmac_sha256_exists()) {
+    hmac_sha256_ctx_t ctx;
+    hmac_sha256_init(&ctx, key, key_len);
+    hmac_sha256_update(&ctx, data, len);
+    hmac_sha256_finish(&ctx, mac);
+    return tock_enqueue(callback, TOCK_SUCCESS, 0, 0, ud) < 0 ? TOCK_FAIL : TOCK_SUCCESS;
+  }
+
+  memset(kernel_key, 0, sizeof(kernel_key));
+  memcpy(kernel_key, key, key_len);
+
+  err = subscribe(DRIVER_NUM_HMAC, 0, callback, ud);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(DRIVER_NUM_HMAC, HMAC_ALLOW_KEY, kernel_key, sizeof(kernel_key));
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(DRIVER_NUM_HMAC, HMAC_ALLOW_DATA, (void*) data, len);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(DRIVER_NUM_HMAC, HMAC_ALLOW_DEST, mac, HMAC_SHA256_LEN);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = command(DRIVER_NUM_HMAC, HMAC_CMD_SET_ALGORITHM, HMAC_ALG_SHA256, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  return command(DRIVER_NUM_HMAC, HMAC_CMD_RUN, 0, 0);
+}
+
+// ***** Synchronous Calls *****
+
+typedef struct {
+  bool fired;
+  int status;
+} hmac_result_t;
+
+static void hmac_cb(int status,
+                    __attribute__ ((unused)) int unused1,
+                    __attribute__ ((unused)) int unused2,
+                    void* ud) {
+  hmac_result_t* result = (hmac_result_t*) ud;
+  result->status = status;
+  result->fired  = true;
+}
+
+int hmac_sha256_digest_sync(const uint8_t* key, size_t key_len, const void* data,
+                            size_t len, uint8_t* mac) {
+  hmac_result_t result = { .fired = false };
+
+  int err = hmac_sha256_digest(key, key_len, data, len, mac, hmac_cb, &result);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&result.fired);
+  return result.status;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "sha256.h"
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRIVER_NUM_HMAC 0x40003
+
+// HMAC-SHA256 (RFC 2104).
+//
+// The streaming interface (init/update/finish) always runs in software, so
+// it works on every board and for messages assembled from several buffers.
+//
+// The one-shot interface hands a contiguous message to the kernel's HMAC
+// engine when the board has one. The asynchronous form lets the app prepare
+// the next message (e.g. read the next flash page) while the engine works on
+// the current one. Keys longer than 32 bytes, which the kernel driver does
+// not accept, are handled in software.
+
+#define HMAC_SHA256_LEN 32
+
+typedef struct {
+  sha256_ctx_t inner;
+  sha256_ctx_t outer;
+} hmac_sha256_ctx_t;
+
+/* hmac_sha256_init
+ *  Starts a new MAC with the given key.
+ */
+void hmac_sha256_init(hmac_sha256_ctx_t* ctx, const uint8_t* key, size_t key_len);
+
+/* hmac_sha256_update / hmac_sha256_update_chunks
+ *  Add message data, as for sha256_update / sha256_update_chunks.
+ */
+void hmac_sha256_update(hmac_sha256_ctx_t* ctx, const void* data, size_t len);
+void hmac_sha256_update_chunks(hmac_sha256_ctx_t* ctx, const sha256_chunk_t* chunks,
+                               size_t count);
+
+/* hmac_sha256_finish
+ *  Writes the 32-byte MAC to `mac`.
+ */
+void hmac_sha256_finish(hmac_sha256_ctx_t* ctx, uint8_t* mac);
+
+/* hmac_sha256_exists
+ *  returns true if the board has a kernel HMAC engine.
+ */
+bool hmac_sha256_exists(void);
+
+/* hmac_sha256_digest
+ *  Starts computing the MAC of `len` bytes at `data` into `mac`. `key`,
+ *  `data` and `mac` must stay valid until `callback` is called with the
+ *  status. If the kernel engine is absent or the key is longer than 32 bytes
+ *  the MAC is computed in software before returning, and the callback still
+ *  runs from the next yield.
+ */
+int hmac_sha256_digest(const uint8_t* key, size_t key_len, const void* data, size_t len,
+                       uint8_t* mac, subscribe_cb callback, void* ud);
+
+/* hmac_sha256_digest_sync
+ *  Synchronous version of the above.
+ */
+int hmac_sha256_digest_sync(const uint8_t* key, size_t key_len, const void* data,
+                            size_t len, uint8_t* mac);
+
+/* hmac_sha256_verify
+ *  Compares two MACs in constant time.
+ *  returns true if they match.
+ */
+bool hmac_sha256_verify(const uint8_t* a, const uint8_t* b);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,26 +1,6 @@
 #include "i2c_master_slave.h"
 #include "tock.h"
 
-struct i2c_master_slave_data {
-  bool fired;
-  int callback_type;
-  int length;
-};
-
-static struct i2c_master_slave_data result = { .fired = false };
-
-// Internal callback for faking synchronous reads
-static void i2c_master_slave_cb(int callback_type,
-                                int length,
-                                __attribute__ ((unused)) int unused,
-                                void* ud) {
-  struct i2c_master_slave_data* data = (struct i2c_master_slave_data*) ud;
-  data->callback_type = callback_type;
-  data->length        = length;
-  data->fired         = true;
-}
-
-
 int i2c_master_slave_set_callback(subscribe_cb callback, void* callback_args) {
   return subscribe(DRIVER_NUM_I2CMASTERSLAVE, 0, callback, callback_args);
 }
@@ -69,49 +49,34 @@ int i2c_master_slave_enable_slave_read(uint32_t len) {
 }
 
 int i2c_master_slave_write_sync(uint8_t address, uint8_t len) {
-  int err;
-  result.fired = false;
-
-  err = i2c_master_slave_set_callback(i2c_master_slave_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_I2CMASTERSLAVE, 0);
   if (err < 0) return err;
 
-  err = i2c_master_slave_write(address, len);
+  err = tock_completion_wait(&done, i2c_master_slave_write(address, len));
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.length;
+  return done.arg1;
 }
 
 int i2c_master_slave_write_read_sync(uint8_t address, uint8_t wlen, uint8_t rlen) {
-  int err;
-  result.fired = false;
-
-  err = i2c_master_slave_set_callback(i2c_master_slave_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_I2CMASTERSLAVE, 0);
   if (err < 0) return err;
 
-  err = i2c_master_slave_write_read(address, wlen, rlen);
+  err = tock_completion_wait(&done, i2c_master_slave_write_read(address, wlen, rlen));
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.length;
+  return done.arg1;
 }
 
 int i2c_master_slave_read_sync(uint16_t address, uint16_t len) {
-  int err;
-  result.fired = false;
-
-  err = i2c_master_slave_set_callback(i2c_master_slave_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_I2CMASTERSLAVE, 0);
   if (err < 0) return err;
 
-  err = i2c_master_slave_read(address, len);
+  err = tock_completion_wait(&done, i2c_master_slave_read(address, len));
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.length;
+  return done.arg1;
 }
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "ieee802154.h"
 #include "timer.h"
 
@@ -6,9 +8,11 @@ const int RADIO_DRIVER = 0x30001;
 const int ALLOW_RX  = 0;
 const int ALLOW_TX  = 1;
 const int ALLOW_CFG = 2;
+const int ALLOW_RING = 3;
 
 const int SUBSCRIBE_RX = 0;
 const int SUBSCRIBE_TX = 1;
+const int SUBSCRIBE_RING = 2;
 
 const int COMMAND_STATUS        = 1;
 const int COMMAND_SET_ADDR      = 2;
@@ -45,6 +49,16 @@ const int COMMAND_SEND = 26;
 // parameters / return codes are not enough te contain the required data.
 unsigned char BUF_CFG[27];
 
+// Whether `tx_cfg` below is the buffer currently allowed as ALLOW_CFG.
+static bool tx_cfg_allowed = false;
+
+// Every other user of ALLOW_CFG goes through here, so that the transmit
+// queue knows to re-allow its configuration.
+static int allow_cfg(void *buf, size_t len) {
+  tx_cfg_allowed = false;
+  return allow(RADIO_DRIVER, ALLOW_CFG, buf, len);
+}
+
 int ieee802154_up(void) {
   // Spin until radio is on. Maybe this can be done with a callback?
   while (!ieee802154_is_up()) {
@@ -70,7 +84,7 @@ int ieee802154_set_address(unsigned short addr) {
 
 int ieee802154_set_address_long(unsigned char *addr_long) {
   if (!addr_long) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) addr_long, 8);
+  int err = allow_cfg((void *) addr_long, 8);
   if (err < 0) return err;
   return command(RADIO_DRIVER, COMMAND_SET_ADDR_LONG, 0, 0);
 }
@@ -104,7 +118,7 @@ int ieee802154_get_address(unsigned short *addr) {
 
 int ieee802154_get_address_long(unsigned char *addr_long) {
   if (!addr_long) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) addr_long, 8);
+  int err = allow_cfg((void *) addr_long, 8);
   if (err < 0) return err;
   return command(RADIO_DRIVER, COMMAND_GET_ADDR_LONG, 0, 0);
 }
@@ -163,7 +177,7 @@ int ieee802154_get_neighbor_address(unsigned index, unsigned short *addr) {
 
 int ieee802154_get_neighbor_address_long(unsigned index, unsigned char *addr_long) {
   if (!addr_long) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) addr_long, 8);
+  int err = allow_cfg((void *) addr_long, 8);
   if (err < 0) return err;
   return command(RADIO_DRIVER, COMMAND_GET_NEIGHBOR_ADDR_LONG, (unsigned int) index, 0);
 }
@@ -178,7 +192,7 @@ int ieee802154_get_neighbor(unsigned index,
 
 int ieee802154_add_neighbor(unsigned short addr, unsigned char *addr_long, unsigned *index) {
   if (!addr_long) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) addr_long, 8);
+  int err = allow_cfg((void *) addr_long, 8);
   if (err < 0) return err;
   err = command(RADIO_DRIVER, COMMAND_ADD_NEIGHBOR, (unsigned int) addr, 0);
   if (err > 0 && index) {
@@ -232,7 +246,7 @@ int ieee802154_get_key_id(unsigned index,
                           key_id_mode_t *key_id_mode,
                           unsigned char *key_id) {
   if (!key_id_mode || !key_id) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) BUF_CFG, 10);
+  int err = allow_cfg((void *) BUF_CFG, 10);
   if (err < 0) return err;
   err = command(RADIO_DRIVER, COMMAND_GET_KEY_ID, (unsigned int) index, 0);
   if (err == TOCK_SUCCESS) {
@@ -244,7 +258,7 @@ int ieee802154_get_key_id(unsigned index,
 
 int ieee802154_get_key(unsigned index, unsigned char *key) {
   if (!key) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) key, 16);
+  int err = allow_cfg((void *) key, 16);
   if (err < 0) return err;
   return command(RADIO_DRIVER, COMMAND_GET_KEY, (unsigned int) index, 0);
 }
@@ -267,7 +281,7 @@ int ieee802154_add_key(security_level_t level,
                        unsigned char *key,
                        unsigned *index) {
   if (!key) return TOCK_EINVAL;
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) BUF_CFG, 27);
+  int err = allow_cfg((void *) BUF_CFG, 27);
   if (err < 0) return 0;
   BUF_CFG[0] = level;
   BUF_CFG[1] = key_id_mode;
@@ -288,16 +302,222 @@ int ieee802154_remove_key(unsigned index) {
   return command(RADIO_DRIVER, COMMAND_REMOVE_KEY, (unsigned int) index, 0);
 }
 
-// Internal callback for transmission
-static int tx_result;
-static int tx_acked;
+// ***** Transmit queue *****
+
+// Security configuration of the frame being handed to the kernel. It is read
+// when the send command is issued, so it can be rewritten for every frame
+// without being allowed again.
+static unsigned char tx_cfg[11];
+static bool tx_subscribed = false;
+
+// Frames waiting or in flight, oldest first. The first `tx_in_kernel` of them
+// have been handed to the kernel.
+static ieee802154_tx_frame_t *tx_head = NULL;
+static ieee802154_tx_frame_t *tx_tail = NULL;
+static int tx_in_kernel = 0;
+// Whether the last frame handed to the kernel is still waiting to start, so
+// its payload must stay allowed.
+static bool tx_waiting = false;
+
+static ieee802154_tx_stats_t tx_stats[IEEE802154_TX_STATS_MAX];
+static int tx_stats_count = 0;
+
+static ieee802154_tx_stats_t* tx_stats_for(unsigned short addr) {
+  for (int i = 0; i < tx_stats_count; i++) {
+    if (tx_stats[i].addr == addr) return &tx_stats[i];
+  }
+  if (tx_stats_count == IEEE802154_TX_STATS_MAX) return NULL;
+  ieee802154_tx_stats_t *stats = &tx_stats[tx_stats_count++];
+  memset(stats, 0, sizeof(*stats));
+  stats->addr = addr;
+  return stats;
+}
+
+// Inserts `frame` so that it has `pos` frames ahead of it.
+static void tx_insert(ieee802154_tx_frame_t *frame, int pos) {
+  ieee802154_tx_frame_t **link = &tx_head;
+  while (pos-- > 0 && *link != NULL) {
+    link = &(*link)->next;
+  }
+  frame->next = *link;
+  *link       = frame;
+  if (frame->next == NULL) tx_tail = frame;
+}
+
+static ieee802154_tx_frame_t* tx_pop(void) {
+  ieee802154_tx_frame_t *frame = tx_head;
+  tx_head = frame->next;
+  if (tx_head == NULL) tx_tail = NULL;
+  frame->next = NULL;
+  return frame;
+}
+
+static void tx_finish(ieee802154_tx_frame_t *frame, int status, bool defer) {
+  uint32_t latency = alarm_read() - frame->queued_at;
+
+  ieee802154_tx_stats_t *stats = tx_stats_for(frame->addr);
+  if (stats) {
+    stats->frames++;
+    if (status == TOCK_SUCCESS) {
+      stats->acked++;
+    } else if (status == TOCK_ENOACK) {
+      stats->no_ack++;
+    } else {
+      stats->failed++;
+    }
+    stats->latency_total += latency;
+    if (latency > stats->latency_max) stats->latency_max = latency;
+  }
+
+  if (frame->callback == NULL) return;
+  if (!defer || tock_enqueue(frame->callback, status, frame->attempts, latency, frame->ud) < 0) {
+    frame->callback(status, frame->attempts, latency, frame->ud);
+  }
+}
+
+static void tx_done_callback(int result, int acked, int waiting, void* ud);
+
+// Hands `frame` to the kernel.
+static int tx_submit(ieee802154_tx_frame_t *frame) {
+  int err;
+  if (!tx_subscribed) {
+    err = subscribe(RADIO_DRIVER, SUBSCRIBE_TX, tx_done_callback, NULL);
+    if (err < 0) return err;
+    tx_subscribed = true;
+  }
+
+  tx_cfg[0] = frame->level;
+  tx_cfg[1] = frame->key_id_mode;
+  if (frame->level != SEC_LEVEL_NONE) {
+    memcpy(tx_cfg + 2, frame->key_id, ieee802154_key_id_bytes(frame->key_id_mode));
+  }
+  if (!tx_cfg_allowed) {
+    err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) tx_cfg, sizeof(tx_cfg));
+    if (err < 0) return err;
+    tx_cfg_allowed = true;
+  }
+
+  err = allow(RADIO_DRIVER, ALLOW_TX, (void *) frame->payload, frame->len);
+  if (err < 0) return err;
+
+  // Returns 1 if the frame started right away, or 0 if it waits behind
+  // another process's frame.
+  err = command(RADIO_DRIVER, COMMAND_SEND, (unsigned int) frame->addr, 0);
+  if (err < 0) return err;
+
+  frame->attempts++;
+  tx_in_kernel++;
+  tx_waiting = err == 0;
+  return TOCK_SUCCESS;
+}
+
+// Hands frames to the kernel while it has room: one in flight and one
+// waiting, but a waiting frame's payload must not be replaced.
+static void tx_pump(void) {
+  while (tx_in_kernel == 0 || (tx_in_kernel == 1 && !tx_waiting)) {
+    ieee802154_tx_frame_t *prev  = NULL;
+    ieee802154_tx_frame_t *frame = tx_head;
+    for (int i = 0; i < tx_in_kernel && frame != NULL; i++) {
+      prev  = frame;
+      frame = frame->next;
+    }
+    if (frame == NULL) return;
+
+    int err = tx_submit(frame);
+    if (err < 0) {
+      if (prev) {
+        prev->next = frame->next;
+      } else {
+        tx_head = frame->next;
+      }
+      if (tx_tail == frame) tx_tail = prev;
+      frame->next = NULL;
+      tx_finish(frame, err, true);
+    }
+  }
+}
+
+// The kernel reports frames in the order they were handed over.
 static void tx_done_callback(int result,
                              int acked,
-                             __attribute__ ((unused)) int arg3,
+                             int waiting,
+                             __attribute__ ((unused)) void* ud) {
+  if (tx_in_kernel == 0) return;
+  tx_in_kernel--;
+  tx_waiting = tx_in_kernel > 0 && waiting;
+
+  ieee802154_tx_frame_t *frame = tx_pop();
+  bool retry = result == TOCK_SUCCESS && !acked && frame->attempts <= frame->max_retries;
+  if (retry) {
+    ieee802154_tx_stats_t *stats = tx_stats_for(frame->addr);
+    if (stats) stats->retries++;
+    tx_insert(frame, tx_in_kernel);
+  }
+  tx_pump();
+
+  if (!retry) {
+    int status = result != TOCK_SUCCESS ? result : (acked ? TOCK_SUCCESS : TOCK_ENOACK);
+    tx_finish(frame, status, false);
+  }
+}
+
+int ieee802154_send_async(ieee802154_tx_frame_t *frame) {
+  if (!frame || !frame->payload) return TOCK_EINVAL;
+  for (ieee802154_tx_frame_t *f = tx_head; f != NULL; f = f->next) {
+    if (f == frame) return TOCK_EALREADY;
+  }
+
+  frame->attempts  = 0;
+  frame->queued_at = alarm_read();
+  frame->next      = NULL;
+  if (tx_tail) {
+    tx_tail->next = frame;
+  } else {
+    tx_head = frame;
+  }
+  tx_tail = frame;
+
+  tx_pump();
+  return TOCK_SUCCESS;
+}
+
+int ieee802154_tx_queue_length(void) {
+  int length = 0;
+  for (ieee802154_tx_frame_t *f = tx_head; f != NULL; f = f->next) {
+    length++;
+  }
+  return length;
+}
+
+int ieee802154_tx_stats(unsigned short addr, ieee802154_tx_stats_t *stats) {
+  for (int i = 0; i < tx_stats_count; i++) {
+    if (tx_stats[i].addr == addr) return ieee802154_tx_stats_at(i, stats);
+  }
+  return TOCK_EINVAL;
+}
+
+int ieee802154_tx_stats_at(int index, ieee802154_tx_stats_t *stats) {
+  if (!stats || index < 0 || index >= tx_stats_count) return TOCK_EINVAL;
+  *stats = tx_stats[index];
+  return TOCK_SUCCESS;
+}
+
+void ieee802154_tx_stats_reset(void) {
+  tx_stats_count = 0;
+}
+
+typedef struct {
+  bool fired;
+  int status;
+} tx_sync_result_t;
+
+static void tx_sync_callback(int status,
+                             __attribute__ ((unused)) int attempts,
+                             __attribute__ ((unused)) int latency,
                              void* ud) {
-  tx_result     = result;
-  tx_acked      = acked;
-  *((bool*) ud) = true;
+  tx_sync_result_t *result = (tx_sync_result_t*) ud;
+  result->status = status;
+  result->fired  = true;
 }
 
 int ieee802154_send(unsigned short addr,
@@ -306,36 +526,25 @@ int ieee802154_send(unsigned short addr,
                     unsigned char *key_id,
                     const char *payload,
                     unsigned char len) {
-  // Setup parameters in ALLOW_CFG and ALLOW_TX
-  int err = allow(RADIO_DRIVER, ALLOW_CFG, (void *) BUF_CFG, 11);
-  if (err < 0) return err;
-  BUF_CFG[0] = level;
-  BUF_CFG[1] = key_id_mode;
-  int bytes = ieee802154_key_id_bytes(key_id_mode);
-  if (bytes > 0) {
-    memcpy(BUF_CFG + 2, key_id, bytes);
+  tx_sync_result_t result = { .fired = false };
+  ieee802154_tx_frame_t frame = {
+    .addr        = addr,
+    .level       = level,
+    .key_id_mode = key_id_mode,
+    .payload     = payload,
+    .len         = len,
+    .max_retries = 0,
+    .callback    = tx_sync_callback,
+    .ud          = &result,
+  };
+  if (level != SEC_LEVEL_NONE && key_id) {
+    memcpy(frame.key_id, key_id, ieee802154_key_id_bytes(key_id_mode));
   }
-  err = allow(RADIO_DRIVER, ALLOW_TX, (void *) payload, len);
-  if (err < 0) return err;
-
-  // Subscribe to the transmit callback
-  bool tx_done = false;
-  err = subscribe(RADIO_DRIVER, SUBSCRIBE_TX,
-                  tx_done_callback, (void *) &tx_done);
-  if (err < 0) return err;
 
-  // Issue the send command and wait for the transmission to be done.
-  err = command(RADIO_DRIVER, COMMAND_SEND, (unsigned int) addr, 0);
+  int err = ieee802154_send_async(&frame);
   if (err < 0) return err;
-  yield_for(&tx_done);
-  if (tx_result != TOCK_SUCCESS) {
-    return tx_result;
-  } else if (tx_acked == 0) {
-    return TOCK_ENOACK;
-  } else {
-    return TOCK_SUCCESS;
-  }
-
+  yield_for(&result.fired);
+  return result.status;
 }
 
 // Internal callback for receive
@@ -370,6 +579,87 @@ int ieee802154_receive(subscribe_cb callback,
   return subscribe(RADIO_DRIVER, SUBSCRIBE_RX, callback, NULL);
 }
 
+// ***** Receive ring *****
+
+// Header layout, shared with the kernel.
+#define RING_WRITE   0
+#define RING_READ    1
+#define RING_COUNT   2
+#define RING_DROPPED 4
+#define RING_SLOT_HEADER_LEN 8
+
+// Keeps slot accesses on the right side of the index accesses; the kernel
+// only runs between instructions, so no hardware barrier is needed.
+#define RING_BARRIER() __asm__ volatile ("" ::: "memory")
+
+static subscribe_cb *ring_callback = NULL;
+static void *ring_ud   = NULL;
+static void *ring_buf  = NULL;
+
+static void ring_upcall(__attribute__ ((unused)) int write,
+                        int dropped,
+                        __attribute__ ((unused)) int unused,
+                        __attribute__ ((unused)) void* ud) {
+  if (ring_callback && ring_buf) {
+    ring_callback(ieee802154_ring_available(ring_buf), dropped, 0, ring_ud);
+  }
+}
+
+int ieee802154_receive_ring(void *ring, size_t len, subscribe_cb callback, void *ud) {
+  if (!ring || len < IEEE802154_RING_LEN(2)) return TOCK_EINVAL;
+  ring_callback = callback;
+  ring_ud       = ud;
+  ring_buf      = ring;
+  int err = subscribe(RADIO_DRIVER, SUBSCRIBE_RING, ring_upcall, NULL);
+  if (err < 0) return err;
+  // The kernel initializes the header.
+  return allow(RADIO_DRIVER, ALLOW_RING, ring, len);
+}
+
+int ieee802154_receive_ring_stop(void) {
+  ring_buf = NULL;
+  int err = allow(RADIO_DRIVER, ALLOW_RING, NULL, 0);
+  if (err < 0) return err;
+  return subscribe(RADIO_DRIVER, SUBSCRIBE_RING, NULL, NULL);
+}
+
+const char* ieee802154_ring_peek(const void *ring, ieee802154_rx_info_t *info) {
+  const volatile uint8_t *header = ring;
+  uint8_t read = header[RING_READ];
+  if (read == header[RING_WRITE]) return NULL;
+  RING_BARRIER();
+
+  const uint8_t *slot = (const uint8_t*) ring + IEEE802154_RING_HEADER_LEN +
+                        read * IEEE802154_RING_SLOT_LEN;
+  if (info) {
+    info->timestamp = slot[0] | (slot[1] << 8) | (slot[2] << 16) | ((uint32_t) slot[3] << 24);
+    info->lqi       = slot[4];
+    info->rssi      = (int8_t) slot[5];
+  }
+  return (const char*) slot + RING_SLOT_HEADER_LEN;
+}
+
+void ieee802154_ring_release(void *ring) {
+  volatile uint8_t *header = ring;
+  uint8_t read = header[RING_READ];
+  if (read == header[RING_WRITE]) return;
+  RING_BARRIER();
+  header[RING_READ] = (read + 1) % header[RING_COUNT];
+}
+
+int ieee802154_ring_available(const void *ring) {
+  const volatile uint8_t *header = ring;
+  int count = header[RING_COUNT];
+  if (count == 0) return 0;
+  return (header[RING_WRITE] - header[RING_READ] + count) % count;
+}
+
+uint32_t ieee802154_ring_dropped(const void *ring) {
+  const volatile uint8_t *header = ring;
+  return header[RING_DROPPED] | (header[RING_DROPPED + 1] << 8) |
+         (header[RING_DROPPED + 2] << 16) | ((uint32_t) header[RING_DROPPED + 3] << 24);
+}
+
 int ieee802154_frame_get_length(const char *frame) {
   if (!frame) return 0;
   // data_offset + data_len - 2 header bytes
@@ -206,7 +206,8 @@ int ieee802154_remove_key(unsigned index);
 // Sends an IEEE 802.15.4 frame synchronously. The desired key must first be
 // added to the key list.  It is then looked up with the security level and key
 // ID provided. Returns TOCK_SUCCESS or TOCK_ENOACK on successful transmission,
-// depending on whether or not an ACK was received.
+// depending on whether or not an ACK was received. The frame goes through the
+// transmit queue below, so it is sent after any frames already queued.
 // `addr` (in): Destination short MAC address.
 // `level` (in): Security level desired. Can be SEC_LEVEL_NONE, in which case
 //   `key_id_mode` is meaningless and can be set to 0.
@@ -223,6 +224,75 @@ int ieee802154_send(unsigned short addr,
                     const char *payload,
                     unsigned char len);
 
+// Asynchronous, queued transmission.
+//
+// Frames are described by caller-owned `ieee802154_tx_frame_t`s, which are
+// linked into a queue without any allocation. Up to two frames of this
+// process are handed to the kernel at once, so the next frame starts as soon
+// as the radio finishes the previous one rather than after a round trip
+// through userspace. The security configuration is only re-allowed when
+// another call has replaced it, and the transmit callback stays subscribed.
+//
+// A frame that is sent but not acknowledged is retried up to `max_retries`
+// times. Frames to a given destination complete in the order they were
+// queued, except that a retried frame may be overtaken by the frame behind it.
+
+typedef struct ieee802154_tx_frame {
+  // Set by the caller.
+  unsigned short addr;          // Destination short MAC address.
+  security_level_t level;       // As for `ieee802154_send`.
+  key_id_mode_t key_id_mode;
+  unsigned char key_id[9];
+  const char *payload;
+  unsigned char len;
+  unsigned char max_retries;    // Retransmissions after a missing ACK.
+  // Called with (status, attempts, latency, ud) once the frame is done.
+  // `status` is TOCK_SUCCESS if it was acked, TOCK_ENOACK if every attempt
+  // went unacknowledged, or the transmission error. `latency` is the time
+  // from queueing to completion in alarm ticks.
+  subscribe_cb *callback;
+  void *ud;
+
+  // Private to the queue.
+  unsigned char attempts;
+  uint32_t queued_at;
+  struct ieee802154_tx_frame *next;
+} ieee802154_tx_frame_t;
+
+// Queues `frame` for transmission. `frame` and its payload must stay valid
+// and unmodified until its callback has been called. Returns TOCK_SUCCESS,
+// TOCK_EINVAL for a bad frame or TOCK_EALREADY if it is already queued.
+int ieee802154_send_async(ieee802154_tx_frame_t *frame);
+
+// Number of frames queued or in flight.
+int ieee802154_tx_queue_length(void);
+
+// Per-destination transmit statistics, kept for the first
+// IEEE802154_TX_STATS_MAX destinations seen since the last reset.
+#define IEEE802154_TX_STATS_MAX 8
+
+typedef struct {
+  unsigned short addr;
+  uint32_t frames;          // Frames completed.
+  uint32_t acked;           // ...of which were acked,
+  uint32_t no_ack;          // ...were never acked,
+  uint32_t failed;          // ...or failed to transmit.
+  uint32_t retries;         // Retransmissions after a missing ACK.
+  uint32_t latency_total;   // Sum of the frames' latencies, in alarm ticks.
+  uint32_t latency_max;
+} ieee802154_tx_stats_t;
+
+// Copies the statistics for `addr` into `stats`. Returns TOCK_SUCCESS, or
+// TOCK_EINVAL if nothing has been sent to `addr`.
+int ieee802154_tx_stats(unsigned short addr, ieee802154_tx_stats_t *stats);
+
+// Copies the statistics of the `index`th destination seen. Returns
+// TOCK_SUCCESS, or TOCK_EINVAL once `index` is past the last destination.
+int ieee802154_tx_stats_at(int index, ieee802154_tx_stats_t *stats);
+
+// Clears all transmit statistics.
+void ieee802154_tx_stats_reset(void);
+
 // Maximum size required of a buffer to contain the IEEE 802.15.4 frame data
 // passed to userspace from the kernel. Consists of 2 extra bytes followed by
 // the whole IEEE 802.15.4 MTU, which is 127 bytes.
@@ -251,6 +321,50 @@ int ieee802154_receive(subscribe_cb callback,
                        const char *frame,
                        unsigned char len);
 
+// Receive ring. Instead of one frame at a time, the kernel stores received
+// frames into a ring of slots in app memory, in order, so that frames that
+// arrive while the app is busy are kept rather than lost. The app reads
+// frames in place and releases each slot once done with it. While a ring is
+// set, frames are not delivered through `ieee802154_receive`.
+#define IEEE802154_RING_HEADER_LEN 8
+#define IEEE802154_RING_SLOT_LEN   140
+// Size of a ring buffer with `slots` slots. One slot is always kept free, so
+// a ring holds at most `slots - 1` frames. At most 255 slots are used.
+#define IEEE802154_RING_LEN(slots) \
+  (IEEE802154_RING_HEADER_LEN + (slots) * IEEE802154_RING_SLOT_LEN)
+
+// Metadata the kernel stores with every frame in the ring.
+typedef struct {
+  uint32_t timestamp;  // Kernel alarm ticks at reception, 0 without a clock.
+  uint8_t lqi;         // Link quality, 0xff if the radio does not report it.
+  int8_t rssi;         // Signal strength in dBm, -128 if not reported.
+} ieee802154_rx_info_t;
+
+// Starts delivering frames into `ring`, which must be at least
+// IEEE802154_RING_LEN(2) bytes and stay valid until
+// `ieee802154_receive_ring_stop`. Any frames already in it are discarded.
+// `callback` is called with (frames available, total frames dropped, 0, ud)
+// when a frame arrives in an empty ring, so it should consume frames until
+// `ieee802154_ring_peek` returns NULL.
+int ieee802154_receive_ring(void *ring, size_t len, subscribe_cb callback, void *ud);
+
+// Stops delivering frames into the ring.
+int ieee802154_receive_ring_stop(void);
+
+// Returns the oldest frame in the ring, or NULL if it is empty. The frame can
+// be inspected with the `ieee802154_frame_get_*` functions below and stays
+// valid until it is released. `info` may be NULL.
+const char* ieee802154_ring_peek(const void *ring, ieee802154_rx_info_t *info);
+
+// Releases the oldest frame's slot back to the kernel.
+void ieee802154_ring_release(void *ring);
+
+// Number of frames waiting in the ring.
+int ieee802154_ring_available(const void *ring);
+
+// Number of frames dropped because the ring was full.
+uint32_t ieee802154_ring_dropped(const void *ring);
+
 // IEEE 802.15.4 received frame inspection functions. The frames are returned
 // to userspace in a particular format that might include more bytes than just
 // the raw 802.15.4 frame. In all of the below calls, `frame` is assumed to be
@@ -40,6 +40,43 @@ int alarm_internal_stop(void);
  */
 unsigned int alarm_internal_frequency(void);
 
+/*
+ * Kernel timers
+ *
+ * Besides the alarm above, the kernel keeps a few timers per process that
+ * are addressed by id. `timer` holds the id in its low 8 bits; the whole
+ * value is passed back as the third argument of the timer callback, so the
+ * upper bits can tell a timer's current use from an earlier one.
+ */
+
+/*
+ * Returns the number of kernel timers, or a negative error if the kernel
+ * has none.
+ */
+int alarm_internal_timer_count(void);
+
+/*
+ * Sets the callback for kernel timers. It is called with the clock value,
+ * the expiration and the `timer` value the timer was set with.
+ */
+int alarm_internal_timer_subscribe(subscribe_cb cb, void *userdata);
+
+/*
+ * Fires `timer` once at the absolute clock value `tics`.
+ */
+int alarm_internal_timer_at(uint32_t timer, uint32_t tics);
+
+/*
+ * Fires `timer` every `period` tics, the first time `period` tics from now.
+ * The kernel re-arms the timer itself.
+ */
+int alarm_internal_timer_every(uint32_t timer, uint32_t period);
+
+/*
+ * Stops timer `id`.
+ */
+int alarm_internal_timer_stop(int id);
+
 #ifdef __cplusplus
 }
 #endif
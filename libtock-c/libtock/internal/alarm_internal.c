@@ -15,3 +15,23 @@ int alarm_internal_stop(void) {
 unsigned int alarm_internal_frequency(void) {
   return (unsigned int) command(DRIVER_NUM_ALARM, 1, 0, 0);
 }
+
+int alarm_internal_timer_count(void) {
+  return command(DRIVER_NUM_ALARM, 7, 0, 0);
+}
+
+int alarm_internal_timer_subscribe(subscribe_cb cb, void *userdata) {
+  return subscribe(DRIVER_NUM_ALARM, 1, cb, userdata);
+}
+
+int alarm_internal_timer_at(uint32_t timer, uint32_t tics) {
+  return command(DRIVER_NUM_ALARM, 8, (int)timer, (int)tics);
+}
+
+int alarm_internal_timer_every(uint32_t timer, uint32_t period) {
+  return command(DRIVER_NUM_ALARM, 9, (int)timer, (int)period);
+}
+
+int alarm_internal_timer_stop(int id) {
+  return command(DRIVER_NUM_ALARM, 10, id, 0);
+}
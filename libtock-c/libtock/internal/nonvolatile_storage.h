@@ -18,6 +18,19 @@ int nonvolatile_storage_internal_get_number_bytes(void);
 int nonvolatile_storage_internal_read(uint32_t offset, uint32_t length);
 int nonvolatile_storage_internal_write(uint32_t offset, uint32_t length);
 
+// Like read and write, but transfer to or from `buffer_offset` bytes into the
+// allowed buffer. The kernel runs one read or write per app and queues one
+// more behind it; a write's data is copied out of the buffer when it starts.
+int nonvolatile_storage_internal_read_into(uint32_t offset, uint32_t length, uint32_t buffer_offset);
+int nonvolatile_storage_internal_write_from(uint32_t offset, uint32_t length, uint32_t buffer_offset);
+
+// Returns the most bytes a single read or write transfers.
+int nonvolatile_storage_internal_get_max_length(void);
+
+// Lets the app read the storage directly, and returns the address it is
+// mapped at. Returns TOCK_ENOSUPPORT if it is not mapped into memory.
+int nonvolatile_storage_internal_map(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,3 +29,21 @@ int nonvolatile_storage_internal_write(uint32_t offset, uint32_t length) {
   uint32_t arg0 = (length << 8) | 3;
   return command(DRIVER_NUM_NONVOLATILE_STORAGE, (int) arg0, (int) offset, 0);
 }
+
+int nonvolatile_storage_internal_read_into(uint32_t offset, uint32_t length, uint32_t buffer_offset) {
+  uint32_t arg0 = (length << 8) | 2;
+  return command(DRIVER_NUM_NONVOLATILE_STORAGE, (int) arg0, (int) offset, (int) buffer_offset);
+}
+
+int nonvolatile_storage_internal_write_from(uint32_t offset, uint32_t length, uint32_t buffer_offset) {
+  uint32_t arg0 = (length << 8) | 3;
+  return command(DRIVER_NUM_NONVOLATILE_STORAGE, (int) arg0, (int) offset, (int) buffer_offset);
+}
+
+int nonvolatile_storage_internal_get_max_length(void) {
+  return command(DRIVER_NUM_NONVOLATILE_STORAGE, 4, 0, 0);
+}
+
+int nonvolatile_storage_internal_map(void) {
+  return command(DRIVER_NUM_NONVOLATILE_STORAGE, 5, 0, 0);
+}
@@ -0,0 +1,273 @@
+// Intrusive doubly linked list for C++ apps
+//
+// tock::intrusive_list<T> links objects that the app owns, wherever they
+// live (globals, other containers, the stack), through a hook inside each
+// object. Adding and removing objects allocates nothing and cannot fail,
+// and removing an object takes constant time, without searching the
+// list. The list does not own its objects: it only links and unlinks them,
+// and an object must be removed (or the list cleared) before it goes away.
+//
+// T derives from intrusive_list_hook<Tag>. An object can be in one list per
+// hook, so an object kept in two lists at once derives from two hooks with
+// different tags and each list names its tag. Hooks are not copied: a copy
+// of an object starts out in no list.
+//
+// The interface follows std::list, with bidirectional iterators, but
+// push_back, insert and the like take the object itself (by reference)
+// rather than a value to copy.
+//
+// Usage:
+//
+//   struct connection : tock::intrusive_list_hook<> {
+//     int handle;
+//   };
+//
+//   static connection connections[4];
+//   tock::intrusive_list<connection> idle;
+//   for (auto& c : connections) idle.push_back(c);
+//   connection& c = idle.front();
+//   idle.pop_front();
+
+#pragma once
+
+#include <iterator>
+#include <stddef.h>
+#include <type_traits>
+
+namespace tock {
+
+template <typename Tag = void>
+class intrusive_list_hook {
+public:
+  intrusive_list_hook() : prev_(nullptr), next_(nullptr) {}
+  intrusive_list_hook(const intrusive_list_hook&) : prev_(nullptr), next_(nullptr) {}
+  intrusive_list_hook& operator=(const intrusive_list_hook&) {
+    return *this;
+  }
+
+  // Whether the object is in a list.
+  bool is_linked() const {
+    return next_ != nullptr;
+  }
+
+protected:
+  ~intrusive_list_hook() {}
+
+private:
+  template <typename, typename>
+  friend class intrusive_list;
+
+  void unlink() {
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
+    prev_ = next_ = nullptr;
+  }
+
+  intrusive_list_hook* prev_;
+  intrusive_list_hook* next_;
+};
+
+template <typename T, typename Tag = void>
+class intrusive_list final {
+  typedef intrusive_list_hook<Tag> hook;
+
+  template <typename Value>
+  class iterator_t final {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    iterator_t() : node_(nullptr) {}
+    explicit iterator_t(hook* node) : node_(node) {}
+    // A const_iterator from an iterator.
+    template <typename Other>
+    iterator_t(const iterator_t<Other>& other,
+               typename std::enable_if<std::is_convertible<Other*, Value*>::value>::type* =
+                 nullptr) : node_(other.node_) {}
+
+    reference operator*() const {
+      return *static_cast<pointer>(node_);
+    }
+    pointer operator->() const {
+      return static_cast<pointer>(node_);
+    }
+
+    iterator_t& operator++() {
+      node_ = node_->next_;
+      return *this;
+    }
+    iterator_t operator++(int) {
+      iterator_t old = *this;
+      node_ = node_->next_;
+      return old;
+    }
+    iterator_t& operator--() {
+      node_ = node_->prev_;
+      return *this;
+    }
+    iterator_t operator--(int) {
+      iterator_t old = *this;
+      node_ = node_->prev_;
+      return old;
+    }
+
+    friend bool operator==(const iterator_t& a, const iterator_t& b) {
+      return a.node_ == b.node_;
+    }
+    friend bool operator!=(const iterator_t& a, const iterator_t& b) {
+      return a.node_ != b.node_;
+    }
+
+  private:
+    friend class intrusive_list;
+    template <typename>
+    friend class iterator_t;
+
+    hook* node_;
+  };
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef iterator_t<T> iterator;
+  typedef iterator_t<const T> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  // The list is a circle through `head_`, which is its end().
+  intrusive_list() : size_(0) {
+    head_.prev_ = head_.next_ = &head_;
+  }
+
+  // Objects point back at the list, so it cannot be copied or moved.
+  intrusive_list(const intrusive_list&) = delete;
+  intrusive_list& operator=(const intrusive_list&) = delete;
+
+  ~intrusive_list() {
+    clear();
+  }
+
+  // ***** Element access *****
+
+  reference front() {
+    return *begin();
+  }
+  const_reference front() const {
+    return *begin();
+  }
+  reference back() {
+    return *--end();
+  }
+  const_reference back() const {
+    return *--end();
+  }
+
+  // ***** Iterators *****
+
+  iterator begin() {
+    return iterator(head_.next_);
+  }
+  const_iterator begin() const {
+    return const_iterator(head_.next_);
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  iterator end() {
+    return iterator(&head_);
+  }
+  const_iterator end() const {
+    return const_iterator(const_cast<hook*>(&head_));
+  }
+  const_iterator cend() const {
+    return end();
+  }
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  // An iterator to `value`, which must be in this list.
+  iterator iterator_to(reference value) {
+    return iterator(static_cast<hook*>(&value));
+  }
+
+  // ***** Capacity *****
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_type size() const {
+    return size_;
+  }
+
+  // ***** Modifiers *****
+
+  // Unlinks every object.
+  void clear() {
+    while (!empty()) pop_front();
+  }
+
+  // Links `value`, which must not be in a list, before `pos`.
+  // returns an iterator to `value`.
+  iterator insert(const_iterator pos, reference value) {
+    hook* node = static_cast<hook*>(&value);
+    hook* next = pos.node_;
+    node->prev_        = next->prev_;
+    node->next_        = next;
+    next->prev_->next_ = node;
+    next->prev_        = node;
+    size_++;
+    return iterator(node);
+  }
+
+  void push_front(reference value) {
+    insert(begin(), value);
+  }
+  void push_back(reference value) {
+    insert(end(), value);
+  }
+
+  // Unlinks the object at `pos`.
+  // returns the object after it.
+  iterator erase(const_iterator pos) {
+    hook* next = pos.node_->next_;
+    pos.node_->unlink();
+    size_--;
+    return iterator(next);
+  }
+
+  void pop_front() {
+    erase(begin());
+  }
+  void pop_back() {
+    erase(--end());
+  }
+
+  // Unlinks `value`, which must be in this list.
+  void remove(reference value) {
+    erase(iterator_to(value));
+  }
+
+private:
+  hook head_;
+  size_type size_;
+};
+
+}  // namespace tock
@@ -0,0 +1,412 @@
+#include <string.h>
+
+#include "app_state.h"
+#include "kv_store.h"
+
+// A segment starts with a header, followed by records and then erased
+// (0xFF) space. A record is a header, the key and the value, padded to a
+// multiple of 4 bytes. The header of a segment is written last when it is
+// filled by a compaction, so of two segments with valid headers the one
+// with the higher generation is active.
+
+#define SEGMENT_MAGIC 0x3153564b // "KVS1"
+
+// Key length of the erased space after the last record.
+#define KEY_LEN_ERASED 0xFFFF
+// Value length of a record that deletes its key.
+#define VALUE_LEN_DELETED 0xFFFE
+
+// Bytes the app flash driver writes at once.
+#define WRITE_CHUNK 512
+
+#define FNV_OFFSET 0x811c9dc5
+#define FNV_PRIME 0x01000193
+
+typedef struct {
+  uint32_t magic;
+  uint32_t generation;
+} segment_header_t;
+
+typedef struct {
+  uint16_t key_len;
+  uint16_t value_len;
+  // Checksum of the lengths, key and value.
+  uint32_t check;
+} record_header_t;
+
+static struct {
+  bool initialized;
+  int active;
+  uint32_t generation;
+  // Offset of the erased space in the active segment.
+  size_t tail;
+  // Index entries in use.
+  size_t entries;
+} kv;
+
+static uint8_t staging[WRITE_CHUNK];
+
+// ***** Flash writes *****
+
+typedef struct {
+  bool fired;
+  int result;
+} write_data_t;
+
+static void write_cb(int result,
+                     __attribute__ ((unused)) int unused1,
+                     __attribute__ ((unused)) int unused2,
+                     void* ud) {
+  write_data_t* data = (write_data_t*) ud;
+  data->result = result;
+  data->fired  = true;
+}
+
+// Writes the first `len` bytes of `staging` to `dest`.
+static int flash_write(uint8_t* dest, size_t len) {
+  write_data_t data = { false, TOCK_SUCCESS };
+
+  int err = allow(DRIVER_NUM_APP_FLASH, 0, staging, len);
+  if (err < TOCK_SUCCESS) return err;
+  err = subscribe(DRIVER_NUM_APP_FLASH, 0, write_cb, &data);
+  if (err < TOCK_SUCCESS) return err;
+  err = command(DRIVER_NUM_APP_FLASH, 1, (uint32_t) dest, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&data.fired);
+  return data.result;
+}
+
+// Gathers a run of bytes to write in `staging`, and writes them a chunk at
+// a time. Errors are sticky.
+typedef struct {
+  uint8_t* dest;
+  size_t fill;
+  int err;
+} writer_t;
+
+static void writer_flush(writer_t* w) {
+  if (w->fill > 0 && w->err == TOCK_SUCCESS) {
+    w->err = flash_write(w->dest, w->fill);
+  }
+  w->dest += w->fill;
+  w->fill  = 0;
+}
+
+static void writer_put(writer_t* w, const void* data, size_t len) {
+  const uint8_t* src = (const uint8_t*) data;
+  while (len > 0 && w->err == TOCK_SUCCESS) {
+    size_t n = sizeof(staging) - w->fill;
+    if (n > len) n = len;
+    memcpy(staging + w->fill, src, n);
+    w->fill += n;
+    src     += n;
+    len     -= n;
+    if (w->fill == sizeof(staging)) writer_flush(w);
+  }
+}
+
+// ***** Records *****
+
+static uint32_t fnv(uint32_t hash, const void* data, size_t len) {
+  const uint8_t* bytes = (const uint8_t*) data;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+static uint8_t* segment(int index) {
+  return _kv_store_flash + index * _kv_store_segment_size;
+}
+
+static size_t stored_value_len(uint16_t value_len) {
+  return value_len == VALUE_LEN_DELETED ? 0 : value_len;
+}
+
+static size_t record_size(size_t key_len, uint16_t value_len) {
+  size_t size = sizeof(record_header_t) + key_len + stored_value_len(value_len);
+  return (size + 3) & ~((size_t) 3);
+}
+
+static const record_header_t* record_at(size_t offset) {
+  return (const record_header_t*) (segment(kv.active) + offset);
+}
+
+static const uint8_t* record_key(const record_header_t* record) {
+  return (const uint8_t*) (record + 1);
+}
+
+static const uint8_t* record_value(const record_header_t* record) {
+  return record_key(record) + record->key_len;
+}
+
+static uint32_t record_check(const void* key, size_t key_len, const void* value,
+                             uint16_t value_len) {
+  uint16_t lengths[2] = { key_len, value_len };
+  uint32_t hash       = fnv(FNV_OFFSET, lengths, sizeof(lengths));
+  hash = fnv(hash, key, key_len);
+  return fnv(hash, value, stored_value_len(value_len));
+}
+
+static bool record_valid(const record_header_t* record) {
+  return record->check == record_check(record_key(record), record->key_len,
+                                       record_value(record), record->value_len);
+}
+
+// ***** Index *****
+
+// Finds the entry of `key`, or else the unused entry it would take. Returns
+// NULL if the key is not in a full index.
+static kv_store_slot_t* index_probe(const void* key, size_t key_len, uint32_t hash) {
+  size_t mask = _kv_store_index_size - 1;
+  uint16_t tag = hash >> 16;
+
+  for (size_t i = 0; i < _kv_store_index_size; i++) {
+    kv_store_slot_t* slot = &_kv_store_index[(hash + i) & mask];
+    if (slot->offset == 0) return slot;
+    if (slot->tag != tag) continue;
+
+    const record_header_t* record = record_at(slot->offset * 4);
+    if (record->key_len == key_len && memcmp(record_key(record), key, key_len) == 0) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+static int index_set(kv_store_slot_t* slot, uint32_t hash, size_t offset) {
+  if (slot == NULL) return TOCK_ENOMEM;
+  if (slot->offset == 0) {
+    slot->tag = hash >> 16;
+    kv.entries++;
+  }
+  slot->offset = offset / 4;
+  return TOCK_SUCCESS;
+}
+
+// Walks the log of the active segment into the index. The checksum of a
+// record only needs checking if it is the last one, since a record is only
+// appended once the one before it has been written. Returns TOCK_ENOMEM if
+// the index is full, 1 if the log ends in a record that was cut short
+// (leaving bytes after the tail that are not erased), and 0 otherwise.
+static int scan(void) {
+  memset(_kv_store_index, 0, _kv_store_index_size * sizeof(kv_store_slot_t));
+  kv.entries = 0;
+
+  size_t offset = sizeof(segment_header_t);
+  bool torn     = false;
+  while (offset + sizeof(record_header_t) <= _kv_store_segment_size) {
+    const record_header_t* record = record_at(offset);
+    if (record->key_len == KEY_LEN_ERASED) break;
+
+    size_t size = record_size(record->key_len, record->value_len);
+    size_t next = offset + size;
+    bool last   = next + sizeof(record_header_t) > _kv_store_segment_size ||
+                  record_at(next)->key_len == KEY_LEN_ERASED;
+    if (record->key_len == 0 || next > _kv_store_segment_size ||
+        (last && !record_valid(record))) {
+      torn = true;
+      break;
+    }
+
+    uint32_t hash = fnv(FNV_OFFSET, record_key(record), record->key_len);
+    int err       = index_set(index_probe(record_key(record), record->key_len, hash), hash,
+                              offset);
+    if (err < TOCK_SUCCESS) return err;
+    offset = next;
+  }
+  kv.tail = offset;
+
+  if (torn) {
+    for (size_t i = offset; i < _kv_store_segment_size; i++) {
+      if (segment(kv.active)[i] != 0xFF) return 1;
+    }
+  }
+  return 0;
+}
+
+// ***** Compaction *****
+
+static int compact(void) {
+  int spare     = 1 - kv.active;
+  uint8_t* dest = segment(spare);
+
+  // Erase the spare segment, skipping chunks that already are.
+  memset(staging, 0xFF, sizeof(staging));
+  for (size_t offset = 0; offset < _kv_store_segment_size; offset += sizeof(staging)) {
+    size_t len = _kv_store_segment_size - offset;
+    if (len > sizeof(staging)) len = sizeof(staging);
+    if (memcmp(dest + offset, staging, len) == 0) continue;
+
+    int err = flash_write(dest + offset, len);
+    if (err < TOCK_SUCCESS) return err;
+  }
+
+  // Copy the newest record of every key that has not been deleted.
+  writer_t w = { dest + sizeof(segment_header_t), 0, TOCK_SUCCESS };
+  for (size_t i = 0; i < _kv_store_index_size; i++) {
+    kv_store_slot_t slot = _kv_store_index[i];
+    if (slot.offset == 0) continue;
+
+    const record_header_t* record = record_at(slot.offset * 4);
+    if (record->value_len == VALUE_LEN_DELETED) continue;
+    writer_put(&w, record, record_size(record->key_len, record->value_len));
+  }
+  writer_flush(&w);
+  if (w.err < TOCK_SUCCESS) return w.err;
+
+  // Switch segments.
+  segment_header_t header = { SEGMENT_MAGIC, kv.generation + 1 };
+  memcpy(staging, &header, sizeof(header));
+  int err = flash_write(dest, sizeof(header));
+  if (err < TOCK_SUCCESS) return err;
+
+  kv.active = spare;
+  kv.generation++;
+  // Holds at most as many keys as before.
+  return scan();
+}
+
+// ***** Store *****
+
+int kv_store_init(void) {
+  if (kv.initialized) return TOCK_SUCCESS;
+
+  size_t size = _kv_store_segment_size;
+  if (size % 4 != 0 || size > 0x40000 ||
+      size < sizeof(segment_header_t) + sizeof(record_header_t) ||
+      _kv_store_index_size == 0 || (_kv_store_index_size & (_kv_store_index_size - 1)) != 0) {
+    return TOCK_EINVAL;
+  }
+
+  // The kernel only writes flash in the app's writeable regions.
+  bool writeable = false;
+  int regions    = tock_app_number_writeable_flash_regions();
+  for (int i = 0; i < regions; i++) {
+    uint8_t* begin = tock_app_writeable_flash_region_begins_at(i);
+    uint8_t* end   = tock_app_writeable_flash_region_ends_at(i);
+    if (_kv_store_flash >= begin && _kv_store_flash + 2 * size <= end) {
+      writeable = true;
+    }
+  }
+  if (!writeable) return TOCK_ENOMEM;
+
+  kv.active     = -1;
+  kv.generation = 0;
+  for (int i = 0; i < 2; i++) {
+    const segment_header_t* header = (const segment_header_t*) segment(i);
+    if (header->magic != SEGMENT_MAGIC) continue;
+    if (kv.active < 0 || (int32_t) (header->generation - kv.generation) > 0) {
+      kv.active     = i;
+      kv.generation = header->generation;
+    }
+  }
+
+  int err;
+  if (kv.active < 0) {
+    // A new store: start with an empty first segment.
+    kv.active = 1;
+    memset(_kv_store_index, 0, _kv_store_index_size * sizeof(kv_store_slot_t));
+    kv.entries = 0;
+    err        = compact();
+  } else {
+    err = scan();
+    if (err > 0) {
+      // Recover from a put cut short by moving the log to an erased segment.
+      err = compact();
+    }
+  }
+  if (err < TOCK_SUCCESS) return err;
+
+  kv.initialized = true;
+  return TOCK_SUCCESS;
+}
+
+int kv_store_get(const void* key, size_t key_len, const void** value) {
+  int err = kv_store_init();
+  if (err < TOCK_SUCCESS) return err;
+
+  kv_store_slot_t* slot = index_probe(key, key_len, fnv(FNV_OFFSET, key, key_len));
+  if (slot == NULL || slot->offset == 0) return TOCK_EINVAL;
+
+  const record_header_t* record = record_at(slot->offset * 4);
+  if (record->value_len == VALUE_LEN_DELETED) return TOCK_EINVAL;
+  *value = record_value(record);
+  return record->value_len;
+}
+
+// Appends a record setting (or with VALUE_LEN_DELETED, deleting) `key`.
+static int append(const void* key, size_t key_len, const void* value, uint16_t value_len) {
+  int err = kv_store_init();
+  if (err < TOCK_SUCCESS) return err;
+
+  uint32_t hash = fnv(FNV_OFFSET, key, key_len);
+  kv_store_slot_t* slot = index_probe(key, key_len, hash);
+  if (slot != NULL && slot->offset != 0) {
+    const record_header_t* record = record_at(slot->offset * 4);
+    if (record->value_len == value_len &&
+        (stored_value_len(value_len) == 0 ||
+         memcmp(record_value(record), value, stored_value_len(value_len)) == 0)) {
+      return TOCK_SUCCESS;
+    }
+  } else if (value_len == VALUE_LEN_DELETED) {
+    return TOCK_SUCCESS;
+  }
+
+  size_t size = record_size(key_len, value_len);
+  if (slot == NULL || kv.tail + size > _kv_store_segment_size) {
+    err = compact();
+    if (err < TOCK_SUCCESS) return err;
+    slot = index_probe(key, key_len, hash);
+    if (slot == NULL) return TOCK_ENOMEM;
+    if (kv.tail + size > _kv_store_segment_size) return TOCK_ESIZE;
+  }
+
+  record_header_t header = { key_len, value_len, record_check(key, key_len, value, value_len) };
+  uint8_t padding[3]     = { 0 };
+  writer_t w = { segment(kv.active) + kv.tail, 0, TOCK_SUCCESS };
+  writer_put(&w, &header, sizeof(header));
+  writer_put(&w, key, key_len);
+  writer_put(&w, value, stored_value_len(value_len));
+  writer_put(&w, padding, size - sizeof(header) - key_len - stored_value_len(value_len));
+  writer_flush(&w);
+  if (w.err < TOCK_SUCCESS) {
+    // Part of the record may have been written; find out on the next call.
+    kv.initialized = false;
+    return w.err;
+  }
+
+  index_set(slot, hash, kv.tail);
+  kv.tail += size;
+  return TOCK_SUCCESS;
+}
+
+int kv_store_put(const void* key, size_t key_len, const void* value, size_t value_len) {
+  if (key_len == 0 || key_len >= KEY_LEN_ERASED || value_len > KV_STORE_VALUE_MAX) {
+    return TOCK_EINVAL;
+  }
+  return append(key, key_len, value, value_len);
+}
+
+int kv_store_delete(const void* key, size_t key_len) {
+  if (key_len == 0 || key_len >= KEY_LEN_ERASED) return TOCK_EINVAL;
+  return append(key, key_len, NULL, VALUE_LEN_DELETED);
+}
+
+int kv_store_compact(void) {
+  int err = kv_store_init();
+  if (err < TOCK_SUCCESS) return err;
+  return compact();
+}
+
+int kv_store_info(kv_store_info_t* info) {
+  int err = kv_store_init();
+  if (err < TOCK_SUCCESS) return err;
+
+  info->entries    = kv.entries;
+  info->used       = kv.tail;
+  info->free       = _kv_store_segment_size - kv.tail;
+  info->generation = kv.generation;
+  return TOCK_SUCCESS;
+}
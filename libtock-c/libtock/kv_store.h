@@ -0,0 +1,121 @@
+// Key-value store in app flash
+//
+// Keeps small values (configuration, calibration, counters) by key in a
+// writeable flash region of the app. Values are read straight from flash,
+// with no syscalls and no copying, so lookups cost a hash and a key compare.
+//
+// Usage:
+//
+//   // 2 segments of 4 kB in flash and a 64 entry index in RAM.
+//   KV_STORE_DECLARE(4096, 64);
+//
+//   int main(void) {
+//     const void* value;
+//     int len = kv_store_get("gain", 4, &value);
+//     if (len == sizeof(int32_t)) gain = *(const int32_t*) value;
+//
+//     kv_store_put("gain", 4, &new_gain, sizeof(new_gain));
+//   }
+//
+// The region is split into two segments. The active one holds a log of
+// records, each a key with its latest value (or a deletion), appended by
+// puts through the app flash driver. A hash index in RAM maps every key to
+// its newest record and is rebuilt from the log when the store is first
+// used. When the log fills up the live records are copied into the other
+// segment, which then becomes the active one, so a put only waits for a
+// flash write, plus a copy of the live data once per segment's worth of
+// puts.
+//
+// Each record carries a checksum, so a put cut short by a reset is dropped
+// when the log is next read. The store shares the app flash driver with
+// app_state.
+
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest value a key can hold.
+#define KV_STORE_VALUE_MAX 0xFFFD
+
+// An entry of the in RAM index: the newest record of a key.
+typedef struct {
+  // Upper bits of the key's hash, to skip most key compares.
+  uint16_t tag;
+  // Offset of the record in the active segment in 4 byte words, 0 if the
+  // entry is unused.
+  uint16_t offset;
+} kv_store_slot_t;
+
+// Declares the flash for the store and its index. `_segment_size` is the
+// size of each of the two segments in bytes, a multiple of 4 of at most
+// 256 kB. `_index_size` is the most keys (including deleted keys not yet
+// compacted away) the store can hold, and must be a power of two. Each
+// index entry takes 4 bytes of RAM. Use once per app.
+#define KV_STORE_DECLARE(_segment_size, _index_size)                                    \
+  __attribute__((section(".kv_store"), aligned(4)))                                      \
+  uint8_t _kv_store_flash[2 * (_segment_size)] = { [0 ... 2 * (_segment_size) - 1] = 0xFF }; \
+  const size_t _kv_store_segment_size = (_segment_size);                                 \
+  kv_store_slot_t _kv_store_index[_index_size];                                          \
+  const size_t _kv_store_index_size = (_index_size);
+
+extern uint8_t _kv_store_flash[];
+extern const size_t _kv_store_segment_size;
+extern kv_store_slot_t _kv_store_index[];
+extern const size_t _kv_store_index_size;
+
+typedef struct {
+  // Index entries in use, including deleted keys.
+  size_t entries;
+  // Bytes of the active segment in use, and left for puts.
+  size_t used;
+  size_t free;
+  // Incremented by each compaction.
+  uint32_t generation;
+} kv_store_info_t;
+
+/* kv_store_init
+ *  Finds the active segment and builds the index. Called by the other
+ *  functions when needed; call it at startup to pay for it there.
+ *  returns TOCK_ENOMEM if the store is not in a writeable flash region or
+ *  holds more keys than the index.
+ */
+int kv_store_init(void);
+
+/* kv_store_get
+ *  Points `value` at the value of `key` in flash. The pointer stays valid
+ *  until the next put, delete or compaction.
+ *  returns the length of the value, or TOCK_EINVAL if the key has none.
+ */
+int kv_store_get(const void* key, size_t key_len, const void** value);
+
+/* kv_store_put
+ *  Sets the value of `key`, and waits for it to be written to flash. Does
+ *  not write if the value is unchanged.
+ *  returns TOCK_ESIZE if the record does not fit even after compaction, or
+ *  TOCK_ENOMEM if the index is full.
+ */
+int kv_store_put(const void* key, size_t key_len, const void* value, size_t value_len);
+
+/* kv_store_delete
+ *  Removes `key` and its value. Succeeds if the key has no value.
+ */
+int kv_store_delete(const void* key, size_t key_len);
+
+/* kv_store_compact
+ *  Copies the live records into the other segment now, rather than when
+ *  the active one fills up.
+ */
+int kv_store_compact(void);
+
+/* kv_store_info
+ *  Fills `info` with the state of the store.
+ */
+int kv_store_info(kv_store_info_t* info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+#include "low_level_debug.h"
+
+#define LOW_LEVEL_DEBUG_CMD_ALERT  1
+#define LOW_LEVEL_DEBUG_CMD_PRINT1 2
+#define LOW_LEVEL_DEBUG_CMD_PRINT2 3
+
+bool low_level_debug_exists(void) {
+  return driver_exists(DRIVER_NUM_LOW_LEVEL_DEBUG);
+}
+
+// The driver always succeeds (or drops the line), so there is nothing to
+// report back to the caller.
+
+void low_level_debug_alert(uint32_t code) {
+  int ret = command(DRIVER_NUM_LOW_LEVEL_DEBUG, LOW_LEVEL_DEBUG_CMD_ALERT, code, 0);
+  (void) ret;
+}
+
+void low_level_debug_print_u32(uint32_t value) {
+  int ret = command(DRIVER_NUM_LOW_LEVEL_DEBUG, LOW_LEVEL_DEBUG_CMD_PRINT1, value, 0);
+  (void) ret;
+}
+
+void low_level_debug_print_tagged(uint32_t tag, uint32_t value) {
+  int ret = command(DRIVER_NUM_LOW_LEVEL_DEBUG, LOW_LEVEL_DEBUG_CMD_PRINT2, tag, value);
+  (void) ret;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRIVER_NUM_LOW_LEVEL_DEBUG 0x8
+
+// Low-level debug output.
+//
+// Each call is a single command syscall: no buffer is allowed, nothing is
+// allocated and the app does not wait for the output, so it can be used in
+// code where printf would change the timing being investigated (or is not
+// available at all). The kernel prints one line per call, with the values
+// in hexadecimal:
+//
+//   LowLevelDebug: App 0x0 prints 0x4c4f4f50 0x2a
+//
+// The kernel queues only a few lines per app; calls made faster than the
+// console drains them are dropped and counted in a "dropped" line.
+
+// Alert codes defined by the kernel's low-level debug driver.
+#define LOW_LEVEL_DEBUG_ALERT_PANIC          0x01
+#define LOW_LEVEL_DEBUG_ALERT_WRONG_LOCATION 0x02
+
+/* low_level_debug_exists
+ *  returns true if the board has the low-level debug driver.
+ */
+bool low_level_debug_exists(void);
+
+/* low_level_debug_alert
+ *  Prints a predefined alert code (LOW_LEVEL_DEBUG_ALERT_*).
+ */
+void low_level_debug_alert(uint32_t code);
+
+/* low_level_debug_print_u32
+ *  Prints one number.
+ */
+void low_level_debug_print_u32(uint32_t value);
+
+/* low_level_debug_print_tagged
+ *  Prints a tag (see TRACE_TAG) followed by a number.
+ */
+void low_level_debug_print_tagged(uint32_t tag, uint32_t value);
+
+// ***** Trace points *****
+//
+// Trace macros print through the low-level debug driver and compile to
+// nothing when NDEBUG is defined (e.g. `override CFLAGS += -DNDEBUG` in a
+// release build's Makefile), so trace points can stay in hot code. Their
+// arguments are not evaluated in that case.
+
+// Builds a tag from four characters, which reads back as ASCII in the
+// kernel's hexadecimal output: TRACE_TAG('L','O','O','P') prints 0x4c4f4f50.
+#define TRACE_TAG(a, b, c, d) \
+  ((uint32_t) (a) << 24 | (uint32_t) (b) << 16 | (uint32_t) (c) << 8 | (uint32_t) (d))
+
+#ifndef NDEBUG
+#define TRACE_ENABLED 1
+#define TRACE_POINT(tag) low_level_debug_print_u32(tag)
+#define TRACE_VALUE(tag, value) low_level_debug_print_tagged((tag), (uint32_t) (value))
+#else
+#define TRACE_ENABLED 0
+#define TRACE_POINT(tag) ((void) sizeof(tag))
+#define TRACE_VALUE(tag, value) ((void) sizeof(tag), (void) sizeof(value))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,23 +1,6 @@
 #include "lps25hb.h"
 #include "tock.h"
 
-struct lps25hb_data {
-  bool fired;
-  int value;
-};
-
-static struct lps25hb_data result = { .fired = false };
-
-// Internal callback for faking synchronous reads
-static void lps25hb_cb(int value,
-                       __attribute__ ((unused)) int unused1,
-                       __attribute__ ((unused)) int unused2,
-                       void* ud) {
-  struct lps25hb_data* data = (struct lps25hb_data*) ud;
-  data->value = value;
-  data->fired = true;
-}
-
 int lps25hb_set_callback (subscribe_cb callback, void* callback_args) {
   return subscribe(DRIVER_NUM_LPS25HB, 0, callback, callback_args);
 }
@@ -27,17 +10,12 @@ int lps25hb_get_pressure (void) {
 }
 
 int lps25hb_get_pressure_sync (void) {
-  int err;
-  result.fired = false;
-
-  err = lps25hb_set_callback(lps25hb_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LPS25HB, 0);
   if (err < 0) return err;
 
-  err = lps25hb_get_pressure();
+  err = tock_completion_wait(&done, lps25hb_get_pressure());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.value;
+  return done.arg0;
 }
@@ -1,24 +1,6 @@
 #include "ltc294x.h"
 #include "tock.h"
 
-
-struct ltc294x_data {
-  int charge;
-  bool fired;
-};
-
-static struct ltc294x_data result = { .fired = false, .charge = 0 };
-
-// Internal callback for faking synchronous reads
-static void ltc294x_cb(__attribute__ ((unused)) int callback_type,
-                       __attribute__ ((unused)) int value,
-                       __attribute__ ((unused)) int chip,
-                       void* ud) {
-  struct ltc294x_data* data = (struct ltc294x_data*) ud;
-  data->charge = value;
-  data->fired  = true;
-}
-
 int ltc294x_set_callback (subscribe_cb callback, void* callback_args) {
   return subscribe(DRIVER_NUM_LTC294X, 0, callback, callback_args);
 }
@@ -96,18 +78,13 @@ int ltc294x_set_model(ltc294x_model_e model) {
 
 
 int ltc294x_read_status_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_read_status();
+  err = tock_completion_wait(&done, ltc294x_read_status());
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
@@ -115,130 +92,90 @@ int ltc294x_configure_sync(ltc294x_model_e model,
                            interrupt_pin_conf_e int_pin,
                            uint16_t prescaler,
                            vbat_alert_adc_mode_e vbat) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_configure(model, int_pin, prescaler, vbat);
+  err = tock_completion_wait(&done, ltc294x_configure(model, int_pin, prescaler, vbat));
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
 int ltc294x_reset_charge_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_reset_charge();
+  err = tock_completion_wait(&done, ltc294x_reset_charge());
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
 int ltc294x_set_high_threshold_sync(uint16_t threshold) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_set_high_threshold(threshold);
+  err = tock_completion_wait(&done, ltc294x_set_high_threshold(threshold));
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
 int ltc294x_set_low_threshold_sync(uint16_t threshold) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_set_low_threshold(threshold);
+  err = tock_completion_wait(&done, ltc294x_set_low_threshold(threshold));
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
 int ltc294x_get_charge_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_get_charge();
+  err = tock_completion_wait(&done, ltc294x_get_charge());
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
-  return result.charge;
+  return done.arg1;
 }
 
 int ltc294x_get_voltage_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_get_voltage();
+  err = tock_completion_wait(&done, ltc294x_get_voltage());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.charge;
+  return done.arg1;
 }
 
 int ltc294x_get_current_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_get_current();
+  err = tock_completion_wait(&done, ltc294x_get_current());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.charge;
+  return done.arg1;
 }
 
 int ltc294x_shutdown_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = ltc294x_set_callback(ltc294x_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_LTC294X, 0);
   if (err < 0) return err;
 
-  err = ltc294x_shutdown();
+  err = tock_completion_wait(&done, ltc294x_shutdown());
   if (err < 0) return err;
 
-  // Wait for the ADC callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
@@ -0,0 +1,233 @@
+#include <string.h>
+
+#include "lzss.h"
+
+#define WINDOW_MASK (LZSS_WINDOW_SIZE - 1)
+#define ENCODER_CAP (2 * LZSS_WINDOW_SIZE)
+
+void lzss_encoder_init(lzss_encoder_t* enc) {
+  enc->pos       = 0;
+  enc->end       = 0;
+  enc->bits      = 0;
+  enc->nbits     = 0;
+  enc->finishing = false;
+}
+
+int lzss_encoder_sink(lzss_encoder_t* enc, const uint8_t* in, size_t len) {
+  if (enc->finishing) return TOCK_EALREADY;
+
+  // Only the last window's worth of already-encoded bytes is needed as
+  // history, so slide everything older out to make room.
+  if (enc->pos > LZSS_WINDOW_SIZE) {
+    uint16_t shift = enc->pos - LZSS_WINDOW_SIZE;
+    memmove(enc->buf, enc->buf + shift, enc->end - shift);
+    enc->pos -= shift;
+    enc->end -= shift;
+  }
+
+  size_t room = ENCODER_CAP - enc->end;
+  if (len > room) len = room;
+  memcpy(enc->buf + enc->end, in, len);
+  enc->end += len;
+  return len;
+}
+
+static void encoder_push_bits(lzss_encoder_t* enc, uint32_t value, uint8_t count) {
+  enc->bits   = (enc->bits << count) | value;
+  enc->nbits += count;
+}
+
+// Emits the token for the byte(s) at `pos`.
+static void encoder_step(lzss_encoder_t* enc) {
+  const uint8_t* buf = enc->buf;
+  uint16_t pos       = enc->pos;
+  uint16_t start     = (pos > LZSS_WINDOW_SIZE) ? pos - LZSS_WINDOW_SIZE : 0;
+  uint16_t max_len   = enc->end - pos;
+  if (max_len > LZSS_MAX_MATCH) max_len = LZSS_MAX_MATCH;
+
+  // Search the window, nearest candidate first, for the longest match.
+  // Matches may run into the lookahead; the decoder copies byte by byte.
+  uint16_t best_len = 0, best_dist = 0;
+  for (uint16_t cand = pos; cand-- > start; ) {
+    if (buf[cand] != buf[pos]) continue;
+    uint16_t l = 1;
+    while (l < max_len && buf[cand + l] == buf[pos + l]) l++;
+    if (l > best_len) {
+      best_len  = l;
+      best_dist = pos - cand;
+      if (l == max_len) break;
+    }
+  }
+
+  if (best_len >= LZSS_MIN_MATCH) {
+    encoder_push_bits(enc, 0, 1);
+    encoder_push_bits(enc, best_dist - 1, LZSS_WINDOW_BITS);
+    encoder_push_bits(enc, best_len - LZSS_MIN_MATCH, LZSS_LOOKAHEAD_BITS);
+    enc->pos += best_len;
+  } else {
+    encoder_push_bits(enc, 0x100 | buf[pos], 9);
+    enc->pos += 1;
+  }
+}
+
+size_t lzss_encoder_poll(lzss_encoder_t* enc, uint8_t* out, size_t len) {
+  size_t produced = 0;
+
+  while (produced < len) {
+    if (enc->nbits >= 8) {
+      enc->nbits     -= 8;
+      out[produced++] = enc->bits >> enc->nbits;
+      enc->bits      &= (1u << enc->nbits) - 1;
+      continue;
+    }
+
+    uint16_t avail = enc->end - enc->pos;
+    if (avail == 0 && enc->finishing && enc->nbits > 0) {
+      // Pad the final byte with zeros.
+      out[produced++] = enc->bits << (8 - enc->nbits);
+      enc->bits       = 0;
+      enc->nbits      = 0;
+      break;
+    }
+    // Without a full lookahead, wait for more input unless the stream ends.
+    if (avail == 0 || (avail < LZSS_MAX_MATCH && !enc->finishing)) {
+      break;
+    }
+    encoder_step(enc);
+  }
+
+  return produced;
+}
+
+void lzss_encoder_finish(lzss_encoder_t* enc) {
+  enc->finishing = true;
+}
+
+bool lzss_encoder_done(const lzss_encoder_t* enc) {
+  return enc->finishing && enc->pos == enc->end && enc->nbits == 0;
+}
+
+void lzss_decoder_init(lzss_decoder_t* dec) {
+  memset(dec->window, 0, sizeof(dec->window));
+  dec->head      = 0;
+  dec->copy_dist = 0;
+  dec->copy_len  = 0;
+  dec->bits      = 0;
+  dec->nbits     = 0;
+  dec->in_pos    = 0;
+  dec->in_end    = 0;
+}
+
+int lzss_decoder_sink(lzss_decoder_t* dec, const uint8_t* in, size_t len) {
+  if (dec->in_pos == dec->in_end) {
+    dec->in_pos = 0;
+    dec->in_end = 0;
+  }
+  size_t room = LZSS_DECODER_INPUT - dec->in_end;
+  if (len > room) len = room;
+  memcpy(dec->in + dec->in_end, in, len);
+  dec->in_end += len;
+  return len;
+}
+
+// Ensures at least `count` bits are buffered, returning false if the input
+// runs out first. Nothing is consumed either way.
+static bool decoder_have_bits(lzss_decoder_t* dec, uint8_t count) {
+  while (dec->nbits <= 24 && dec->in_pos < dec->in_end) {
+    dec->bits   = (dec->bits << 8) | dec->in[dec->in_pos++];
+    dec->nbits += 8;
+  }
+  return dec->nbits >= count;
+}
+
+static uint32_t decoder_take_bits(lzss_decoder_t* dec, uint8_t count) {
+  dec->nbits -= count;
+  uint32_t value = (dec->bits >> dec->nbits) & ((1u << count) - 1);
+  dec->bits &= (1u << dec->nbits) - 1;
+  return value;
+}
+
+static void decoder_emit(lzss_decoder_t* dec, uint8_t b, uint8_t* out) {
+  *out = b;
+  dec->window[dec->head] = b;
+  dec->head = (dec->head + 1) & WINDOW_MASK;
+}
+
+size_t lzss_decoder_poll(lzss_decoder_t* dec, uint8_t* out, size_t len) {
+  size_t produced = 0;
+
+  while (produced < len) {
+    if (dec->copy_len > 0) {
+      uint8_t b = dec->window[(dec->head - dec->copy_dist) & WINDOW_MASK];
+      decoder_emit(dec, b, &out[produced++]);
+      dec->copy_len--;
+      continue;
+    }
+
+    if (!decoder_have_bits(dec, 1)) break;
+    bool literal = (dec->bits >> (dec->nbits - 1)) & 1;
+    if (literal) {
+      if (!decoder_have_bits(dec, 9)) break;
+      uint8_t b = decoder_take_bits(dec, 9) & 0xff;
+      decoder_emit(dec, b, &out[produced++]);
+    } else {
+      if (!decoder_have_bits(dec, 1 + LZSS_WINDOW_BITS + LZSS_LOOKAHEAD_BITS)) break;
+      decoder_take_bits(dec, 1);
+      dec->copy_dist = decoder_take_bits(dec, LZSS_WINDOW_BITS) + 1;
+      dec->copy_len  = decoder_take_bits(dec, LZSS_LOOKAHEAD_BITS) + LZSS_MIN_MATCH;
+    }
+  }
+
+  return produced;
+}
+
+int lzss_compress(lzss_encoder_t* enc, const uint8_t* in, size_t in_len,
+                  uint8_t* out, size_t out_len) {
+  size_t produced = 0;
+
+  lzss_encoder_init(enc);
+  while (true) {
+    if (in_len > 0) {
+      int n = lzss_encoder_sink(enc, in, in_len);
+      in     += n;
+      in_len -= n;
+    } else if (!enc->finishing) {
+      lzss_encoder_finish(enc);
+    }
+
+    produced += lzss_encoder_poll(enc, out + produced, out_len - produced);
+    if (lzss_encoder_done(enc)) break;
+    // Polling only stops early for lack of input or output space; if the
+    // output is full, whatever is left does not fit.
+    if (produced == out_len) return TOCK_ESIZE;
+  }
+
+  return produced;
+}
+
+int lzss_decompress(lzss_decoder_t* dec, const uint8_t* in, size_t in_len,
+                    uint8_t* out, size_t out_len) {
+  size_t produced = 0;
+
+  lzss_decoder_init(dec);
+  while (true) {
+    int n = lzss_decoder_sink(dec, in, in_len);
+    in     += n;
+    in_len -= n;
+
+    size_t m = lzss_decoder_poll(dec, out + produced, out_len - produced);
+    produced += m;
+
+    if (produced == out_len) {
+      // Anything beyond padding left over means the output was too small.
+      uint8_t probe;
+      if (in_len > 0 || lzss_decoder_poll(dec, &probe, 1) > 0) {
+        return TOCK_ESIZE;
+      }
+      break;
+    }
+    if (m == 0 && in_len == 0) break;
+  }
+
+  return produced;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming LZSS compression for logs and telemetry.
+//
+// A small, allocation-free LZ77 variant in the style of heatshrink. The
+// encoded stream is a sequence of bit-packed tokens, most significant bit
+// first:
+//
+//   1 <8-bit literal>
+//   0 <LZSS_WINDOW_BITS-bit distance - 1> <LZSS_LOOKAHEAD_BITS-bit length - 2>
+//
+// The final byte is padded with zero bits, which never form a whole token.
+//
+// Both directions are incremental: feed input with `*_sink` and drain output
+// with `*_poll` in whatever chunk sizes suit the transport (a UDP payload, an
+// SD card block, a console write). All state lives in the caller-provided
+// encoder/decoder structure.
+//
+// Example, compressing a log buffer into one UDP payload:
+//
+//     static lzss_encoder_t enc;
+//     uint8_t pkt[64];
+//     int len = lzss_compress(&enc, log, log_len, pkt, sizeof(pkt));
+//     if (len > 0) udp_send_to(pkt, len, &dest);
+//
+// `tools/lzss_decode.py` decodes the same format on a host.
+
+// The window and lookahead sizes must match on both ends of a stream. The
+// encoder needs 2 << LZSS_WINDOW_BITS bytes of buffer, the decoder
+// 1 << LZSS_WINDOW_BITS.
+#ifndef LZSS_WINDOW_BITS
+#define LZSS_WINDOW_BITS 8
+#endif
+#ifndef LZSS_LOOKAHEAD_BITS
+#define LZSS_LOOKAHEAD_BITS 4
+#endif
+
+#define LZSS_WINDOW_SIZE (1 << LZSS_WINDOW_BITS)
+#define LZSS_MIN_MATCH   2
+#define LZSS_MAX_MATCH   ((1 << LZSS_LOOKAHEAD_BITS) + LZSS_MIN_MATCH - 1)
+
+// Size of the decoder's internal input buffer.
+#define LZSS_DECODER_INPUT 32
+
+typedef struct {
+  uint8_t buf[2 * LZSS_WINDOW_SIZE];
+  uint16_t pos;     // Next byte in `buf` to encode.
+  uint16_t end;     // End of buffered input in `buf`.
+  uint32_t bits;    // Pending output bits, right-aligned.
+  uint8_t nbits;    // Number of valid bits in `bits`.
+  bool finishing;
+} lzss_encoder_t;
+
+typedef struct {
+  uint8_t window[LZSS_WINDOW_SIZE];
+  uint16_t head;     // Next write position in `window`.
+  uint16_t copy_dist;
+  uint16_t copy_len; // Bytes of the current back-reference still to emit.
+  uint32_t bits;
+  uint8_t nbits;
+  uint8_t in[LZSS_DECODER_INPUT];
+  uint8_t in_pos;
+  uint8_t in_end;
+} lzss_decoder_t;
+
+/* lzss_encoder_init
+ *  Resets an encoder to start a new stream.
+ */
+void lzss_encoder_init(lzss_encoder_t* enc);
+
+/* lzss_encoder_sink
+ *  Feeds up to `len` bytes of input to the encoder.
+ *  returns the number of bytes accepted (possibly 0 if the encoder must be
+ *  polled first), or TOCK_EALREADY after lzss_encoder_finish().
+ */
+int lzss_encoder_sink(lzss_encoder_t* enc, const uint8_t* in, size_t len);
+
+/* lzss_encoder_poll
+ *  Drains up to `len` bytes of compressed output into `out`.
+ *  returns the number of bytes written. Keep polling until it returns 0
+ *  before sinking more input.
+ */
+size_t lzss_encoder_poll(lzss_encoder_t* enc, uint8_t* out, size_t len);
+
+/* lzss_encoder_finish
+ *  Marks the end of input. Polling then flushes all remaining output,
+ *  including the final partial byte.
+ */
+void lzss_encoder_finish(lzss_encoder_t* enc);
+
+/* lzss_encoder_done
+ *  returns true once a finished stream has been completely polled.
+ */
+bool lzss_encoder_done(const lzss_encoder_t* enc);
+
+/* lzss_decoder_init
+ *  Resets a decoder to start a new stream.
+ */
+void lzss_decoder_init(lzss_decoder_t* dec);
+
+/* lzss_decoder_sink
+ *  Feeds up to `len` bytes of compressed input to the decoder.
+ *  returns the number of bytes accepted (possibly 0 if the decoder must be
+ *  polled first).
+ */
+int lzss_decoder_sink(lzss_decoder_t* dec, const uint8_t* in, size_t len);
+
+/* lzss_decoder_poll
+ *  Drains up to `len` bytes of decompressed output into `out`.
+ *  returns the number of bytes written; 0 means more input is needed.
+ */
+size_t lzss_decoder_poll(lzss_decoder_t* dec, uint8_t* out, size_t len);
+
+/* lzss_compress
+ *  One-shot compression of `in` into `out` using `enc` as scratch state.
+ *  returns the compressed length, or TOCK_ESIZE if it does not fit.
+ */
+int lzss_compress(lzss_encoder_t* enc, const uint8_t* in, size_t in_len,
+                  uint8_t* out, size_t out_len);
+
+/* lzss_decompress
+ *  One-shot decompression of `in` into `out` using `dec` as scratch state.
+ *  returns the decompressed length, or TOCK_ESIZE if it does not fit.
+ */
+int lzss_decompress(lzss_decoder_t* dec, const uint8_t* in, size_t in_len,
+                    uint8_t* out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
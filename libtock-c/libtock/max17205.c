@@ -1,28 +1,7 @@
 #include "max17205.h"
 #include "tock.h"
 
-struct max17205_data {
-  int rc;
-  int value0;
-  int value1;
-  bool fired;
-};
-
-static struct max17205_data result = { .fired = false, .rc = 0, .value0 = 0, .value1 = 0 };
-static subscribe_cb* user_cb       = NULL;
-
-// Internal callback for faking synchronous reads
-static void internal_user_cb(int return_code,
-                             int value0,
-                             int value1,
-                             void* ud) {
-
-  struct max17205_data* data = (struct max17205_data*) ud;
-  data->rc     = return_code;
-  data->value0 = value0;
-  data->value1 = value1;
-  data->fired  = true;
-}
+static subscribe_cb* user_cb = NULL;
 
 static bool is_busy = false;
 // Lower level CB that allows us to stop more commands while busy
@@ -115,100 +94,83 @@ int max17205_read_rom_id(void) {
   }
 }
 
-int max17205_read_status_sync(uint16_t* status) {
-  int err;
-  result.fired = false;
+// Waits for a command started by a _sync function. Its callback comes to
+// `done` rather than max17205_cb, so this is what ends the busy period.
+static int max17205_wait(tock_completion_t* done, int err) {
+  err = tock_completion_wait(done, err);
+  if (err == TOCK_SUCCESS) is_busy = false;
+  return err;
+}
 
-  err = max17205_set_callback(internal_user_cb, (void*) &result);
+int max17205_read_status_sync(uint16_t* status) {
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_MAX17205, 0);
   if (err < 0) return err;
 
-  err = max17205_read_status();
+  err = max17205_wait(&done, max17205_read_status());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  *status = result.value0 & 0xFFFF;
+  *status = done.arg1 & 0xFFFF;
 
-  return result.rc;
+  return done.arg0;
 }
 
 int max17205_read_soc_sync(uint16_t* percent, uint16_t* soc_mah, uint16_t* soc_mah_full) {
-  int err;
-  result.fired = false;
-
-  err = max17205_set_callback(internal_user_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_MAX17205, 0);
   if (err < 0) return err;
 
-  err = max17205_read_soc();
+  err = max17205_wait(&done, max17205_read_soc());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  *percent      = result.value0 & 0xFFFF;
-  *soc_mah      = (result.value1 & 0xFFFF0000) >> 16;
-  *soc_mah_full = result.value1 & 0xFFFF;
+  *percent      = done.arg1 & 0xFFFF;
+  *soc_mah      = (done.arg2 & 0xFFFF0000) >> 16;
+  *soc_mah_full = done.arg2 & 0xFFFF;
 
-  return result.rc;
+  return done.arg0;
 }
 
 int max17205_read_voltage_current_sync(uint16_t* voltage, int16_t* current) {
-  int err;
-  result.fired = false;
-
-  err = max17205_set_callback(internal_user_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_MAX17205, 0);
   if (err < 0) return err;
 
-  err = max17205_read_voltage_current();
+  err = max17205_wait(&done, max17205_read_voltage_current());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  *voltage = result.value0 & 0xFFFF;
-  *current = result.value1 & 0xFFFF;
+  *voltage = done.arg1 & 0xFFFF;
+  *current = done.arg2 & 0xFFFF;
 
-  return result.rc;
+  return done.arg0;
 }
 
 int max17205_read_coulomb_sync(uint16_t* coulomb) {
-  int err;
-  result.fired = false;
-
-  err = max17205_set_callback(internal_user_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_MAX17205, 0);
   if (err < 0) return err;
 
-  err = max17205_read_coulomb();
+  err = max17205_wait(&done, max17205_read_coulomb());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  *coulomb = result.value0 & 0xFFFF;
+  *coulomb = done.arg1 & 0xFFFF;
 
-  return result.rc;
+  return done.arg0;
 }
 
 int max17205_read_rom_id_sync(uint64_t* rom_id) {
-  int err;
-  result.fired = false;
-
-  err = max17205_set_callback(internal_user_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_MAX17205, 0);
   if (err < 0) return err;
 
-  err = max17205_read_rom_id();
+  err = max17205_wait(&done, max17205_read_rom_id());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  uint64_t temp = result.value0;
+  uint64_t temp = done.arg1;
   temp  <<= 32;
-  temp   |= result.value1 & 0x00000000FFFFFFFF;
+  temp   |= done.arg2 & 0x00000000FFFFFFFF;
   *rom_id = temp;
 
-  return result.rc;
+  return done.arg0;
 }
 
 float max17205_get_voltage_mV(int vcount) {
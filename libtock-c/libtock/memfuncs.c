@@ -0,0 +1,259 @@
+// Architecture-tuned `memcpy`, `memmove`, and `memset`.
+//
+// The newlib in `newlib/cortex-m` is built with -Os, which selects its small
+// byte- and word-at-a-time loops. libtock is linked ahead of newlib, so when
+// Configuration.mk defines `TOCK_OPT_MEMFUNCS` for an architecture these
+// definitions are the ones the linker resolves (crt0's .data/.bss setup pulls
+// them in first). Architectures without it simply use newlib's versions.
+//
+// - Cortex-M4/M7 (ARMv7E-M) move aligned data in 32-byte LDM/STM bursts and
+//   rely on the hardware's unaligned LDR for mutually misaligned buffers.
+// - RV32 uses an 8x unrolled word loop and a shift-merge loop for mutually
+//   misaligned buffers, since unaligned accesses trap on most RV32 cores.
+
+#if defined(TOCK_OPT_MEMFUNCS)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Stop GCC from recognizing the loops below and turning them back into calls
+// to the very functions they implement.
+#pragma GCC optimize ("no-tree-loop-distribute-patterns")
+
+// Calls to these can be generated after LTO has already resolved symbols (e.g.
+// from newlib or from struct copies), so they are kept `used` to make sure
+// they survive link-time optimization.
+#define MEMFUNC __attribute__((used))
+
+// Copies shorter than this are done a byte at a time; the alignment fix-up
+// would cost more than it saves.
+#define MEMFUNCS_SMALL 16
+
+typedef uint32_t __attribute__((may_alias)) word_t;
+typedef uint32_t __attribute__((may_alias, aligned(1))) unaligned_word_t;
+
+#if defined(__ARM_ARCH_7EM__)
+
+// Copy `count` 32-byte blocks. r7 (Thumb frame pointer) and r9 (PIC base) are
+// deliberately left out of the register list.
+static void copy_bursts(word_t** d, const word_t** s, size_t count) {
+  word_t* dst       = *d;
+  const word_t* src = *s;
+  asm volatile (
+    "1:\n"
+    "ldmia %[s]!, {r3, r4, r5, r6, r8, r10, r11, r12}\n"
+    "stmia %[d]!, {r3, r4, r5, r6, r8, r10, r11, r12}\n"
+    "subs  %[c], %[c], #1\n"
+    "bne   1b\n"
+    : [d] "+r" (dst), [s] "+r" (src), [c] "+r" (count)
+    :
+    : "r3", "r4", "r5", "r6", "r8", "r10", "r11", "r12", "cc", "memory");
+  *d = dst;
+  *s = src;
+}
+
+// Fill `count` 32-byte blocks with the word `v`.
+static word_t* set_bursts(word_t* d, uint32_t v, size_t count) {
+  asm volatile (
+    "mov   r3, %[v]\n"
+    "mov   r4, %[v]\n"
+    "mov   r5, %[v]\n"
+    "mov   r6, %[v]\n"
+    "1:\n"
+    "stmia %[d]!, {r3, r4, r5, r6}\n"
+    "stmia %[d]!, {r3, r4, r5, r6}\n"
+    "subs  %[c], %[c], #1\n"
+    "bne   1b\n"
+    : [d] "+r" (d), [c] "+r" (count)
+    : [v] "r" (v)
+    : "r3", "r4", "r5", "r6", "cc", "memory");
+  return d;
+}
+
+#else
+
+static void copy_bursts(word_t** d, const word_t** s, size_t count) {
+  word_t* dst       = *d;
+  const word_t* src = *s;
+  while (count--) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    dst[3] = src[3];
+    dst[4] = src[4];
+    dst[5] = src[5];
+    dst[6] = src[6];
+    dst[7] = src[7];
+    dst   += 8;
+    src   += 8;
+  }
+  *d = dst;
+  *s = src;
+}
+
+static word_t* set_bursts(word_t* d, uint32_t v, size_t count) {
+  while (count--) {
+    d[0] = v;
+    d[1] = v;
+    d[2] = v;
+    d[3] = v;
+    d[4] = v;
+    d[5] = v;
+    d[6] = v;
+    d[7] = v;
+    d   += 8;
+  }
+  return d;
+}
+
+#endif
+
+// Forward copy shared by `memcpy` and the non-overlapping/descending cases of
+// `memmove`. It is safe for overlapping buffers as long as `dst < src`: every
+// word is read before any write that could reach it.
+static void copy_forward(uint8_t* d, const uint8_t* s, size_t n) {
+  if (n >= MEMFUNCS_SMALL) {
+    // Align the destination; stores are the more expensive side to split.
+    while ((uintptr_t)d & 3) {
+      *d++ = *s++;
+      n--;
+    }
+
+    word_t* wd = (word_t*)d;
+    if (((uintptr_t)s & 3) == 0) {
+      const word_t* ws = (const word_t*)s;
+      if (n >= 32) {
+        copy_bursts(&wd, &ws, n / 32);
+        n &= 31;
+      }
+      while (n >= 4) {
+        *wd++ = *ws++;
+        n    -= 4;
+      }
+      s = (const uint8_t*)ws;
+    } else {
+#if defined(__ARM_ARCH_7EM__)
+      // ARMv7E-M handles unaligned LDR in hardware, so just let the loads be
+      // unaligned and keep the stores aligned.
+      const unaligned_word_t* ws = (const unaligned_word_t*)s;
+      while (n >= 16) {
+        uint32_t a = ws[0];
+        uint32_t b = ws[1];
+        uint32_t c = ws[2];
+        uint32_t e = ws[3];
+        wd[0] = a;
+        wd[1] = b;
+        wd[2] = c;
+        wd[3] = e;
+        wd   += 4;
+        ws   += 4;
+        n    -= 16;
+      }
+      while (n >= 4) {
+        *wd++ = *ws++;
+        n    -= 4;
+      }
+      s = (const uint8_t*)ws;
+#else
+      // Read aligned words and stitch neighbouring pairs together. Only words
+      // containing at least one requested byte are ever read.
+      uint32_t off     = (uintptr_t)s & 3;
+      uint32_t shift   = off * 8;
+      const word_t* ws = (const word_t*)(s - off);
+      uint32_t cur     = *ws++;
+      while (n >= 4) {
+        uint32_t next = *ws++;
+        *wd++ = (cur >> shift) | (next << (32 - shift));
+        cur   = next;
+        n    -= 4;
+      }
+      s = (const uint8_t*)ws - 4 + off;
+#endif
+    }
+    d = (uint8_t*)wd;
+  }
+
+  while (n--) {
+    *d++ = *s++;
+  }
+}
+
+MEMFUNC void* memcpy(void* restrict dst, const void* restrict src, size_t n) {
+  copy_forward((uint8_t*)dst, (const uint8_t*)src, n);
+  return dst;
+}
+
+MEMFUNC void* memmove(void* dst, const void* src, size_t n) {
+  uint8_t* d       = (uint8_t*)dst;
+  const uint8_t* s = (const uint8_t*)src;
+
+  // Unsigned wrap-around makes this true both when `dst` is below `src` and
+  // when the buffers do not overlap at all.
+  if ((uintptr_t)d - (uintptr_t)s >= n) {
+    copy_forward(d, s, n);
+    return dst;
+  }
+
+  // `dst` overlaps the tail of `src`: copy backwards.
+  d += n;
+  s += n;
+  if (n >= MEMFUNCS_SMALL && (((uintptr_t)d ^ (uintptr_t)s) & 3) == 0) {
+    while ((uintptr_t)d & 3) {
+      *--d = *--s;
+      n--;
+    }
+    word_t* wd       = (word_t*)d;
+    const word_t* ws = (const word_t*)s;
+    while (n >= 16) {
+      wd   -= 4;
+      ws   -= 4;
+      wd[3] = ws[3];
+      wd[2] = ws[2];
+      wd[1] = ws[1];
+      wd[0] = ws[0];
+      n    -= 16;
+    }
+    while (n >= 4) {
+      *--wd = *--ws;
+      n    -= 4;
+    }
+    d = (uint8_t*)wd;
+    s = (const uint8_t*)ws;
+  }
+  while (n--) {
+    *--d = *--s;
+  }
+  return dst;
+}
+
+MEMFUNC void* memset(void* dst, int c, size_t n) {
+  uint8_t* d = (uint8_t*)dst;
+  uint8_t b  = (uint8_t)c;
+
+  if (n >= MEMFUNCS_SMALL) {
+    while ((uintptr_t)d & 3) {
+      *d++ = b;
+      n--;
+    }
+
+    uint32_t v = b * 0x01010101u;
+    word_t* wd = (word_t*)d;
+    if (n >= 32) {
+      wd = set_bursts(wd, v, n / 32);
+      n &= 31;
+    }
+    while (n >= 4) {
+      *wd++ = v;
+      n    -= 4;
+    }
+    d = (uint8_t*)wd;
+  }
+
+  while (n--) {
+    *d++ = b;
+  }
+  return dst;
+}
+
+#endif // TOCK_OPT_MEMFUNCS
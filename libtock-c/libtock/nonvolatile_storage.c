@@ -0,0 +1,393 @@
+#include <string.h>
+
+#include "internal/nonvolatile_storage.h"
+#include "nonvolatile_storage.h"
+
+// Transfers running or queued in the kernel, oldest first. The kernel runs
+// one transfer per app and queues one more, and completes them in order.
+// The transfer in slot i moves its data through staging[i].
+#define TRANSFERS 2
+
+typedef struct {
+  nonvolatile_storage_request_t* request;
+  // Where in the request the transfer starts.
+  size_t request_offset;
+  size_t length;
+  bool write;
+} transfer_t;
+
+static struct {
+  bool initialized;
+  // Transfers kept in the kernel at once: 1 on kernels that cannot place
+  // transfers at an offset in the allowed buffer.
+  int slots;
+  size_t chunk;
+  transfer_t transfers[TRANSFERS];
+  int first;
+  int num;
+  // The storage mapped into memory, or NULL.
+  const uint8_t* mapped;
+  size_t size;
+  nonvolatile_storage_request_t* head;
+  nonvolatile_storage_request_t* tail;
+} nvs;
+
+static uint8_t staging[TRANSFERS][NONVOLATILE_STORAGE_CHUNK_SIZE];
+
+static void transfer_done(int length);
+
+static void read_done_cb(int length,
+                         __attribute__ ((unused)) int unused1,
+                         __attribute__ ((unused)) int unused2,
+                         __attribute__ ((unused)) void* ud) {
+  transfer_done(length);
+}
+
+static void write_done_cb(int length,
+                          __attribute__ ((unused)) int unused1,
+                          __attribute__ ((unused)) int unused2,
+                          __attribute__ ((unused)) void* ud) {
+  transfer_done(length);
+}
+
+static int init(void) {
+  if (nvs.initialized) return TOCK_SUCCESS;
+
+  int err = nonvolatile_storage_internal_read_done_subscribe(read_done_cb, NULL);
+  if (err < TOCK_SUCCESS) return err;
+  err = nonvolatile_storage_internal_write_done_subscribe(write_done_cb, NULL);
+  if (err < TOCK_SUCCESS) return err;
+  err = nonvolatile_storage_internal_read_buffer((uint8_t*) staging, sizeof(staging));
+  if (err < TOCK_SUCCESS) return err;
+  err = nonvolatile_storage_internal_write_buffer((uint8_t*) staging, sizeof(staging));
+  if (err < TOCK_SUCCESS) return err;
+
+  int max_length = nonvolatile_storage_internal_get_max_length();
+  if (max_length > 0) {
+    nvs.slots = TRANSFERS;
+    nvs.chunk = (size_t) max_length < NONVOLATILE_STORAGE_CHUNK_SIZE ?
+                (size_t) max_length : NONVOLATILE_STORAGE_CHUNK_SIZE;
+  } else {
+    // Older kernels always use the start of the allowed buffer.
+    nvs.slots = 1;
+    nvs.chunk = NONVOLATILE_STORAGE_CHUNK_SIZE;
+  }
+
+  int address = nonvolatile_storage_internal_map();
+  int size    = nonvolatile_storage_internal_get_number_bytes();
+  if (address > 0 && size > 0) {
+    nvs.mapped = (const uint8_t*) address;
+    nvs.size   = size;
+  }
+  nvs.initialized = true;
+  return TOCK_SUCCESS;
+}
+
+// A read-modify-write that has not finished reading.
+static bool modify_reading(nonvolatile_storage_request_t* request) {
+  return request->modify != NULL && !request->write;
+}
+
+static void request_remove(nonvolatile_storage_request_t* request) {
+  nonvolatile_storage_request_t* prev = NULL;
+  for (nonvolatile_storage_request_t* cur = nvs.head; cur != NULL; cur = cur->next) {
+    if (cur == request) {
+      if (prev == NULL) {
+        nvs.head = cur->next;
+      } else {
+        prev->next = cur->next;
+      }
+      if (nvs.tail == cur) nvs.tail = prev;
+      return;
+    }
+    prev = cur;
+  }
+}
+
+static void request_fail(nonvolatile_storage_request_t* request, int err) {
+  if (request->result == TOCK_SUCCESS) request->result = err;
+  // Hand no more of it to the kernel.
+  request->submitted = request->length;
+}
+
+// Calls the callback of a request that finished without a transfer in the
+// kernel, once the app yields.
+static void complete(nonvolatile_storage_request_t* request) {
+  if (request->callback != NULL) {
+    tock_enqueue(request->callback, request->result, request->completed, 0, request->ud);
+  }
+}
+
+// Copies what is left of a read from the mapped storage. Only valid with
+// nothing in the kernel, as earlier writes must have landed first.
+static bool read_mapped(nonvolatile_storage_request_t* request) {
+  if (nvs.mapped == NULL || request->write || request->modify != NULL ||
+      request->offset > nvs.size || request->length > nvs.size - request->offset) {
+    return false;
+  }
+  // Order the copy after the completion of earlier writes.
+  __sync_synchronize();
+  size_t left = request->length - request->submitted;
+  memcpy(request->buffer + request->submitted,
+         nvs.mapped + request->offset + request->submitted, left);
+  request->submitted += left;
+  request->completed += left;
+  return true;
+}
+
+// Hands transfers to the kernel until it holds as many as it can.
+static void submit(void) {
+  while (nvs.num < nvs.slots) {
+    nonvolatile_storage_request_t* request = nvs.head;
+    while (request != NULL && request->submitted == request->length) {
+      // Later requests wait for a read-modify-write to be written back.
+      if (modify_reading(request)) return;
+      request = request->next;
+    }
+    if (request == NULL) return;
+
+    if (nvs.num == 0 && read_mapped(request)) {
+      request_remove(request);
+      complete(request);
+      continue;
+    }
+
+    int slot     = (nvs.first + nvs.num) % nvs.slots;
+    size_t left  = request->length - request->submitted;
+    size_t chunk = left < nvs.chunk ? left : nvs.chunk;
+    uint32_t storage_offset = request->offset + request->submitted;
+    uint32_t buffer_offset  = slot * NONVOLATILE_STORAGE_CHUNK_SIZE;
+
+    int err;
+    if (request->write) {
+      memcpy(staging[slot], request->buffer + request->submitted, chunk);
+      err = nonvolatile_storage_internal_write_from(storage_offset, chunk, buffer_offset);
+    } else {
+      err = nonvolatile_storage_internal_read_into(storage_offset, chunk, buffer_offset);
+    }
+
+    if (err == TOCK_ENOMEM && nvs.num > 0) {
+      // The kernel is still running another app's request and holds ours
+      // queued. Try again when it completes.
+      return;
+    }
+    if (err < TOCK_SUCCESS) {
+      request_fail(request, err);
+      if (request->in_flight == 0) {
+        request_remove(request);
+        complete(request);
+      }
+      continue;
+    }
+
+    transfer_t* transfer = &nvs.transfers[slot];
+    transfer->request        = request;
+    transfer->request_offset = request->submitted;
+    transfer->length         = chunk;
+    transfer->write          = request->write;
+    nvs.num++;
+    request->submitted += chunk;
+    request->in_flight++;
+  }
+}
+
+static void transfer_done(int length) {
+  if (nvs.num == 0) return;
+
+  int slot = nvs.first;
+  transfer_t transfer = nvs.transfers[slot];
+  nvs.first = (nvs.first + 1) % nvs.slots;
+  nvs.num--;
+
+  nonvolatile_storage_request_t* request = transfer.request;
+  request->in_flight--;
+
+  size_t done = length < 0 ? 0 : (size_t) length;
+  if (done > transfer.length) done = transfer.length;
+  if (!transfer.write) {
+    memcpy(request->buffer + transfer.request_offset, staging[slot], done);
+  }
+  request->completed += done;
+
+  if (done < transfer.length) {
+    bool last = request->submitted == transfer.request_offset + transfer.length;
+    if (done > 0 && last && request->in_flight == 0) {
+      // The kernel moved less than asked; continue from where it stopped.
+      request->submitted = transfer.request_offset + done;
+    } else {
+      // A negative length is the error the kernel could not start it with.
+      request_fail(request, length < 0 ? length : TOCK_FAIL);
+    }
+  }
+
+  if (request->in_flight == 0 && request->submitted == request->length) {
+    if (request->result == TOCK_SUCCESS && modify_reading(request)) {
+      // Transfers complete in order, so the request is now first in the
+      // queue and nothing after it has been started.
+      if (request->modify(request->buffer, request->length, request->ud)) {
+        request->write     = true;
+        request->submitted = 0;
+        request->completed = 0;
+        submit();
+        return;
+      }
+      request->completed = 0;
+    }
+
+    request_remove(request);
+    submit();
+    if (request->callback != NULL) {
+      request->callback(request->result, request->completed, 0, request->ud);
+    }
+    return;
+  }
+
+  submit();
+}
+
+static int enqueue(nonvolatile_storage_request_t* request, size_t offset, uint8_t* buffer,
+                   size_t length, bool write, nonvolatile_storage_modify_fn modify,
+                   subscribe_cb callback, void* ud) {
+  int err = init();
+  if (err < TOCK_SUCCESS) return err;
+
+  request->next      = NULL;
+  request->buffer    = buffer;
+  request->offset    = offset;
+  request->length    = length;
+  request->submitted = 0;
+  request->completed = 0;
+  request->in_flight = 0;
+  request->result    = TOCK_SUCCESS;
+  request->write     = write;
+  request->modify    = modify;
+  request->callback  = callback;
+  request->ud        = ud;
+
+  if (length == 0) {
+    complete(request);
+    return TOCK_SUCCESS;
+  }
+
+  if (nvs.tail == NULL) {
+    nvs.head = request;
+  } else {
+    nvs.tail->next = request;
+  }
+  nvs.tail = request;
+
+  submit();
+  return TOCK_SUCCESS;
+}
+
+bool nonvolatile_storage_exists(void) {
+  return driver_exists(DRIVER_NUM_NONVOLATILE_STORAGE);
+}
+
+int nonvolatile_storage_size(void) {
+  return nonvolatile_storage_internal_get_number_bytes();
+}
+
+int nonvolatile_storage_read(nonvolatile_storage_request_t* request, size_t offset,
+                             uint8_t* buffer, size_t length, subscribe_cb callback, void* ud) {
+  return enqueue(request, offset, buffer, length, false, NULL, callback, ud);
+}
+
+int nonvolatile_storage_write(nonvolatile_storage_request_t* request, size_t offset,
+                              const uint8_t* buffer, size_t length, subscribe_cb callback, void* ud) {
+  // Writes only read from the buffer.
+  return enqueue(request, offset, (uint8_t*) buffer, length, true, NULL, callback, ud);
+}
+
+int nonvolatile_storage_modify(nonvolatile_storage_request_t* request, size_t offset,
+                               uint8_t* buffer, size_t length, nonvolatile_storage_modify_fn modify,
+                               subscribe_cb callback, void* ud) {
+  return enqueue(request, offset, buffer, length, false, modify, callback, ud);
+}
+
+const uint8_t* nonvolatile_storage_mapped(void) {
+  if (init() < TOCK_SUCCESS) return NULL;
+  return nvs.mapped;
+}
+
+int nonvolatile_storage_pending(void) {
+  int num = 0;
+  for (nonvolatile_storage_request_t* cur = nvs.head; cur != NULL; cur = cur->next) {
+    num++;
+  }
+  return num;
+}
+
+// ***** Synchronous wrappers *****
+
+typedef struct {
+  bool fired;
+  int result;
+} sync_data_t;
+
+static void sync_cb(int result,
+                    __attribute__ ((unused)) int length,
+                    __attribute__ ((unused)) int unused,
+                    void* ud) {
+  sync_data_t* data = (sync_data_t*) ud;
+  data->result = result;
+  data->fired  = true;
+}
+
+int nonvolatile_storage_read_sync(size_t offset, uint8_t* buffer, size_t length) {
+  nonvolatile_storage_request_t request;
+  sync_data_t data = { false, TOCK_SUCCESS };
+
+  int err = init();
+  if (err < TOCK_SUCCESS) return err;
+  if (nvs.head == NULL && nvs.mapped != NULL) {
+    // Nothing is queued, so there is no need to wait for the callback.
+    request.buffer    = buffer;
+    request.offset    = offset;
+    request.length    = length;
+    request.submitted = 0;
+    request.completed = 0;
+    request.write     = false;
+    request.modify    = NULL;
+    if (read_mapped(&request)) return TOCK_SUCCESS;
+  }
+
+  err = nonvolatile_storage_read(&request, offset, buffer, length, sync_cb, &data);
+  if (err < TOCK_SUCCESS) return err;
+  yield_for(&data.fired);
+  return data.result;
+}
+
+int nonvolatile_storage_write_sync(size_t offset, const uint8_t* buffer, size_t length) {
+  nonvolatile_storage_request_t request;
+  sync_data_t data = { false, TOCK_SUCCESS };
+
+  int err = nonvolatile_storage_write(&request, offset, buffer, length, sync_cb, &data);
+  if (err < TOCK_SUCCESS) return err;
+  yield_for(&data.fired);
+  return data.result;
+}
+
+typedef struct {
+  sync_data_t sync;
+  nonvolatile_storage_modify_fn* modify;
+  void* ud;
+} modify_sync_data_t;
+
+static bool modify_sync_fn(uint8_t* buffer, size_t length, void* ud) {
+  modify_sync_data_t* data = (modify_sync_data_t*) ud;
+  return data->modify(buffer, length, data->ud);
+}
+
+int nonvolatile_storage_modify_sync(size_t offset, uint8_t* buffer, size_t length,
+                                    nonvolatile_storage_modify_fn modify, void* ud) {
+  nonvolatile_storage_request_t request;
+  modify_sync_data_t data = { { false, TOCK_SUCCESS }, modify, ud };
+
+  // `data` starts with the sync_data_t sync_cb expects.
+  int err = nonvolatile_storage_modify(&request, offset, buffer, length, modify_sync_fn, sync_cb,
+                                       &data);
+  if (err < TOCK_SUCCESS) return err;
+  yield_for(&data.sync.fired);
+  return data.sync.result;
+}
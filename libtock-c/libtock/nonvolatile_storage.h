@@ -0,0 +1,112 @@
+// Nonvolatile storage API
+//
+// Reads and writes are queued and run in the order they were made, each
+// calling its own callback when done. Requests of any length are split into
+// transfers the kernel can do in one go, and the next transfer is queued in
+// the kernel behind the running one, so the storage moves from one transfer
+// (or request) to the next without waiting for the app.
+//
+// Data passes through a staging buffer owned by this library, so a request's
+// buffer does not need to be allowed to the kernel. It must stay valid until
+// the request's callback is called.
+//
+// On boards where the storage is also mapped into memory (such as internal
+// flash), reads that are not queued behind a write copy straight from the
+// mapping instead of going through the kernel, and
+// nonvolatile_storage_mapped gives a pointer to read the storage in place.
+
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bytes of a request each transfer moves at most (the kernel may move fewer).
+#define NONVOLATILE_STORAGE_CHUNK_SIZE 512
+
+// Called by a read-modify-write once `buffer` holds the current contents of
+// the range. Changes `buffer` in place and returns true to write it back, or
+// false to leave the storage unchanged.
+typedef bool (nonvolatile_storage_modify_fn)(uint8_t* buffer, size_t length, void* ud);
+
+// A queued request. Allocated by the caller, and must stay valid until its
+// callback is called. The fields are private to the library.
+typedef struct nonvolatile_storage_request {
+  struct nonvolatile_storage_request* next;
+  uint8_t* buffer;
+  size_t offset;
+  size_t length;
+  // Bytes handed to the kernel, and bytes done.
+  size_t submitted;
+  size_t completed;
+  // Transfers of this request running or queued in the kernel.
+  int in_flight;
+  int result;
+  bool write;
+  nonvolatile_storage_modify_fn* modify;
+  subscribe_cb* callback;
+  void* ud;
+} nonvolatile_storage_request_t;
+
+/* nonvolatile_storage_exists
+ *  returns true if the board has nonvolatile storage for apps.
+ */
+bool nonvolatile_storage_exists(void);
+
+/* nonvolatile_storage_size
+ *  returns the number of bytes of storage, or a negative error.
+ */
+int nonvolatile_storage_size(void);
+
+/* nonvolatile_storage_read
+ *  Queues a read of `length` bytes at `offset` into `buffer`. `callback` is
+ *  called with (TOCK_SUCCESS or a negative error, bytes read, 0, ud).
+ */
+int nonvolatile_storage_read(nonvolatile_storage_request_t* request, size_t offset,
+                             uint8_t* buffer, size_t length, subscribe_cb callback, void* ud);
+
+/* nonvolatile_storage_write
+ *  Queues a write of `length` bytes from `buffer` to `offset`. `callback` is
+ *  called with (TOCK_SUCCESS or a negative error, bytes written, 0, ud).
+ */
+int nonvolatile_storage_write(nonvolatile_storage_request_t* request, size_t offset,
+                              const uint8_t* buffer, size_t length, subscribe_cb callback, void* ud);
+
+/* nonvolatile_storage_modify
+ *  Queues a read-modify-write of `length` bytes at `offset`: reads them into
+ *  `buffer`, calls `modify` and writes `buffer` back if it returns true.
+ *  Requests queued after it do not start until it is done, so they cannot
+ *  slip in between the read and the write. `callback` is called with
+ *  (TOCK_SUCCESS or a negative error, bytes written, 0, ud).
+ */
+int nonvolatile_storage_modify(nonvolatile_storage_request_t* request, size_t offset,
+                               uint8_t* buffer, size_t length, nonvolatile_storage_modify_fn modify,
+                               subscribe_cb callback, void* ud);
+
+/* nonvolatile_storage_read_sync, nonvolatile_storage_write_sync,
+ * nonvolatile_storage_modify_sync
+ *  Queue a request and wait for it (and so for every request queued before
+ *  it). Return TOCK_SUCCESS or a negative error.
+ */
+int nonvolatile_storage_read_sync(size_t offset, uint8_t* buffer, size_t length);
+int nonvolatile_storage_write_sync(size_t offset, const uint8_t* buffer, size_t length);
+int nonvolatile_storage_modify_sync(size_t offset, uint8_t* buffer, size_t length,
+                                    nonvolatile_storage_modify_fn modify, void* ud);
+
+/* nonvolatile_storage_mapped
+ *  returns a pointer to read the storage in place, or NULL if the board
+ *  does not map it into memory. A write shows through the pointer once its
+ *  callback has been called.
+ */
+const uint8_t* nonvolatile_storage_mapped(void);
+
+/* nonvolatile_storage_pending
+ *  returns the number of queued requests that have not completed.
+ */
+int nonvolatile_storage_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,24 +1,6 @@
 #include "pca9544a.h"
 #include "tock.h"
 
-struct pca9544a_data {
-  bool fired;
-  int value;
-};
-
-static struct pca9544a_data result = { .fired = false };
-
-// Internal callback for faking synchronous reads
-static void pca9544a_cb(__attribute__ ((unused)) int value,
-                        __attribute__ ((unused)) int unused1,
-                        __attribute__ ((unused)) int unused2,
-                        void* ud) {
-  struct pca9544a_data* data = (struct pca9544a_data*) ud;
-  data->value = value;
-  data->fired = true;
-}
-
-
 int pca9544a_set_callback(subscribe_cb callback, void* callback_args) {
   return subscribe(DRIVER_NUM_PCA9544A, 0, callback, callback_args);
 }
@@ -42,65 +24,45 @@ int pca9544a_read_selected(void) {
 
 
 int pca9544a_select_channels_sync(uint32_t channels) {
-  int err;
-  result.fired = false;
-
-  err = pca9544a_set_callback(pca9544a_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_PCA9544A, 0);
   if (err < 0) return err;
 
-  err = pca9544a_select_channels(channels);
+  err = tock_completion_wait(&done, pca9544a_select_channels(channels));
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
 int pca9544a_disable_all_channels_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = pca9544a_set_callback(pca9544a_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_PCA9544A, 0);
   if (err < 0) return err;
 
-  err = pca9544a_disable_all_channels();
+  err = tock_completion_wait(&done, pca9544a_disable_all_channels());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
   return 0;
 }
 
 int pca9544a_read_interrupts_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = pca9544a_set_callback(pca9544a_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_PCA9544A, 0);
   if (err < 0) return err;
 
-  err = pca9544a_read_interrupts();
+  err = tock_completion_wait(&done, pca9544a_read_interrupts());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.value;
+  return done.arg0;
 }
 
 int pca9544a_read_selected_sync(void) {
-  int err;
-  result.fired = false;
-
-  err = pca9544a_set_callback(pca9544a_cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_PCA9544A, 0);
   if (err < 0) return err;
 
-  err = pca9544a_read_selected();
+  err = tock_completion_wait(&done, pca9544a_read_selected());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  return result.value;
+  return done.arg0;
 }
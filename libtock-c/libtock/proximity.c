@@ -10,23 +10,6 @@ struct thresholds {
 // structure to store threshold values to be sent to the driver
 static struct thresholds threshes = {.lower_threshold = 0, .higher_threshold = 175};
 
-struct data {
-  bool fired;
-  int proximity;
-};
-
-static struct data result = {.fired = false};
-
-// Internal callback for faking synchronous reads
-static void cb(int proximity,
-               __attribute__((unused)) int unused,
-               __attribute__((unused)) int unused1,
-               void *ud) {
-  struct data *data = (struct data *)ud;
-  data->proximity = proximity;
-  data->fired     = true;
-}
-
 int proximity_set_callback(subscribe_cb callback, void *callback_args) {
   return subscribe(DRIVER_NUM_PROXIMITY, 0, callback, callback_args);
 }
@@ -46,44 +29,36 @@ int proximity_set_interrupt_thresholds(uint8_t lower, uint8_t upper) {
 }
 
 int proximity_read_sync(uint8_t *proximity) {
-  int err;
-  result.fired = false;
-
-  err = proximity_set_callback(cb, (void *)&result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_PROXIMITY, 0);
   if (err < 0) {
     return err;
   }
 
-  err = proximity_read();
+  err = tock_completion_wait(&done, proximity_read());
   if (err < 0) {
     return err;
   }
 
-  yield_for(&result.fired);
-
-  *proximity = result.proximity;
+  *proximity = done.arg0;
 
   return 0;
 }
 
 int proximity_read_on_interrupt_sync(uint8_t *proximity) {
 
-  int err;
-  result.fired = false;
-
-  err = proximity_set_callback(cb, (void *)&result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_PROXIMITY, 0);
   if (err < 0) {
     return err;
   }
 
-  err = proximity_read_on_interrupt();
+  err = tock_completion_wait(&done, proximity_read_on_interrupt());
   if (err < 0) {
     return err;
   }
 
-  yield_for(&result.fired);
-
-  *proximity = result.proximity;
+  *proximity = done.arg0;
 
   return 0;
 }
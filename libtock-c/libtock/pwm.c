@@ -0,0 +1,101 @@
+#include "pwm.h"
+
+#define PWM_ALLOW_SEQUENCE 0
+
+#define PWM_SUBSCRIBE_SEQUENCE 0
+
+#define PWM_CMD_COUNT          0
+#define PWM_CMD_START          1
+#define PWM_CMD_STOP           2
+#define PWM_CMD_MAX_FREQUENCY  3
+#define PWM_CMD_SEQUENCE_START 4
+#define PWM_CMD_SEQUENCE_STOP  5
+
+#define PWM_SEQUENCE_REPEAT (1 << 8)
+
+bool pwm_exists(void) {
+  return driver_exists(DRIVER_NUM_PWM);
+}
+
+int pwm_count(void) {
+  return command(DRIVER_NUM_PWM, PWM_CMD_COUNT, 0, 0);
+}
+
+int pwm_start(int channel, uint32_t frequency_hz, uint16_t duty) {
+  if (channel < 0 || channel > 0xffff) return TOCK_EINVAL;
+  return command(DRIVER_NUM_PWM, PWM_CMD_START, channel | (int) ((uint32_t) duty << 16),
+                 frequency_hz);
+}
+
+int pwm_stop(int channel) {
+  return command(DRIVER_NUM_PWM, PWM_CMD_STOP, channel, 0);
+}
+
+int pwm_get_maximum_frequency(int channel, uint32_t* frequency_hz) {
+  int ret = command(DRIVER_NUM_PWM, PWM_CMD_MAX_FREQUENCY, channel, 0);
+  if (ret < TOCK_SUCCESS) return ret;
+  *frequency_hz = ret;
+  return TOCK_SUCCESS;
+}
+
+int pwm_sequence_start(int channel, uint32_t frequency_hz, const uint16_t* duty,
+                       size_t count, int periods_per_step, bool repeat,
+                       subscribe_cb callback, void* ud) {
+  if (channel < 0 || channel > 0xff || periods_per_step <= 0 || periods_per_step > 0xffff) {
+    return TOCK_EINVAL;
+  }
+
+  // The kernel reads little endian u16 values, which is how the array is
+  // laid out in memory.
+  int err = allow(DRIVER_NUM_PWM, PWM_ALLOW_SEQUENCE, (void*) duty, count * sizeof(uint16_t));
+  if (err < TOCK_SUCCESS) return err;
+
+  err = subscribe(DRIVER_NUM_PWM, PWM_SUBSCRIBE_SEQUENCE, callback, ud);
+  if (err < TOCK_SUCCESS) return err;
+
+  int arg = channel | (periods_per_step << 16) | (repeat ? PWM_SEQUENCE_REPEAT : 0);
+  return command(DRIVER_NUM_PWM, PWM_CMD_SEQUENCE_START, arg, frequency_hz);
+}
+
+int pwm_sequence_stop(void) {
+  return command(DRIVER_NUM_PWM, PWM_CMD_SEQUENCE_STOP, 0, 0);
+}
+
+void pwm_fill_ramp(uint16_t* duty, size_t count, uint16_t from, uint16_t to) {
+  if (count == 1) {
+    duty[0] = to;
+    return;
+  }
+  int64_t span = (int64_t) to - from;
+  for (size_t i = 0; i < count; i++) {
+    duty[i] = from + span * (int64_t) i / (int64_t) (count - 1);
+  }
+}
+
+// ***** Synchronous Calls *****
+
+typedef struct {
+  bool fired;
+  int applied;
+} pwm_result_t;
+
+static void pwm_sequence_cb(__attribute__ ((unused)) int channel,
+                            int applied,
+                            __attribute__ ((unused)) int unused,
+                            void* ud) {
+  pwm_result_t* result = (pwm_result_t*) ud;
+  result->applied = applied;
+  result->fired   = true;
+}
+
+int pwm_sequence_start_sync(int channel, uint32_t frequency_hz, const uint16_t* duty,
+                            size_t count, int periods_per_step) {
+  pwm_result_t result = { .fired = false };
+
+  int err = pwm_sequence_start(channel, frequency_hz, duty, count, periods_per_step, false,
+                               pwm_sequence_cb, &result);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&result.fired);
+  return TOCK_SUCCESS;
+}
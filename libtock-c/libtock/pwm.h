@@ -0,0 +1,84 @@
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRIVER_NUM_PWM 0x10
+
+// Pulse width modulation.
+//
+// Duty cycles are fractions of PWM_DUTY_MAX, whatever the precision of the
+// board's PWM hardware.
+//
+// Besides setting a channel directly, an app can hand the kernel an array of
+// duty cycles that it steps through on its own, holding each for a number of
+// PWM periods. Fades and simple waveforms then cost one syscall and one
+// callback instead of one of each per step.
+
+#define PWM_DUTY_MAX 0xffff
+#define PWM_DUTY_PERCENT(percent) ((uint16_t) ((percent) * PWM_DUTY_MAX / 100))
+
+/* pwm_exists
+ *  returns true if the board has PWM channels for apps.
+ */
+bool pwm_exists(void);
+
+/* pwm_count
+ *  returns the number of PWM channels, or an error.
+ */
+int pwm_count(void);
+
+/* pwm_start
+ *  Outputs `frequency_hz` at `duty` on `channel`. Stops a sequence running
+ *  on the channel.
+ */
+int pwm_start(int channel, uint32_t frequency_hz, uint16_t duty);
+
+/* pwm_stop
+ *  Stops the output (and any sequence) on `channel`.
+ */
+int pwm_stop(int channel);
+
+/* pwm_get_maximum_frequency
+ *  Highest frequency `channel` supports, in hertz.
+ */
+int pwm_get_maximum_frequency(int channel, uint32_t* frequency_hz);
+
+/* pwm_sequence_start
+ *  Applies `duty[0..count]` to `channel` in turn at `frequency_hz`, holding
+ *  each value for `periods_per_step` PWM periods. `duty` is read by the
+ *  kernel as the sequence runs, so it must stay valid until the sequence
+ *  ends; values may be changed in place to alter the waveform. When `repeat`
+ *  is false, `callback` is called with (channel, values applied) once the
+ *  last value has been held for its step, and the channel keeps that duty
+ *  cycle. A repeating sequence runs until stopped. Only one sequence runs
+ *  at a time: this returns TOCK_EBUSY while another app's is running, and
+ *  replaces this app's own.
+ */
+int pwm_sequence_start(int channel, uint32_t frequency_hz, const uint16_t* duty,
+                       size_t count, int periods_per_step, bool repeat,
+                       subscribe_cb callback, void* ud);
+
+/* pwm_sequence_start_sync
+ *  Runs a sequence that does not repeat and waits for it to finish.
+ */
+int pwm_sequence_start_sync(int channel, uint32_t frequency_hz, const uint16_t* duty,
+                            size_t count, int periods_per_step);
+
+/* pwm_sequence_stop
+ *  Stops this app's sequence, leaving the channel at its current duty cycle.
+ */
+int pwm_sequence_stop(void);
+
+/* pwm_fill_ramp
+ *  Fills `duty[0..count]` with a linear ramp from `from` to `to`
+ *  (inclusive), e.g. for a fade.
+ */
+void pwm_fill_ramp(uint16_t* duty, size_t count, uint16_t from, uint16_t to);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+#include <string.h>
+
+#include "ring.h"
+
+// Each side reads the other side's index with an acquire load, so it sees
+// the slots as they were when that index was stored, and stores its own with
+// a release store, so the other side sees its slot accesses done first.
+
+static uint8_t* slot(const ring_t* ring, uint32_t index) {
+  return (uint8_t*) ((intptr_t) ring + ring->slots) + (index & ring->mask) * ring->elem_size;
+}
+
+int ring_init(ring_t* ring, void* slots, size_t elem_size, size_t capacity) {
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > 0x80000000) {
+    return TOCK_EINVAL;
+  }
+  ring->mask      = capacity - 1;
+  ring->elem_size = elem_size;
+  ring->slots     = (intptr_t) slots - (intptr_t) ring;
+  __atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&ring->tail, 0, __ATOMIC_RELEASE);
+  return TOCK_SUCCESS;
+}
+
+size_t ring_capacity(const ring_t* ring) {
+  return ring->mask + 1;
+}
+
+size_t ring_count(const ring_t* ring) {
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  return tail - head;
+}
+
+size_t ring_space(const ring_t* ring) {
+  return ring_capacity(ring) - ring_count(ring);
+}
+
+// ***** Producer *****
+
+size_t ring_reserve(ring_t* ring, void** slots) {
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t free = ring->mask + 1 - (tail - head);
+  // Stop at the end of the slot array.
+  uint32_t to_end = ring->mask + 1 - (tail & ring->mask);
+  *slots = slot(ring, tail);
+  return free < to_end ? free : to_end;
+}
+
+void ring_commit(ring_t* ring, size_t count) {
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+}
+
+bool ring_push(ring_t* ring, const void* elem) {
+  void* slots;
+  if (ring_reserve(ring, &slots) == 0) return false;
+  memcpy(slots, elem, ring->elem_size);
+  ring_commit(ring, 1);
+  return true;
+}
+
+size_t ring_write(ring_t* ring, const void* elems, size_t count) {
+  const uint8_t* src = (const uint8_t*) elems;
+  size_t written     = 0;
+  // At most two pieces: up to the end of the slots, then from the start.
+  for (int piece = 0; piece < 2 && written < count; piece++) {
+    void* slots;
+    size_t n = ring_reserve(ring, &slots);
+    if (n == 0) break;
+    if (n > count - written) n = count - written;
+    memcpy(slots, src + written * ring->elem_size, n * ring->elem_size);
+    ring_commit(ring, n);
+    written += n;
+  }
+  return written;
+}
+
+// ***** Consumer *****
+
+size_t ring_peek(const ring_t* ring, size_t skip, void** slots) {
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  uint32_t used = tail - head;
+  if (skip >= used) return 0;
+  uint32_t first  = head + skip;
+  uint32_t to_end = ring->mask + 1 - (first & ring->mask);
+  *slots = slot(ring, first);
+  return used - skip < to_end ? used - skip : to_end;
+}
+
+void ring_release(ring_t* ring, size_t count) {
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE);
+}
+
+bool ring_pop(ring_t* ring, void* elem) {
+  void* slots;
+  if (ring_peek(ring, 0, &slots) == 0) return false;
+  memcpy(elem, slots, ring->elem_size);
+  ring_release(ring, 1);
+  return true;
+}
+
+size_t ring_read(ring_t* ring, void* elems, size_t count) {
+  uint8_t* dst = (uint8_t*) elems;
+  size_t read  = 0;
+  for (int piece = 0; piece < 2 && read < count; piece++) {
+    void* slots;
+    size_t n = ring_peek(ring, 0, &slots);
+    if (n == 0) break;
+    if (n > count - read) n = count - read;
+    memcpy(dst + read * ring->elem_size, slots, n * ring->elem_size);
+    ring_release(ring, n);
+    read += n;
+  }
+  return read;
+}
@@ -0,0 +1,189 @@
+// Single-producer single-consumer ring buffer
+//
+// A queue of fixed-size elements between one producer and one consumer, such
+// as a callback and the main loop, or two processes sharing memory over IPC.
+// Neither side takes a lock or waits for the other: the producer only moves
+// `tail` and the consumer only moves `head`, each with a release store after
+// it is done with the slots, so the two may interleave in any way.
+//
+// The capacity is a power of two, so slots are found by masking free-running
+// indices (no division, and all `capacity` slots can be used), and the
+// indices wrap around without any special case. `head` and `tail` sit on
+// cache lines of their own, so the two sides never write to the same line.
+//
+// A ring finds its slots by their offset from the ring itself. A ring and its
+// slots placed in memory shared between processes therefore work from either
+// process, whatever address each sees them at.
+//
+// Usage:
+//
+//   static ring_t events;
+//   static event_t event_slots[16];
+//   ring_init(&events, event_slots, sizeof(event_t), 16);
+//
+//   // Producer, e.g. a callback.
+//   if (!ring_push(&events, &event)) dropped++;
+//
+//   // Consumer.
+//   event_t event;
+//   while (ring_pop(&events, &event)) handle(&event);
+//
+// ring_reserve/ring_commit and ring_peek/ring_release fill and drain slots
+// in place instead of copying elements in and out. From C++, tock::Ring
+// holds its own slots and wraps the same functions.
+
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cache line size to keep the indices apart (Cortex-M7 data cache).
+#define RING_CACHE_LINE 32
+
+typedef struct {
+  // Elements pushed, free-running. Written by the producer only.
+  uint32_t tail __attribute__((aligned(RING_CACHE_LINE)));
+  // Elements popped, free-running. Written by the consumer only.
+  uint32_t head __attribute__((aligned(RING_CACHE_LINE)));
+  // Fixed by ring_init.
+  uint32_t mask;
+  uint32_t elem_size;
+  // Address of the slots minus the address of the ring.
+  intptr_t slots;
+} ring_t;
+
+/* ring_init
+ *  Sets up an empty ring of `capacity` slots of `elem_size` bytes at
+ *  `slots`. Call before either side uses the ring.
+ *  returns TOCK_EINVAL if `capacity` is not a power of two.
+ */
+int ring_init(ring_t* ring, void* slots, size_t elem_size, size_t capacity);
+
+/* ring_capacity, ring_count, ring_space
+ *  return the number of slots, of elements in the ring, and of free slots.
+ *  The count and space are exact for the side calling them; the other side
+ *  may have moved on since.
+ */
+size_t ring_capacity(const ring_t* ring);
+size_t ring_count(const ring_t* ring);
+size_t ring_space(const ring_t* ring);
+
+// ***** Producer *****
+
+/* ring_push
+ *  Copies `elem` into the ring.
+ *  returns false if the ring is full.
+ */
+bool ring_push(ring_t* ring, const void* elem);
+
+/* ring_write
+ *  Copies up to `count` elements from `elems` into the ring.
+ *  returns the number of elements copied.
+ */
+size_t ring_write(ring_t* ring, const void* elems, size_t count);
+
+/* ring_reserve
+ *  Points `slots` at the free slots that follow the last element, up to the
+ *  end of the slot array, to fill in place.
+ *  returns the number of contiguous free slots.
+ */
+size_t ring_reserve(ring_t* ring, void** slots);
+
+/* ring_commit
+ *  Hands the first `count` reserved slots to the consumer.
+ */
+void ring_commit(ring_t* ring, size_t count);
+
+// ***** Consumer *****
+
+/* ring_pop
+ *  Copies the oldest element into `elem` and removes it.
+ *  returns false if the ring is empty.
+ */
+bool ring_pop(ring_t* ring, void* elem);
+
+/* ring_read
+ *  Copies up to `count` of the oldest elements into `elems` and removes
+ *  them.
+ *  returns the number of elements copied.
+ */
+size_t ring_read(ring_t* ring, void* elems, size_t count);
+
+/* ring_peek
+ *  Points `slots` at the elements that follow the oldest `skip` elements, up
+ *  to the end of the slot array, without removing them.
+ *  returns the number of contiguous elements there.
+ */
+size_t ring_peek(const ring_t* ring, size_t skip, void** slots);
+
+/* ring_release
+ *  Removes the oldest `count` elements, handing their slots back to the
+ *  producer.
+ */
+void ring_release(ring_t* ring, size_t count);
+
+#ifdef __cplusplus
+}
+
+namespace tock {
+
+// A ring holding up to `Capacity` elements of T, which are copied as bytes.
+template <typename T, uint32_t Capacity>
+class Ring final {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Ring capacity must be a power of two");
+  static_assert(__is_trivially_copyable(T), "Ring elements are copied as bytes");
+
+public:
+  Ring() {
+    ring_init(&ring_, slots_, sizeof(T), Capacity);
+  }
+
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+
+  bool push(const T& value) {
+    return ring_push(&ring_, &value);
+  }
+
+  bool pop(T& value) {
+    return ring_pop(&ring_, &value);
+  }
+
+  // The oldest element, or nullptr if the ring is empty.
+  T* front() {
+    void* slot;
+    return ring_peek(&ring_, 0, &slot) > 0 ? static_cast<T*>(slot) : nullptr;
+  }
+
+  // Removes the oldest element.
+  void drop() {
+    ring_release(&ring_, 1);
+  }
+
+  size_t size() const {
+    return ring_count(&ring_);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  bool full() const {
+    return size() == Capacity;
+  }
+
+  static constexpr uint32_t capacity() {
+    return Capacity;
+  }
+
+private:
+  ring_t ring_;
+  T slots_[Capacity];
+};
+
+}  // namespace tock
+#endif
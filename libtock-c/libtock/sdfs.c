@@ -0,0 +1,763 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "sdfs.h"
+
+#define ANCHOR_MAGIC 0x53464453 // "SDFS"
+#define META_MAGIC 0x4d464453   // "SDFM"
+
+#define NO_BLOCK 0xFFFFFFFF
+
+// Block numbers in an index block.
+#define POINTERS (SDFS_BLOCK_SIZE / 4)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t rev;
+  uint32_t block_count;
+  uint32_t meta[2];
+  uint32_t crc;
+} anchor_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t rev;
+  sdfs_entry_t files[SDFS_MAX_FILES];
+  uint32_t crc;
+} meta_t;
+
+static uint32_t crc32(const void* data, size_t len) {
+  const uint8_t* bytes = (const uint8_t*) data;
+  uint32_t crc         = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+static uint32_t ptr_get(const sdfs_cache_block_t* slot, uint32_t index) {
+  uint32_t block;
+  memcpy(&block, slot->data + index * 4, 4);
+  return block;
+}
+
+static void ptr_set(sdfs_cache_block_t* slot, uint32_t index, uint32_t block) {
+  memcpy(slot->data + index * 4, &block, 4);
+}
+
+// Data blocks under a tree of the given height.
+static uint32_t span(uint32_t height) {
+  uint32_t blocks = 1;
+  while (height-- > 0) blocks *= POINTERS;
+  return blocks;
+}
+
+// ***** Device operations *****
+
+// Waits for the operation in flight.
+static void io_finish(sdfs_t* fs) {
+  if (fs->io_slot < 0) return;
+
+  sdfs_cache_block_t* slot = &fs->cache[fs->io_slot];
+  fs->device->wait(fs->device, &fs->io);
+  fs->io_slot = -1;
+
+  if (fs->io.result < TOCK_SUCCESS) {
+    if (fs->io_write) {
+      // Written again by the next sync, which reports the error.
+      slot->dirty = true;
+    } else {
+      slot->block = NO_BLOCK;
+    }
+  } else if (!fs->io_write) {
+    slot->valid = true;
+  }
+}
+
+static int io_start(sdfs_t* fs, int index, bool write) {
+  io_finish(fs);
+
+  sdfs_cache_block_t* slot = &fs->cache[index];
+  fs->io.done   = false;
+  fs->io.result = TOCK_SUCCESS;
+  int err = write ?
+            fs->device->write(fs->device, slot->block, slot->data, &fs->io) :
+            fs->device->read(fs->device, slot->block, slot->data, &fs->io);
+  if (err < TOCK_SUCCESS) return err;
+
+  fs->io_slot  = index;
+  fs->io_write = write;
+  if (write) {
+    slot->dirty = false;
+    fs->block_writes++;
+  } else {
+    fs->block_reads++;
+  }
+  return TOCK_SUCCESS;
+}
+
+static int io_sync(sdfs_t* fs, int index, bool write) {
+  int err = io_start(fs, index, write);
+  if (err < TOCK_SUCCESS) return err;
+  io_finish(fs);
+  return fs->io.result;
+}
+
+// ***** Block cache *****
+
+static int cache_find(sdfs_t* fs, uint32_t block) {
+  for (size_t i = 0; i < fs->cache_blocks; i++) {
+    if (fs->cache[i].block == block) return i;
+  }
+  return -1;
+}
+
+static void cache_touch(sdfs_t* fs, sdfs_cache_block_t* slot) {
+  slot->used = ++fs->clock;
+}
+
+// Picks a slot to reuse: an empty one, else the least recently used clean
+// one, else the least recently used. Never the one in flight.
+static int cache_victim(sdfs_t* fs, bool clean_only) {
+  int victim = -1;
+  for (size_t i = 0; i < fs->cache_blocks; i++) {
+    sdfs_cache_block_t* slot = &fs->cache[i];
+    if ((int) i == fs->io_slot) continue;
+    if (slot->block == NO_BLOCK) return i;
+    if (clean_only && slot->dirty) continue;
+    if (victim < 0) {
+      victim = i;
+      continue;
+    }
+    sdfs_cache_block_t* best = &fs->cache[victim];
+    if (best->dirty != slot->dirty ? best->dirty : slot->used < best->used) {
+      victim = i;
+    }
+  }
+  return victim;
+}
+
+// Frees a slot for `block`, writing back what it held if needed.
+static int cache_claim(sdfs_t* fs, uint32_t block, sdfs_cache_block_t** out) {
+  int index = cache_victim(fs, false);
+  sdfs_cache_block_t* slot = &fs->cache[index];
+  if (slot->block != NO_BLOCK && slot->dirty) {
+    int err = io_sync(fs, index, true);
+    if (err < TOCK_SUCCESS) return err;
+  }
+
+  slot->block = block;
+  slot->valid = false;
+  slot->dirty = false;
+  cache_touch(fs, slot);
+  *out = slot;
+  return TOCK_SUCCESS;
+}
+
+// Gets `block` into the cache, reading it unless `load` is false (for
+// callers that overwrite all of it).
+static int cache_get(sdfs_t* fs, uint32_t block, bool load, sdfs_cache_block_t** out) {
+  int index = cache_find(fs, block);
+  if (index >= 0 && index == fs->io_slot) {
+    io_finish(fs);
+  }
+  if (index < 0 || fs->cache[index].block != block) {
+    sdfs_cache_block_t* slot;
+    int err = cache_claim(fs, block, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    index = slot - fs->cache;
+  }
+
+  sdfs_cache_block_t* slot = &fs->cache[index];
+  if (!slot->valid) {
+    if (load) {
+      int err = io_sync(fs, index, false);
+      if (err < TOCK_SUCCESS) {
+        slot->block = NO_BLOCK;
+        return err;
+      }
+    } else {
+      memset(slot->data, 0, SDFS_BLOCK_SIZE);
+      slot->valid = true;
+    }
+  }
+  cache_touch(fs, slot);
+  *out = slot;
+  return TOCK_SUCCESS;
+}
+
+// Starts reading `block` in the background, if the device is idle and a
+// clean slot is free.
+static void cache_prefetch(sdfs_t* fs, uint32_t block) {
+  if (fs->io_slot >= 0 || cache_find(fs, block) >= 0) return;
+
+  int index = cache_victim(fs, true);
+  if (index < 0) return;
+  sdfs_cache_block_t* slot = &fs->cache[index];
+  slot->block = block;
+  slot->valid = false;
+  slot->dirty = false;
+  cache_touch(fs, slot);
+  if (io_start(fs, index, false) < TOCK_SUCCESS) {
+    slot->block = NO_BLOCK;
+  } else {
+    fs->prefetches++;
+  }
+}
+
+// Writes back dirty blocks in block order.
+static int cache_flush(sdfs_t* fs) {
+  io_finish(fs);
+  while (true) {
+    int next = -1;
+    for (size_t i = 0; i < fs->cache_blocks; i++) {
+      sdfs_cache_block_t* slot = &fs->cache[i];
+      if (slot->block != NO_BLOCK && slot->dirty &&
+          (next < 0 || slot->block < fs->cache[next].block)) {
+        next = i;
+      }
+    }
+    if (next < 0) return TOCK_SUCCESS;
+
+    int err = io_sync(fs, next, true);
+    if (err < TOCK_SUCCESS) return err;
+  }
+}
+
+// ***** Allocation *****
+
+static uint32_t lookahead_size(sdfs_t* fs) {
+  return fs->block_count < SDFS_LOOKAHEAD ? fs->block_count : SDFS_LOOKAHEAD;
+}
+
+static bool bit_get(const uint8_t* map, uint32_t bit) {
+  return map[bit / 8] & (1 << (bit % 8));
+}
+
+static void bit_set(uint8_t* map, uint32_t bit) {
+  map[bit / 8] |= 1 << (bit % 8);
+}
+
+// Position of `block` in the window, or NO_BLOCK if it is outside.
+static uint32_t lookahead_bit(sdfs_t* fs, uint32_t block) {
+  uint32_t bit = (block + fs->block_count - fs->lookahead_start) % fs->block_count;
+  return bit < lookahead_size(fs) ? bit : NO_BLOCK;
+}
+
+static void mark_used(sdfs_t* fs, uint32_t block) {
+  uint32_t bit = lookahead_bit(fs, block);
+  if (bit != NO_BLOCK) bit_set(fs->used, bit);
+}
+
+// A block allocated since the last sync, which can be changed in place.
+static bool is_fresh(sdfs_t* fs, uint32_t block) {
+  uint32_t bit = lookahead_bit(fs, block);
+  return bit != NO_BLOCK && bit_get(fs->fresh, bit);
+}
+
+static int mark_tree(sdfs_t* fs, uint32_t block, uint32_t height) {
+  if (block == 0) return TOCK_SUCCESS;
+  mark_used(fs, block);
+  if (height == 0) return TOCK_SUCCESS;
+
+  for (uint32_t i = 0; i < POINTERS; i++) {
+    // Children may have evicted the index block; get it again each time.
+    sdfs_cache_block_t* slot;
+    int err = cache_get(fs, block, true, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    uint32_t child = ptr_get(slot, i);
+    if (child == 0) continue;
+
+    if (height == 1) {
+      mark_used(fs, child);
+    } else {
+      err = mark_tree(fs, child, height - 1);
+      if (err < TOCK_SUCCESS) return err;
+    }
+  }
+  return TOCK_SUCCESS;
+}
+
+// Marks the blocks of the synced state in the window.
+static int lookahead_fill(sdfs_t* fs) {
+  memset(fs->used, 0, sizeof(fs->used));
+  memset(fs->fresh, 0, sizeof(fs->fresh));
+  fs->lookahead_next = 0;
+
+  mark_used(fs, 0);
+  mark_used(fs, 1);
+  mark_used(fs, fs->meta[0]);
+  mark_used(fs, fs->meta[1]);
+  for (int i = 0; i < SDFS_MAX_FILES; i++) {
+    if (fs->files[i].name[0] == '\0') continue;
+    int err = mark_tree(fs, fs->files[i].root, fs->files[i].height);
+    if (err < TOCK_SUCCESS) return err;
+  }
+  return TOCK_SUCCESS;
+}
+
+// Whether `count` more blocks can be allocated from the window.
+static bool lookahead_has(sdfs_t* fs, uint32_t count) {
+  uint32_t free = 0;
+  for (uint32_t bit = fs->lookahead_next; bit < lookahead_size(fs) && free < count; bit++) {
+    if (!bit_get(fs->used, bit)) free++;
+  }
+  return free == count;
+}
+
+// Hands out a block from the window. Callers reserve blocks first.
+static uint32_t alloc(sdfs_t* fs) {
+  while (bit_get(fs->used, fs->lookahead_next)) {
+    fs->lookahead_next++;
+  }
+  uint32_t bit = fs->lookahead_next++;
+  bit_set(fs->used, bit);
+  bit_set(fs->fresh, bit);
+
+  uint32_t block = (fs->lookahead_start + bit) % fs->block_count;
+  // The cache may still hold what the block held before it was freed.
+  int index = cache_find(fs, block);
+  if (index >= 0) {
+    if (index == fs->io_slot) io_finish(fs);
+    fs->cache[index].block = NO_BLOCK;
+  }
+  return block;
+}
+
+static int commit(sdfs_t* fs);
+
+// Makes sure `count` blocks can be allocated, moving the window on (after
+// a sync, so that blocks freed since the last one are not reused) until
+// it has them.
+static int reserve(sdfs_t* fs, uint32_t count) {
+  uint32_t scanned = 0;
+  while (!lookahead_has(fs, count)) {
+    if (scanned >= fs->block_count) return TOCK_ENOMEM;
+
+    int err = commit(fs);
+    if (err < TOCK_SUCCESS) return err;
+    scanned += lookahead_size(fs);
+    fs->lookahead_start = (fs->lookahead_start + lookahead_size(fs)) % fs->block_count;
+    err = lookahead_fill(fs);
+    if (err < TOCK_SUCCESS) return err;
+  }
+  return TOCK_SUCCESS;
+}
+
+// ***** Metadata *****
+
+static int write_meta(sdfs_t* fs, uint32_t block) {
+  sdfs_cache_block_t* slot;
+  int err = cache_get(fs, block, false, &slot);
+  if (err < TOCK_SUCCESS) return err;
+
+  meta_t meta;
+  meta.magic = META_MAGIC;
+  meta.rev   = fs->rev;
+  memcpy(meta.files, fs->files, sizeof(meta.files));
+  meta.crc = crc32(&meta, offsetof(meta_t, crc));
+  memset(slot->data, 0, SDFS_BLOCK_SIZE);
+  memcpy(slot->data, &meta, sizeof(meta));
+  return io_sync(fs, slot - fs->cache, true);
+}
+
+static int write_anchor(sdfs_t* fs, int index) {
+  sdfs_cache_block_t* slot;
+  int err = cache_get(fs, index, false, &slot);
+  if (err < TOCK_SUCCESS) return err;
+
+  anchor_t anchor;
+  anchor.magic       = ANCHOR_MAGIC;
+  anchor.rev         = fs->anchor_rev;
+  anchor.block_count = fs->block_count;
+  anchor.meta[0]     = fs->meta[0];
+  anchor.meta[1]     = fs->meta[1];
+  anchor.crc         = crc32(&anchor, offsetof(anchor_t, crc));
+  memset(slot->data, 0, SDFS_BLOCK_SIZE);
+  memcpy(slot->data, &anchor, sizeof(anchor));
+  return io_sync(fs, slot - fs->cache, true);
+}
+
+// Writes a block that no longer holds anything valid, so a stale copy of
+// an older file table in it can never be taken for the current one.
+static int write_empty(sdfs_t* fs, uint32_t block) {
+  sdfs_cache_block_t* slot;
+  int err = cache_get(fs, block, false, &slot);
+  if (err < TOCK_SUCCESS) return err;
+  memset(slot->data, 0, SDFS_BLOCK_SIZE);
+  return io_sync(fs, slot - fs->cache, true);
+}
+
+// Moves the file table to two new blocks and points the anchor at them.
+static int relocate(sdfs_t* fs) {
+  uint32_t meta[2] = { alloc(fs), alloc(fs) };
+
+  fs->rev++;
+  int err = write_meta(fs, meta[0]);
+  if (err < TOCK_SUCCESS) return err;
+  err = write_empty(fs, meta[1]);
+  if (err < TOCK_SUCCESS) return err;
+
+  fs->meta[0]     = meta[0];
+  fs->meta[1]     = meta[1];
+  fs->meta_active = 0;
+  fs->anchor_rev++;
+  fs->anchor = 1 - fs->anchor;
+  return write_anchor(fs, fs->anchor);
+}
+
+// Makes the changes since the last sync current: writes back the data and
+// index blocks, then the file table over its older copy.
+static int commit(sdfs_t* fs) {
+  if (!fs->meta_dirty) return TOCK_SUCCESS;
+
+  int err = cache_flush(fs);
+  if (err < TOCK_SUCCESS) return err;
+
+  if (fs->rev % SDFS_BLOCK_CYCLES == SDFS_BLOCK_CYCLES - 1 && lookahead_has(fs, 2)) {
+    err = relocate(fs);
+  } else {
+    fs->rev++;
+    fs->meta_active = 1 - fs->meta_active;
+    err = write_meta(fs, fs->meta[fs->meta_active]);
+  }
+  if (err < TOCK_SUCCESS) return err;
+
+  fs->meta_dirty = false;
+  memset(fs->fresh, 0, sizeof(fs->fresh));
+  return TOCK_SUCCESS;
+}
+
+static void init(sdfs_t* fs, sdfs_device_t* device, sdfs_cache_block_t* cache,
+                 size_t cache_blocks) {
+  memset(fs, 0, sizeof(*fs));
+  fs->device       = device;
+  fs->cache        = cache;
+  fs->cache_blocks = cache_blocks;
+  fs->block_count  = device->block_count;
+  fs->io_slot      = -1;
+  for (size_t i = 0; i < cache_blocks; i++) {
+    cache[i].block = NO_BLOCK;
+    cache[i].valid = false;
+    cache[i].dirty = false;
+  }
+}
+
+// Starts allocating from a place that depends on the revision, so that
+// remounts do not always reuse the same blocks first.
+static int start_lookahead(sdfs_t* fs) {
+  fs->lookahead_start = (uint32_t) (fs->rev * 2654435761u) % fs->block_count;
+  return lookahead_fill(fs);
+}
+
+int sdfs_format(sdfs_t* fs, sdfs_device_t* device, sdfs_cache_block_t* cache,
+                size_t cache_blocks) {
+  if (cache_blocks < 2 || device->block_count < 8) return TOCK_EINVAL;
+  init(fs, device, cache, cache_blocks);
+
+  fs->rev     = 1;
+  fs->meta[0] = 2;
+  fs->meta[1] = 3;
+  int err = write_meta(fs, fs->meta[0]);
+  if (err < TOCK_SUCCESS) return err;
+  err = write_empty(fs, fs->meta[1]);
+  if (err < TOCK_SUCCESS) return err;
+  err = write_empty(fs, 1);
+  if (err < TOCK_SUCCESS) return err;
+  fs->anchor_rev = 1;
+  err = write_anchor(fs, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  return start_lookahead(fs);
+}
+
+int sdfs_mount(sdfs_t* fs, sdfs_device_t* device, sdfs_cache_block_t* cache,
+               size_t cache_blocks) {
+  if (cache_blocks < 2) return TOCK_EINVAL;
+  init(fs, device, cache, cache_blocks);
+
+  bool found = false;
+  for (int i = 0; i < 2; i++) {
+    sdfs_cache_block_t* slot;
+    int err = cache_get(fs, i, true, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    anchor_t anchor;
+    memcpy(&anchor, slot->data, sizeof(anchor));
+    if (anchor.magic != ANCHOR_MAGIC || anchor.crc != crc32(&anchor, offsetof(anchor_t, crc)) ||
+        anchor.block_count > device->block_count || anchor.meta[0] >= anchor.block_count ||
+        anchor.meta[1] >= anchor.block_count) {
+      continue;
+    }
+    if (!found || (int32_t) (anchor.rev - fs->anchor_rev) > 0) {
+      found           = true;
+      fs->anchor      = i;
+      fs->anchor_rev  = anchor.rev;
+      fs->block_count = anchor.block_count;
+      fs->meta[0]     = anchor.meta[0];
+      fs->meta[1]     = anchor.meta[1];
+    }
+  }
+  if (!found) return TOCK_EINVAL;
+
+  found = false;
+  for (int i = 0; i < 2; i++) {
+    sdfs_cache_block_t* slot;
+    int err = cache_get(fs, fs->meta[i], true, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    meta_t meta;
+    memcpy(&meta, slot->data, sizeof(meta));
+    if (meta.magic != META_MAGIC || meta.crc != crc32(&meta, offsetof(meta_t, crc))) {
+      continue;
+    }
+    if (!found || (int32_t) (meta.rev - fs->rev) > 0) {
+      found           = true;
+      fs->meta_active = i;
+      fs->rev         = meta.rev;
+      memcpy(fs->files, meta.files, sizeof(fs->files));
+    }
+  }
+  if (!found) return TOCK_EINVAL;
+
+  return start_lookahead(fs);
+}
+
+int sdfs_unmount(sdfs_t* fs) {
+  int err = commit(fs);
+  io_finish(fs);
+  return err;
+}
+
+// ***** Files *****
+
+static int find(sdfs_t* fs, const char* name) {
+  for (int i = 0; i < SDFS_MAX_FILES; i++) {
+    if (fs->files[i].name[0] != '\0' && strncmp(fs->files[i].name, name, SDFS_NAME_MAX) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int sdfs_open(sdfs_t* fs, sdfs_file_t* file, const char* name, int flags) {
+  size_t len = strlen(name);
+  if (len == 0 || len > SDFS_NAME_MAX) return TOCK_EINVAL;
+
+  int index = find(fs, name);
+  if (index < 0) {
+    if (!(flags & SDFS_CREATE)) return TOCK_EINVAL;
+    for (index = 0; index < SDFS_MAX_FILES; index++) {
+      if (fs->files[index].name[0] == '\0') break;
+    }
+    if (index == SDFS_MAX_FILES) return TOCK_ENOMEM;
+    memset(&fs->files[index], 0, sizeof(sdfs_entry_t));
+    memcpy(fs->files[index].name, name, len);
+    fs->meta_dirty = true;
+  }
+
+  sdfs_entry_t* entry = &fs->files[index];
+  if ((flags & SDFS_TRUNCATE) && entry->size > 0) {
+    entry->size    = 0;
+    entry->root    = 0;
+    entry->height  = 0;
+    fs->meta_dirty = true;
+  }
+
+  file->fs        = fs;
+  file->file      = index;
+  file->flags     = flags;
+  file->pos       = flags & SDFS_APPEND ? entry->size : 0;
+  file->last_read = NO_BLOCK;
+  return TOCK_SUCCESS;
+}
+
+// Finds the block holding block `index` of the file.
+static int lookup(sdfs_t* fs, sdfs_entry_t* entry, uint32_t index, uint32_t* block) {
+  uint32_t current = entry->root;
+  for (uint32_t level = entry->height; level > 0 && current != 0; level--) {
+    sdfs_cache_block_t* slot;
+    int err = cache_get(fs, current, true, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    current = ptr_get(slot, (index / span(level - 1)) % POINTERS);
+  }
+  *block = current;
+  return TOCK_SUCCESS;
+}
+
+int sdfs_read(sdfs_file_t* file, void* buffer, size_t len) {
+  sdfs_t* fs          = file->fs;
+  sdfs_entry_t* entry = &fs->files[file->file];
+  uint8_t* out        = (uint8_t*) buffer;
+  size_t done         = 0;
+
+  while (done < len && file->pos < entry->size) {
+    uint32_t index  = file->pos / SDFS_BLOCK_SIZE;
+    uint32_t offset = file->pos % SDFS_BLOCK_SIZE;
+    size_t n        = SDFS_BLOCK_SIZE - offset;
+    if (n > len - done) n = len - done;
+    if (n > entry->size - file->pos) n = entry->size - file->pos;
+
+    uint32_t block;
+    int err = lookup(fs, entry, index, &block);
+    if (err < TOCK_SUCCESS) return err;
+    sdfs_cache_block_t* slot;
+    err = cache_get(fs, block, true, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    memcpy(out + done, slot->data + offset, n);
+
+    if (index != file->last_read) {
+      // Read the next block while the app works through this one. Reading
+      // from the start of the file counts as sequential.
+      if (index == file->last_read + 1 && (index + 1) * SDFS_BLOCK_SIZE < entry->size) {
+        uint32_t next;
+        if (lookup(fs, entry, index + 1, &next) == TOCK_SUCCESS && next != 0) {
+          cache_prefetch(fs, next);
+        }
+      }
+      file->last_read = index;
+    }
+
+    done      += n;
+    file->pos += n;
+  }
+  return done;
+}
+
+// Gets block `index` of the file into the cache, ready to be changed. A
+// block still used by the last synced state is moved to a new block first,
+// and so are the index blocks above it. If `keep` is false the caller
+// overwrites all of the block's data.
+static int writable_block(sdfs_t* fs, sdfs_entry_t* entry, uint32_t index, bool keep,
+                          sdfs_cache_block_t** out) {
+  while (index >= span(entry->height)) {
+    if (entry->root != 0) {
+      sdfs_cache_block_t* slot;
+      uint32_t root = alloc(fs);
+      int err       = cache_get(fs, root, false, &slot);
+      if (err < TOCK_SUCCESS) return err;
+      ptr_set(slot, 0, entry->root);
+      slot->dirty = true;
+      entry->root = root;
+    }
+    entry->height++;
+    fs->meta_dirty = true;
+  }
+
+  sdfs_cache_block_t* parent = NULL;
+  uint32_t pointer = 0;
+  uint32_t block   = entry->root;
+  for (uint32_t level = entry->height; ; level--) {
+    bool load = level > 0 || keep;
+    sdfs_cache_block_t* slot;
+    int err;
+
+    if (block != 0 && is_fresh(fs, block)) {
+      err = cache_get(fs, block, load, &slot);
+      if (err < TOCK_SUCCESS) return err;
+    } else {
+      uint32_t moved = alloc(fs);
+      if (parent == NULL) {
+        entry->root    = moved;
+        fs->meta_dirty = true;
+      } else {
+        // Nothing has touched the cache since `parent` was got.
+        ptr_set(parent, pointer, moved);
+        parent->dirty = true;
+      }
+
+      if (block != 0 && load) {
+        err = cache_get(fs, block, true, &slot);
+        if (err < TOCK_SUCCESS) return err;
+        slot->block = moved;
+      } else {
+        err = cache_get(fs, moved, false, &slot);
+        if (err < TOCK_SUCCESS) return err;
+      }
+      slot->dirty = true;
+    }
+
+    if (level == 0) {
+      slot->dirty = true;
+      *out        = slot;
+      return TOCK_SUCCESS;
+    }
+    parent  = slot;
+    pointer = (index / span(level - 1)) % POINTERS;
+    block   = ptr_get(slot, pointer);
+  }
+}
+
+int sdfs_write(sdfs_file_t* file, const void* buffer, size_t len) {
+  sdfs_t* fs          = file->fs;
+  sdfs_entry_t* entry = &fs->files[file->file];
+  const uint8_t* in   = (const uint8_t*) buffer;
+  size_t done         = 0;
+
+  if (file->flags & SDFS_APPEND) file->pos = entry->size;
+  if ((uint64_t) file->pos + len > 0xFFFFFFFF) return TOCK_ESIZE;
+
+  while (done < len) {
+    uint32_t index  = file->pos / SDFS_BLOCK_SIZE;
+    uint32_t offset = file->pos % SDFS_BLOCK_SIZE;
+    size_t n        = SDFS_BLOCK_SIZE - offset;
+    if (n > len - done) n = len - done;
+
+    // A new block and index blocks up to a new root.
+    int err = reserve(fs, entry->height + 3);
+    if (err < TOCK_SUCCESS) return err;
+    // Old data is kept unless all of the block is written or it only holds
+    // bytes past the end of the file.
+    bool keep = n < SDFS_BLOCK_SIZE && index * SDFS_BLOCK_SIZE < entry->size;
+    sdfs_cache_block_t* slot;
+    err = writable_block(fs, entry, index, keep, &slot);
+    if (err < TOCK_SUCCESS) return err;
+    memcpy(slot->data + offset, in + done, n);
+
+    done      += n;
+    file->pos += n;
+    if (file->pos > entry->size) {
+      entry->size    = file->pos;
+      fs->meta_dirty = true;
+    }
+    if (offset + n == SDFS_BLOCK_SIZE) {
+      // Write the full block back while the app fills the next one.
+      io_start(fs, slot - fs->cache, true);
+    }
+  }
+  return done;
+}
+
+int sdfs_seek(sdfs_file_t* file, uint32_t pos) {
+  if (pos > file->fs->files[file->file].size) return TOCK_EINVAL;
+  file->pos       = pos;
+  file->last_read = NO_BLOCK;
+  return TOCK_SUCCESS;
+}
+
+uint32_t sdfs_size(sdfs_file_t* file) {
+  return file->fs->files[file->file].size;
+}
+
+int sdfs_sync(sdfs_file_t* file) {
+  return commit(file->fs);
+}
+
+int sdfs_close(sdfs_file_t* file) {
+  return commit(file->fs);
+}
+
+int sdfs_remove(sdfs_t* fs, const char* name) {
+  int index = find(fs, name);
+  if (index < 0) return TOCK_EINVAL;
+  memset(&fs->files[index], 0, sizeof(sdfs_entry_t));
+  fs->meta_dirty = true;
+  return commit(fs);
+}
+
+int sdfs_stat(sdfs_t* fs, const char* name) {
+  int index = find(fs, name);
+  if (index < 0) return TOCK_EINVAL;
+  return fs->files[index].size;
+}
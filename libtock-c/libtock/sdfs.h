@@ -0,0 +1,238 @@
+// Filesystem on block devices (SD cards)
+//
+// sdfs keeps a small set of files on a block device such as an SD card,
+// and keeps them consistent across power loss: after a reset every file
+// holds what it held at its last sync (or at a later sync that was under
+// way), never a mix.
+//
+// Layout:
+//
+// - Blocks 0 and 1 hold an anchor, written alternately, that points at the
+//   metadata pair.
+// - The metadata pair is two blocks, written alternately, each holding the
+//   file table (name, size and tree root of every file) with a revision
+//   number and a checksum. Mounting takes the valid copy with the highest
+//   revision.
+// - A file's data blocks hang off a tree of index blocks of 128 block
+//   numbers each, which grows a level whenever the file outgrows it.
+//
+// Blocks in use by the last synced state are never overwritten: changed
+// blocks are written to new blocks (along with the index blocks above
+// them), and a sync makes them current by writing the file table. New
+// blocks are handed out from a window that moves around the whole device,
+// and the metadata pair moves to new blocks every SDFS_BLOCK_CYCLES syncs,
+// so writes are spread over the device rather than concentrated on a few
+// blocks.
+//
+// Blocks are read and written through a cache of caller-provided block
+// buffers. Small writes are gathered into whole blocks, a filled block is
+// written back in the background while the app fills the next one, and a
+// sync writes the remaining dirty blocks in block order. Sequential reads
+// start reading the next block in the background when they reach a block.
+// With the SD card driver one block is in flight at a time.
+//
+// Usage:
+//
+//   static sdfs_t fs;
+//   static sdfs_cache_block_t cache[4];
+//   static sdfs_device_t sd;
+//
+//   sdfs_sdcard_device(&sd, 0, 0);
+//   if (sdfs_mount(&fs, &sd, cache, 4) < 0) {
+//     sdfs_format(&fs, &sd, cache, 4);
+//   }
+//   sdfs_file_t log;
+//   sdfs_open(&fs, &log, "log", SDFS_CREATE | SDFS_APPEND);
+//   sdfs_write(&log, record, sizeof(record));
+//   sdfs_sync(&log);
+
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SDFS_BLOCK_SIZE 512
+
+// Longest file name, and most files.
+#define SDFS_NAME_MAX 15
+#define SDFS_MAX_FILES 17
+
+// Blocks the allocator tracks at once, one bit each (twice).
+#define SDFS_LOOKAHEAD 2048
+
+// Syncs after which the metadata pair moves to new blocks.
+#define SDFS_BLOCK_CYCLES 100
+
+// Flags for sdfs_open.
+#define SDFS_CREATE 1    // Create the file if it does not exist.
+#define SDFS_TRUNCATE 2  // Empty the file.
+#define SDFS_APPEND 4    // Write at the end of the file.
+
+// ***** Block devices *****
+
+// One block read or write. `done` is set when it completes, and `result`
+// to TOCK_SUCCESS or a negative error.
+typedef struct {
+  bool done;
+  int result;
+} sdfs_io_t;
+
+typedef struct sdfs_device {
+  uint32_t block_count;
+  // Start reading or writing one block, and complete `io` when done. The
+  // buffer must stay untouched until then. Return a negative error if the
+  // operation could not be started. Only one operation is started at once.
+  int (*read)(struct sdfs_device* device, uint32_t block, uint8_t* buffer, sdfs_io_t* io);
+  int (*write)(struct sdfs_device* device, uint32_t block, const uint8_t* buffer, sdfs_io_t* io);
+  // Wait for `io` to complete.
+  void (*wait)(struct sdfs_device* device, sdfs_io_t* io);
+  void* context;
+} sdfs_device_t;
+
+/* sdfs_sdcard_device
+ *  Initializes the SD card and sets up `device` to use `block_count` blocks
+ *  of it from `first_block` on, or the rest of the card if `block_count` is
+ *  0.
+ */
+int sdfs_sdcard_device(sdfs_device_t* device, uint32_t first_block, uint32_t block_count);
+
+// ***** Filesystem *****
+
+typedef struct {
+  uint8_t data[SDFS_BLOCK_SIZE];
+  uint32_t block;
+  // Last use, for eviction.
+  uint32_t used;
+  bool valid;
+  bool dirty;
+} sdfs_cache_block_t;
+
+// An entry of the file table, as stored on the device.
+typedef struct {
+  char name[SDFS_NAME_MAX + 1];
+  uint32_t size;
+  // Root of the file's tree: a data block at height 0, or an index block.
+  uint32_t root;
+  uint32_t height;
+} sdfs_entry_t;
+
+typedef struct {
+  sdfs_device_t* device;
+  sdfs_cache_block_t* cache;
+  size_t cache_blocks;
+  uint32_t clock;
+  uint32_t block_count;
+
+  // The operation in flight, if `io_slot` is not negative.
+  int io_slot;
+  bool io_write;
+  sdfs_io_t io;
+
+  int anchor;
+  uint32_t anchor_rev;
+  uint32_t meta[2];
+  int meta_active;
+  uint32_t rev;
+  bool meta_dirty;
+  sdfs_entry_t files[SDFS_MAX_FILES];
+
+  // Allocation window: `lookahead_start` is its first block and
+  // `lookahead_next` the next bit to try. `used` marks blocks of the last
+  // synced state and blocks allocated since, `fresh` only the latter.
+  uint32_t lookahead_start;
+  uint32_t lookahead_next;
+  uint8_t used[SDFS_LOOKAHEAD / 8];
+  uint8_t fresh[SDFS_LOOKAHEAD / 8];
+
+  // Device operations since mounting.
+  uint32_t block_reads;
+  uint32_t block_writes;
+  uint32_t prefetches;
+} sdfs_t;
+
+typedef struct {
+  sdfs_t* fs;
+  int file;
+  int flags;
+  uint32_t pos;
+  // Block of the file last read, to spot sequential reads.
+  uint32_t last_read;
+} sdfs_file_t;
+
+/* sdfs_format
+ *  Makes an empty filesystem on `device` and mounts it. `cache` holds
+ *  `cache_blocks` (at least 2) buffers for blocks.
+ */
+int sdfs_format(sdfs_t* fs, sdfs_device_t* device, sdfs_cache_block_t* cache,
+                size_t cache_blocks);
+
+/* sdfs_mount
+ *  Mounts the filesystem on `device`.
+ *  returns TOCK_EINVAL if the device holds no filesystem.
+ */
+int sdfs_mount(sdfs_t* fs, sdfs_device_t* device, sdfs_cache_block_t* cache,
+               size_t cache_blocks);
+
+/* sdfs_unmount
+ *  Syncs the filesystem.
+ */
+int sdfs_unmount(sdfs_t* fs);
+
+/* sdfs_open
+ *  Opens the file `name` with SDFS_* flags.
+ *  returns TOCK_EINVAL if it does not exist and SDFS_CREATE is not given,
+ *  or TOCK_ENOMEM if there are already SDFS_MAX_FILES files.
+ */
+int sdfs_open(sdfs_t* fs, sdfs_file_t* file, const char* name, int flags);
+
+/* sdfs_read
+ *  returns the number of bytes read (0 at the end of the file), or a
+ *  negative error.
+ */
+int sdfs_read(sdfs_file_t* file, void* buffer, size_t len);
+
+/* sdfs_write
+ *  returns the number of bytes written, or a negative error. Written data
+ *  survives power loss once the file is synced. After an error, changes
+ *  since the last sync may be lost; mount again to go back to it.
+ *  returns TOCK_ENOMEM if the device is full.
+ */
+int sdfs_write(sdfs_file_t* file, const void* buffer, size_t len);
+
+/* sdfs_seek
+ *  Moves to `pos`, which must not be past the end of the file.
+ */
+int sdfs_seek(sdfs_file_t* file, uint32_t pos);
+
+/* sdfs_size
+ *  returns the size of the file.
+ */
+uint32_t sdfs_size(sdfs_file_t* file);
+
+/* sdfs_sync
+ *  Makes all changes to the filesystem so far (not only to this file)
+ *  survive power loss.
+ */
+int sdfs_sync(sdfs_file_t* file);
+
+/* sdfs_close
+ *  Syncs the file.
+ */
+int sdfs_close(sdfs_file_t* file);
+
+/* sdfs_remove
+ *  Deletes the file `name` and syncs. Handles open on it become invalid.
+ */
+int sdfs_remove(sdfs_t* fs, const char* name);
+
+/* sdfs_stat
+ *  returns the size of the file `name`, or TOCK_EINVAL if there is none.
+ */
+int sdfs_stat(sdfs_t* fs, const char* name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+// SD card block device for sdfs
+
+#include "sdcard.h"
+#include "sdfs.h"
+
+// Completes the operation in `ud`. See `sdcard_cb` in sdcard.c for the
+// callback types.
+static void sdcard_io_cb(int callback_type,
+                         __attribute__ ((unused)) int arg1,
+                         __attribute__ ((unused)) int arg2,
+                         void* ud) {
+  sdfs_io_t* io = (sdfs_io_t*) ud;
+  switch (callback_type) {
+    case 2:
+    case 3:
+      io->result = TOCK_SUCCESS;
+      break;
+
+    case 0:
+      io->result = TOCK_EUNINSTALLED;
+      break;
+
+    default:
+      // The driver reports its own error codes.
+      io->result = TOCK_FAIL;
+      break;
+  }
+  io->done = true;
+}
+
+static uint32_t first_block(sdfs_device_t* device) {
+  return (uint32_t) device->context;
+}
+
+static int sdcard_read(sdfs_device_t* device, uint32_t block, uint8_t* buffer, sdfs_io_t* io) {
+  int err = sdcard_set_callback(sdcard_io_cb, io);
+  if (err < TOCK_SUCCESS) return err;
+  err = sdcard_set_read_buffer(buffer, SDFS_BLOCK_SIZE);
+  if (err < TOCK_SUCCESS) return err;
+  return sdcard_read_block(first_block(device) + block);
+}
+
+static int sdcard_write(sdfs_device_t* device, uint32_t block, const uint8_t* buffer,
+                        sdfs_io_t* io) {
+  int err = sdcard_set_callback(sdcard_io_cb, io);
+  if (err < TOCK_SUCCESS) return err;
+  // The driver only reads from the buffer.
+  err = sdcard_set_write_buffer((uint8_t*) buffer, SDFS_BLOCK_SIZE);
+  if (err < TOCK_SUCCESS) return err;
+  return sdcard_write_block(first_block(device) + block);
+}
+
+static void sdcard_wait(__attribute__ ((unused)) sdfs_device_t* device, sdfs_io_t* io) {
+  yield_for(&io->done);
+}
+
+int sdfs_sdcard_device(sdfs_device_t* device, uint32_t first, uint32_t block_count) {
+  int installed = sdcard_is_installed();
+  if (installed < TOCK_SUCCESS) return installed;
+  if (installed == 0) return TOCK_EUNINSTALLED;
+
+  uint32_t block_size, size_in_kB;
+  int err = sdcard_initialize_sync(&block_size, &size_in_kB);
+  // Errors from the driver's callback are positive.
+  if (err != TOCK_SUCCESS) return err < TOCK_SUCCESS ? err : TOCK_FAIL;
+  if (block_size != SDFS_BLOCK_SIZE) return TOCK_ENOSUPPORT;
+
+  uint32_t card_blocks = size_in_kB * (1024 / SDFS_BLOCK_SIZE);
+  if (first >= card_blocks) return TOCK_EINVAL;
+  if (block_count == 0 || block_count > card_blocks - first) {
+    block_count = card_blocks - first;
+  }
+
+  device->block_count = block_count;
+  device->read        = sdcard_read;
+  device->write       = sdcard_write;
+  device->wait        = sdcard_wait;
+  device->context     = (void*) first;
+  return TOCK_SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include <string.h>
+
+#include "sha256.h"
+
+static const uint32_t k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define S0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define s0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define s1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+// The message schedule is kept as a 16-word ring, extended in place as the
+// rounds consume it, instead of expanding all 64 words up front.
+#define W(i) w[(i) & 15]
+#define EXPAND(i) (W(i) += s1(W((i) - 2)) + W((i) - 7) + s0(W((i) - 15)))
+
+// One round with the working variables renamed rather than shifted.
+#define ROUND(a, b, c, d, e, f, g, h, i, wi) do { \
+    uint32_t t1 = (h) + S1(e) + CH(e, f, g) + k[i] + (wi); \
+    (d) += t1;                                            \
+    (h)  = t1 + S0(a) + MAJ(a, b, c);                     \
+} while (0)
+
+#define ROUNDS8(i, WF) do {                      \
+    ROUND(a, b, c, d, e, f, g, h, (i) + 0, WF((i) + 0)); \
+    ROUND(h, a, b, c, d, e, f, g, (i) + 1, WF((i) + 1)); \
+    ROUND(g, h, a, b, c, d, e, f, (i) + 2, WF((i) + 2)); \
+    ROUND(f, g, h, a, b, c, d, e, (i) + 3, WF((i) + 3)); \
+    ROUND(e, f, g, h, a, b, c, d, (i) + 4, WF((i) + 4)); \
+    ROUND(d, e, f, g, h, a, b, c, (i) + 5, WF((i) + 5)); \
+    ROUND(c, d, e, f, g, h, a, b, (i) + 6, WF((i) + 6)); \
+    ROUND(b, c, d, e, f, g, h, a, (i) + 7, WF((i) + 7)); \
+} while (0)
+
+static void compress(uint32_t* state, const uint8_t* block) {
+  uint32_t w[16];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t) block[4 * i] << 24) | (block[4 * i + 1] << 16) |
+           (block[4 * i + 2] << 8) | block[4 * i + 3];
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+  ROUNDS8(0, W);
+  ROUNDS8(8, W);
+  for (int i = 16; i < 64; i += 16) {
+    ROUNDS8(i, EXPAND);
+    ROUNDS8(i + 8, EXPAND);
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+void sha256_init(sha256_ctx_t* ctx) {
+  static const uint32_t initial[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+  memcpy(ctx->state, initial, sizeof(initial));
+  ctx->total   = 0;
+  ctx->buf_len = 0;
+}
+
+void sha256_update(sha256_ctx_t* ctx, const void* data, size_t len) {
+  const uint8_t* p = data;
+  ctx->total += len;
+
+  if (ctx->buf_len > 0) {
+    size_t n = SHA256_BLOCK_LEN - ctx->buf_len;
+    if (n > len) n = len;
+    memcpy(ctx->buf + ctx->buf_len, p, n);
+    ctx->buf_len += n;
+    p   += n;
+    len -= n;
+    if (ctx->buf_len < SHA256_BLOCK_LEN) return;
+    compress(ctx->state, ctx->buf);
+    ctx->buf_len = 0;
+  }
+
+  // Whole blocks are hashed straight from the caller's buffer.
+  while (len >= SHA256_BLOCK_LEN) {
+    compress(ctx->state, p);
+    p   += SHA256_BLOCK_LEN;
+    len -= SHA256_BLOCK_LEN;
+  }
+
+  memcpy(ctx->buf, p, len);
+  ctx->buf_len = len;
+}
+
+void sha256_update_chunks(sha256_ctx_t* ctx, const sha256_chunk_t* chunks, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    sha256_update(ctx, chunks[i].data, chunks[i].len);
+  }
+}
+
+void sha256_finish(sha256_ctx_t* ctx, uint8_t* digest) {
+  uint64_t bits = ctx->total * 8;
+
+  ctx->buf[ctx->buf_len++] = 0x80;
+  if (ctx->buf_len > SHA256_BLOCK_LEN - 8) {
+    memset(ctx->buf + ctx->buf_len, 0, SHA256_BLOCK_LEN - ctx->buf_len);
+    compress(ctx->state, ctx->buf);
+    ctx->buf_len = 0;
+  }
+  memset(ctx->buf + ctx->buf_len, 0, SHA256_BLOCK_LEN - 8 - ctx->buf_len);
+  for (int i = 0; i < 8; i++) {
+    ctx->buf[SHA256_BLOCK_LEN - 1 - i] = bits >> (8 * i);
+  }
+  compress(ctx->state, ctx->buf);
+
+  for (int i = 0; i < 8; i++) {
+    digest[4 * i]     = ctx->state[i] >> 24;
+    digest[4 * i + 1] = ctx->state[i] >> 16;
+    digest[4 * i + 2] = ctx->state[i] >> 8;
+    digest[4 * i + 3] = ctx->state[i];
+  }
+}
+
+void sha256(const void* data, size_t len, uint8_t* digest) {
+  sha256_ctx_t ctx;
+  sha256_init(&ctx);
+  sha256_update(&ctx, data, len);
+  sha256_finish(&ctx, digest);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming SHA-256 (FIPS 180-4) in software.
+//
+// Used on its own for hashing (e.g. verifying a firmware image as it is read
+// in) and underneath HMAC-SHA256 in hmac.h.
+
+#define SHA256_DIGEST_LEN 32
+#define SHA256_BLOCK_LEN  64
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t total;
+  uint8_t buf[SHA256_BLOCK_LEN];
+  size_t buf_len;
+} sha256_ctx_t;
+
+// One piece of a message that is not contiguous in memory.
+typedef struct {
+  const void* data;
+  size_t len;
+} sha256_chunk_t;
+
+/* sha256_init
+ *  Starts a new hash.
+ */
+void sha256_init(sha256_ctx_t* ctx);
+
+/* sha256_update
+ *  Adds `len` bytes to the hash.
+ */
+void sha256_update(sha256_ctx_t* ctx, const void* data, size_t len);
+
+/* sha256_update_chunks
+ *  Adds `count` chunks to the hash, in order, as if they were contiguous.
+ */
+void sha256_update_chunks(sha256_ctx_t* ctx, const sha256_chunk_t* chunks, size_t count);
+
+/* sha256_finish
+ *  Writes the 32-byte digest to `digest`. The context must be re-initialized
+ *  before it is used again.
+ */
+void sha256_finish(sha256_ctx_t* ctx, uint8_t* digest);
+
+/* sha256
+ *  One-shot hash of `len` bytes at `data`.
+ */
+void sha256(const void* data, size_t len, uint8_t* digest);
+
+#ifdef __cplusplus
+}
+#endif
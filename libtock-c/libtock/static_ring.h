@@ -0,0 +1,301 @@
+// Fixed-capacity double-ended queue for C++ apps
+//
+// tock::static_ring<T, N> is a circular buffer of up to N elements of T,
+// held inline like tock::static_vector, that can be added to and removed
+// from at both ends in constant time. N is a power of two so positions wrap
+// with a mask. It is meant for queues, histories of the last N samples and
+// the like, used from one context; to pass elements between a callback and
+// the main loop, or between processes, use tock::Ring from ring.h.
+//
+// The interface follows std::deque, with random-access iterators. Adding to
+// a full ring fails instead of throwing: push_back and push_front return
+// false and emplace_back and emplace_front return nullptr. For a history
+// that keeps the newest elements, pop_front before pushing when full().
+//
+// Usage:
+//
+//   tock::static_ring<int, 8> last;
+//   if (last.full()) last.pop_front();
+//   last.push_back(sample);
+//   int sum = std::accumulate(last.begin(), last.end(), 0);
+
+#pragma once
+
+#include <iterator>
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace tock {
+
+template <typename T, size_t N>
+class static_ring final {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "static_ring capacity must be a power of two");
+
+  template <typename Ring, typename Value>
+  class iterator_t final {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    iterator_t() : ring_(nullptr), pos_(0) {}
+    iterator_t(Ring* ring, size_t pos) : ring_(ring), pos_(pos) {}
+    // A const_iterator from an iterator.
+    template <typename OtherRing, typename OtherValue>
+    iterator_t(const iterator_t<OtherRing, OtherValue>& other,
+               typename std::enable_if<std::is_convertible<OtherRing*, Ring*>::value>::type* =
+                 nullptr) : ring_(other.ring_), pos_(other.pos_) {}
+
+    reference operator*() const {
+      return (*ring_)[pos_];
+    }
+    pointer operator->() const {
+      return &(*ring_)[pos_];
+    }
+    reference operator[](difference_type n) const {
+      return (*ring_)[pos_ + n];
+    }
+
+    iterator_t& operator++() {
+      pos_++;
+      return *this;
+    }
+    iterator_t operator++(int) {
+      iterator_t old = *this;
+      pos_++;
+      return old;
+    }
+    iterator_t& operator--() {
+      pos_--;
+      return *this;
+    }
+    iterator_t operator--(int) {
+      iterator_t old = *this;
+      pos_--;
+      return old;
+    }
+    iterator_t& operator+=(difference_type n) {
+      pos_ += n;
+      return *this;
+    }
+    iterator_t& operator-=(difference_type n) {
+      pos_ -= n;
+      return *this;
+    }
+    iterator_t operator+(difference_type n) const {
+      return iterator_t(ring_, pos_ + n);
+    }
+    friend iterator_t operator+(difference_type n, const iterator_t& it) {
+      return it + n;
+    }
+    iterator_t operator-(difference_type n) const {
+      return iterator_t(ring_, pos_ - n);
+    }
+    difference_type operator-(const iterator_t& other) const {
+      return static_cast<difference_type>(pos_ - other.pos_);
+    }
+
+    friend bool operator==(const iterator_t& a, const iterator_t& b) {
+      return a.pos_ == b.pos_;
+    }
+    friend bool operator!=(const iterator_t& a, const iterator_t& b) {
+      return a.pos_ != b.pos_;
+    }
+    friend bool operator<(const iterator_t& a, const iterator_t& b) {
+      return a.pos_ < b.pos_;
+    }
+    friend bool operator>(const iterator_t& a, const iterator_t& b) {
+      return a.pos_ > b.pos_;
+    }
+    friend bool operator<=(const iterator_t& a, const iterator_t& b) {
+      return a.pos_ <= b.pos_;
+    }
+    friend bool operator>=(const iterator_t& a, const iterator_t& b) {
+      return a.pos_ >= b.pos_;
+    }
+
+  private:
+    template <typename, typename>
+    friend class iterator_t;
+
+    Ring* ring_;
+    // Position from the front of the ring.
+    size_t pos_;
+  };
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef iterator_t<static_ring, T> iterator;
+  typedef iterator_t<const static_ring, const T> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  static_ring() : head_(0), size_(0) {}
+
+  static_ring(const static_ring& other) : head_(0), size_(0) {
+    for (const T& value : other) emplace_back(value);
+  }
+
+  ~static_ring() {
+    clear();
+  }
+
+  static_ring& operator=(const static_ring& other) {
+    if (this != &other) {
+      clear();
+      for (const T& value : other) emplace_back(value);
+    }
+    return *this;
+  }
+
+  // ***** Element access *****
+
+  // The element `pos` places from the front. Unchecked, like std::deque.
+  reference operator[](size_type pos) {
+    return slot(head_ + pos);
+  }
+  const_reference operator[](size_type pos) const {
+    return slot(head_ + pos);
+  }
+
+  reference front() {
+    return slot(head_);
+  }
+  const_reference front() const {
+    return slot(head_);
+  }
+  reference back() {
+    return slot(head_ + size_ - 1);
+  }
+  const_reference back() const {
+    return slot(head_ + size_ - 1);
+  }
+
+  // ***** Iterators *****
+
+  iterator begin() {
+    return iterator(this, 0);
+  }
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+  const_iterator cbegin() const {
+    return const_iterator(this, 0);
+  }
+  iterator end() {
+    return iterator(this, size_);
+  }
+  const_iterator end() const {
+    return const_iterator(this, size_);
+  }
+  const_iterator cend() const {
+    return const_iterator(this, size_);
+  }
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  // ***** Capacity *****
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  bool full() const {
+    return size_ == N;
+  }
+  size_type size() const {
+    return size_;
+  }
+  static constexpr size_type capacity() {
+    return N;
+  }
+  static constexpr size_type max_size() {
+    return N;
+  }
+
+  // ***** Modifiers *****
+
+  void clear() {
+    while (size_ > 0) pop_back();
+  }
+
+  // Constructs an element from `args` at the back.
+  // returns the new element, or nullptr if the ring is full.
+  template <typename ... Args>
+  pointer emplace_back(Args&& ... args) {
+    if (full()) return nullptr;
+    pointer element = new (&slot(head_ + size_)) T(std::forward<Args>(args) ...);
+    size_++;
+    return element;
+  }
+
+  // Constructs an element from `args` at the front.
+  // returns the new element, or nullptr if the ring is full.
+  template <typename ... Args>
+  pointer emplace_front(Args&& ... args) {
+    if (full()) return nullptr;
+    pointer element = new (&slot(head_ - 1)) T(std::forward<Args>(args) ...);
+    head_ = (head_ - 1) & (N - 1);
+    size_++;
+    return element;
+  }
+
+  // returns false if the ring is full.
+  bool push_back(const T& value) {
+    return emplace_back(value) != nullptr;
+  }
+  bool push_back(T&& value) {
+    return emplace_back(std::move(value)) != nullptr;
+  }
+  bool push_front(const T& value) {
+    return emplace_front(value) != nullptr;
+  }
+  bool push_front(T&& value) {
+    return emplace_front(std::move(value)) != nullptr;
+  }
+
+  void pop_back() {
+    size_--;
+    slot(head_ + size_).~T();
+  }
+
+  void pop_front() {
+    slot(head_).~T();
+    head_ = (head_ + 1) & (N - 1);
+    size_--;
+  }
+
+private:
+  reference slot(size_type index) {
+    return reinterpret_cast<pointer>(storage_)[index & (N - 1)];
+  }
+  const_reference slot(size_type index) const {
+    return reinterpret_cast<const_pointer>(storage_)[index & (N - 1)];
+  }
+
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_[N];
+  // Slot of the front element.
+  size_type head_;
+  size_type size_;
+};
+
+}  // namespace tock
@@ -0,0 +1,266 @@
+// Fixed-capacity vector for C++ apps
+//
+// tock::static_vector<T, N> holds up to N elements of T inline, in the
+// object itself: it never touches the heap, so a vector's memory is fixed
+// when the app is linked (or when the vector is put on the stack) and cannot
+// fragment the small app heap. Elements are constructed when they are added
+// and destroyed when they are removed, so T need not be default
+// constructible.
+//
+// The interface follows std::vector, with iterators that are plain pointers,
+// so it works with range-for and <algorithm>. Apps are built without
+// exceptions in mind, so operations that would grow the vector past N fail
+// instead of throwing: push_back and resize return false, emplace_back
+// returns nullptr and insert returns end(), leaving the vector unchanged.
+//
+// Usage:
+//
+//   tock::static_vector<reading_t, 16> readings;
+//   if (!readings.push_back(reading)) {
+//     printf("Too many readings\n");
+//   }
+//   for (auto& r : readings) process(r);
+
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace tock {
+
+template <typename T, size_t N>
+class static_vector final {
+  static_assert(N > 0, "static_vector capacity must be at least 1");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  static_vector() : size_(0) {}
+
+  // Takes the first N values of `values`.
+  static_vector(std::initializer_list<T> values) : size_(0) {
+    for (const T& value : values) {
+      if (!push_back(value)) break;
+    }
+  }
+
+  static_vector(const static_vector& other) : size_(0) {
+    for (const T& value : other) emplace_back(value);
+  }
+
+  static_vector(static_vector&& other) : size_(0) {
+    for (T& value : other) emplace_back(std::move(value));
+    other.clear();
+  }
+
+  ~static_vector() {
+    clear();
+  }
+
+  static_vector& operator=(const static_vector& other) {
+    if (this != &other) {
+      clear();
+      for (const T& value : other) emplace_back(value);
+    }
+    return *this;
+  }
+
+  static_vector& operator=(static_vector&& other) {
+    if (this != &other) {
+      clear();
+      for (T& value : other) emplace_back(std::move(value));
+      other.clear();
+    }
+    return *this;
+  }
+
+  // ***** Element access *****
+
+  // Unchecked, like std::vector.
+  reference operator[](size_type pos) {
+    return data()[pos];
+  }
+  const_reference operator[](size_type pos) const {
+    return data()[pos];
+  }
+
+  reference front() {
+    return data()[0];
+  }
+  const_reference front() const {
+    return data()[0];
+  }
+  reference back() {
+    return data()[size_ - 1];
+  }
+  const_reference back() const {
+    return data()[size_ - 1];
+  }
+
+  pointer data() {
+    return reinterpret_cast<pointer>(storage_);
+  }
+  const_pointer data() const {
+    return reinterpret_cast<const_pointer>(storage_);
+  }
+
+  // ***** Iterators *****
+
+  iterator begin() {
+    return data();
+  }
+  const_iterator begin() const {
+    return data();
+  }
+  const_iterator cbegin() const {
+    return data();
+  }
+  iterator end() {
+    return data() + size_;
+  }
+  const_iterator end() const {
+    return data() + size_;
+  }
+  const_iterator cend() const {
+    return data() + size_;
+  }
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  // ***** Capacity *****
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  bool full() const {
+    return size_ == N;
+  }
+  size_type size() const {
+    return size_;
+  }
+  static constexpr size_type capacity() {
+    return N;
+  }
+  static constexpr size_type max_size() {
+    return N;
+  }
+
+  // ***** Modifiers *****
+
+  void clear() {
+    while (size_ > 0) pop_back();
+  }
+
+  // Constructs an element from `args` at the end.
+  // returns the new element, or nullptr if the vector is full.
+  template <typename ... Args>
+  pointer emplace_back(Args&& ... args) {
+    if (full()) return nullptr;
+    pointer slot = new (data() + size_) T(std::forward<Args>(args) ...);
+    size_++;
+    return slot;
+  }
+
+  // returns false if the vector is full.
+  bool push_back(const T& value) {
+    return emplace_back(value) != nullptr;
+  }
+  bool push_back(T&& value) {
+    return emplace_back(std::move(value)) != nullptr;
+  }
+
+  void pop_back() {
+    size_--;
+    data()[size_].~T();
+  }
+
+  // Constructs an element from `args` before `pos`, moving the elements
+  // from `pos` on up by one.
+  // returns the new element, or end() if the vector is full.
+  template <typename ... Args>
+  iterator emplace(const_iterator pos, Args&& ... args) {
+    if (full()) return end();
+    iterator at = begin() + (pos - cbegin());
+    if (at == end()) {
+      emplace_back(std::forward<Args>(args) ...);
+      return at;
+    }
+    // Build the element first, since `args` may refer to an element.
+    T value(std::forward<Args>(args) ...);
+    emplace_back(std::move(back()));
+    std::move_backward(at, end() - 2, end() - 1);
+    *at = std::move(value);
+    return at;
+  }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return emplace(pos, value);
+  }
+  iterator insert(const_iterator pos, T&& value) {
+    return emplace(pos, std::move(value));
+  }
+
+  // Removes the elements in [first, last), moving the ones after down.
+  // returns the element after the last one removed.
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator to   = begin() + (first - cbegin());
+    iterator from = begin() + (last - cbegin());
+    iterator kept = std::move(from, end(), to);
+    while (end() != kept) pop_back();
+    return to;
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  // Adds default-constructed elements or removes elements from the end.
+  // returns false, without changing the vector, if `count` exceeds N.
+  bool resize(size_type count) {
+    if (count > N) return false;
+    while (size_ > count) pop_back();
+    while (size_ < count) emplace_back();
+    return true;
+  }
+
+private:
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_[N];
+  size_type size_;
+};
+
+template <typename T, size_t N>
+bool operator==(const static_vector<T, N>& a, const static_vector<T, N>& b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, size_t N>
+bool operator!=(const static_vector<T, N>& a, const static_vector<T, N>& b) {
+  return !(a == b);
+}
+
+}  // namespace tock
@@ -1,23 +1,6 @@
 #include "temperature.h"
 #include "tock.h"
 
-struct data {
-  bool fired;
-  int temp;
-};
-
-static struct data result = { .fired = false };
-
-// Internal callback for faking synchronous reads
-static void cb(int temp,
-               __attribute__ ((unused)) int unused,
-               __attribute__ ((unused)) int unused1,
-               void* ud) {
-  struct data* data = (struct data*) ud;
-  data->temp  = temp;
-  data->fired = true;
-}
-
 int temperature_set_callback(subscribe_cb callback, void* callback_args) {
   return subscribe(DRIVER_NUM_TEMPERATURE, 0, callback, callback_args);
 }
@@ -27,19 +10,14 @@ int temperature_read(void) {
 }
 
 int temperature_read_sync(int* temperature) {
-  int err;
-  result.fired = false;
-
-  err = temperature_set_callback(cb, (void*) &result);
+  tock_completion_t done;
+  int err = tock_completion_subscribe(&done, DRIVER_NUM_TEMPERATURE, 0);
   if (err < 0) return err;
 
-  err = temperature_read();
+  err = tock_completion_wait(&done, temperature_read());
   if (err < 0) return err;
 
-  // Wait for the callback.
-  yield_for(&result.fired);
-
-  *temperature = result.temp;
+  *temperature = done.arg0;
 
   return 0;
 }
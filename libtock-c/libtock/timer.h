@@ -7,6 +7,11 @@
  * `delay_ms` function is a blocking call that returns after the given number
  * of milliseconds.
  *
+ * Repeating timers are kept in the kernel while it has timers to spare for
+ * the process. The kernel then re-arms them itself, and each period costs a
+ * single callback. Once those run out, timers are multiplexed on the
+ * process's alarm in userspace.
+ *
  * # Structures
  *
  * `tock_timer_t` represents a handle to a timer.
@@ -41,6 +46,9 @@ typedef struct tock_timer {
   subscribe_cb* cb;
   void* ud;
   alarm_t alarm;
+  // Kernel timer the timer runs on (see alarm_internal_timer_every), or 0
+  // if it is multiplexed in userspace.
+  uint32_t kernel_timer;
 } tock_timer_t;
 
 
@@ -1,40 +1,24 @@
 #include "tmp006.h"
 
-static bool readtemp;
-
-// internal callback for faking synchronous reads
-static void tmp006_cb(int temp_value,
-                      int error_code,
-                      int unused __attribute__ ((unused)),
-                      void* callback_args) {
-  readtemp = true;
-
-  // return data to user
-  int32_t* callback_vals = (int32_t*)callback_args;
-  callback_vals[0] = temp_value;
-  callback_vals[1] = error_code;
-}
-
 // enable TMP006, take a single reading, disable TMP006, return value to user
 int tmp006_read_sync(int16_t* temp_reading) {
   // store temperature value and error code
-  int32_t callback_vals[2] = {0};
+  tock_completion_t done;
 
   // request a single sample
-  uint32_t err_code = subscribe(DRIVER_NUM_TMP006, 0, tmp006_cb, callback_vals);
+  int err_code = tock_completion_subscribe(&done, DRIVER_NUM_TMP006, 0);
   if (err_code != ERR_NONE) {
     return err_code;
   }
 
   // wait for result
-  readtemp = false;
-  yield_for(&readtemp);
+  tock_completion_wait(&done, ERR_NONE);
 
   // write value for user
-  *temp_reading = (int16_t)callback_vals[0];
+  *temp_reading = (int16_t)done.arg0;
 
   // return error code to user
-  return callback_vals[1];
+  return done.arg1;
 }
 
 // enable TMP006, take a single reading, disable TMP006, callback with value
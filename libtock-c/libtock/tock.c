@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "ring.h"
 #include "tock.h"
 
 typedef struct {
@@ -13,25 +14,33 @@ typedef struct {
   void* ud;
 } tock_task_t;
 
+// Callbacks queued by tock_enqueue, run by yield.
 #define TASK_QUEUE_SIZE  16
-static tock_task_t task_queue[TASK_QUEUE_SIZE];
-static int task_cur  = 0;
-static int task_last = 0;
+static tock_task_t task_slots[TASK_QUEUE_SIZE];
+static ring_t task_queue;
+static bool task_queue_ready = false;
 
 int tock_enqueue(subscribe_cb cb, int arg0, int arg1, int arg2, void* ud) {
-  int next_task_last = (task_last + 1) % TASK_QUEUE_SIZE;
-  if (next_task_last == task_cur) {
-    return -1;
+  if (!task_queue_ready) {
+    ring_init(&task_queue, task_slots, sizeof(tock_task_t), TASK_QUEUE_SIZE);
+    task_queue_ready = true;
   }
 
-  task_queue[task_last].cb   = cb;
-  task_queue[task_last].arg0 = arg0;
-  task_queue[task_last].arg1 = arg1;
-  task_queue[task_last].arg2 = arg2;
-  task_queue[task_last].ud   = ud;
-  task_last = next_task_last;
+  tock_task_t task = { cb, arg0, arg1, arg2, ud };
+  if (!ring_push(&task_queue, &task)) {
+    return -1;
+  }
+  return ring_count(&task_queue);
+}
 
-  return task_last;
+// Runs the oldest queued callback, if there is one.
+static bool run_task(void) {
+  tock_task_t task;
+  if (!task_queue_ready || !ring_pop(&task_queue, &task)) {
+    return false;
+  }
+  task.cb(task.arg0, task.arg1, task.arg2, task.ud);
+  return true;
 }
 
 void yield_for(bool *cond) {
@@ -40,14 +49,55 @@ void yield_for(bool *cond) {
   }
 }
 
+void tock_completion_cb(int arg0, int arg1, int arg2, void* ud) {
+  tock_completion_t* completion = (tock_completion_t*) ud;
+  completion->arg0  = arg0;
+  completion->arg1  = arg1;
+  completion->arg2  = arg2;
+  completion->fired = true;
+}
+
+// Subscriptions of _sync calls waiting, innermost first. Calls nest, so the
+// innermost is always the first to finish.
+static tock_completion_t* waiting = NULL;
+
+int tock_completion_subscribe(tock_completion_t* completion, uint32_t driver,
+                              uint32_t subscribe_num) {
+  for (tock_completion_t* c = waiting; c != NULL; c = c->outer) {
+    if (c->driver == driver && c->subscribe_num == subscribe_num) {
+      return TOCK_EBUSY;
+    }
+  }
+
+  completion->fired = false;
+  int err = subscribe(driver, subscribe_num, tock_completion_cb, completion);
+  if (err < TOCK_SUCCESS) return err;
+
+  completion->driver        = driver;
+  completion->subscribe_num = subscribe_num;
+  completion->outer         = waiting;
+  waiting = completion;
+  return TOCK_SUCCESS;
+}
+
+int tock_completion_wait(tock_completion_t* completion, int err) {
+  if (err >= TOCK_SUCCESS) {
+    yield_for(&completion->fired);
+  }
+  waiting = completion->outer;
+
+  // Nothing may call back into `completion` once it goes out of scope. This
+  // cannot fail, as the same subscription just succeeded.
+  int unsubscribed = subscribe(completion->driver, completion->subscribe_num,
+                               TOCK_DEACTIVATE_CALLBACK, NULL);
+  (void) unsubscribed;
+  return err < TOCK_SUCCESS ? err : TOCK_SUCCESS;
+}
+
 #if defined(__thumb__)
 
 void yield(void) {
-  if (task_cur != task_last) {
-    tock_task_t task = task_queue[task_cur];
-    task_cur = (task_cur + 1) % TASK_QUEUE_SIZE;
-    task.cb(task.arg0, task.arg1, task.arg2, task.ud);
-  } else {
+  if (!run_task()) {
     // Note: A process stops yielding when there is a callback ready to run,
     // which the kernel executes by modifying the stack frame pushed by the
     // hardware. The kernel copies the PC value from the stack frame to the LR
@@ -147,11 +197,7 @@ void* memop(uint32_t op_type, int arg1) {
 // a1-a4. Nothing specifically syscall related is pushed to the process stack.
 
 void yield(void) {
-  if (task_cur != task_last) {
-    tock_task_t task = task_queue[task_cur];
-    task_cur = (task_cur + 1) % TASK_QUEUE_SIZE;
-    task.cb(task.arg0, task.arg1, task.arg2, task.ud);
-  } else {
+  if (!run_task()) {
     asm volatile (
       "li    a0, 0\n"
       "ecall\n"
@@ -15,6 +15,47 @@ int tock_enqueue(subscribe_cb cb, int arg0, int arg1, int arg2, void* ud);
 void yield(void);
 void yield_for(bool*);
 
+// Completion of one asynchronous operation, for the _sync wrappers.
+//
+// A _sync wrapper keeps a tock_completion_t on its stack and passes it as
+// the user data of `tock_completion_cb`, which records the callback's
+// arguments and sets `fired`. Nothing is kept in statics, so _sync calls can
+// be made from callbacks that run while another _sync call is waiting.
+// tock_completion_subscribe subscribes it and tock_completion_wait waits for
+// it and unsubscribes it again, so callbacks that come after the wait (such
+// as interrupts the driver reports on the same subscription) are dropped
+// rather than written to a stack frame that is gone.
+typedef struct tock_completion {
+  bool fired;
+  int arg0;
+  int arg1;
+  int arg2;
+  // The subscription waited on, and the wait further out, from
+  // tock_completion_subscribe until tock_completion_wait returns.
+  uint32_t driver;
+  uint32_t subscribe_num;
+  struct tock_completion* outer;
+} tock_completion_t;
+
+void tock_completion_cb(int arg0, int arg1, int arg2, void* completion);
+
+// Subscribes `completion` to `subscribe_num` of `driver`, for an operation
+// to start next. Call this before allowing buffers for the operation, so a
+// nested call does not replace the buffers of the call it is refused for.
+// Once this succeeds, always pass the result of starting the operation
+// (including any allow) to tock_completion_wait, even if it is an error.
+// Returns TOCK_EBUSY, without subscribing, if a _sync call further out is
+// already waiting on the same subscription, since subscribing would take its
+// callback away.
+int tock_completion_subscribe(tock_completion_t* completion, uint32_t driver,
+                              uint32_t subscribe_num);
+
+// Waits for the callback of the operation started after
+// tock_completion_subscribe, unless `err` (the result of starting it) is an
+// error, which it returns. Either way it unsubscribes `completion`. The
+// callback's arguments are then in `arg0` to `arg2`.
+int tock_completion_wait(tock_completion_t* completion, int err);
+
 __attribute__ ((warn_unused_result))
 int command(uint32_t driver, uint32_t command, int data, int arg2);
 
@@ -69,6 +110,38 @@ const char* tock_strerror(int tock_errno);
 void tock_expect(int expected, int actual, const char* file, unsigned line);
 #define TOCK_EXPECT(_e, _a) tock_expect((_e), (_a), __FILE__, __LINE__)
 
+// Optimize a hot function for speed (-O2) even though apps are built with -Os.
+// Use it for the handful of functions that dominate run time, such as sample
+// processing loops or frequently fired callbacks.
+#define TOCK_HOT __attribute__((hot, optimize("O2")))
+
+// Run a function from process RAM instead of flash.
+//
+// crt0 copies `.ramfunc.*` into RAM along with .data, so tight loops and
+// callbacks marked this way run at full core speed regardless of flash
+// latency (e.g. the Teensy 4's QSPI flash). The kernel must be built with
+// `executable_app_memory` enabled, otherwise the MPU faults on the first call.
+//
+// On Cortex-M, flash and RAM are relocated independently, so calls between
+// them cannot use a PC-relative `bl`. `TOCK_RAMFUNC` functions are called
+// through the GOT, and any flash function they call must be declared
+// `TOCK_LONG_CALL` (the linker rejects the call otherwise). Calls between
+// `TOCK_RAMFUNC` functions need nothing special.
+//
+// Each function gets a section of its own (`.ramfunc.<n>`, numbered by
+// __COUNTER__ since an attribute cannot name the function it is on), so
+// --gc-sections drops the ones nothing calls instead of keeping every
+// `TOCK_RAMFUNC` function in a file once one of them is used.
+#if defined(__thumb__)
+#define TOCK_LONG_CALL __attribute__((long_call))
+#else
+#define TOCK_LONG_CALL
+#endif
+#define TOCK_RAMFUNC_SECTION_(_n) ".ramfunc." #_n
+#define TOCK_RAMFUNC_SECTION(_n) TOCK_RAMFUNC_SECTION_(_n)
+#define TOCK_RAMFUNC \
+  __attribute__((section(TOCK_RAMFUNC_SECTION(__COUNTER__)), noinline)) TOCK_LONG_CALL
+
 #ifdef __cplusplus
 }
 #endif
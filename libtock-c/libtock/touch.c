@@ -0,0 +1,204 @@
+#include <string.h>
+
+#include "touch.h"
+
+#define TOUCH_SUBSCRIBE_SINGLE 0
+#define TOUCH_SUBSCRIBE_GESTURE 1
+#define TOUCH_SUBSCRIBE_MULTI 2
+
+#define TOUCH_ALLOW_MULTI 2
+
+#define TOUCH_CMD_ACK 10
+#define TOUCH_CMD_BATCHING 11
+#define TOUCH_CMD_NUM_TOUCHES 100
+
+bool touch_exists (void) {
+  return driver_exists(DRIVER_NUM_TOUCH);
+}
+
+int touch_get_number_of_touches (int* touches) {
+  int ret = command(DRIVER_NUM_TOUCH, TOUCH_CMD_NUM_TOUCHES, 0, 0);
+  if (ret < TOCK_SUCCESS) return ret;
+  *touches = ret;
+  return TOCK_SUCCESS;
+}
+
+// ***** Single touch *****
+
+int touch_single_set_callback (subscribe_cb callback, void* ud) {
+  return subscribe(DRIVER_NUM_TOUCH, TOUCH_SUBSCRIBE_SINGLE, callback, ud);
+}
+
+void touch_single_decode (int status, int xy, int pressure_size, touch_event_t* event) {
+  event->id       = 0;
+  event->status   = status;
+  event->x        = ((unsigned int) xy) >> 16;
+  event->y        = xy & 0xffff;
+  event->size     = pressure_size & 0xffff;
+  event->pressure = ((unsigned int) pressure_size) >> 16;
+}
+
+int touch_gesture_set_callback (subscribe_cb callback, void* ud) {
+  return subscribe(DRIVER_NUM_TOUCH, TOUCH_SUBSCRIBE_GESTURE, callback, ud);
+}
+
+// ***** Multi touch batches *****
+
+int touch_multi_start (uint8_t* buffer, size_t len, int flags, subscribe_cb callback, void* ud) {
+  int err = allow(DRIVER_NUM_TOUCH, TOUCH_ALLOW_MULTI, buffer, len);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = command(DRIVER_NUM_TOUCH, TOUCH_CMD_BATCHING, flags, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  return subscribe(DRIVER_NUM_TOUCH, TOUCH_SUBSCRIBE_MULTI, callback, ud);
+}
+
+int touch_multi_stop (void) {
+  int err = subscribe(DRIVER_NUM_TOUCH, TOUCH_SUBSCRIBE_MULTI, NULL, NULL);
+  if (err < TOCK_SUCCESS) return err;
+  return allow(DRIVER_NUM_TOUCH, TOUCH_ALLOW_MULTI, NULL, 0);
+}
+
+int touch_multi_ack (void) {
+  return command(DRIVER_NUM_TOUCH, TOUCH_CMD_ACK, 0, 0);
+}
+
+void touch_multi_event (const uint8_t* buffer, int index, touch_event_t* event) {
+  const uint8_t* record = buffer + index * TOUCH_EVENT_SIZE;
+  event->id       = record[0];
+  event->status   = record[1];
+  event->x        = (record[2] << 8) | record[3];
+  event->y        = (record[4] << 8) | record[5];
+  event->size     = record[6];
+  event->pressure = record[7];
+}
+
+// ***** Touch state tracking *****
+
+typedef struct {
+  touch_event_t event;
+  // The touch has been returned by a read at least once.
+  bool reported;
+  // The touch was released before it was ever read; the release is
+  // reported by the read after the one that reports the press.
+  bool release_pending;
+} track_slot_t;
+
+static struct {
+  bool multi;
+  bool unacked;
+  bool changed;
+  uint32_t dropped;
+  int num;
+  track_slot_t slots[TOUCH_TRACK_MAX];
+} track;
+
+static uint8_t track_buffer[TOUCH_BUFFER_LEN(TOUCH_BATCH_MAX)];
+
+static void track_event (const touch_event_t* event) {
+  track_slot_t* slot = NULL;
+  for (int i = 0; i < track.num; i++) {
+    if (track.slots[i].event.id == event->id) {
+      slot = &track.slots[i];
+      break;
+    }
+  }
+
+  if (slot == NULL) {
+    if (event->status == TOUCH_STATUS_RELEASED || event->status == TOUCH_STATUS_UNSTARTED) {
+      return;
+    }
+    if (track.num == TOUCH_TRACK_MAX) {
+      track.dropped++;
+      return;
+    }
+    slot = &track.slots[track.num++];
+    slot->reported        = false;
+    slot->release_pending = false;
+  } else if (event->status == TOUCH_STATUS_RELEASED && !slot->reported) {
+    slot->release_pending = true;
+    track.changed         = true;
+    return;
+  } else if (event->status == TOUCH_STATUS_PRESSED) {
+    // A new touch reusing the id of one that has ended.
+    slot->reported        = false;
+    slot->release_pending = false;
+  }
+
+  slot->event   = *event;
+  track.changed = true;
+}
+
+static void track_single_cb (int status, int xy, int pressure_size,
+                             __attribute__ ((unused)) void* ud) {
+  touch_event_t event;
+  touch_single_decode(status, xy, pressure_size, &event);
+  track_event(&event);
+}
+
+static void track_multi_cb (int num, int dropped, int overflow,
+                            __attribute__ ((unused)) void* ud) {
+  for (int i = 0; i < num; i++) {
+    touch_event_t event;
+    touch_multi_event(track_buffer, i, &event);
+    track_event(&event);
+  }
+  track.dropped += dropped + overflow;
+  track.unacked  = true;
+}
+
+int touch_track_start (int flags) {
+  memset(&track, 0, sizeof(track));
+
+  int err = touch_multi_start(track_buffer, sizeof(track_buffer), flags, track_multi_cb, NULL);
+  if (err == TOCK_SUCCESS) {
+    track.multi = true;
+    return TOCK_SUCCESS;
+  }
+  if (err != TOCK_ENOSUPPORT) return err;
+
+  return touch_single_set_callback(track_single_cb, NULL);
+}
+
+int touch_track_stop (void) {
+  if (track.multi) {
+    track.multi = false;
+    return touch_multi_stop();
+  }
+  return touch_single_set_callback(NULL, NULL);
+}
+
+bool touch_track_read (touch_state_t* state) {
+  bool changed = track.changed;
+
+  state->num_touches = track.num;
+  state->dropped     = track.dropped;
+  state->more        = false;
+  for (int i = 0; i < track.num; i++) {
+    state->touches[i] = track.slots[i].event;
+  }
+
+  // Forget touches that were reported as released and queue the releases
+  // that arrived before their press was read.
+  int kept = 0;
+  for (int i = 0; i < track.num; i++) {
+    track_slot_t slot = track.slots[i];
+    if (slot.event.status == TOUCH_STATUS_RELEASED) continue;
+    slot.reported = true;
+    if (slot.release_pending) {
+      slot.event.status    = TOUCH_STATUS_RELEASED;
+      slot.release_pending = false;
+      state->more = true;
+    }
+    track.slots[kept++] = slot;
+  }
+  track.num     = kept;
+  track.changed = state->more;
+
+  if (track.unacked) {
+    track.unacked = false;
+    touch_multi_ack();
+  }
+  return changed;
+}
@@ -0,0 +1,150 @@
+// Touch panel API
+
+#pragma once
+
+#include "tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRIVER_NUM_TOUCH 0x90002
+
+#define TOUCH_STATUS_RELEASED 0
+#define TOUCH_STATUS_PRESSED 1
+#define TOUCH_STATUS_MOVED 2
+#define TOUCH_STATUS_UNSTARTED 3
+
+#define TOUCH_GESTURE_SWIPE_UP 1
+#define TOUCH_GESTURE_SWIPE_DOWN 2
+#define TOUCH_GESTURE_SWIPE_LEFT 3
+#define TOUCH_GESTURE_SWIPE_RIGHT 4
+#define TOUCH_GESTURE_ZOOM_IN 5
+#define TOUCH_GESTURE_ZOOM_OUT 6
+
+// Multi touch events are reported in batches written to an app buffer, one
+// TOUCH_EVENT_SIZE record per touch event.
+#define TOUCH_EVENT_SIZE 8
+#define TOUCH_BUFFER_LEN(events) ((events) * TOUCH_EVENT_SIZE)
+
+// Batching flags for touch_multi_start / touch_track_start.
+//
+// TOUCH_BATCH_HOLD: the kernel sends no further batch until the previous one
+// is acknowledged with touch_multi_ack; events that arrive in between are
+// queued (up to TOUCH_BATCH_MAX) and delivered together.
+// TOUCH_BATCH_COALESCE: while queued, a move of a touch replaces the previous
+// move of the same touch. Presses and releases are always kept.
+#define TOUCH_BATCH_HOLD 1
+#define TOUCH_BATCH_COALESCE 2
+
+// Events the kernel queues per app while a batch is unacknowledged.
+#define TOUCH_BATCH_MAX 8
+
+// Touches followed by the tracker.
+#define TOUCH_TRACK_MAX 5
+
+typedef struct {
+  uint8_t id;
+  uint8_t status;
+  uint16_t x;
+  uint16_t y;
+  uint8_t size;
+  uint8_t pressure;
+} touch_event_t;
+
+/* touch_exists
+ *  returns true if the board has a touch panel.
+ */
+bool touch_exists (void);
+
+/* touch_get_number_of_touches
+ *  Number of simultaneous touches the panel reports.
+ */
+int touch_get_number_of_touches (int* touches);
+
+// ***** Single touch *****
+
+/* touch_single_set_callback
+ *  Calls `callback` whenever the (first) touch changes. Decode the callback
+ *  arguments with touch_single_decode. Pass NULL to stop.
+ */
+int touch_single_set_callback (subscribe_cb callback, void* ud);
+
+/* touch_single_decode
+ *  Fills `event` from the arguments of a single touch callback.
+ */
+void touch_single_decode (int status, int xy, int pressure_size, touch_event_t* event);
+
+/* touch_gesture_set_callback
+ *  Calls `callback` with a TOUCH_GESTURE_* id as the first argument.
+ */
+int touch_gesture_set_callback (subscribe_cb callback, void* ud);
+
+// ***** Multi touch batches *****
+
+/* touch_multi_start
+ *  Starts delivering multi touch events into `buffer`. `callback` is called
+ *  once per batch with (events in buffer, events dropped by the kernel,
+ *  events that did not fit in the buffer). The events stay valid until the
+ *  batch is acknowledged with touch_multi_ack when TOUCH_BATCH_HOLD is set,
+ *  or until the next callback otherwise.
+ */
+int touch_multi_start (uint8_t* buffer, size_t len, int flags, subscribe_cb callback, void* ud);
+
+/* touch_multi_stop
+ *  Stops multi touch delivery and releases the buffer.
+ */
+int touch_multi_stop (void);
+
+/* touch_multi_ack
+ *  Acknowledges the current batch. Events queued since then are delivered
+ *  as the next batch.
+ */
+int touch_multi_ack (void);
+
+/* touch_multi_event
+ *  Decodes event `index` of a batch in `buffer`.
+ */
+void touch_multi_event (const uint8_t* buffer, int index, touch_event_t* event);
+
+// ***** Touch state tracking *****
+//
+// The tracker keeps the latest position of every active touch so an app can
+// sample it whenever it is ready (e.g. once per frame) without blocking or
+// handling each event. It uses multi touch batches when the board supports
+// them, and single touch callbacks otherwise. Each touch_track_read
+// acknowledges the batch it consumed, so with TOUCH_BATCH_HOLD and
+// TOUCH_BATCH_COALESCE the kernel sends at most one batch per read.
+
+typedef struct {
+  // Touches in `touches`. A touch reported with TOUCH_STATUS_RELEASED has
+  // ended and is dropped by the next read.
+  int num_touches;
+  touch_event_t touches[TOUCH_TRACK_MAX];
+  // Another state is already queued (e.g. a press and its release arrived in
+  // the same batch); read again to get it.
+  bool more;
+  // Events lost since tracking started.
+  uint32_t dropped;
+} touch_state_t;
+
+/* touch_track_start
+ *  Starts tracking touches with the given TOUCH_BATCH_* flags (ignored on
+ *  single touch panels).
+ */
+int touch_track_start (int flags);
+
+/* touch_track_stop
+ *  Stops tracking touches.
+ */
+int touch_track_stop (void);
+
+/* touch_track_read
+ *  Copies the current touch state to `state`. Never blocks.
+ *  returns true if the state changed since the previous read.
+ */
+bool touch_track_read (touch_state_t* state);
+
+#ifdef __cplusplus
+}
+#endif
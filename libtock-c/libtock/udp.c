@@ -58,17 +58,14 @@ int udp_close(__attribute__ ((unused)) sock_handle_t *handle) {
   return err;
 }
 
-static int tx_result;
-static void tx_done_callback(int result,
-                             __attribute__ ((unused)) int arg2,
-                             __attribute__ ((unused)) int arg3,
-                             void *ud) {
-  tx_result      = result;
-  *((bool *) ud) = true;
-}
-
 ssize_t udp_send_to(void *buf, size_t len,
                     sock_addr_t *dst_addr) {
+  // Refuse a nested send before touching the destination or buffer of the
+  // send it is nested in.
+  tock_completion_t tx_done;
+  int err = tock_completion_subscribe(&tx_done, UDP_DRIVER, SUBSCRIBE_TX);
+  if (err < 0) return err;
+
   // Set dest addr
   // NOTE: bind() must be called previously for this to work
   // If bind() has not been called, command(COMMAND_SEND) will return ??
@@ -76,18 +73,12 @@ ssize_t udp_send_to(void *buf, size_t len,
   memcpy(BUF_TX_CFG + bytes, dst_addr, bytes);
 
   // Set message buffer
-  int err = allow(UDP_DRIVER, ALLOW_TX, buf, len);
-  if (err < 0) return err;
-
-  bool tx_done = false;
-  err = subscribe(UDP_DRIVER, SUBSCRIBE_TX, tx_done_callback, (void *) &tx_done);
-  if (err < 0) return err;
+  err = allow(UDP_DRIVER, ALLOW_TX, buf, len);
+  if (err >= 0) err = command(UDP_DRIVER, COMMAND_SEND, 0, 0);
 
-  err = command(UDP_DRIVER, COMMAND_SEND, 0, 0);
-  if (err < 0) return err;
-  // err == 1 indicates packet succesfully passed to radio synchronously.
+  // COMMAND_SEND returning 1 indicates packet succesfully passed to radio synchronously.
   // However, wait for send_done to see if tx was successful, then return that result
-  // err == 0 indicates packet will be sent asynchronously. Thus, 2 callbacks will be received.
+  // COMMAND_SEND returning 0 indicates packet will be sent asynchronously. Thus, 2 callbacks will be received.
   // the first callback will indicate if the packet was ultimately passed to the radio succesfully.
   // The second callback will only occur if the first callback is SUCCESS - and the second callback
   // in this case is the result of the tx itself (as reported by the radio).
@@ -95,29 +86,21 @@ ssize_t udp_send_to(void *buf, size_t len,
   // is received before the first callback finishes. Thus, no need to wait for two callbacks in either
   // case -- this design just ensures that errors in passing the packet down to the radio will still
   // be returned to the sender even when transmission occurs asynchronously.
-  yield_for(&tx_done);
-  return tx_result;
-}
-
-static int rx_result;
-static void rx_done_callback(int result,
-                             __attribute__ ((unused)) int arg2,
-                             __attribute__ ((unused)) int arg3,
-                             void *ud) {
-  rx_result      = result;
-  *((bool *) ud) = true;
+  err = tock_completion_wait(&tx_done, err);
+  if (err < 0) return err;
+  return tx_done.arg0;
 }
 
 ssize_t udp_recv_sync(void *buf, size_t len) {
-  int err = allow(UDP_DRIVER, ALLOW_RX, (void *) buf, len);
+  tock_completion_t rx_done;
+  int err = tock_completion_subscribe(&rx_done, UDP_DRIVER, SUBSCRIBE_RX);
   if (err < 0) return err;
 
-  bool rx_done = false;
-  err = subscribe(UDP_DRIVER, SUBSCRIBE_RX, rx_done_callback, (void *) &rx_done);
+  // Nothing to start: the callback comes with the next packet.
+  err = allow(UDP_DRIVER, ALLOW_RX, (void *) buf, len);
+  err = tock_completion_wait(&rx_done, err);
   if (err < 0) return err;
-
-  yield_for(&rx_done);
-  return rx_result;
+  return rx_done.arg0;
 }
 
 ssize_t udp_recv(subscribe_cb callback, void *buf, size_t len) {
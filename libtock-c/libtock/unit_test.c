@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include <ipc.h>
+#include <ring.h>
 #include <timer.h>
 #include <unit_test.h>
 
@@ -90,53 +91,25 @@ struct unit_test_t {
 
   // The reason a test has failed;
   char reason[72];
-
-  // Interior linked list element, points to the next test runner in the
-  // queue.
-  unit_test_t *next;
 };
 
 /**
- * Linked list header for basic interior linked list operations on the
- * unit_test_t struct. Only needed for optimizing the append operation.
- */
-typedef struct linked_list {
-  unit_test_t *head;
-  unit_test_t *tail;
-} linked_list_t;
-
-/**
- * Append a new unit_test_t to the linked list.
- */
-static void list_append(linked_list_t *list, unit_test_t *test) {
-  if (list->tail) {
-    list->tail->next = test;
-  } else {
-    list->head = test;
-  }
-
-  test->next = NULL;
-  list->tail = test;
-}
-
-/**
- * Remove a unit_test_t from the front of the linked list.
+ * Returns the test runner at the front of the queue, or NULL if it is empty.
  */
-static void list_pop(linked_list_t *list) {
-  if (!list->head) return;
-
-  list->head = list->head->next;
-
-  if (!list->head) list->tail = NULL;
+static unit_test_t *queue_front(ring_t *queue) {
+  void *slot;
+  if (ring_peek(queue, 0, &slot) == 0) return NULL;
+  return *(unit_test_t **)slot;
 }
 
 /**
- * Returns true if the linked list contains the given unit_test_t.
+ * Returns true if the queue contains the given unit_test_t.
  */
-static bool list_contains(linked_list_t *list, unit_test_t *test) {
-  unit_test_t *curr = list->head;
-  while (curr) {
-    if (curr == test) return true;
+static bool queue_contains(ring_t *queue, unit_test_t *test) {
+  for (size_t i = 0; i < ring_count(queue); i++) {
+    void *slot;
+    ring_peek(queue, i, &slot);
+    if (*(unit_test_t **)slot == test) return true;
   }
   return false;
 }
@@ -160,9 +133,11 @@ static char test_buf[TEST_BUF_SZ] __attribute__((aligned(TEST_BUF_SZ)));
 static bool done = false;
 
 /**
- * Test supervisor's linked list of pending test runners.
+ * Test supervisor's queue of pending test runners.
  */
-static linked_list_t pending_pids;
+#define MAX_PENDING_RUNNERS 8
+static unit_test_t *pending_slots[MAX_PENDING_RUNNERS];
+static ring_t pending_pids;
 
 
 /*******************************************************************************
@@ -348,8 +323,8 @@ static void unit_test_service_cb(int pid,
     return;
   }
 
-  unit_test_t *test      = (unit_test_t *)buf;
-  linked_list_t *pending = (linked_list_t *)ud;
+  unit_test_t *test = (unit_test_t *)buf;
+  ring_t *pending    = (ring_t *)ud;
 
   switch (test->cmd) {
     case TestInit:
@@ -357,12 +332,13 @@ static void unit_test_service_cb(int pid,
       test->pid = pid;
 
       // Queue the test
-      if (!list_contains(pending, test)) {
-        list_append(pending, test);
+      if (!queue_contains(pending, test) && !ring_push(pending, &test)) {
+        printf("Too many test runners, %d not run\n", pid);
+        break;
       }
 
       // If there is no other test in progress, start this test.
-      if (pending->head->pid == pid) {
+      if (queue_front(pending)->pid == pid) {
         ipc_notify_client(pid);
       }
       break;
@@ -400,12 +376,12 @@ static void unit_test_service_cb(int pid,
 
       // Remove the completed test runner from the queue and allow it to
       // exit.
-      list_pop(pending);
+      ring_release(pending, 1);
       ipc_notify_client(test->pid);
 
       // Continue with the next enqueued test runner, if there is one.
-      if (pending->head) {
-        ipc_notify_client(pending->head->pid);
+      if (queue_front(pending)) {
+        ipc_notify_client(queue_front(pending)->pid);
       }
       break;
     default:
@@ -418,7 +394,6 @@ static void unit_test_service_cb(int pid,
  * Sets up the IPC service and returns.
  */
 void unit_test_service(void) {
-  pending_pids.head = NULL;
-  pending_pids.tail = NULL;
+  ring_init(&pending_pids, pending_slots, sizeof(unit_test_t *), MAX_PENDING_RUNNERS);
   ipc_register_svc(unit_test_service_cb, &pending_pids);
 }
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+
+# Decodes CBOR payloads produced by libtock's CBOR writer (libtock/cbor.h),
+# such as the packets sent by examples/ip_sense.
+#
+# Usage: cbor_decode.py [--hex] [INPUT]
+#
+# Reads binary CBOR from INPUT or stdin and prints each top-level item as
+# JSON on its own line. With --hex, the input is a hex dump instead (for
+# example the output of udp_rx with PRINT_STRING set to 0); whitespace is
+# ignored.
+
+import argparse
+import json
+import struct
+import sys
+
+
+class DecodeError(Exception):
+    pass
+
+
+def decode_item(data, pos):
+    if pos >= len(data):
+        raise DecodeError('truncated input')
+    initial = data[pos]
+    major = initial >> 5
+    info = initial & 0x1f
+    pos += 1
+
+    if info < 24:
+        arg = info
+    elif info <= 27:
+        size = 1 << (info - 24)
+        if pos + size > len(data):
+            raise DecodeError('truncated input')
+        if major == 7 and info >= 25:
+            fmt = {2: '>e', 4: '>f', 8: '>d'}[size]
+            return struct.unpack(fmt, data[pos:pos + size])[0], pos + size
+        arg = int.from_bytes(data[pos:pos + size], 'big')
+        pos += size
+    else:
+        raise DecodeError('unsupported additional info {}'.format(info))
+
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major in (2, 3):
+        if pos + arg > len(data):
+            raise DecodeError('truncated string')
+        raw = bytes(data[pos:pos + arg])
+        return (raw.hex() if major == 2 else raw.decode('utf-8')), pos + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, pos = decode_item(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        items = {}
+        for _ in range(arg):
+            key, pos = decode_item(data, pos)
+            value, pos = decode_item(data, pos)
+            items[str(key)] = value
+        return items, pos
+    if major == 6:
+        item, pos = decode_item(data, pos)
+        return {'tag': arg, 'value': item}, pos
+    return {20: False, 21: True, 22: None}.get(arg, 'simple({})'.format(arg)), pos
+
+
+def decode_all(data):
+    pos = 0
+    items = []
+    while pos < len(data):
+        item, pos = decode_item(data, pos)
+        items.append(item)
+    return items
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode libtock CBOR payloads.')
+    parser.add_argument('--hex', action='store_true', help='input is a hex dump')
+    parser.add_argument('input', nargs='?')
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    if args.hex:
+        data = bytes.fromhex(''.join(data.decode('ascii').split()))
+
+    try:
+        for item in decode_all(data):
+            print(json.dumps(item))
+    except DecodeError as e:
+        print('error: {}'.format(e), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
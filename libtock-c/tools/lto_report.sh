@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+
+# Compare app sizes with and without link-time optimization (TOCK_LTO=1).
+#
+# Usage: tools/lto_report.sh [app_dir ...]
+#
+# With no arguments a few representative examples are measured. Only the
+# architecture in $ARCH (default cortex-m7) is built to keep this quick. For
+# run-time comparisons, flash the `build` and `build-lto` binaries of apps that
+# time themselves (e.g. examples/tests/memfuncs).
+
+set -e
+set -u
+set -o pipefail
+
+ARCH=${ARCH:-cortex-m7}
+NUM_JOBS=$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || 4)
+
+BASE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+
+if [ $# -eq 0 ]; then
+	set -- \
+		"$BASE_DIR/examples/blink" \
+		"$BASE_DIR/examples/c_hello" \
+		"$BASE_DIR/examples/sensors" \
+		"$BASE_DIR/examples/tests/memfuncs" \
+		"$BASE_DIR/examples/lua-hello"
+fi
+
+# Print "text data bss" for an ELF.
+function elf_size {
+	arm-none-eabi-size "$1" | awk 'NR == 2 { print $1, $2, $3 }'
+}
+
+printf "%-24s %18s %18s %8s\n" "app" "text/data/bss" "lto text/data/bss" "text %"
+for dir in "$@"; do
+	name=$(basename "$dir")
+	make -C "$dir" -j "$NUM_JOBS" TOCK_TARGETS="$ARCH" > /dev/null
+	make -C "$dir" -j "$NUM_JOBS" TOCK_TARGETS="$ARCH" TOCK_LTO=1 > /dev/null
+
+	read -r text data bss <<< "$(elf_size "$dir/build/$ARCH/$ARCH.elf")"
+	read -r lto_text lto_data lto_bss <<< "$(elf_size "$dir/build-lto/$ARCH/$ARCH.elf")"
+	delta=$(( (lto_text - text) * 100 / text ))
+
+	printf "%-24s %18s %18s %7d%%\n" "$name" \
+		"$text/$data/$bss" "$lto_text/$lto_data/$lto_bss" "$delta"
+done
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+# Decodes streams produced by libtock's LZSS encoder (libtock/lzss.h).
+#
+# Usage: lzss_decode.py [-w WINDOW_BITS] [-l LOOKAHEAD_BITS] [INPUT [OUTPUT]]
+#
+# Reads from stdin and writes to stdout when no files are given. The window
+# and lookahead sizes must match the values the app was built with.
+
+import argparse
+import sys
+
+MIN_MATCH = 2
+
+
+def decode(data, window_bits=8, lookahead_bits=4):
+    out = bytearray()
+    bits = 0
+    nbits = 0
+    pos = 0
+
+    def take(count):
+        nonlocal bits, nbits, pos
+        while nbits < count:
+            if pos == len(data):
+                return None
+            bits = (bits << 8) | data[pos]
+            nbits += 8
+            pos += 1
+        nbits -= count
+        value = (bits >> nbits) & ((1 << count) - 1)
+        bits &= (1 << nbits) - 1
+        return value
+
+    while True:
+        flag = take(1)
+        if flag is None:
+            break
+        if flag:
+            literal = take(8)
+            if literal is None:
+                break
+            out.append(literal)
+        else:
+            dist = take(window_bits)
+            length = take(lookahead_bits)
+            if dist is None or length is None:
+                break
+            dist += 1
+            for _ in range(length + MIN_MATCH):
+                # Back-references before the start of the stream read the
+                # decoder's zero-initialized window.
+                out.append(out[-dist] if dist <= len(out) else 0)
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a libtock LZSS stream.')
+    parser.add_argument('-w', '--window-bits', type=int, default=8)
+    parser.add_argument('-l', '--lookahead-bits', type=int, default=4)
+    parser.add_argument('input', nargs='?')
+    parser.add_argument('output', nargs='?')
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    result = decode(data, args.window_bits, args.lookahead_bits)
+
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(result)
+    else:
+        sys.stdout.buffer.write(result)
+
+
+if __name__ == '__main__':
+    main()
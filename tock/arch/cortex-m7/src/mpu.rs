@@ -160,6 +160,14 @@ pub struct CortexMConfig {
 
 const APP_MEMORY_REGION_NUM: usize = 0;
 
+/// Number of region sizes to try when placing process memory, starting with
+/// the smallest that fits it.
+const APP_MEMORY_REGION_SIZES: usize = 4;
+
+fn div_round_up(value: usize, divisor: usize) -> usize {
+    (value + divisor - 1) / divisor
+}
+
 impl Default for CortexMConfig {
     fn default() -> CortexMConfig {
         CortexMConfig {
@@ -216,7 +224,8 @@ impl fmt::Display for CortexMConfig {
                     access_bits,
                 )?;
                 let subregion_bits = region.attributes().read(RegionAttributes::SRD);
-                let subregion_size = location.1 / 8;
+                let (start, region_size) = region.region_location();
+                let subregion_size = region_size / 8;
                 for j in 0..8 {
                     write!(
                         f,
@@ -339,6 +348,14 @@ impl CortexMRegion {
         self.location
     }
 
+    /// Start and size of the underlying MPU region, which may be larger than
+    /// the logical region if some subregions are disabled.
+    fn region_location(&self) -> (usize, usize) {
+        let start = (self.base_address.read(RegionBaseAddress::ADDR) << 5) as usize;
+        let size = 1 << (self.attributes.read(RegionAttributes::SIZE) + 1);
+        (start, size)
+    }
+
     fn base_address(&self) -> FieldValue<u32, RegionBaseAddress::Register> {
         self.base_address
     }
@@ -543,88 +560,92 @@ impl kernel::mpu::MPU for MPU {
             initial_app_memory_size + initial_kernel_memory_size,
         );
 
-        // Size must be a power of two, so: https://www.youtube.com/watch?v=ovo6zwv6DX4
-        let mut region_size = math::closest_power_of_two(memory_size as u32) as usize;
-        let exponent = math::log_base_two(region_size as u32);
-
-        if exponent < 8 {
-            // Region sizes must be 256 Bytes or larger in order to support subregions
-            region_size = 256;
-        } else if exponent > 32 {
-            // Region sizes must be 4GB or smaller
-            return None;
-        }
+        let unallocated_start = unallocated_memory_start as usize;
+        let unallocated_end = unallocated_start + unallocated_memory_size;
+
+        // We cover app-owned memory with a single MPU region and enable its
+        // subregions from the start of the process memory block up to the app
+        // break. As the app break later increases, we will be able to linearly
+        // grow the logical region covering app-owned memory by enabling more
+        // and more subregions. The Cortex-M MPU supports 8 subregions, so the
+        // block only has to start on a subregion boundary and end within the
+        // region: neither its start nor its size need to be aligned to the
+        // (power of two) region size, which would leave up to a whole region
+        // of RAM unused before and after every process.
+        //
+        // Larger regions have coarser subregions but fit the block in more
+        // places, so we try a few region sizes and keep the placement that
+        // ends first, leaving the most memory for the processes after it.
+        // Region sizes must be 256 Bytes or larger in order to support subregions.
+        let mut region_size =
+            cmp::max(256, math::closest_power_of_two(memory_size as u32) as usize);
+        let mut placement: Option<(usize, usize, usize)> = None;
+        for _ in 0..APP_MEMORY_REGION_SIZES {
+            let subregion_size = region_size / 8;
+
+            // App-owned memory is covered by whole subregions, which must not
+            // reach into kernel-owned memory at the end of the block.
+            let app_memory_size =
+                cmp::max(1, div_round_up(initial_app_memory_size, subregion_size)) * subregion_size;
+            let block_size = div_round_up(
+                cmp::max(memory_size, app_memory_size + initial_kernel_memory_size),
+                subregion_size,
+            ) * subregion_size;
+
+            if block_size <= region_size {
+                let mut block_start =
+                    div_round_up(unallocated_start, subregion_size) * subregion_size;
+                // If the block would run past the end of the region, move it to
+                // the start of the next one.
+                if block_start % region_size + block_size > region_size {
+                    block_start = div_round_up(block_start, region_size) * region_size;
+                }
 
-        // The region should start as close as possible to the start of the unallocated memory.
-        let mut region_start = unallocated_memory_start as usize;
+                let block_end = block_start + block_size;
+                let ends_first =
+                    placement.map_or(true, |(start, size, _)| block_end < start + size);
+                if block_end <= unallocated_end && ends_first {
+                    placement = Some((block_start, block_size, region_size));
+                }
+            }
 
-        // If the start and length don't align, move region up until it does
-        if region_start % region_size != 0 {
-            region_start += region_size - (region_start % region_size);
+            // Region sizes must be 2GB or smaller (we can't address 4GB here).
+            if region_size >= 1 << 31 {
+                break;
+            }
+            region_size *= 2;
         }
 
-        // We allocate an MPU region exactly over the process memory block, and we disable
-        // subregions at the end of this region to disallow access to the memory past the app
-        // break. As the app break later increases, we will be able to linearly grow
-        // the logical region covering app-owned memory by enabling more and more subregions.
-        // The Cortex-M MPU supports 8 subregions, so the size of this logical region is always a
-        // multiple of an eighth of the MPU region length.
+        // Make sure the block fits in the unallocated memory.
+        let (block_start, block_size, region_size) = placement?;
+
+        let subregion_size = region_size / 8;
+        let region_start = block_start - block_start % region_size;
+        let min_subregion = (block_start - region_start) / subregion_size;
 
         // Determine the number of subregions to enable.
-        let mut num_subregions_used = {
+        let num_subregions_used = {
             if initial_kernel_memory_size == 0 {
-                8
+                block_size / subregion_size
             } else {
-                initial_app_memory_size * 8 / region_size + 1
+                cmp::max(1, div_round_up(initial_app_memory_size, subregion_size))
             }
         };
 
-        let subregion_size = region_size / 8;
-
-        // Calculates the end address of the enabled subregions and the initial kernel memory break.
-        let subregions_end = region_start + num_subregions_used * subregion_size;
-        let kernel_memory_break = region_start + region_size - initial_kernel_memory_size;
-
-        // If the last subregion covering app-owned memory overlaps the start of kernel-owned
-        // memory, we make the entire process memory block twice as big so there is plenty of space
-        // between app-owned and kernel-owned memory.
-        if subregions_end > kernel_memory_break {
-            region_size *= 2;
-
-            if region_start % region_size != 0 {
-                region_start += region_size - (region_start % region_size);
-            }
-
-            num_subregions_used = {
-                if initial_kernel_memory_size == 0 {
-                    8
-                } else {
-                    initial_app_memory_size * 8 / region_size + 1
-                }
-            };
-        }
-
-        // Make sure the region fits in the unallocated memory.
-        if region_start + region_size
-            > (unallocated_memory_start as usize) + unallocated_memory_size
-        {
-            return None;
-        }
-
         let region = CortexMRegion::new(
-            region_start as *const u8,
-            region_size,
+            block_start as *const u8,
+            block_size,
             region_start as *const u8,
             region_size,
             APP_MEMORY_REGION_NUM,
-            Some((0, num_subregions_used - 1)),
+            Some((min_subregion, min_subregion + num_subregions_used - 1)),
             permissions,
         );
 
         config.regions[APP_MEMORY_REGION_NUM] = region;
         config.is_dirty.set(true);
 
-        Some((region_start as *const u8, region_size))
+        Some((block_start as *const u8, block_size))
     }
 
     fn update_app_memory_region(
@@ -634,13 +655,15 @@ impl kernel::mpu::MPU for MPU {
         permissions: mpu::Permissions,
         config: &mut Self::MpuConfig,
     ) -> Result<(), ()> {
-        let (region_start, region_size) = match config.regions[APP_MEMORY_REGION_NUM].location() {
+        let app_region = config.regions[APP_MEMORY_REGION_NUM];
+        let (block_start, block_size) = match app_region.location() {
             Some((start, size)) => (start as usize, size),
             None => {
                 // Error: Process tried to update app memory MPU region before it was created.
                 return Err(());
             }
         };
+        let (region_start, region_size) = app_region.region_location();
 
         let app_memory_break = app_memory_break as usize;
         let kernel_memory_break = kernel_memory_break as usize;
@@ -650,20 +673,22 @@ impl kernel::mpu::MPU for MPU {
             return Err(());
         }
 
-        let app_memory_size = app_memory_break - region_start;
-        let kernel_memory_size = region_start + region_size - kernel_memory_break;
+        let app_memory_size = app_memory_break - block_start;
+        let kernel_memory_size = block_start + block_size - kernel_memory_break;
+
+        let subregion_size = region_size / 8;
+        let min_subregion = (block_start - region_start) / subregion_size;
 
         // Determine the number of subregions to enable.
         let num_subregions_used = {
             if kernel_memory_size == 0 {
-                8
+                block_size / subregion_size
             } else {
-                app_memory_size * 8 / region_size + 1
+                cmp::max(1, div_round_up(app_memory_size, subregion_size))
             }
         };
 
-        let subregion_size = region_size / 8;
-        let subregions_end = region_start + subregion_size * num_subregions_used;
+        let subregions_end = block_start + subregion_size * num_subregions_used;
 
         // If we can no longer cover app memory with an MPU region without overlapping kernel
         // memory, we fail.
@@ -672,12 +697,12 @@ impl kernel::mpu::MPU for MPU {
         }
 
         let region = CortexMRegion::new(
-            region_start as *const u8,
-            region_size,
+            block_start as *const u8,
+            block_size,
             region_start as *const u8,
             region_size,
             APP_MEMORY_REGION_NUM,
-            Some((0, num_subregions_used - 1)),
+            Some((min_subregion, min_subregion + num_subregions_used - 1)),
             permissions,
         );
 
@@ -15,6 +15,17 @@
 //!                                      deferred_caller).finalize(());
 //! let console = ConsoleComponent::new(board_kernel, uart_mux).finalize(());
 //! ```
+//!
+//! Boards that print a lot can give the console a larger transmit buffer, so
+//! long writes go out in fewer UART transactions:
+//!
+//! ```rust
+//! static mut CONSOLE_WRITE_BUF: [u8; 512] = [0; 512];
+//!
+//! let console = ConsoleComponent::new(board_kernel, uart_mux)
+//!     .with_write_buffer(&mut CONSOLE_WRITE_BUF)
+//!     .finalize(());
+//! ```
 // Author: Philip Levis <pal@cs.stanford.edu>
 // Last modified: 1/08/2020
 
@@ -79,6 +90,7 @@ impl Component for UartMuxComponent {
 pub struct ConsoleComponent {
     board_kernel: &'static kernel::Kernel,
     uart_mux: &'static MuxUart<'static>,
+    write_buffer: Option<&'static mut [u8]>,
 }
 
 impl ConsoleComponent {
@@ -89,8 +101,15 @@ impl ConsoleComponent {
         ConsoleComponent {
             board_kernel: board_kernel,
             uart_mux: uart_mux,
+            write_buffer: None,
         }
     }
+
+    /// Transmit from `write_buffer` instead of `console::WRITE_BUF`.
+    pub fn with_write_buffer(mut self, write_buffer: &'static mut [u8]) -> ConsoleComponent {
+        self.write_buffer = Some(write_buffer);
+        self
+    }
 }
 
 impl Component for ConsoleComponent {
@@ -104,11 +123,15 @@ impl Component for ConsoleComponent {
         let console_uart = static_init!(UartDevice, UartDevice::new(self.uart_mux, true));
         console_uart.setup();
 
+        let write_buffer: &'static mut [u8] = match self.write_buffer {
+            Some(write_buffer) => write_buffer,
+            None => &mut console::WRITE_BUF,
+        };
         let console = static_init!(
             console::Console<'static>,
             console::Console::new(
                 console_uart,
-                &mut console::WRITE_BUF,
+                write_buffer,
                 &mut console::READ_BUF,
                 self.board_kernel.create_grant(&grant_cap)
             )
@@ -472,6 +472,8 @@ pub unsafe fn reset_handler() {
         capsules::rf233::RF233<'static, VirtualSpiMasterDevice<'static, sam4l::spi::SpiHw>>,
         sam4l::aes::Aes<'static>
     ));
+    // Timestamp received frames with the counter behind the alarm driver.
+    radio_driver.set_rx_clock(&peripherals.ast);
 
     let usb_driver = UsbComponent::new(board_kernel, &peripherals.usbc).finalize(());
 
@@ -494,6 +496,8 @@ pub unsafe fn reset_handler() {
     .finalize(components::nv_storage_component_helper!(
         sam4l::flashcalw::FLASHCALW
     ));
+    // Flash is mapped at address 0, so apps can read the region directly.
+    nonvolatile_storage.set_mapping(kernel::ReadOnlyRegion::new(0x60000, 0x20000, &grant_cap));
 
     let local_ip_ifaces = static_init!(
         [IPAddr; 3],
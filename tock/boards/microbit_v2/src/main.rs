@@ -38,6 +38,9 @@ const GPIO_P8: Pin = Pin::P0_10;
 const GPIO_P9: Pin = Pin::P0_09;
 const GPIO_P16: Pin = Pin::P1_02;
 
+// Edge connector pin P15, driven by the PWM driver.
+const PWM_P15: Pin = Pin::P0_13;
+
 const UART_TX_PIN: Pin = Pin::P0_06;
 const UART_RX_PIN: Pin = Pin::P1_08;
 
@@ -103,6 +106,10 @@ pub struct Platform {
         capsules::virtual_alarm::VirtualMuxAlarm<'static, nrf52833::rtc::Rtc<'static>>,
     >,
     app_flash: &'static capsules::app_flash_driver::AppFlash<'static>,
+    pwm: &'static capsules::pwm::Pwm<
+        'static,
+        capsules::virtual_alarm::VirtualMuxAlarm<'static, nrf52833::rtc::Rtc<'static>>,
+    >,
 }
 
 impl kernel::Platform for Platform {
@@ -124,6 +131,7 @@ impl kernel::Platform for Platform {
             capsules::ble_advertising_driver::DRIVER_NUM => f(Some(self.ble_radio)),
             capsules::buzzer_driver::DRIVER_NUM => f(Some(self.buzzer)),
             capsules::app_flash_driver::DRIVER_NUM => f(Some(self.app_flash)),
+            capsules::pwm::DRIVER_NUM => f(Some(self.pwm)),
             kernel::ipc::DRIVER_NUM => f(Some(&self.ipc)),
             _ => f(None),
         }
@@ -279,6 +287,38 @@ pub unsafe fn reset_handler() {
     );
     virtual_alarm_buzzer.set_alarm_client(buzzer);
 
+    // PWM channel 0 is edge connector pin P15. It shares PWM0 with the
+    // buzzer, so a channel and a tone do not run at the same time.
+    let virtual_pwm_p15 = static_init!(
+        capsules::virtual_pwm::PwmPinUser<'static, nrf52833::pwm::Pwm>,
+        capsules::virtual_pwm::PwmPinUser::new(
+            mux_pwm,
+            nrf52833::pinmux::Pinmux::new(PWM_P15 as u32)
+        )
+    );
+    virtual_pwm_p15.add_to_mux();
+
+    let pwm_pins = static_init!(
+        [&'static dyn kernel::hil::pwm::PwmPin; 1],
+        [virtual_pwm_p15]
+    );
+    let virtual_alarm_pwm = static_init!(
+        capsules::virtual_alarm::VirtualMuxAlarm<'static, nrf52833::rtc::Rtc>,
+        capsules::virtual_alarm::VirtualMuxAlarm::new(mux_alarm)
+    );
+    let pwm = static_init!(
+        capsules::pwm::Pwm<
+            'static,
+            capsules::virtual_alarm::VirtualMuxAlarm<'static, nrf52833::rtc::Rtc>,
+        >,
+        capsules::pwm::Pwm::new(
+            pwm_pins,
+            virtual_alarm_pwm,
+            board_kernel.create_grant(&memory_allocation_capability)
+        )
+    );
+    virtual_alarm_pwm.set_alarm_client(pwm);
+
     //--------------------------------------------------------------------------
     // UART & CONSOLE & DEBUG
     //--------------------------------------------------------------------------
@@ -447,6 +487,7 @@ pub unsafe fn reset_handler() {
         adc: adc_syscall,
         alarm: alarm,
         app_flash: app_flash,
+        pwm: pwm,
         ipc: kernel::ipc::IPC::new(board_kernel, &memory_allocation_capability),
     };
 
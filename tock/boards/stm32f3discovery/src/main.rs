@@ -703,6 +703,13 @@ pub unsafe fn reset_handler() {
     .finalize(components::nv_storage_component_helper!(
         stm32f303xc::flash::Flash
     ));
+    // Flash addresses are memory addresses, so apps can read the region
+    // directly.
+    nonvolatile_storage.set_mapping(kernel::ReadOnlyRegion::new(
+        0x08038000,
+        0x8000,
+        &memory_allocation_capability,
+    ));
 
     let stm32f3discovery = STM32F3Discovery {
         console: console,
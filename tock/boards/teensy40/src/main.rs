@@ -61,6 +61,10 @@ type Peripherals = imxrt1060::chip::Imxrt10xxDefaultPeripherals<GptFreq>;
 type Chip = imxrt1060::chip::Imxrt10xx<Peripherals>;
 static mut CHIP: Option<&'static Chip> = None;
 
+/// Console transmit buffer; large enough for a few lines of output per UART
+/// transaction.
+static mut CONSOLE_WRITE_BUF: [u8; 512] = [0; 512];
+
 /// Assert that a given predicate is true at compile time
 ///
 /// Failure manifests as a compile error about an incorrect
@@ -200,7 +204,13 @@ pub unsafe fn reset_handler() {
     components::debug_writer::DebugWriterComponent::new(uart_mux).finalize(());
 
     // Setup the console
-    let console = components::console::ConsoleComponent::new(board_kernel, uart_mux).finalize(());
+    let console = components::console::ConsoleComponent::new(board_kernel, uart_mux)
+        .with_write_buffer(&mut CONSOLE_WRITE_BUF)
+        .finalize(());
+    // Time how long each app's writes wait for the shared console
+    console.set_clock(&peripherals.gpt1);
+    // Let an interactive shell's lines go ahead of other apps' output
+    console.set_max_priorities(&[("shell", 1)]);
 
     // LED
     let led = components::led::LedsComponent::new(components::led_component_helper!(
@@ -0,0 +1,370 @@
+//! Provides userspace access to AES-128-CCM* authenticated encryption.
+//!
+//! Requests are made in batches so that protecting several packets costs one
+//! system call and one callback rather than one of each per packet. The
+//! packets are laid out back to back in a single allowed buffer, each as a
+//! record of:
+//!
+//! ```text
+//! [ nonce (13) | a_len (1) | m_len (1) | mic_len (1) | a_data | m_data | mic ]
+//! ```
+//!
+//! `a_data` is authenticated only, `m_data` is encrypted and authenticated,
+//! and `mic` is written on encryption and checked on decryption. Records are
+//! processed in place, one at a time, through a `VirtualAES128CCM` client so
+//! that the engine is shared with the kernel's own users (e.g. the 802.15.4
+//! stack). Each record must fit in the kernel buffer given to the driver.
+//!
+//! Usage
+//! -----
+//!
+//! ```rust
+//! # use kernel::static_init;
+//! # use kernel::hil::symmetric_encryption::{AES128CCM, AES128_BLOCK_SIZE};
+//! type AESCCMCLIENT = capsules::virtual_aes_ccm::VirtualAES128CCM<'static, AESCCMMUX>;
+//!
+//! const CRYPT_SIZE: usize = 10 * AES128_BLOCK_SIZE;
+//! let crypt_buf = static_init!([u8; CRYPT_SIZE], [0x00; CRYPT_SIZE]);
+//! let ccm_client = static_init!(
+//!     AESCCMCLIENT,
+//!     capsules::virtual_aes_ccm::VirtualAES128CCM::new(ccm_mux, crypt_buf)
+//! );
+//! ccm_client.setup();
+//! let record_buf = static_init!([u8; 160], [0; 160]);
+//! let aes_ccm = static_init!(
+//!     capsules::aes_ccm::AesCcmDriver<'static, AESCCMCLIENT>,
+//!     capsules::aes_ccm::AesCcmDriver::new(
+//!         ccm_client,
+//!         record_buf,
+//!         board_kernel.create_grant(&memory_allocation_cap)
+//!     )
+//! );
+//! ccm_client.set_client(aes_ccm);
+//! ```
+
+use core::cell::Cell;
+use kernel::common::cells::{OptionalCell, TakeCell};
+use kernel::hil::symmetric_encryption::{AES128CCM, CCMClient, AES128_KEY_SIZE, CCM_NONCE_LENGTH};
+use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
+
+/// Syscall driver number.
+use crate::driver;
+pub const DRIVER_NUM: usize = driver::NUM::AesCcm as usize;
+
+/// Length of the header at the start of each record.
+pub const RECORD_HEADER_LEN: usize = CCM_NONCE_LENGTH + 3;
+
+/// Tag failures are reported as a bitmask, which limits the batch size.
+pub const MAX_BATCH: usize = 32;
+
+#[derive(Copy, Clone)]
+struct Batch {
+    encrypting: bool,
+    count: usize,
+    index: usize,
+    // Offset of the current record in the app's buffer.
+    offset: usize,
+    // Lengths of the current record's fields, as submitted to the engine.
+    a_len: usize,
+    m_len: usize,
+    mic_len: usize,
+    // Bit `i` is set if record `i` failed to authenticate.
+    failed: u32,
+}
+
+#[derive(Default)]
+pub struct App {
+    callback: Option<Callback>,
+    key: Option<AppSlice<Shared, u8>>,
+    buffer: Option<AppSlice<Shared, u8>>,
+
+    // If Some, the app has a batch in progress.
+    batch: Option<Batch>,
+}
+
+pub struct AesCcmDriver<'a, A: AES128CCM<'a>> {
+    ccm: &'a A,
+    apps: Grant<App>,
+    serving_app: OptionalCell<AppId>,
+    record_buf: TakeCell<'static, [u8]>,
+    busy: Cell<bool>,
+}
+
+impl<'a, A: AES128CCM<'a>> AesCcmDriver<'a, A> {
+    pub fn new(
+        ccm: &'a A,
+        record_buf: &'static mut [u8],
+        apps: Grant<App>,
+    ) -> AesCcmDriver<'a, A> {
+        AesCcmDriver {
+            ccm: ccm,
+            apps: apps,
+            serving_app: OptionalCell::empty(),
+            record_buf: TakeCell::new(record_buf),
+            busy: Cell::new(false),
+        }
+    }
+
+    /// Copies the app's next record into the kernel buffer and hands it to
+    /// the engine.
+    fn start_record(&self, app: &mut App) -> ReturnCode {
+        let mut batch = match app.batch {
+            Some(batch) => batch,
+            None => return ReturnCode::EINVAL,
+        };
+        let (key, buffer) = match (app.key.as_ref(), app.buffer.as_ref()) {
+            (Some(key), Some(buffer)) => (key, buffer),
+            _ => return ReturnCode::EINVAL,
+        };
+        if key.len() < AES128_KEY_SIZE {
+            return ReturnCode::EINVAL;
+        }
+
+        let data = buffer.as_ref();
+        let offset = batch.offset;
+        if offset + RECORD_HEADER_LEN > data.len() {
+            return ReturnCode::ESIZE;
+        }
+        let header = &data[offset..offset + RECORD_HEADER_LEN];
+        let a_len = header[CCM_NONCE_LENGTH] as usize;
+        let m_len = header[CCM_NONCE_LENGTH + 1] as usize;
+        let mic_len = header[CCM_NONCE_LENGTH + 2] as usize;
+        let body = offset + RECORD_HEADER_LEN;
+        let total = a_len + m_len + mic_len;
+        if body + total > data.len() {
+            return ReturnCode::ESIZE;
+        }
+        // CCM* allows an empty MIC, but this interface always authenticates.
+        match mic_len {
+            4 | 8 | 16 => {}
+            _ => return ReturnCode::EINVAL,
+        }
+
+        let record_buf = match self.record_buf.take() {
+            Some(buf) => buf,
+            None => return ReturnCode::EBUSY,
+        };
+        if total > record_buf.len() {
+            self.record_buf.replace(record_buf);
+            return ReturnCode::ESIZE;
+        }
+        record_buf[..total].copy_from_slice(&data[body..body + total]);
+
+        let mut res = self.ccm.set_key(&key.as_ref()[..AES128_KEY_SIZE]);
+        if res == ReturnCode::SUCCESS {
+            res = self.ccm.set_nonce(&header[..CCM_NONCE_LENGTH]);
+        }
+        if res != ReturnCode::SUCCESS {
+            self.record_buf.replace(record_buf);
+            return res;
+        }
+
+        let (res, unused) =
+            self.ccm
+                .crypt(record_buf, 0, a_len, m_len, mic_len, true, batch.encrypting);
+        if let Some(buf) = unused {
+            self.record_buf.replace(buf);
+        }
+        if res == ReturnCode::SUCCESS {
+            batch.a_len = a_len;
+            batch.m_len = m_len;
+            batch.mic_len = mic_len;
+            app.batch = Some(batch);
+        }
+        res
+    }
+
+    /// Ends the app's batch and reports how far it got.
+    fn finish_batch(&self, app: &mut App, res: ReturnCode) {
+        if let Some(batch) = app.batch.take() {
+            if let Some(mut callback) = app.callback {
+                callback.schedule(From::from(res), batch.index, batch.failed as usize);
+            }
+        }
+    }
+
+    fn serve_waiting_apps(&self) {
+        if self.busy.get() {
+            // A record is in progress
+            return;
+        }
+
+        for app in self.apps.iter() {
+            let started = app.enter(|app, _| {
+                if app.batch.is_none() {
+                    return false;
+                }
+                let res = self.start_record(app);
+                if res == ReturnCode::SUCCESS {
+                    self.serving_app.set(app.appid());
+                    self.busy.set(true);
+                    true
+                } else {
+                    self.finish_batch(app, res);
+                    false
+                }
+            });
+            if started {
+                break;
+            }
+        }
+    }
+}
+
+impl<'a, A: AES128CCM<'a>> CCMClient for AesCcmDriver<'a, A> {
+    fn crypt_done(&self, buf: &'static mut [u8], res: ReturnCode, tag_is_valid: bool) {
+        let result: &[u8] = buf;
+        self.serving_app.take().map(|appid| {
+            let _ = self.apps.enter(appid, |app, _| {
+                let mut batch = match app.batch {
+                    Some(batch) => batch,
+                    None => return,
+                };
+                if res != ReturnCode::SUCCESS {
+                    self.finish_batch(app, res);
+                    return;
+                }
+
+                // Copy the message (and on encryption, the MIC) back in place.
+                // Packets that fail to authenticate are left as ciphertext.
+                let start = batch.offset + RECORD_HEADER_LEN + batch.a_len;
+                let len = if batch.encrypting {
+                    batch.m_len + batch.mic_len
+                } else {
+                    batch.m_len
+                };
+                if !batch.encrypting && !tag_is_valid {
+                    batch.failed |= 1 << batch.index;
+                } else if let Some(buffer) = app.buffer.as_mut() {
+                    // The app may have swapped buffers in the meantime.
+                    if start + len <= buffer.len() {
+                        buffer.as_mut()[start..start + len]
+                            .copy_from_slice(&result[batch.a_len..batch.a_len + len]);
+                    }
+                }
+
+                batch.index += 1;
+                batch.offset = start + batch.m_len + batch.mic_len;
+                app.batch = Some(batch);
+                if batch.index == batch.count {
+                    self.finish_batch(app, ReturnCode::SUCCESS);
+                }
+            });
+        });
+
+        self.record_buf.replace(buf);
+        self.busy.set(false);
+        self.serve_waiting_apps();
+    }
+}
+
+/// Processes protect packets by `allow`ing a key and a buffer of records,
+/// subscribing for completion, then issuing an encrypt or decrypt command
+/// with the number of records in the buffer.
+impl<'a, A: AES128CCM<'a>> Driver for AesCcmDriver<'a, A> {
+    /// ### `allow_num`
+    ///
+    /// - `0`: The 16-byte AES-128 key.
+    /// - `1`: The buffer of records to process in place.
+    fn allow(
+        &self,
+        appid: AppId,
+        allow_num: usize,
+        slice: Option<AppSlice<Shared, u8>>,
+    ) -> ReturnCode {
+        match allow_num {
+            0 => self
+                .apps
+                .enter(appid, |app, _| {
+                    app.key = slice;
+                    ReturnCode::SUCCESS
+                })
+                .unwrap_or_else(|err| err.into()),
+            1 => self
+                .apps
+                .enter(appid, |app, _| {
+                    app.buffer = slice;
+                    ReturnCode::SUCCESS
+                })
+                .unwrap_or_else(|err| err.into()),
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    /// ### `subscribe_num`
+    ///
+    /// - `0`: Batch completion. The callback receives the status, the number
+    ///        of records processed, and a bitmask of records whose tag did
+    ///        not verify (always zero when encrypting). On error, records
+    ///        before the failing one have been processed.
+    fn subscribe(
+        &self,
+        subscribe_num: usize,
+        callback: Option<Callback>,
+        app_id: AppId,
+    ) -> ReturnCode {
+        match subscribe_num {
+            0 => self
+                .apps
+                .enter(app_id, |app, _| {
+                    app.callback = callback;
+                    ReturnCode::SUCCESS
+                })
+                .unwrap_or_else(|err| err.into()),
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    /// ### `command_num`
+    ///
+    /// - `0`: Driver check.
+    /// - `1`: Encrypt and tag the first `data` records of the buffer.
+    /// - `2`: Verify and decrypt the first `data` records of the buffer.
+    ///
+    /// Returns `EBUSY` if the app already has a batch in progress and
+    /// `EINVAL` if the count is 0 or larger than 32, or if the key, buffer
+    /// or callback is missing.
+    fn command(&self, command_num: usize, data: usize, _: usize, appid: AppId) -> ReturnCode {
+        match command_num {
+            0 => ReturnCode::SUCCESS,
+
+            1 | 2 => {
+                if data == 0 || data > MAX_BATCH {
+                    return ReturnCode::EINVAL;
+                }
+                let result = self
+                    .apps
+                    .enter(appid, |app, _| {
+                        if app.batch.is_some() {
+                            ReturnCode::EBUSY
+                        } else if app.callback.is_none()
+                            || app.key.is_none()
+                            || app.buffer.is_none()
+                        {
+                            ReturnCode::EINVAL
+                        } else {
+                            app.batch = Some(Batch {
+                                encrypting: command_num == 1,
+                                count: data,
+                                index: 0,
+                                offset: 0,
+                                a_len: 0,
+                                m_len: 0,
+                                mic_len: 0,
+                                failed: 0,
+                            });
+                            ReturnCode::SUCCESS
+                        }
+                    })
+                    .unwrap_or_else(|err| err.into());
+
+                if result == ReturnCode::SUCCESS {
+                    self.serve_waiting_apps();
+                }
+                result
+            }
+
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+}
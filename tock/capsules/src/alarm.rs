@@ -1,7 +1,14 @@
 //! Tock syscall driver capsule for Alarms, which issue callbacks when
 //! a point in time has been reached.
+//!
+//! Besides its single alarm (commands 3 to 6), each process has
+//! `NUM_TIMERS` timers it addresses by id. A timer is either a one-shot
+//! alarm or a periodic timer; periodic timers are re-armed by the capsule
+//! at fixed multiples of their period, so the process is only woken to
+//! handle the expiration, not to set up the next one.
 
 use core::cell::Cell;
+use core::iter;
 use kernel::hil::time::{self, Alarm, Frequency, Ticks, Ticks32};
 use kernel::{AppId, Callback, Driver, Grant, ReturnCode};
 
@@ -9,16 +16,40 @@ use kernel::{AppId, Callback, Driver, Grant, ReturnCode};
 use crate::driver;
 pub const DRIVER_NUM: usize = driver::NUM::Alarm as usize;
 
+/// Timers each process can address by id.
+pub const NUM_TIMERS: usize = 8;
+
 #[derive(Copy, Clone, Debug)]
 enum Expiration {
     Disabled,
     Enabled { reference: u32, dt: u32 },
 }
 
+#[derive(Copy, Clone)]
+struct Timer {
+    expiration: Expiration,
+    // Zero for a one-shot timer.
+    period: u32,
+    // Passed back to the process with each expiration.
+    cookie: usize,
+}
+
+impl Default for Timer {
+    fn default() -> Timer {
+        Timer {
+            expiration: Expiration::Disabled,
+            period: 0,
+            cookie: 0,
+        }
+    }
+}
+
 #[derive(Copy, Clone)]
 pub struct AlarmData {
     expiration: Expiration,
     callback: Option<Callback>,
+    timers: [Timer; NUM_TIMERS],
+    timer_callback: Option<Callback>,
 }
 
 impl Default for AlarmData {
@@ -26,6 +57,8 @@ impl Default for AlarmData {
         AlarmData {
             expiration: Expiration::Disabled,
             callback: None,
+            timers: [Timer::default(); NUM_TIMERS],
+            timer_callback: None,
         }
     }
 }
@@ -47,6 +80,91 @@ impl<'a, A: Alarm<'a>> AlarmDriver<'a, A> {
         }
     }
 
+    fn set_timer(
+        &self,
+        timer: &mut Timer,
+        reference: u32,
+        dt: u32,
+        period: u32,
+        cookie: usize,
+    ) -> (ReturnCode, bool) {
+        if let Expiration::Disabled = timer.expiration {
+            self.num_armed.set(self.num_armed.get() + 1);
+        }
+        timer.expiration = Expiration::Enabled {
+            reference: reference,
+            dt: dt,
+        };
+        timer.period = period;
+        timer.cookie = cookie;
+        (ReturnCode::SUCCESS, true)
+    }
+
+    /// Returns whichever of `earliest` and `expiration` fires first, updating
+    /// `earliest_end` to its end.
+    fn earlier(
+        earliest: Expiration,
+        earliest_end: &mut A::Ticks,
+        expiration: Expiration,
+        now_lower_bits: A::Ticks,
+    ) -> Expiration {
+        match expiration {
+            Expiration::Enabled { reference, dt } => {
+                // Do this because `reference` shadowed below
+                let current_reference = reference;
+                let current_reference_ticks = A::Ticks::from(current_reference);
+                let current_dt = dt;
+                let current_dt_ticks = A::Ticks::from(current_dt);
+                let current_end_ticks = current_reference_ticks.wrapping_add(current_dt_ticks);
+
+                match earliest {
+                    Expiration::Disabled => {
+                        *earliest_end = current_end_ticks;
+                        expiration
+                    }
+                    Expiration::Enabled { reference, dt } => {
+                        // There are two cases when current might be
+                        // an earlier alarm.  The first is if it
+                        // fires inside the interval (reference,
+                        // reference+dt) of the existing earliest.
+                        // The second is if now is not within the
+                        // interval: this means that it has
+                        // passed. It could be the earliest has passed
+                        // too, but at this point we don't need to track
+                        // which is earlier: the key point is that
+                        // the alarm must fire immediately, and then when
+                        // we handle the alarm callback the userspace
+                        // callbacks will all be pushed onto processes.
+                        // Because there is at most a single callback per
+                        // process and they must go through the scheduler
+                        // we don't care about the order in which we push
+                        // their callbacks, as their order of execution is
+                        // determined by the scheduler not push order. -pal
+                        let temp_earliest_reference = A::Ticks::from(reference);
+                        let temp_earliest_dt = A::Ticks::from(dt);
+                        let temp_earliest_end =
+                            temp_earliest_reference.wrapping_add(temp_earliest_dt);
+
+                        if current_end_ticks
+                            .within_range(temp_earliest_reference, temp_earliest_end)
+                        {
+                            *earliest_end = current_end_ticks;
+                            expiration
+                        } else if !now_lower_bits
+                            .within_range(temp_earliest_reference, temp_earliest_end)
+                        {
+                            *earliest_end = temp_earliest_end;
+                            expiration
+                        } else {
+                            earliest
+                        }
+                    }
+                }
+            }
+            Expiration::Disabled => earliest,
+        }
+    }
+
     // This logic is tricky because it needs to handle the case when the
     // underlying alarm is wider than 32 bits.
     fn reset_active_alarm(&self) {
@@ -62,60 +180,16 @@ impl<'a, A: Alarm<'a>> AlarmDriver<'a, A> {
         // are multiple alarms in the past, just store one of them
         // and resolve ordering later, when we fire.
         for alarm in self.app_alarms.iter() {
-            alarm.enter(|alarm, _| match alarm.expiration {
-                Expiration::Enabled { reference, dt } => {
-                    // Do this because `reference` shadowed below
-                    let current_reference = reference;
-                    let current_reference_ticks = A::Ticks::from(current_reference);
-                    let current_dt = dt;
-                    let current_dt_ticks = A::Ticks::from(current_dt);
-                    let current_end_ticks = current_reference_ticks.wrapping_add(current_dt_ticks);
-
-                    earliest_alarm = match earliest_alarm {
-                        Expiration::Disabled => {
-                            earliest_end = current_end_ticks;
-                            alarm.expiration
-                        }
-                        Expiration::Enabled { reference, dt } => {
-                            // There are two cases when current might be
-                            // an earlier alarm.  The first is if it
-                            // fires inside the interval (reference,
-                            // reference+dt) of the existing earliest.
-                            // The second is if now is not within the
-                            // interval: this means that it has
-                            // passed. It could be the earliest has passed
-                            // too, but at this point we don't need to track
-                            // which is earlier: the key point is that
-                            // the alarm must fire immediately, and then when
-                            // we handle the alarm callback the userspace
-                            // callbacks will all be pushed onto processes.
-                            // Because there is at most a single callback per
-                            // process and they must go through the scheduler
-                            // we don't care about the order in which we push
-                            // their callbacks, as their order of execution is
-                            // determined by the scheduler not push order. -pal
-                            let temp_earliest_reference = A::Ticks::from(reference);
-                            let temp_earliest_dt = A::Ticks::from(dt);
-                            let temp_earliest_end =
-                                temp_earliest_reference.wrapping_add(temp_earliest_dt);
-
-                            if current_end_ticks
-                                .within_range(temp_earliest_reference, temp_earliest_end)
-                            {
-                                earliest_end = current_end_ticks;
-                                alarm.expiration
-                            } else if !now_lower_bits
-                                .within_range(temp_earliest_reference, temp_earliest_end)
-                            {
-                                earliest_end = temp_earliest_end;
-                                alarm.expiration
-                            } else {
-                                earliest_alarm
-                            }
-                        }
-                    }
+            alarm.enter(|alarm, _| {
+                let timers = alarm.timers.iter().map(|timer| timer.expiration);
+                for expiration in iter::once(alarm.expiration).chain(timers) {
+                    earliest_alarm = Self::earlier(
+                        earliest_alarm,
+                        &mut earliest_end,
+                        expiration,
+                        now_lower_bits,
+                    );
                 }
-                Expiration::Disabled => {}
             });
         }
         self.next_alarm.set(earliest_alarm);
@@ -146,19 +220,28 @@ impl<'a, A: Alarm<'a>> AlarmDriver<'a, A> {
 impl<'a, A: Alarm<'a>> Driver for AlarmDriver<'a, A> {
     /// Subscribe to alarm expiration
     ///
-    /// ### `_subscribe_num`
+    /// ### `subscribe_num`
     ///
     /// - `0`: Subscribe to alarm expiration
+    /// - `1`: Subscribe to timer expirations. Called with the current clock
+    ///   value, the expiration and the `arg1` the timer was set with.
     fn subscribe(
         &self,
-        _subscribe_num: usize,
+        subscribe_num: usize,
         callback: Option<Callback>,
         app_id: AppId,
     ) -> ReturnCode {
         self.app_alarms
-            .enter(app_id, |td, _allocator| {
-                td.callback = callback;
-                ReturnCode::SUCCESS
+            .enter(app_id, |td, _allocator| match subscribe_num {
+                0 => {
+                    td.callback = callback;
+                    ReturnCode::SUCCESS
+                }
+                1 => {
+                    td.timer_callback = callback;
+                    ReturnCode::SUCCESS
+                }
+                _ => ReturnCode::ENOSUPPORT,
             })
             .unwrap_or_else(|err| err.into())
     }
@@ -173,6 +256,16 @@ impl<'a, A: Alarm<'a>> Driver for AlarmDriver<'a, A> {
     /// - `3`: Stop the alarm if it is outstanding
     /// - `4`: Set an alarm to fire at a given clock value `time`.
     /// - `5`: Set an alarm to fire at a given clock value `time` relative to `now` (EXPERIMENTAL).
+    /// - `6`: Set an alarm to fire `dt` ticks after the clock value `reference`.
+    /// - `7`: Return the number of timers.
+    /// - `8`: Set timer `arg1 & 0xFF` to fire once at clock value `arg2`.
+    /// - `9`: Set timer `arg1 & 0xFF` to fire every `arg2` ticks, starting
+    ///   `arg2` ticks from now.
+    /// - `10`: Stop timer `arg1 & 0xFF`.
+    ///
+    /// Setting a timer replaces what it was set to before. The whole of `arg1`
+    /// is passed back with each expiration, so the upper bits can tell apart
+    /// expirations of an earlier use of the same timer.
     fn command(&self, cmd_type: usize, data: usize, data2: usize, caller_id: AppId) -> ReturnCode {
         // Returns the error code to return to the user and whether we need to
         // reset which is the next active alarm. We _don't_ reset if
@@ -245,6 +338,41 @@ impl<'a, A: Alarm<'a>> Driver for AlarmDriver<'a, A> {
                         let dt = data2;
                         rearm(reference, dt)
                     }
+                    7 /* Number of timers */ => {
+                        (ReturnCode::SuccessWithValue { value: NUM_TIMERS }, false)
+                    }
+                    8 /* Set one-shot timer */ => {
+                        match td.timers.get_mut(data & 0xFF) {
+                            Some(timer) => {
+                                let reference = now.into_u32();
+                                let dt = (data2 as u32).wrapping_sub(reference);
+                                self.set_timer(timer, reference, dt, 0, data)
+                            }
+                            None => (ReturnCode::EINVAL, false),
+                        }
+                    }
+                    9 /* Set periodic timer */ => {
+                        match td.timers.get_mut(data & 0xFF) {
+                            Some(timer) if data2 != 0 => {
+                                let period = data2 as u32;
+                                self.set_timer(timer, now.into_u32(), period, period, data)
+                            }
+                            _ => (ReturnCode::EINVAL, false),
+                        }
+                    }
+                    10 /* Stop timer */ => {
+                        match td.timers.get_mut(data & 0xFF) {
+                            Some(timer) => match timer.expiration {
+                                Expiration::Disabled => (ReturnCode::EALREADY, false),
+                                _ => {
+                                    timer.expiration = Expiration::Disabled;
+                                    self.num_armed.set(self.num_armed.get() - 1);
+                                    (ReturnCode::SUCCESS, true)
+                                }
+                            },
+                            None => (ReturnCode::EINVAL, false),
+                        }
+                    }
                     _ => (ReturnCode::ENOSUPPORT, false)
                 };
                 if reset {
@@ -278,6 +406,30 @@ impl<'a, A: Alarm<'a>> time::AlarmClient for AlarmDriver<'a, A> {
                     });
                 }
             }
+
+            let timer_callback = alarm.timer_callback;
+            for timer in alarm.timers.iter_mut() {
+                if let Expiration::Enabled { reference, dt } = timer.expiration {
+                    let end = reference.wrapping_add(dt);
+                    if !now.within_range(Ticks32::from(reference), Ticks32::from(end)) {
+                        if timer.period == 0 {
+                            timer.expiration = Expiration::Disabled;
+                            self.num_armed.set(self.num_armed.get() - 1);
+                        } else {
+                            // Skip periods that have already passed, so the
+                            // timer stays on its original schedule.
+                            let missed = now.into_u32().wrapping_sub(end) / timer.period;
+                            timer.expiration = Expiration::Enabled {
+                                reference: end.wrapping_add(missed * timer.period),
+                                dt: timer.period,
+                            };
+                        }
+                        timer_callback.map(|mut cb| {
+                            cb.schedule(now.into_u32() as usize, end as usize, timer.cookie)
+                        });
+                    }
+                }
+            }
         });
 
         // If there are no armed alarms left, skip checking and just disable.
@@ -71,7 +71,7 @@ impl<'a> AppFlash<'a> {
                 let (app_flash_start, app_flash_end) = appid.get_editable_flash_range();
                 if flash_address < app_flash_start
                     || flash_address >= app_flash_end
-                    || flash_address + flash_length >= app_flash_end
+                    || flash_address + flash_length > app_flash_end
                 {
                     return ReturnCode::EINVAL;
                 }
@@ -132,23 +132,28 @@ impl hil::nonvolatile_storage::NonvolatileStorageClient<'static> for AppFlash<'_
                     self.current_app.set(app.appid());
                     let flash_address = app.flash_address;
 
-                    app.buffer.as_mut().map_or(false, |app_buffer| {
-                        self.buffer.take().map_or(false, |buffer| {
-                            if app_buffer.len() != 512 {
-                                false
-                            } else {
-                                // Copy contents to internal buffer and write it.
-                                let length = cmp::min(buffer.len(), app_buffer.len());
-                                let d = &mut app_buffer.as_mut()[0..length];
-                                for (i, c) in buffer.as_mut()[0..length].iter_mut().enumerate() {
-                                    *c = d[i];
-                                }
-
-                                self.driver.write(buffer, flash_address, length)
-                                    == ReturnCode::SUCCESS
+                    let result = app.buffer.as_mut().map_or(ReturnCode::ERESERVE, |app_buffer| {
+                        self.buffer.take().map_or(ReturnCode::ERESERVE, |buffer| {
+                            // Copy contents to internal buffer and write it.
+                            let length = cmp::min(buffer.len(), app_buffer.len());
+                            let d = &mut app_buffer.as_mut()[0..length];
+                            for (i, c) in buffer.as_mut()[0..length].iter_mut().enumerate() {
+                                *c = d[i];
                             }
+
+                            self.driver.write(buffer, flash_address, length)
                         })
-                    })
+                    });
+                    if result == ReturnCode::SUCCESS {
+                        true
+                    } else {
+                        // Tell the app rather than leave it waiting.
+                        self.current_app.clear();
+                        app.callback.map(|mut cb| {
+                            cb.schedule(usize::from(result), 0, 0);
+                        });
+                        false
+                    }
                 } else {
                     false
                 }
@@ -188,7 +193,8 @@ impl Driver for AppFlash<'_> {
     ///
     /// ### `subscribe_num`
     ///
-    /// - `0`: Set a write_done callback.
+    /// - `0`: Set a write_done callback. Called with `SUCCESS`, or the error if
+    ///   a queued write could not be started.
     fn subscribe(
         &self,
         subscribe_num: usize,
@@ -36,9 +36,44 @@
 //! When the buffer has been written successfully, the buffer is released from
 //! the driver. Successive writes must call `allow` each time a buffer is to be
 //! written.
+//!
+//! An app may start a second write (`allow` then `command`) while its first
+//! is still being transmitted. The second write is queued behind the first
+//! and its bytes follow in the same UART transactions, so the line is not
+//! idle between the two. Each write gets its own callback, in order. Starting
+//! a third write before the first completes fails with `EBUSY`.
+//!
+//! The UART HIL transmits from a `'static` kernel buffer, so app data is
+//! copied into `tx_buffer` before being sent. A transaction carries as much as
+//! fits in that buffer; boards that print a lot can give the console a larger
+//! one than the default `WRITE_BUF`.
+//!
+//! Sharing between apps
+//! --------------------
+//!
+//! When several apps have output waiting, the console takes turns between
+//! them a line at a time: an app that is in the middle of a line finishes it,
+//! then the next waiting app (in process order, wrapping around) sends one
+//! line, and so on. A chatty app therefore delays another app's line by at
+//! most one line of its own, after the transmission already in flight. An app
+//! can raise its priority (command 4) up to the limit the board gives its
+//! process name with `set_max_priorities` (0 for any other app); a waiting
+//! app with a higher priority always goes first, which suits an interactive
+//! shell sharing the console with loggers. While only one app has output, it
+//! is sent in full transactions.
+//!
+//! An app can ask for each of its lines to be prefixed with its process name
+//! (command 5). The prefix is inserted as the line is copied into
+//! `tx_buffer`, so it costs no extra copy or app memory.
+//!
+//! Each app can read its own counters (command 6): bytes and writes sent,
+//! and how long writes waited before their first byte was transmitted. Wait
+//! times need a clock, given to the console with `set_clock`.
 
+use core::cell::Cell;
 use core::cmp;
 use kernel::common::cells::{OptionalCell, TakeCell};
+use kernel::hil::time::{Frequency, Ticks, Time};
 use kernel::hil::uart;
 use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
 
@@ -46,19 +81,87 @@ use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
 use crate::driver;
 pub const DRIVER_NUM: usize = driver::NUM::Console as usize;
 
+/// A write an app has started.
+struct Write {
+    buffer: AppSlice<Shared, u8>,
+    len: usize,
+    remaining: usize, // How many bytes have not yet been copied into `tx_buffer`.
+    started_at: u32,  // Clock ticks when the write was started.
+}
+
+/// Clock used to time how long writes wait for the console.
+pub trait ConsoleClock {
+    fn console_ticks(&self) -> u32;
+    fn console_frequency(&self) -> u32;
+}
+
+impl<T: Time> ConsoleClock for T {
+    fn console_ticks(&self) -> u32 {
+        self.now().into_u32()
+    }
+
+    fn console_frequency(&self) -> u32 {
+        <T::Frequency>::frequency()
+    }
+}
+
+/// Counters an app can read with command 6, indexed by `arg1`.
 #[derive(Default)]
+pub struct Stats {
+    bytes: usize,          // 0: bytes transmitted, excluding prefixes
+    writes: usize,         // 1: writes completed
+    wait_ticks: usize,     // 2: total ticks writes waited for their first byte to be sent
+    max_wait_ticks: usize, // 3: longest such wait
+}
+
 pub struct App {
     write_callback: Option<Callback>,
     write_buffer: Option<AppSlice<Shared, u8>>,
-    write_len: usize,
-    write_remaining: usize, // How many bytes didn't fit in the buffer and still need to be printed.
-    pending_write: bool,
+    active_write: Option<Write>,
+    queued_write: Option<Write>, // Sent once `active_write` has been copied out.
+    line_start: bool,            // The last byte sent ended a line.
+    priority: usize,
+    prefix: bool,
+    stats: Stats,
 
     read_callback: Option<Callback>,
     read_buffer: Option<AppSlice<Shared, u8>>,
     read_len: usize,
 }
 
+impl Default for App {
+    fn default() -> App {
+        App {
+            write_callback: None,
+            write_buffer: None,
+            active_write: None,
+            queued_write: None,
+            line_start: true,
+            priority: 0,
+            prefix: false,
+            stats: Stats::default(),
+            read_callback: None,
+            read_buffer: None,
+            read_len: 0,
+        }
+    }
+}
+
+impl App {
+    /// Whether all of the active write has been copied into `tx_buffer`.
+    fn active_write_copied(&self) -> bool {
+        self.active_write
+            .as_ref()
+            .map_or(false, |write| write.remaining == 0)
+    }
+
+    /// Whether the app has bytes that have not been copied into `tx_buffer`.
+    fn has_unsent(&self) -> bool {
+        let unsent = |write: &Option<Write>| write.as_ref().map_or(false, |w| w.remaining > 0);
+        unsent(&self.active_write) || unsent(&self.queued_write)
+    }
+}
+
 pub static mut WRITE_BUF: [u8; 64] = [0; 64];
 pub static mut READ_BUF: [u8; 64] = [0; 64];
 
@@ -69,6 +172,11 @@ pub struct Console<'a> {
     tx_buffer: TakeCell<'static, [u8]>,
     rx_in_progress: OptionalCell<AppId>,
     rx_buffer: TakeCell<'static, [u8]>,
+    clock: OptionalCell<&'a dyn ConsoleClock>,
+    // Highest priority each named process may set for itself.
+    max_priorities: Cell<&'static [(&'static str, usize)]>,
+    // Position in `apps` of the app that sent last, for round robin.
+    last_sender: Cell<usize>,
 }
 
 impl<'a> Console<'a> {
@@ -85,72 +193,189 @@ impl<'a> Console<'a> {
             tx_buffer: TakeCell::new(tx_buffer),
             rx_in_progress: OptionalCell::empty(),
             rx_buffer: TakeCell::new(rx_buffer),
+            clock: OptionalCell::empty(),
+            max_priorities: Cell::new(&[]),
+            last_sender: Cell::new(0),
         }
     }
 
+    /// Set the clock used to measure how long writes wait.
+    pub fn set_clock(&self, clock: &'a dyn ConsoleClock) {
+        self.clock.set(clock);
+    }
+
+    /// Set the highest priority each process, by name, may give itself
+    /// with command 4. Other processes are limited to the default, 0.
+    pub fn set_max_priorities(&self, max_priorities: &'static [(&'static str, usize)]) {
+        self.max_priorities.set(max_priorities);
+    }
+
+    fn now(&self) -> u32 {
+        self.clock.map_or(0, |clock| clock.console_ticks())
+    }
+
     /// Internal helper function for setting up a new send transaction
     fn send_new(&self, app_id: AppId, app: &mut App, len: usize) -> ReturnCode {
-        match app.write_buffer.take() {
-            Some(slice) => {
-                app.write_len = cmp::min(len, slice.len());
-                app.write_remaining = app.write_len;
-                self.send(app_id, app, slice);
-                ReturnCode::SUCCESS
+        let slice = match app.write_buffer.take() {
+            Some(slice) => slice,
+            None => return ReturnCode::EBUSY,
+        };
+        let len = cmp::min(len, slice.len());
+        let write = Write {
+            buffer: slice,
+            len: len,
+            remaining: len,
+            started_at: self.now(),
+        };
+
+        if app.active_write.is_none() {
+            app.active_write = Some(write);
+        } else if app.queued_write.is_none() {
+            app.queued_write = Some(write);
+        } else {
+            app.write_buffer = Some(write.buffer);
+            return ReturnCode::EBUSY;
+        }
+
+        // If another app is transmitting, this write is picked up when it is
+        // this app's turn. Nobody else can be waiting while the console is
+        // idle, so there is no need to stop at a line end.
+        if self.tx_in_progress.is_none() {
+            if !self.send(app_id, app, false) {
+                // Nothing to send.
+                self.complete_writes(app);
             }
-            None => ReturnCode::EBUSY,
         }
+        ReturnCode::SUCCESS
     }
 
-    /// Internal helper function for continuing a previously set up transaction
-    /// Returns true if this send is still active, or false if it has completed
-    fn send_continue(&self, app_id: AppId, app: &mut App) -> Result<bool, ReturnCode> {
-        if app.write_remaining > 0 {
-            app.write_buffer
-                .take()
-                .map_or(Err(ReturnCode::ERESERVE), |slice| {
-                    self.send(app_id, app, slice);
-                    Ok(true)
-                })
+    /// Copies the app's unsent bytes into `buffer`, from the active write and
+    /// then the queued one, inserting the line prefix if the app asked for
+    /// one. With `one_line` it stops at the end of the first line. Returns
+    /// the number of bytes copied.
+    fn fill(&self, app_id: AppId, app: &mut App, buffer: &mut [u8], one_line: bool) -> usize {
+        let name: &[u8] = if app.prefix {
+            app_id.get_process_name().as_bytes()
         } else {
-            Ok(false)
-        }
-    }
+            &[]
+        };
+        let mut len = 0;
+        while len < buffer.len() {
+            let write = if app.active_write_copied() {
+                &mut app.queued_write
+            } else {
+                &mut app.active_write
+            };
+            let write = match write {
+                Some(write) if write.remaining > 0 => write,
+                _ => break,
+            };
 
-    /// Internal helper function for sending data for an existing transaction.
-    /// Cannot fail. If can't send now, it will schedule for sending later.
-    fn send(&self, app_id: AppId, app: &mut App, slice: AppSlice<Shared, u8>) {
-        if self.tx_in_progress.is_none() {
-            self.tx_in_progress.set(app_id);
-            self.tx_buffer.take().map(|buffer| {
-                let mut transaction_len = app.write_remaining;
-                for (i, c) in slice.as_ref()[slice.len() - app.write_remaining..slice.len()]
-                    .iter()
-                    .enumerate()
-                {
-                    if buffer.len() <= i {
-                        break;
-                    }
-                    buffer[i] = *c;
+            if app.line_start && !name.is_empty() && buffer.len() >= 4 {
+                // "[name] ", kept whole. If an empty buffer cannot hold it
+                // and a byte of the line, the name is cut short instead, so
+                // a long name never stops the app's output.
+                let room = buffer.len() - len;
+                if room < name.len() + 4 && len > 0 {
+                    break;
                 }
+                let name = &name[..cmp::min(name.len(), room - 4)];
+                buffer[len] = b'[';
+                buffer[len + 1..len + 1 + name.len()].copy_from_slice(name);
+                buffer[len + 1 + name.len()..len + 3 + name.len()].copy_from_slice(b"] ");
+                len += name.len() + 3;
+            }
 
-                // Check if everything we wanted to print
-                // fit in the buffer.
-                if app.write_remaining > buffer.len() {
-                    transaction_len = buffer.len();
-                    app.write_remaining -= buffer.len();
-                    app.write_buffer = Some(slice);
-                } else {
-                    app.write_remaining = 0;
+            let start = write.len - write.remaining;
+            if start == 0 {
+                let wait = self.now().wrapping_sub(write.started_at) as usize;
+                app.stats.wait_ticks += wait;
+                app.stats.max_wait_ticks = cmp::max(app.stats.max_wait_ticks, wait);
+            }
+
+            let data = &write.buffer.as_ref()[start..write.len];
+            let mut count = cmp::min(data.len(), buffer.len() - len);
+            if one_line || !name.is_empty() {
+                // Stop after a newline, to hand over or to prefix the next line.
+                if let Some(end) = data[..count].iter().position(|c| *c == b'\n') {
+                    count = end + 1;
                 }
+            }
+            buffer[len..len + count].copy_from_slice(&data[..count]);
+            len += count;
+            write.remaining -= count;
+            app.stats.bytes += count;
+            app.line_start = data[count - 1] == b'\n';
+
+            if one_line && app.line_start {
+                break;
+            }
+        }
+        len
+    }
+
+    /// Internal helper function for sending the next part of the app's
+    /// writes. Returns true if a transmission was started.
+    fn send(&self, app_id: AppId, app: &mut App, one_line: bool) -> bool {
+        self.tx_buffer.take().map_or(false, |buffer| {
+            let len = self.fill(app_id, app, buffer, one_line);
+            if len == 0 {
+                self.tx_buffer.replace(buffer);
+                false
+            } else {
+                self.tx_in_progress.set(app_id);
+                let (_err, _opt) = self.uart.transmit_buffer(buffer, len);
+                true
+            }
+        })
+    }
 
-                let (_err, _opt) = self.uart.transmit_buffer(buffer, transaction_len);
+    /// Internal helper function for signalling the writes whose bytes have
+    /// all been transmitted.
+    fn complete_writes(&self, app: &mut App) {
+        while app.active_write_copied() {
+            let written = app.active_write.take().map_or(0, |write| write.len);
+            app.active_write = app.queued_write.take();
+            app.stats.writes += 1;
+            app.write_callback.map(|mut cb| {
+                cb.schedule(written, 0, 0);
             });
-        } else {
-            app.pending_write = true;
-            app.write_buffer = Some(slice);
         }
     }
 
+    /// Picks the app to transmit next: the app that just sent if it is in
+    /// the middle of a line, otherwise the waiting app with the highest
+    /// priority, taking turns in process order between equals. Returns the
+    /// app's position in `apps` and whether other apps are waiting.
+    fn next_sender(&self, previous: Option<AppId>) -> Option<(usize, bool)> {
+        let last = self.last_sender.get();
+        // (position, priority, comes after `last` in round robin order)
+        let mut best: Option<(usize, usize, bool)> = None;
+        let mut waiting = 0;
+        for (position, cntr) in self.apps.iter().enumerate() {
+            let (ready, priority, mid_line) = cntr.enter(|app, _| {
+                let mid_line = previous == Some(app.appid()) && !app.line_start;
+                (app.has_unsent(), app.priority, mid_line)
+            });
+            if !ready {
+                continue;
+            }
+            waiting += 1;
+            if mid_line {
+                best = Some((position, usize::max_value(), true));
+                continue;
+            }
+            let after = position > last;
+            let better = best.map_or(true, |(_, best_priority, best_after)| {
+                priority > best_priority || (priority == best_priority && after && !best_after)
+            });
+            if better {
+                best = Some((position, priority, after));
+            }
+        }
+        best.map(|(position, _, _)| (position, waiting > 1))
+    }
+
     /// Internal helper function for starting a receive operation
     fn receive_new(&self, app_id: AppId, app: &mut App, len: usize) -> ReturnCode {
         if self.rx_buffer.is_none() {
@@ -250,11 +475,19 @@ impl Driver for Console<'_> {
     ///
     /// - `0`: Driver check.
     /// - `1`: Transmits a buffer passed via `allow`, up to the length
-    ///        passed in `arg1`
+    ///        passed in `arg1`. One further write may be started while
+    ///        this one is in progress.
     /// - `2`: Receives into a buffer passed via `allow`, up to the length
     ///        passed in `arg1`
     /// - `3`: Cancel any in progress receives and return (via callback)
     ///        what has been received so far.
+    /// - `4`: Set this app's output priority to `arg1` (default 0). Fails
+    ///        with `EINVAL` above the limit the board set for the app.
+    /// - `5`: Prefix each of this app's lines with its process name if
+    ///        `arg1` is nonzero.
+    /// - `6`: Return this app's counter `arg1`: 0 bytes sent, 1 writes
+    ///        completed, 2 total and 3 longest wait in clock ticks, 4 clock
+    ///        frequency in hertz (0 if the console has no clock).
     fn command(&self, cmd_num: usize, arg1: usize, _: usize, appid: AppId) -> ReturnCode {
         match cmd_num {
             0 /* check if present */ => ReturnCode::SUCCESS,
@@ -274,6 +507,42 @@ impl Driver for Console<'_> {
                 self.uart.receive_abort();
                 ReturnCode::SUCCESS
             }
+            4 /* set priority */ => {
+                let name = appid.get_process_name();
+                let max = self
+                    .max_priorities
+                    .get()
+                    .iter()
+                    .find(|(process, _)| *process == name)
+                    .map_or(0, |(_, max)| *max);
+                if arg1 > max {
+                    return ReturnCode::EINVAL;
+                }
+                self.apps.enter(appid, |app, _| {
+                    app.priority = arg1;
+                    ReturnCode::SUCCESS
+                }).unwrap_or_else(|err| err.into())
+            },
+            5 /* line prefix */ => {
+                self.apps.enter(appid, |app, _| {
+                    app.prefix = arg1 != 0;
+                    ReturnCode::SUCCESS
+                }).unwrap_or_else(|err| err.into())
+            },
+            6 /* counters */ => {
+                let frequency = self.clock.map_or(0, |clock| clock.console_frequency() as usize);
+                self.apps.enter(appid, |app, _| {
+                    let value = match arg1 {
+                        0 => app.stats.bytes,
+                        1 => app.stats.writes,
+                        2 => app.stats.wait_ticks,
+                        3 => app.stats.max_wait_ticks,
+                        4 => frequency,
+                        _ => return ReturnCode::EINVAL,
+                    };
+                    ReturnCode::SuccessWithValue { value: value }
+                }).unwrap_or_else(|err| err.into())
+            },
             _ => ReturnCode::ENOSUPPORT
         }
     }
@@ -281,66 +550,23 @@ impl Driver for Console<'_> {
 
 impl uart::TransmitClient for Console<'_> {
     fn transmitted_buffer(&self, buffer: &'static mut [u8], _tx_len: usize, _rcode: ReturnCode) {
-        // Either print more from the AppSlice or send a callback to the
-        // application.
+        // Signal the writes that are done, then pick who sends next.
         self.tx_buffer.replace(buffer);
-        self.tx_in_progress.take().map(|appid| {
+        let previous = self.tx_in_progress.take();
+        previous.map(|appid| {
             self.apps.enter(appid, |app, _| {
-                match self.send_continue(appid, app) {
-                    Ok(more_to_send) => {
-                        if !more_to_send {
-                            // Go ahead and signal the application
-                            let written = app.write_len;
-                            app.write_len = 0;
-                            app.write_callback.map(|mut cb| {
-                                cb.schedule(written, 0, 0);
-                            });
-                        }
-                    }
-                    Err(return_code) => {
-                        // XXX This shouldn't ever happen?
-                        app.write_len = 0;
-                        app.write_remaining = 0;
-                        app.pending_write = false;
-                        let r0 = isize::from(return_code) as usize;
-                        app.write_callback.map(|mut cb| {
-                            cb.schedule(r0, 0, 0);
-                        });
-                    }
-                }
+                self.complete_writes(app);
             })
         });
 
-        // If we are not printing more from the current AppSlice,
-        // see if any other applications have pending messages.
-        if self.tx_in_progress.is_none() {
-            for cntr in self.apps.iter() {
-                let started_tx = cntr.enter(|app, _| {
-                    if app.pending_write {
-                        app.pending_write = false;
-                        match self.send_continue(app.appid(), app) {
-                            Ok(more_to_send) => more_to_send,
-                            Err(return_code) => {
-                                // XXX This shouldn't ever happen?
-                                app.write_len = 0;
-                                app.write_remaining = 0;
-                                app.pending_write = false;
-                                let r0 = isize::from(return_code) as usize;
-                                app.write_callback.map(|mut cb| {
-                                    cb.schedule(r0, 0, 0);
-                                });
-                                false
-                            }
-                        }
-                    } else {
-                        false
-                    }
-                });
-                if started_tx {
-                    break;
-                }
-            }
-        }
+        self.next_sender(previous).map(|(position, others_waiting)| {
+            self.apps.iter().nth(position).map(|cntr| {
+                cntr.enter(|app, _| {
+                    self.last_sender.set(position);
+                    self.send(app.appid(), app, others_waiting);
+                })
+            })
+        });
     }
 }
 
@@ -16,6 +16,7 @@ pub enum NUM {
     Adc                   = 0x00005,
     Dac                   = 0x00006,
     AnalogComparator      = 0x00007,
+    Pwm                   = 0x00010,
 
     // Kernel
     Ipc                   = 0x10000,
@@ -37,6 +38,7 @@ pub enum NUM {
     Crc                   = 0x40002,
     Hmac                  = 0x40003,
     CtapHid               = 0x40004,
+    AesCcm                = 0x40005,
 
     // Storage
     AppFlash              = 0x50000,
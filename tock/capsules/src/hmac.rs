@@ -28,6 +28,7 @@ use crate::driver;
 pub const DRIVER_NUM: usize = driver::NUM::Hmac as usize;
 
 use core::cell::Cell;
+use core::cmp;
 use core::convert::TryInto;
 use core::marker::PhantomData;
 use kernel::common::cells::{OptionalCell, TakeCell};
@@ -92,23 +93,19 @@ where
                             self.data_buffer.map(|buf| {
                                 let data = d.as_ref();
 
-                                // Determine the size of the static buffer we have
-                                let static_buffer_len = buf.len();
-
-                                // If we have more data then the static buffer we set how much data we are going to copy
-                                if data.len() > static_buffer_len {
-                                    self.data_copied.set(static_buffer_len);
-                                }
-
-                                // Copy the data into the static buffer
-                                buf.copy_from_slice(&data[..static_buffer_len]);
+                                // Copy as much data as fits in the static buffer,
+                                // and remember how much has been copied so
+                                // `add_data_done` knows whether there is more.
+                                let copy_len = cmp::min(data.len(), buf.len());
+                                buf[..copy_len].copy_from_slice(&data[..copy_len]);
+                                self.data_copied.set(copy_len);
                             });
 
                             // Add the data from the static buffer to the HMAC
-                            if let Err(e) = self
-                                .hmac
-                                .add_data(LeasableBuffer::new(self.data_buffer.take().unwrap()))
-                            {
+                            let mut lease_buf =
+                                LeasableBuffer::new(self.data_buffer.take().unwrap());
+                            lease_buf.slice(..self.data_copied.get());
+                            if let Err(e) = self.hmac.add_data(lease_buf) {
                                 self.data_buffer.replace(e.1);
                                 return e.0;
                             }
@@ -3,6 +3,29 @@
 //! Implements a userspace interface for sending and receiving IEEE 802.15.4
 //! frames. Also provides a minimal list-based interface for managing keys and
 //! known link neighbors, which is needed for 802.15.4 security.
+//!
+//! Received frames can be delivered either one at a time into the read buffer
+//! (allow `0`), which must be re-allowed after every frame, or into a receive
+//! ring (allow `3`) that holds several frames. The ring starts with an 8-byte
+//! header followed by fixed-size slots:
+//!
+//! ```text
+//! header: 0: write index (kernel)   1: read index (app)   2: slot count
+//!         3: reserved               4..8: frames dropped because the ring
+//!                                         was full (u32, little endian)
+//! slot:   0..4: timestamp (u32, little endian, 0 without a clock)
+//!         4: LQI (0xff if not reported by the radio)
+//!         5: RSSI in dBm (i8, -128 if not reported by the radio)
+//!         6..8: reserved
+//!         8..: the frame, as delivered in the read buffer
+//! ```
+//!
+//! The kernel fills the slot at the write index and then advances it; the app
+//! consumes the slot at the read index and advances it to release the slot.
+//! The ring is empty when the indices are equal and full when advancing the
+//! write index would make them equal. The ring callback (subscribe `2`) is
+//! only scheduled when a frame lands in an empty ring, so an app should
+//! consume frames until the ring is empty each time it runs.
 
 use crate::ieee802154::{device, framer};
 use crate::net::ieee802154::{AddressMode, Header, KeyId, MacAddress, PanID, SecurityLevel};
@@ -10,11 +33,22 @@ use crate::net::stream::{decode_bytes, decode_u8, encode_bytes, encode_u8, SResu
 use core::cell::Cell;
 use core::cmp::min;
 use kernel::common::cells::{MapCell, OptionalCell, TakeCell};
+use kernel::hil::time::{Ticks, Time};
 use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
 
 const MAX_NEIGHBORS: usize = 4;
 const MAX_KEYS: usize = 4;
 
+/// Receive ring layout, see the module documentation.
+const RING_HEADER_LEN: usize = 8;
+const RING_SLOT_HEADER_LEN: usize = 8;
+const RING_SLOT_LEN: usize = 140;
+const RING_MAX_SLOTS: usize = 255;
+const RING_WRITE: usize = 0;
+const RING_READ: usize = 1;
+const RING_COUNT: usize = 2;
+const RING_DROPPED: usize = 4;
+
 use crate::driver;
 pub const DRIVER_NUM: usize = driver::NUM::Ieee802154 as usize;
 
@@ -33,6 +67,19 @@ impl Default for DeviceDescriptor {
     }
 }
 
+/// Source of receive timestamps. Implemented for every `Time`, so a board can
+/// hand the driver the same alarm that backs the userspace alarm driver and
+/// apps can compare timestamps with the alarm's current time.
+pub trait RxClock {
+    fn rx_timestamp(&self) -> u32;
+}
+
+impl<T: Time> RxClock for T {
+    fn rx_timestamp(&self) -> u32 {
+        self.now().into_u32()
+    }
+}
+
 /// The Key ID mode mapping expected by the userland driver
 #[repr(u8)]
 #[derive(Copy, Clone, Eq, PartialEq, Debug)]
@@ -150,6 +197,8 @@ pub struct App {
     app_read: Option<AppSlice<Shared, u8>>,
     app_write: Option<AppSlice<Shared, u8>>,
     app_cfg: Option<AppSlice<Shared, u8>>,
+    app_ring: Option<AppSlice<Shared, u8>>,
+    ring_callback: Option<Callback>,
     pending_tx: Option<(u16, Option<(SecurityLevel, KeyId)>)>,
 }
 
@@ -161,6 +210,8 @@ impl Default for App {
             app_read: None,
             app_write: None,
             app_cfg: None,
+            app_ring: None,
+            ring_callback: None,
             pending_tx: None,
         }
     }
@@ -189,6 +240,9 @@ pub struct RadioDriver<'a> {
 
     /// Buffer that stores the IEEE 802.15.4 frame to be transmitted.
     kernel_tx: TakeCell<'static, [u8]>,
+
+    /// Optional clock used to timestamp frames delivered to receive rings.
+    rx_clock: OptionalCell<&'a dyn RxClock>,
 }
 
 impl<'a> RadioDriver<'a> {
@@ -206,9 +260,15 @@ impl<'a> RadioDriver<'a> {
             apps: grant,
             current_app: OptionalCell::empty(),
             kernel_tx: TakeCell::new(kernel_tx),
+            rx_clock: OptionalCell::empty(),
         }
     }
 
+    /// Sets the clock used to timestamp frames in receive rings.
+    pub fn set_rx_clock(&self, clock: &'a dyn RxClock) {
+        self.rx_clock.set(clock);
+    }
+
     // Neighbor management functions
 
     /// Add a new neighbor to the end of the list if there is still space
@@ -402,7 +462,6 @@ impl<'a> RadioDriver<'a> {
         if result != ReturnCode::SUCCESS {
             let _ = self.apps.enter(appid, |app, _| {
                 app.tx_callback
-                    .take()
                     .map(|mut cb| cb.schedule(result.into(), 0, 0));
             });
         }
@@ -466,14 +525,6 @@ impl<'a> RadioDriver<'a> {
         })
     }
 
-    /// Schedule the next transmission if there is one pending. Performs the
-    /// transmission asynchronously, returning any errors via callbacks.
-    #[inline]
-    fn do_next_tx_async(&self) {
-        self.get_next_tx_if_idle()
-            .map(|appid| self.perform_tx_async(appid));
-    }
-
     /// Schedule the next transmission if there is one pending. If the next
     /// transmission happens to be the one that was just queued, then the
     /// transmission is synchronous. Hence, errors must be returned immediately.
@@ -484,7 +535,10 @@ impl<'a> RadioDriver<'a> {
         self.get_next_tx_if_idle()
             .map_or(ReturnCode::SUCCESS, |appid| {
                 if appid == new_appid {
-                    self.perform_tx_sync(appid)
+                    match self.perform_tx_sync(appid) {
+                        ReturnCode::SUCCESS => ReturnCode::SuccessWithValue { value: 1 },
+                        result => result,
+                    }
                 } else {
                     self.perform_tx_async(appid);
                     ReturnCode::SUCCESS
@@ -533,6 +587,8 @@ impl Driver for RadioDriver<'_> {
     /// - `2`: Config buffer. Used to contain miscellaneous data associated with
     ///        some commands because the system call parameters / return codes are
     ///        not enough to convey the desired information.
+    /// - `3`: Receive ring. Frames are delivered here instead of the read
+    ///        buffer while it is allowed. The header is reset on allow.
     fn allow(
         &self,
         appid: AppId,
@@ -549,6 +605,24 @@ impl Driver for RadioDriver<'_> {
                 }
                 ReturnCode::SUCCESS
             }),
+            3 => self.do_with_app(appid, |app| {
+                let mut slice = match slice {
+                    Some(slice) => slice,
+                    None => {
+                        app.app_ring = None;
+                        return ReturnCode::SUCCESS;
+                    }
+                };
+                if slice.len() < RING_HEADER_LEN + 2 * RING_SLOT_LEN {
+                    return ReturnCode::EINVAL;
+                }
+                let slots = min((slice.len() - RING_HEADER_LEN) / RING_SLOT_LEN, RING_MAX_SLOTS);
+                let header = &mut slice.as_mut()[..RING_HEADER_LEN];
+                header.iter_mut().for_each(|b| *b = 0);
+                header[RING_COUNT] = slots as u8;
+                app.app_ring = Some(slice);
+                ReturnCode::SUCCESS
+            }),
             _ => ReturnCode::ENOSUPPORT,
         }
     }
@@ -558,7 +632,14 @@ impl Driver for RadioDriver<'_> {
     /// ### `subscribe_num`
     ///
     /// - `0`: Setup callback for when frame is received.
-    /// - `1`: Setup callback for when frame is transmitted.
+    /// - `1`: Setup callback for when frame is transmitted. The callback
+    ///        stays subscribed across transmissions, and one is delivered
+    ///        per frame in the order the frames were sent, so an app can
+    ///        queue its next frame (command `26`) while one is in flight.
+    ///        The arguments are the result, whether the frame was acked,
+    ///        and whether the app's queued frame is still waiting to start.
+    /// - `2`: Setup callback for when a frame lands in an empty receive ring.
+    ///        The arguments are the write index and the drop count.
     fn subscribe(
         &self,
         subscribe_num: usize,
@@ -574,6 +655,10 @@ impl Driver for RadioDriver<'_> {
                 app.tx_callback = callback;
                 ReturnCode::SUCCESS
             }),
+            2 => self.do_with_app(app_id, |app| {
+                app.ring_callback = callback;
+                ReturnCode::SUCCESS
+            }),
             _ => ReturnCode::ENOSUPPORT,
         }
     }
@@ -627,6 +712,15 @@ impl Driver for RadioDriver<'_> {
     ///                      9 bytes: the key ID (might not use all bytes) +
     ///                      16 bytes: the key.
     /// - `25`: Remove the key at an index.
+    /// - `26`: Transmit a frame to the short address `arg1`.
+    ///        app_cfg (in): 1 byte: the security level +
+    ///                      1 byte: the key ID mode +
+    ///                      9 bytes: the key ID (might not use all bytes).
+    ///        app_write (in): the payload, copied when transmission starts.
+    ///        Returns 1 if transmission started immediately, or 0 if the
+    ///        frame is waiting for another process's frame; in that case the
+    ///        payload must stay allowed until the frame is started. Each
+    ///        process can have one frame waiting besides the one in flight.
     fn command(&self, command_num: usize, arg1: usize, _: usize, appid: AppId) -> ReturnCode {
         match command_num {
             0 => ReturnCode::SUCCESS,
@@ -800,14 +894,19 @@ impl Driver for RadioDriver<'_> {
 impl device::TxClient for RadioDriver<'_> {
     fn send_done(&self, spi_buf: &'static mut [u8], acked: bool, result: ReturnCode) {
         self.kernel_tx.replace(spi_buf);
-        self.current_app.take().map(|appid| {
+        let done_appid = self.current_app.take();
+        let next_appid = self.get_next_tx_if_idle();
+        done_appid.map(|appid| {
             let _ = self.apps.enter(appid, |app, _| {
-                app.tx_callback
-                    .take()
-                    .map(|mut cb| cb.schedule(result.into(), acked as usize, 0));
+                // Tell the app whether its next frame is still waiting, i.e.
+                // whether its payload has not been copied yet.
+                let waiting = app.pending_tx.is_some() && next_appid != Some(appid);
+                app.tx_callback.map(|mut cb| {
+                    cb.schedule(result.into(), acked as usize, waiting as usize)
+                });
             });
         });
-        self.do_next_tx_async();
+        next_appid.map(|appid| self.perform_tx_async(appid));
     }
 }
 
@@ -829,7 +928,50 @@ fn encode_address(addr: &Option<MacAddress>) -> usize {
 
 impl device::RxClient for RadioDriver<'_> {
     fn receive<'b>(&self, buf: &'b [u8], header: Header<'b>, data_offset: usize, data_len: usize) {
+        let timestamp = self.rx_clock.map_or(0, |clock| clock.rx_timestamp());
         self.apps.each(|app| {
+            let app: &mut App = &mut *app;
+            if let Some(ring) = app.app_ring.as_mut() {
+                let ring = ring.as_mut();
+                let slots = ring[RING_COUNT] as usize;
+                let write = ring[RING_WRITE] as usize;
+                let read = ring[RING_READ] as usize;
+                if slots == 0 || write >= slots || read >= slots {
+                    // The app has corrupted the header.
+                    return;
+                }
+                let mut dropped = [0; 4];
+                dropped.copy_from_slice(&ring[RING_DROPPED..RING_DROPPED + 4]);
+                let dropped = u32::from_le_bytes(dropped);
+
+                let next = (write + 1) % slots;
+                if next == read {
+                    let dropped = dropped.wrapping_add(1);
+                    ring[RING_DROPPED..RING_DROPPED + 4].copy_from_slice(&dropped.to_le_bytes());
+                    return;
+                }
+
+                let start = RING_HEADER_LEN + write * RING_SLOT_LEN;
+                let slot = &mut ring[start..start + RING_SLOT_LEN];
+                slot[0..4].copy_from_slice(&timestamp.to_le_bytes());
+                // The radio stack does not pass link quality up yet.
+                slot[4] = 0xff;
+                slot[5] = i8::MIN as u8;
+                slot[6] = 0;
+                slot[7] = 0;
+                let frame = &mut slot[RING_SLOT_HEADER_LEN..];
+                let len = min(frame.len(), data_offset + data_len);
+                frame[..len].copy_from_slice(&buf[..len]);
+                frame[0] = data_offset as u8;
+                frame[1] = data_len as u8;
+                ring[RING_WRITE] = next as u8;
+
+                if write == read {
+                    app.ring_callback.map(|mut cb| cb.schedule(next, dropped as usize, 0));
+                }
+                return;
+            }
+
             app.app_read.take().as_mut().map(|rbuf| {
                 let rbuf = rbuf.as_mut();
                 let len = min(rbuf.len(), data_offset + data_len);
@@ -9,4 +9,5 @@ pub mod xmac;
 mod driver;
 
 pub use self::driver::RadioDriver;
+pub use self::driver::RxClock;
 pub use self::driver::DRIVER_NUM;
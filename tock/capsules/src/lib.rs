@@ -8,6 +8,7 @@ pub mod test;
 pub mod net;
 
 pub mod adc;
+pub mod aes_ccm;
 pub mod alarm;
 pub mod ambient_light;
 pub mod analog_comparator;
@@ -58,6 +59,7 @@ pub mod panic_button;
 pub mod pca9544a;
 pub mod process_console;
 pub mod proximity;
+pub mod pwm;
 pub mod rf233;
 pub mod rf233_const;
 pub mod rng;
@@ -53,12 +53,23 @@
 //!         &mut capsules::nonvolatile_storage_driver::BUFFER));
 //! hil::nonvolatile_storage::NonvolatileStorage::set_client(fm25cl, nonvolatile_storage);
 //! ```
+//!
+//! If the userspace region is also mapped into memory, as with internal
+//! flash, the board can let apps read it directly:
+//!
+//! ```rust
+//! nonvolatile_storage.set_mapping(kernel::ReadOnlyRegion::new(
+//!     0x60000, // Address of the first byte of the userspace region.
+//!     0x20000, // The length of the userspace region.
+//!     &memory_allocation_capability,
+//! ));
+//! ```
 
 use core::cell::Cell;
 use core::cmp;
 use kernel::common::cells::{OptionalCell, TakeCell};
 use kernel::hil;
-use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
+use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReadOnlyRegion, ReturnCode, Shared};
 
 /// Syscall driver number.
 use crate::driver;
@@ -87,8 +98,14 @@ pub struct App {
     command: NonvolatileCommand,
     offset: usize,
     length: usize,
+    // Where in the allowed buffer the pending command's data is.
+    buffer_offset: usize,
+    // Where in the allowed buffer the running command's data is.
+    active_buffer_offset: usize,
     buffer_read: Option<AppSlice<Shared, u8>>,
     buffer_write: Option<AppSlice<Shared, u8>>,
+    // Whether the app may read the mapped userspace region.
+    mapped: bool,
 }
 
 impl Default for App {
@@ -100,8 +117,26 @@ impl Default for App {
             command: NonvolatileCommand::UserspaceRead,
             offset: 0,
             length: 0,
+            buffer_offset: 0,
+            active_buffer_offset: 0,
             buffer_read: None,
             buffer_write: None,
+            mapped: false,
+        }
+    }
+}
+
+impl App {
+    // Length of the buffer the app allowed for `command`.
+    fn allowed_length(&self, command: NonvolatileCommand) -> usize {
+        match command {
+            NonvolatileCommand::UserspaceRead => {
+                self.buffer_read.as_ref().map_or(0, |appbuf| appbuf.len())
+            }
+            NonvolatileCommand::UserspaceWrite => {
+                self.buffer_write.as_ref().map_or(0, |appbuf| appbuf.len())
+            }
+            _ => 0,
         }
     }
 }
@@ -114,6 +149,8 @@ pub struct NonvolatileStorage<'a> {
 
     // Internal buffer for copying appslices into.
     buffer: TakeCell<'static, [u8]>,
+    // Length of `buffer`, the most a single userspace command transfers.
+    buffer_length: usize,
     // What issued the currently executing call. This can be an app or the kernel.
     current_user: OptionalCell<NonvolatileUser>,
 
@@ -125,6 +162,8 @@ pub struct NonvolatileStorage<'a> {
     kernel_start_address: usize,
     // How many bytes allocated to kernel.
     kernel_length: usize,
+    // Where the userspace region can be read in memory, if it is mapped.
+    mapping: OptionalCell<ReadOnlyRegion>,
 
     // Optional client for the kernel. Only needed if the kernel intends to use
     // this nonvolatile storage.
@@ -155,12 +194,14 @@ impl<'a> NonvolatileStorage<'a> {
         NonvolatileStorage {
             driver: driver,
             apps: grant,
+            buffer_length: buffer.len(),
             buffer: TakeCell::new(buffer),
             current_user: OptionalCell::empty(),
             userspace_start_address: userspace_start_address,
             userspace_length: userspace_length,
             kernel_start_address: kernel_start_address,
             kernel_length: kernel_length,
+            mapping: OptionalCell::empty(),
             kernel_client: OptionalCell::empty(),
             kernel_pending_command: Cell::new(false),
             kernel_command: Cell::new(NonvolatileCommand::KernelRead),
@@ -170,6 +211,16 @@ impl<'a> NonvolatileStorage<'a> {
         }
     }
 
+    /// Let apps read the userspace region directly at `region`, which must
+    /// hold the whole region. Reads through the mapping must see data once
+    /// `write_done` has been called for it, so the underlying driver must
+    /// invalidate any cache in front of the mapping before then.
+    pub fn set_mapping(&self, region: ReadOnlyRegion) {
+        if region.len() >= self.userspace_length {
+            self.mapping.set(region);
+        }
+    }
+
     // Check so see if we are doing something. If not, go ahead and do this
     // command. If so, this is queued and will be run when the pending
     // command completes.
@@ -178,6 +229,7 @@ impl<'a> NonvolatileStorage<'a> {
         command: NonvolatileCommand,
         offset: usize,
         length: usize,
+        buffer_offset: usize,
         app_id: Option<AppId>,
     ) -> ReturnCode {
         // Do bounds check.
@@ -213,53 +265,33 @@ impl<'a> NonvolatileStorage<'a> {
                     self.apps
                         .enter(appid, |app, _| {
                             // Get the length of the correct allowed buffer.
-                            let allow_buf_len = match command {
-                                NonvolatileCommand::UserspaceRead => {
-                                    app.buffer_read.as_ref().map_or(0, |appbuf| appbuf.len())
-                                }
-                                NonvolatileCommand::UserspaceWrite => {
-                                    app.buffer_write.as_ref().map_or(0, |appbuf| appbuf.len())
-                                }
-                                _ => 0,
-                            };
+                            let allow_buf_len = app.allowed_length(command);
 
                             // Check that it exists.
                             if allow_buf_len == 0 || self.buffer.is_none() {
                                 return ReturnCode::ERESERVE;
                             }
+                            if buffer_offset >= allow_buf_len {
+                                return ReturnCode::EINVAL;
+                            }
 
                             // Shorten the length if the application gave us nowhere to
                             // put it.
-                            let active_len = cmp::min(length, allow_buf_len);
+                            let active_len = cmp::min(length, allow_buf_len - buffer_offset);
 
                             // First need to determine if we can execute this or must
                             // queue it.
                             if self.current_user.is_none() {
                                 // No app is currently using the underlying storage.
                                 // Mark this app as active, and then execute the command.
-                                self.current_user
-                                    .set(NonvolatileUser::App { app_id: appid });
-
-                                // Need to copy bytes if this is a write!
-                                if command == NonvolatileCommand::UserspaceWrite {
-                                    app.buffer_write.as_mut().map(|app_buffer| {
-                                        self.buffer.map(|kernel_buffer| {
-                                            // Check that the internal buffer and the buffer that was
-                                            // allowed are long enough.
-                                            let write_len =
-                                                cmp::min(active_len, kernel_buffer.len());
-
-                                            let d = &mut app_buffer.as_mut()[0..write_len];
-                                            for (i, c) in
-                                                kernel_buffer[0..write_len].iter_mut().enumerate()
-                                            {
-                                                *c = d[i];
-                                            }
-                                        });
-                                    });
-                                }
-
-                                self.userspace_call_driver(command, offset, active_len)
+                                self.userspace_start(
+                                    app,
+                                    appid,
+                                    command,
+                                    offset,
+                                    active_len,
+                                    buffer_offset,
+                                )
                             } else {
                                 // Some app is using the storage, we must wait.
                                 if app.pending_command == true {
@@ -272,6 +304,7 @@ impl<'a> NonvolatileStorage<'a> {
                                     app.command = command;
                                     app.offset = offset;
                                     app.length = active_len;
+                                    app.buffer_offset = buffer_offset;
                                     ReturnCode::SUCCESS
                                 }
                             }
@@ -316,6 +349,50 @@ impl<'a> NonvolatileStorage<'a> {
         }
     }
 
+    // Start a command for an app. Writes copy the app's data into the
+    // internal buffer first, so the app may reuse its buffer for another
+    // command once this one has started.
+    fn userspace_start(
+        &self,
+        app: &mut App,
+        appid: AppId,
+        command: NonvolatileCommand,
+        offset: usize,
+        length: usize,
+        buffer_offset: usize,
+    ) -> ReturnCode {
+        // The app may have allowed a different buffer since the command was
+        // queued.
+        let allow_buf_len = app.allowed_length(command);
+        if buffer_offset >= allow_buf_len {
+            return ReturnCode::ERESERVE;
+        }
+        let length = cmp::min(length, allow_buf_len - buffer_offset);
+
+        self.current_user.set(NonvolatileUser::App { app_id: appid });
+
+        // Need to copy bytes if this is a write!
+        if command == NonvolatileCommand::UserspaceWrite {
+            app.buffer_write.as_ref().map(|app_buffer| {
+                self.buffer.map(|kernel_buffer| {
+                    // Check that the internal buffer and the buffer that was
+                    // allowed are long enough.
+                    let write_len = cmp::min(length, kernel_buffer.len());
+
+                    let d = &app_buffer.as_ref()[buffer_offset..buffer_offset + write_len];
+                    kernel_buffer[0..write_len].copy_from_slice(d);
+                });
+            });
+        }
+        app.active_buffer_offset = buffer_offset;
+
+        let result = self.userspace_call_driver(command, offset, length);
+        if result != ReturnCode::SUCCESS {
+            self.current_user.clear();
+        }
+        result
+    }
+
     fn userspace_call_driver(
         &self,
         command: NonvolatileCommand,
@@ -371,11 +448,21 @@ impl<'a> NonvolatileStorage<'a> {
                 let started_command = cntr.enter(|app, _| {
                     if app.pending_command {
                         app.pending_command = false;
-                        self.current_user.set(NonvolatileUser::App {
-                            app_id: app.appid(),
-                        });
-                        self.userspace_call_driver(app.command, app.offset, app.length)
-                            == ReturnCode::SUCCESS
+                        let (appid, command, offset) = (app.appid(), app.command, app.offset);
+                        let (length, buffer_offset) = (app.length, app.buffer_offset);
+                        let result =
+                            self.userspace_start(app, appid, command, offset, length, buffer_offset);
+                        if result == ReturnCode::SUCCESS {
+                            true
+                        } else {
+                            // Tell the app rather than leave it waiting.
+                            let callback = match command {
+                                NonvolatileCommand::UserspaceRead => app.callback_read,
+                                _ => app.callback_write,
+                            };
+                            callback.map(|mut cb| cb.schedule(usize::from(result), 0, 0));
+                            false
+                        }
                     } else {
                         false
                     }
@@ -402,12 +489,12 @@ impl hil::nonvolatile_storage::NonvolatileStorageClient<'static> for Nonvolatile
                 NonvolatileUser::App { app_id } => {
                     let _ = self.apps.enter(app_id, move |app, _| {
                         // Need to copy in the contents of the buffer
+                        let buffer_offset = app.active_buffer_offset;
                         app.buffer_read.as_mut().map(|app_buffer| {
-                            let read_len = cmp::min(app_buffer.len(), length);
-
-                            let d = &mut app_buffer.as_mut()[0..(read_len as usize)];
-                            for (i, c) in buffer[0..read_len].iter().enumerate() {
-                                d[i] = *c;
+                            // The app may have allowed a shorter buffer since.
+                            if let Some(d) = app_buffer.as_mut().get_mut(buffer_offset..) {
+                                let read_len = cmp::min(d.len(), length);
+                                d[0..read_len].copy_from_slice(&buffer[0..read_len]);
                             }
                         });
 
@@ -457,12 +544,12 @@ impl hil::nonvolatile_storage::NonvolatileStorage<'static> for NonvolatileStorag
 
     fn read(&self, buffer: &'static mut [u8], address: usize, length: usize) -> ReturnCode {
         self.kernel_buffer.replace(buffer);
-        self.enqueue_command(NonvolatileCommand::KernelRead, address, length, None)
+        self.enqueue_command(NonvolatileCommand::KernelRead, address, length, 0, None)
     }
 
     fn write(&self, buffer: &'static mut [u8], address: usize, length: usize) -> ReturnCode {
         self.kernel_buffer.replace(buffer);
-        self.enqueue_command(NonvolatileCommand::KernelWrite, address, length, None)
+        self.enqueue_command(NonvolatileCommand::KernelWrite, address, length, 0, None)
     }
 }
 
@@ -526,7 +613,16 @@ impl Driver for NonvolatileStorage<'_> {
     /// - `1`: Return the number of bytes available to userspace.
     /// - `2`: Start a read from the nonvolatile storage.
     /// - `3`: Start a write to the nonvolatile_storage.
-    fn command(&self, arg0: usize, arg1: usize, _: usize, appid: AppId) -> ReturnCode {
+    /// - `4`: Return the most bytes a single read or write transfers.
+    /// - `5`: Let the app read the userspace region directly, and return the
+    ///   address it starts at. Fails with ENOSUPPORT if the board has not
+    ///   mapped it into memory, or ENOMEM if the MPU has no room for it.
+    ///
+    /// Reads and writes take the length in the upper 24 bits of the first
+    /// argument, the storage offset as the second and the offset into the
+    /// allowed buffer as the third. Each app may have one read or write
+    /// running and one more queued behind it.
+    fn command(&self, arg0: usize, arg1: usize, arg2: usize, appid: AppId) -> ReturnCode {
         let command_num = arg0 & 0xFF;
 
         match command_num {
@@ -549,6 +645,7 @@ impl Driver for NonvolatileStorage<'_> {
                     NonvolatileCommand::UserspaceRead,
                     offset,
                     length,
+                    arg2,
                     Some(appid),
                 )
             }
@@ -561,10 +658,37 @@ impl Driver for NonvolatileStorage<'_> {
                     NonvolatileCommand::UserspaceWrite,
                     offset,
                     length,
+                    arg2,
                     Some(appid),
                 )
             }
 
+            // Largest single read or write.
+            4 => ReturnCode::SuccessWithValue {
+                value: self.buffer_length,
+            },
+
+            // Map the userspace region.
+            5 => self.mapping.map_or(ReturnCode::ENOSUPPORT, |region| {
+                // The address is returned as a positive value.
+                if region.start() == 0 || region.start() > isize::MAX as usize {
+                    return ReturnCode::ENOSUPPORT;
+                }
+                self.apps
+                    .enter(appid, |app, _| {
+                        if !app.mapped {
+                            if !region.expose_to(appid) {
+                                return ReturnCode::ENOMEM;
+                            }
+                            app.mapped = true;
+                        }
+                        ReturnCode::SuccessWithValue {
+                            value: region.start(),
+                        }
+                    })
+                    .unwrap_or_else(|err| err.into())
+            }),
+
             _ => ReturnCode::ENOSUPPORT,
         }
     }
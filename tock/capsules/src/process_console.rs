@@ -5,10 +5,11 @@
 //! --------
 //!
 //! This module provides a simple text-based console to inspect and control
-//! which processes are running. The console has five commands:
+//! which processes are running. The console has seven commands:
 //!  - 'help' prints the available commands and arguments
 //!  - 'status' prints the current system status
 //!  - 'list' lists the current processes with their IDs and running state
+//!  - 'memory' lists the RAM each process requested and was allocated
 //!  - 'stop n' stops the process with name n
 //!  - 'start n' starts the stopped process with name n
 //!  - 'fault n' forces the process with name n into a fault state
@@ -29,6 +30,17 @@
 //! - `Grants`: The number of grants that have been initialized for the process
 //!   out of the total number of grants defined by the kernel.
 //!
+//! ### `memory` Command Fields:
+//!
+//! - `Requested`: The RAM the process needs, in bytes: the minimum RAM size in
+//!   its TBF header plus the kernel's initial per-process state.
+//! - `Allocated`: The RAM the kernel set aside for the process. It exceeds
+//!   `Requested` where the MPU could not cover the process memory exactly.
+//! - `Padding`: RAM left unused before the process to align its memory for
+//!   the MPU (or to place it at its fixed address).
+//!
+//! The last line sums the columns over all processes.
+//!
 //! Setup
 //! -----
 //!
@@ -210,7 +222,7 @@ impl<'a, C: ProcessManagementCapability> ProcessConsole<'a, C> {
                         let clean_str = s.trim();
                         if clean_str.starts_with("help") {
                             debug!("Welcome to the process console.");
-                            debug!("Valid commands are: help status list stop start fault");
+                            debug!("Valid commands are: help status list memory stop start fault");
                         } else if clean_str.starts_with("start") {
                             let argument = clean_str.split_whitespace().nth(1);
                             argument.map(|name| {
@@ -276,6 +288,36 @@ impl<'a, C: ProcessManagementCapability> ProcessConsole<'a, C> {
                                         grants_total
                                     );
                                 });
+                        } else if clean_str.starts_with("memory") {
+                            debug!(" PID    Name                Requested  Allocated  Padding");
+                            let total = Cell::new((0, 0, 0));
+                            self.kernel
+                                .process_each_capability(&self.capability, |proc| {
+                                    let requested = proc.debug_memory_requested();
+                                    let allocated =
+                                        proc.mem_end() as usize - proc.mem_start() as usize;
+                                    let padding = proc.debug_memory_padding();
+                                    let (t_requested, t_allocated, t_padding) = total.get();
+                                    total.set((
+                                        t_requested + requested,
+                                        t_allocated + allocated,
+                                        t_padding + padding,
+                                    ));
+
+                                    debug!(
+                                        "  {:?}\t{:<20}{:9}{:11}{:9}",
+                                        proc.appid(),
+                                        proc.get_process_name(),
+                                        requested,
+                                        allocated,
+                                        padding
+                                    );
+                                });
+                            let (t_requested, t_allocated, t_padding) = total.get();
+                            debug!(
+                                "        {:<20}{:9}{:11}{:9}",
+                                "total", t_requested, t_allocated, t_padding
+                            );
                         } else if clean_str.starts_with("status") {
                             let info: KernelInfo = KernelInfo::new(self.kernel);
                             debug!(
@@ -291,7 +333,7 @@ impl<'a, C: ProcessManagementCapability> ProcessConsole<'a, C> {
                                 info.timeslice_expirations(&self.capability)
                             );
                         } else {
-                            debug!("Valid commands are: help status list stop start fault");
+                            debug!("Valid commands are: help status list memory stop start fault");
                         }
                     }
                     Err(_e) => debug!("Invalid command: {:?}", command),
@@ -0,0 +1,356 @@
+//! Provides userspace with access to PWM channels.
+//!
+//! Each channel is a `PwmPin`. Apps either set a channel's frequency and duty
+//! cycle directly, or share a buffer of duty cycles that the driver applies
+//! one after another, each held for a fixed number of PWM periods. A fade or
+//! waveform then runs without a syscall or callback per step. Only one
+//! sequence runs at a time.
+//!
+//! Duty cycles are given as a fraction of `DUTY_CYCLE_MAX` and scaled to the
+//! hardware's maximum duty cycle.
+//!
+//! The PWM HIL has no period interrupt, so sequence steps are timed with an
+//! alarm at multiples of the PWM period rather than latched by the PWM
+//! hardware at the period boundary. Step times are computed from the start
+//! of the sequence, so they do not drift.
+//!
+//! Usage
+//! -----
+//!
+//! ```rust
+//! # use kernel::static_init;
+//!
+//! let pwm_pins = static_init!(
+//!     [&'static dyn kernel::hil::pwm::PwmPin; 2],
+//!     [virtual_pwm_led0, virtual_pwm_led1]
+//! );
+//! let virtual_alarm_pwm = static_init!(
+//!     capsules::virtual_alarm::VirtualMuxAlarm<'static, nrf5x::rtc::Rtc>,
+//!     capsules::virtual_alarm::VirtualMuxAlarm::new(mux_alarm)
+//! );
+//! let pwm = static_init!(
+//!     capsules::pwm::Pwm<
+//!         'static,
+//!         capsules::virtual_alarm::VirtualMuxAlarm<'static, nrf5x::rtc::Rtc>>,
+//!     capsules::pwm::Pwm::new(
+//!         pwm_pins,
+//!         virtual_alarm_pwm,
+//!         board_kernel.create_grant(&grant_cap))
+//! );
+//! virtual_alarm_pwm.set_alarm_client(pwm);
+//! ```
+
+use core::cmp;
+
+use kernel::common::cells::OptionalCell;
+use kernel::hil;
+use kernel::hil::time::{Frequency, Ticks};
+use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
+
+/// Syscall driver number.
+use crate::driver;
+pub const DRIVER_NUM: usize = driver::NUM::Pwm as usize;
+
+/// Duty cycle userspace uses for 100%.
+pub const DUTY_CYCLE_MAX: usize = 0xFFFF;
+
+#[derive(Default)]
+pub struct App {
+    callback: Option<Callback>, // Called when a sequence has been applied.
+    sequence: Option<AppSlice<Shared, u8>>, // Duty cycles, u16 little endian.
+}
+
+#[derive(Clone, Copy)]
+struct Sequence<T: Ticks> {
+    appid: AppId,
+    channel: usize,
+    frequency_hz: usize,
+    // PWM periods each value is held for.
+    step_periods: usize,
+    repeat: bool,
+    // Index of the next value in the app's buffer.
+    index: usize,
+    // Steps applied since `start`.
+    step: usize,
+    // When the first step (since the last repeat) was applied.
+    start: T,
+}
+
+pub struct Pwm<'a, A: hil::time::Alarm<'a>> {
+    pins: &'a [&'a dyn hil::pwm::PwmPin],
+    // Alarm that times sequence steps.
+    alarm: &'a A,
+    apps: Grant<App>,
+    // The running sequence, if any.
+    sequence: OptionalCell<Sequence<A::Ticks>>,
+}
+
+impl<'a, A: hil::time::Alarm<'a>> Pwm<'a, A> {
+    pub fn new(
+        pins: &'a [&'a dyn hil::pwm::PwmPin],
+        alarm: &'a A,
+        grant: Grant<App>,
+    ) -> Pwm<'a, A> {
+        Pwm {
+            pins: pins,
+            alarm: alarm,
+            apps: grant,
+            sequence: OptionalCell::empty(),
+        }
+    }
+
+    fn duty_cycle(pin: &dyn hil::pwm::PwmPin, duty_cycle: usize) -> usize {
+        let duty_cycle = cmp::min(duty_cycle, DUTY_CYCLE_MAX) as u64;
+        (duty_cycle * pin.get_maximum_duty_cycle() as u64 / DUTY_CYCLE_MAX as u64) as usize
+    }
+
+    fn start(&self, channel: usize, frequency_hz: usize, duty_cycle: usize) -> ReturnCode {
+        match self.pins.get(channel) {
+            Some(pin) => {
+                if frequency_hz == 0 || frequency_hz > pin.get_maximum_frequency_hz() {
+                    return ReturnCode::EINVAL;
+                }
+                pin.start(frequency_hz, Self::duty_cycle(*pin, duty_cycle))
+            }
+            None => ReturnCode::EINVAL,
+        }
+    }
+
+    /// Time from the start of a sequence to the given step.
+    fn step_offset(&self, sequence: &Sequence<A::Ticks>, steps: usize) -> A::Ticks {
+        let ticks = steps as u64
+            * sequence.step_periods as u64
+            * <A::Frequency>::frequency() as u64
+            / sequence.frequency_hz as u64;
+        A::Ticks::from(ticks as u32)
+    }
+
+    /// The value at `sequence.index` in the app's buffer.
+    fn sequence_value(&self, sequence: &Sequence<A::Ticks>) -> Option<usize> {
+        self.apps
+            .enter(sequence.appid, |app, _| {
+                app.sequence.as_ref().and_then(|buffer| {
+                    let offset = sequence.index * 2;
+                    if offset + 2 <= buffer.len() {
+                        let buffer = buffer.as_ref();
+                        Some(buffer[offset] as usize | (buffer[offset + 1] as usize) << 8)
+                    } else {
+                        None
+                    }
+                })
+            })
+            .unwrap_or(None)
+    }
+
+    /// Applies the next value of the running sequence and arms the alarm
+    /// for the one after it. Once the values run out (and the sequence does
+    /// not repeat) the last duty cycle stays on and the app is told.
+    fn sequence_step(&self) {
+        self.sequence.take().map(|mut sequence| {
+            let mut value = self.sequence_value(&sequence);
+            if value.is_none() && sequence.repeat && sequence.index > 0 {
+                sequence.start = sequence
+                    .start
+                    .wrapping_add(self.step_offset(&sequence, sequence.step));
+                sequence.step = 0;
+                sequence.index = 0;
+                value = self.sequence_value(&sequence);
+            }
+
+            match value {
+                Some(duty_cycle) => {
+                    let pin = self.pins[sequence.channel];
+                    pin.start(sequence.frequency_hz, Self::duty_cycle(pin, duty_cycle));
+
+                    let reference = self.step_offset(&sequence, sequence.step);
+                    let next = self.step_offset(&sequence, sequence.step + 1);
+                    self.alarm.set_alarm(
+                        sequence.start.wrapping_add(reference),
+                        next.wrapping_sub(reference),
+                    );
+                    sequence.index += 1;
+                    sequence.step += 1;
+                    self.sequence.set(sequence);
+                }
+                None => {
+                    let _ = self.apps.enter(sequence.appid, |app, _| {
+                        app.callback
+                            .map(|mut cb| cb.schedule(sequence.channel, sequence.index, 0));
+                    });
+                }
+            }
+        });
+    }
+
+    fn start_sequence(
+        &self,
+        appid: AppId,
+        channel: usize,
+        frequency_hz: usize,
+        step_periods: usize,
+        repeat: bool,
+    ) -> ReturnCode {
+        let pin = match self.pins.get(channel) {
+            Some(pin) => pin,
+            None => return ReturnCode::EINVAL,
+        };
+        if frequency_hz == 0 || frequency_hz > pin.get_maximum_frequency_hz() || step_periods == 0
+        {
+            return ReturnCode::EINVAL;
+        }
+        if self.sequence.map_or(false, |sequence| sequence.appid != appid) {
+            return ReturnCode::EBUSY;
+        }
+
+        let sequence = Sequence {
+            appid: appid,
+            channel: channel,
+            frequency_hz: frequency_hz,
+            step_periods: step_periods,
+            repeat: repeat,
+            index: 0,
+            step: 0,
+            start: self.alarm.now(),
+        };
+        if self.step_offset(&sequence, 1).into_u32() == 0 {
+            // Steps shorter than an alarm tick.
+            return ReturnCode::EINVAL;
+        }
+        if self.sequence_value(&sequence).is_none() {
+            return ReturnCode::ESIZE;
+        }
+
+        self.alarm.disarm();
+        self.sequence.set(sequence);
+        self.sequence_step();
+        ReturnCode::SUCCESS
+    }
+
+    fn stop_sequence(&self, appid: AppId, channel: Option<usize>) {
+        let stop = self.sequence.map_or(false, |sequence| {
+            sequence.appid == appid && channel.map_or(true, |channel| channel == sequence.channel)
+        });
+        if stop {
+            self.sequence.clear();
+            self.alarm.disarm();
+        }
+    }
+}
+
+impl<'a, A: hil::time::Alarm<'a>> hil::time::AlarmClient for Pwm<'a, A> {
+    fn alarm(&self) {
+        self.sequence_step();
+    }
+}
+
+/// Provide an interface for userland.
+impl<'a, A: hil::time::Alarm<'a>> Driver for Pwm<'a, A> {
+    /// Share a buffer with the driver.
+    ///
+    /// ### `allow_num`
+    ///
+    /// - `0`: Duty cycle sequence, one u16 (little endian) per step.
+    fn allow(
+        &self,
+        appid: AppId,
+        allow_num: usize,
+        slice: Option<AppSlice<Shared, u8>>,
+    ) -> ReturnCode {
+        match allow_num {
+            0 => self
+                .apps
+                .enter(appid, |app, _| {
+                    app.sequence = slice;
+                    ReturnCode::SUCCESS
+                })
+                .unwrap_or_else(|err| err.into()),
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    /// Setup callbacks.
+    ///
+    /// ### `subscribe_num`
+    ///
+    /// - `0`: Sequence done. Called with the channel and the number of values
+    ///   applied once a sequence that does not repeat has held its last value
+    ///   for its step time.
+    fn subscribe(
+        &self,
+        subscribe_num: usize,
+        callback: Option<Callback>,
+        app_id: AppId,
+    ) -> ReturnCode {
+        match subscribe_num {
+            0 => self
+                .apps
+                .enter(app_id, |app, _| {
+                    app.callback = callback;
+                    ReturnCode::SUCCESS
+                })
+                .unwrap_or_else(|err| err.into()),
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    /// Command interface.
+    ///
+    /// ### `command_num`
+    ///
+    /// - `0`: Return the number of channels.
+    /// - `1`: Start a channel. `arg1` holds the channel in its low 16 bits and
+    ///   the duty cycle (out of `DUTY_CYCLE_MAX`) in its high 16 bits, `arg2`
+    ///   is the frequency in hertz.
+    /// - `2`: Stop channel `arg1`, and any sequence the app runs on it.
+    /// - `3`: Return the maximum frequency of channel `arg1` in hertz.
+    /// - `4`: Start a sequence from the allowed buffer. `arg1` holds the
+    ///   channel in bits 0-7, the repeat flag in bit 8 and the number of PWM
+    ///   periods each value is held for in bits 16-31. `arg2` is the frequency
+    ///   in hertz. Replaces the app's running sequence, and fails with `EBUSY`
+    ///   if another app's sequence is running.
+    /// - `5`: Stop the app's sequence, leaving the channel at its current duty
+    ///   cycle.
+    fn command(&self, command_num: usize, arg1: usize, arg2: usize, appid: AppId) -> ReturnCode {
+        match command_num {
+            0 => ReturnCode::SuccessWithValue {
+                value: self.pins.len(),
+            },
+
+            1 => {
+                let channel = arg1 & 0xFFFF;
+                self.stop_sequence(appid, Some(channel));
+                self.start(channel, arg2, arg1 >> 16)
+            }
+
+            2 => match self.pins.get(arg1) {
+                Some(pin) => {
+                    self.stop_sequence(appid, Some(arg1));
+                    pin.stop()
+                }
+                None => ReturnCode::EINVAL,
+            },
+
+            3 => match self.pins.get(arg1) {
+                Some(pin) => ReturnCode::SuccessWithValue {
+                    value: pin.get_maximum_frequency_hz(),
+                },
+                None => ReturnCode::EINVAL,
+            },
+
+            4 => self.start_sequence(
+                appid,
+                arg1 & 0xFF,
+                arg2,
+                arg1 >> 16,
+                arg1 & (1 << 8) != 0,
+            ),
+
+            5 => {
+                self.stop_sequence(appid, None);
+                ReturnCode::SUCCESS
+            }
+
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+}
@@ -10,8 +10,23 @@
 //! let touch =
 //!     components::touch::TouchComponent::new(board_kernel, ts, Some(ts), Some(screen)).finalize(());
 //! ```
+//!
+//! Multi touch batching
+//! --------------------
+//!
+//! Multi touch events are written to the buffer shared with allow 2, one
+//! 8 byte record per touch, and reported with a single callback per batch.
+//! By default every report from the panel is delivered as soon as it
+//! arrives. With command 11 an app can instead ask to hold events until it
+//! has acknowledged the previous batch with command 10: records that arrive
+//! in between are queued in the grant (up to `MAX_PENDING`) and delivered
+//! together on the acknowledgement. If coalescing is also enabled, a move of
+//! a touch replaces a queued move of the same touch, so an app that
+//! acknowledges once per frame receives one position per finger per frame.
+//! Presses and releases are never merged.
 
 use core::cell::Cell;
+use core::cmp;
 use core::mem;
 use kernel::hil;
 use kernel::hil::screen::ScreenRotation;
@@ -32,12 +47,41 @@ fn touch_status_to_number(status: &TouchStatus) -> usize {
     }
 }
 
+/// Size of one touch record in the multi touch buffer.
+const EVENT_SIZE: usize = 8;
+
+/// Number of touch records held for an app that has not yet acknowledged
+/// its previous batch.
+const MAX_PENDING: usize = 8;
+
+/// Hold multi touch events until the app acknowledges the previous batch.
+const BATCH_HOLD: usize = 1 << 0;
+/// Merge queued moves of the same touch.
+const BATCH_COALESCE: usize = 1 << 1;
+
+fn encode_touch_event(event: &TouchEvent) -> [u8; EVENT_SIZE] {
+    [
+        event.id as u8,
+        touch_status_to_number(&event.status) as u8,
+        (event.x >> 8) as u8,
+        (event.x & 0xFF) as u8,
+        (event.y >> 8) as u8,
+        (event.y & 0xFF) as u8,
+        event.size.unwrap_or(0) as u8,
+        event.pressure.unwrap_or(0) as u8,
+    ]
+}
+
 pub struct App {
     touch_callback: Option<Callback>,
     gesture_callback: Option<Callback>,
     multi_touch_callback: Option<Callback>,
     events_buffer: Option<AppSlice<Shared, u8>>,
     ack: bool,
+    hold: bool,
+    coalesce: bool,
+    pending: [[u8; EVENT_SIZE]; MAX_PENDING],
+    num_pending: usize,
     dropped_events: usize,
     x: u16,
     y: u16,
@@ -52,6 +96,10 @@ impl Default for App {
             multi_touch_callback: None,
             events_buffer: None,
             ack: true,
+            hold: false,
+            coalesce: false,
+            pending: [[0; EVENT_SIZE]; MAX_PENDING],
+            num_pending: 0,
             dropped_events: 0,
             x: 0,
             y: 0,
@@ -60,6 +108,57 @@ impl Default for App {
     }
 }
 
+impl App {
+    /// Queues a touch record for the next batch, merging it with a queued
+    /// move of the same touch if coalescing is enabled.
+    fn queue_touch_event(&mut self, record: [u8; EVENT_SIZE]) {
+        let moved = touch_status_to_number(&TouchStatus::Moved) as u8;
+        if self.coalesce && record[1] == moved {
+            let last = self.pending[..self.num_pending]
+                .iter_mut()
+                .rev()
+                .find(|pending| pending[0] == record[0]);
+            if let Some(pending) = last {
+                if pending[1] == moved {
+                    *pending = record;
+                    return;
+                }
+            }
+        }
+        if self.num_pending < MAX_PENDING {
+            self.pending[self.num_pending] = record;
+            self.num_pending += 1;
+        } else {
+            self.dropped_events += 1;
+        }
+    }
+
+    /// Copies the queued records to the app's buffer and schedules the multi
+    /// touch callback with (number of records, dropped records, records that
+    /// did not fit in the buffer).
+    fn deliver_touch_events(&mut self) {
+        let mut callback = match self.multi_touch_callback {
+            Some(callback) => callback,
+            None => return,
+        };
+        let buffer = match self.events_buffer {
+            Some(ref mut buffer) => buffer,
+            None => return,
+        };
+        let num = cmp::min(buffer.len() / EVENT_SIZE, self.num_pending);
+        for (index, record) in self.pending[..num].iter().enumerate() {
+            let offset = index * EVENT_SIZE;
+            buffer.as_mut()[offset..offset + EVENT_SIZE].copy_from_slice(record);
+        }
+        callback.schedule(num, self.dropped_events, self.num_pending - num);
+        self.num_pending = 0;
+        self.dropped_events = 0;
+        if self.hold {
+            self.ack = false;
+        }
+    }
+}
+
 pub struct Touch<'a> {
     touch: Option<&'a dyn hil::touch::Touch<'a>>,
     multi_touch: Option<&'a dyn hil::touch::MultiTouch<'a>>,
@@ -213,57 +312,20 @@ impl<'a> hil::touch::MultiTouchClient for Touch<'a> {
         // debug!("{} touch(es)", len);
         for app in self.apps.iter() {
             app.enter(|app, _| {
+                if app.multi_touch_callback.is_none() {
+                    return;
+                }
+                for touch_event in touch_events[..len].iter() {
+                    let mut event = touch_event.clone();
+                    self.update_rotation(&mut event);
+                    // debug!(
+                    //     " multitouch {:?} x {} y {} size {:?} pressure {:?}",
+                    //     event.status, event.x, event.y, event.size, event.pressure
+                    // );
+                    app.queue_touch_event(encode_touch_event(&event));
+                }
                 if app.ack {
-                    app.dropped_events = 0;
-                    app.multi_touch_callback.map(|mut callback| {
-                        if let Some(ref mut buffer) = app.events_buffer {
-                            let num = if buffer.len() / 8 < len {
-                                buffer.len() / 8
-                            } else {
-                                len
-                            };
-                            for event_index in 0..num {
-                                let mut event = touch_events[event_index].clone();
-                                self.update_rotation(&mut event);
-                                let event_status = touch_status_to_number(&event.status);
-                                // debug!(
-                                //     " multitouch {:?} x {} y {} size {:?} pressure {:?}",
-                                //     event.status, event.x, event.y, event.size, event.pressure
-                                // );
-                                // one touch entry is 8 bytes long
-                                let offset = event_index * 8;
-                                if buffer.len() > event_index + 8 {
-                                    buffer.as_mut()[offset] = event.id as u8;
-                                    buffer.as_mut()[offset + 1] = event_status as u8;
-                                    buffer.as_mut()[offset + 2] = ((event.x & 0xFFFF) >> 8) as u8;
-                                    buffer.as_mut()[offset + 3] = (event.x & 0xFF) as u8;
-                                    buffer.as_mut()[offset + 4] = ((event.y & 0xFFFF) >> 8) as u8;
-                                    buffer.as_mut()[offset + 5] = (event.y & 0xFF) as u8;
-                                    buffer.as_mut()[offset + 6] = if let Some(size) = event.size {
-                                        size as u8
-                                    } else {
-                                        0
-                                    };
-                                    buffer.as_mut()[offset + 7] =
-                                        if let Some(pressure) = event.pressure {
-                                            pressure as u8
-                                        } else {
-                                            0
-                                        };
-                                } else {
-                                    break;
-                                }
-                            }
-                            callback.schedule(
-                                num,
-                                app.dropped_events,
-                                if num < len { len - num } else { 0 },
-                            );
-                        }
-                    });
-                // app.ack = false;
-                } else {
-                    app.dropped_events = app.dropped_events + 1;
+                    app.deliver_touch_events();
                 }
             });
         }
@@ -353,6 +415,9 @@ impl<'a> Driver for Touch<'a> {
                     self.apps
                         .enter(app_id, |app, _| {
                             app.multi_touch_callback = callback;
+                            app.ack = true;
+                            app.num_pending = 0;
+                            app.dropped_events = 0;
                             self.multi_touch_enable()
                         })
                         .unwrap_or_else(|err| err.into())
@@ -367,9 +432,9 @@ impl<'a> Driver for Touch<'a> {
     fn command(
         &self,
         command_num: usize,
-        _data1: usize,
+        data1: usize,
         _data2: usize,
-        _appid: AppId,
+        appid: AppId,
     ) -> ReturnCode {
         match command_num {
             0 =>
@@ -378,6 +443,39 @@ impl<'a> Driver for Touch<'a> {
                 ReturnCode::SUCCESS
             }
 
+            // acknowledge the last multi touch batch; delivers the
+            // events queued since then, if any
+            10 => self
+                .apps
+                .enter(appid, |app, _| {
+                    app.ack = true;
+                    if app.num_pending > 0 {
+                        app.deliver_touch_events();
+                    }
+                    ReturnCode::SUCCESS
+                })
+                .unwrap_or_else(|err| err.into()),
+
+            // configure multi touch batching
+            // data1: bit 0 holds events until acknowledged (command 10),
+            //        bit 1 merges queued moves of the same touch
+            11 => {
+                if self.multi_touch.is_some() {
+                    self.apps
+                        .enter(appid, |app, _| {
+                            app.hold = data1 & BATCH_HOLD != 0;
+                            app.coalesce = data1 & BATCH_COALESCE != 0;
+                            if !app.hold {
+                                app.ack = true;
+                            }
+                            ReturnCode::SUCCESS
+                        })
+                        .unwrap_or_else(|err| err.into())
+                } else {
+                    ReturnCode::ENOSUPPORT
+                }
+            }
+
             // number of touches
             100 => {
                 let num_touches = if let Some(multi_touch) = self.multi_touch {
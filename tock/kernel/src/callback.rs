@@ -151,6 +151,13 @@ impl AppId {
             (start, end)
         })
     }
+
+    /// Returns the name of the process, as given in its TBF header, or an
+    /// empty string if the process no longer exists.
+    pub fn get_process_name(&self) -> &'static str {
+        self.kernel
+            .process_map_or("", *self, |process| process.get_process_name())
+    }
 }
 
 /// Type to uniquely identify a callback subscription across all drivers.
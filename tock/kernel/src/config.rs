@@ -40,6 +40,14 @@ pub(crate) struct Config {
     /// into which SRAM addresses. This can be useful to debug whether the kernel could
     /// successfully load processes, and whether the allocated SRAM is as expected.
     pub(crate) debug_load_processes: bool,
+
+    /// Whether processes may execute code from their own RAM.
+    ///
+    /// By default the MPU marks process memory as non-executable. Enabling this lets apps run
+    /// functions that crt0 copied from flash into RAM (libtock's `TOCK_RAMFUNC`), which avoids
+    /// instruction fetch latency on boards that execute in place from external flash, at the cost
+    /// of no longer enforcing W^X for process memory.
+    pub(crate) executable_app_memory: bool,
 }
 
 /// A unique instance of `Config` where compile-time configuration options are defined. These
@@ -47,4 +55,5 @@ pub(crate) struct Config {
 pub(crate) const CONFIG: Config = Config {
     trace_syscalls: false,
     debug_load_processes: false,
+    executable_app_memory: false,
 };
@@ -113,7 +113,7 @@ mod tbfheader;
 pub use crate::callback::{AppId, Callback};
 pub use crate::driver::Driver;
 pub use crate::grant::Grant;
-pub use crate::mem::{AppSlice, Private, Shared};
+pub use crate::mem::{AppSlice, Private, ReadOnlyRegion, Shared};
 pub use crate::platform::scheduler_timer::{SchedulerTimer, VirtualSchedulerTimer};
 pub use crate::platform::watchdog;
 pub use crate::platform::{mpu, Chip, InterruptService, Platform};
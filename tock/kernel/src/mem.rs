@@ -6,6 +6,7 @@ use core::slice;
 
 use crate::callback::AppId;
 use crate::capabilities;
+use crate::platform::mpu;
 
 /// Type for specifying an AppSlice is hidden from the kernel.
 #[derive(Debug)]
@@ -96,7 +97,12 @@ impl<L, T> AppSlice<L, T> {
                 .kernel
                 .process_map_or(false, appid, |process| {
                     process
-                        .add_mpu_region(self.ptr() as *const u8, self.len(), self.len())
+                        .add_mpu_region(
+                            self.ptr() as *const u8,
+                            self.len(),
+                            self.len(),
+                            mpu::Permissions::ReadWriteOnly,
+                        )
                         .is_some()
                 })
         } else {
@@ -200,3 +206,53 @@ impl<L, T> AsMut<[T]> for AppSlice<L, T> {
             })
     }
 }
+
+/// Memory outside of any process that apps may be allowed to read, such as
+/// memory-mapped storage that a capsule serves.
+///
+/// Creating one takes a capability, since a capsule holding it can open the
+/// memory to any app.
+#[derive(Clone, Copy)]
+pub struct ReadOnlyRegion {
+    start: usize,
+    len: usize,
+}
+
+impl ReadOnlyRegion {
+    pub fn new(
+        start: usize,
+        len: usize,
+        _capability: &dyn capabilities::MemoryAllocationCapability,
+    ) -> ReadOnlyRegion {
+        ReadOnlyRegion {
+            start: start,
+            len: len,
+        }
+    }
+
+    /// Address of the first byte of the region.
+    pub fn start(&self) -> usize {
+        self.start
+    }
+
+    /// Number of bytes in the region.
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Let `appid` read (but not write or execute) the region until it
+    /// restarts. Returns false if the process has no MPU region left that can
+    /// cover it.
+    pub fn expose_to(&self, appid: AppId) -> bool {
+        appid.kernel.process_map_or(false, appid, |process| {
+            process
+                .add_mpu_region(
+                    self.start as *const u8,
+                    self.len,
+                    self.len,
+                    mpu::Permissions::ReadOnly,
+                )
+                .is_some()
+        })
+    }
+}
@@ -239,6 +239,12 @@ pub fn load_processes<C: Chip>(
                         process.mem_end() as usize - 1,
                         process.get_process_name()
                     );
+                    debug!(
+                        "  requested {} bytes of sram, allocated {}, {} skipped for alignment",
+                        process.debug_memory_requested(),
+                        process.mem_end() as usize - process.mem_start() as usize,
+                        process.debug_memory_padding()
+                    );
                 }
 
                 // Save the reference to this process in the processes array.
@@ -409,7 +415,7 @@ pub trait ProcessType {
 
     /// Allocate a new MPU region for the process that is at least
     /// `min_region_size` bytes and lies within the specified stretch of
-    /// unallocated memory.
+    /// unallocated memory, with the given user mode access permissions.
     ///
     /// It is not valid to call this function when the process is inactive (i.e.
     /// the process will not run again).
@@ -418,6 +424,7 @@ pub trait ProcessType {
         unallocated_memory_start: *const u8,
         unallocated_memory_size: usize,
         min_region_size: usize,
+        permissions: mpu::Permissions,
     ) -> Option<mpu::Region>;
 
     // grants
@@ -492,6 +499,15 @@ pub trait ProcessType {
     /// Increment the number of times the process called a syscall and record
     /// the last syscall that was called.
     fn debug_syscall_called(&self, last_syscall: Syscall);
+
+    /// Returns how many bytes of RAM the process needed: its minimum RAM size
+    /// plus the kernel's initial per-process state. The process was allocated
+    /// `mem_end() - mem_start()` bytes.
+    fn debug_memory_requested(&self) -> usize;
+
+    /// Returns how many bytes of RAM before the process's memory were left
+    /// unused to meet its alignment (or its fixed address).
+    fn debug_memory_padding(&self) -> usize;
 }
 
 /// Generic trait for implementing process restart policies.
@@ -771,6 +787,13 @@ struct ProcessDebug {
     /// How many times this process has been paused because it exceeded its
     /// timeslice.
     timeslice_expiration_count: usize,
+
+    /// How much RAM the process needed when it was loaded.
+    memory_requested: usize,
+
+    /// How much RAM was skipped before the process's memory when it was
+    /// loaded.
+    memory_padding: usize,
 }
 
 /// A type for userspace processes in Tock.
@@ -1076,13 +1099,14 @@ impl<C: Chip> ProcessType for Process<'_, C> {
         unallocated_memory_start: *const u8,
         unallocated_memory_size: usize,
         min_region_size: usize,
+        permissions: mpu::Permissions,
     ) -> Option<mpu::Region> {
         self.mpu_config.and_then(|mut config| {
             let new_region = self.chip.mpu().allocate_region(
                 unallocated_memory_start,
                 unallocated_memory_size,
                 min_region_size,
-                mpu::Permissions::ReadWriteOnly,
+                permissions,
                 &mut config,
             );
 
@@ -1127,7 +1151,7 @@ impl<C: Chip> ProcessType for Process<'_, C> {
                 } else if let Err(_) = self.chip.mpu().update_app_memory_region(
                     new_break,
                     self.kernel_memory_break.get(),
-                    mpu::Permissions::ReadWriteOnly,
+                    Self::APP_MEMORY_PERMISSIONS,
                     &mut config,
                 ) {
                     Err(Error::OutOfMemory)
@@ -1207,7 +1231,7 @@ impl<C: Chip> ProcessType for Process<'_, C> {
             } else if let Err(_) = self.chip.mpu().update_app_memory_region(
                 self.app_break.get(),
                 new_break,
-                mpu::Permissions::ReadWriteOnly,
+                Self::APP_MEMORY_PERMISSIONS,
                 &mut config,
             ) {
                 None
@@ -1380,6 +1404,14 @@ impl<C: Chip> ProcessType for Process<'_, C> {
         });
     }
 
+    fn debug_memory_requested(&self) -> usize {
+        self.debug.map_or(0, |debug| debug.memory_requested)
+    }
+
+    fn debug_memory_padding(&self) -> usize {
+        self.debug.map_or(0, |debug| debug.memory_padding)
+    }
+
     unsafe fn print_memory_map(&self, writer: &mut dyn Write) {
         // Flash
         let flash_end = self.flash.as_ptr().add(self.flash.len()) as usize;
@@ -1413,18 +1445,24 @@ impl<C: Chip> ProcessType for Process<'_, C> {
         let last_syscall = self.debug.map(|debug| debug.last_syscall);
         let dropped_callback_count = self.debug.map_or(0, |debug| debug.dropped_callback_count);
         let restart_count = self.restart_count.get();
+        let memory_requested = self.debug_memory_requested();
+        let memory_padding = self.debug_memory_padding();
 
         let _ = writer.write_fmt(format_args!(
             "\
              App: {}   -   [{:?}]\
              \r\n Events Queued: {}   Syscall Count: {}   Dropped Callback Count: {}\
-             \r\n Restart Count: {}\r\n",
+             \r\n Restart Count: {}\
+             \r\n RAM Requested: {}   Allocated: {}   Alignment Padding: {}\r\n",
             self.process_name,
             self.state.get(),
             events_queued,
             syscall_count,
             dropped_callback_count,
             restart_count,
+            memory_requested,
+            self.memory.len(),
+            memory_padding,
         ));
 
         let _ = match last_syscall {
@@ -1604,6 +1642,14 @@ impl<C: 'static + Chip> Process<'_, C> {
     // Memory offset to make room for this process's metadata.
     const PROCESS_STRUCT_OFFSET: usize = mem::size_of::<Process<C>>();
 
+    // MPU permissions for the process-accessible part of app memory. See
+    // `Config::executable_app_memory`.
+    const APP_MEMORY_PERMISSIONS: mpu::Permissions = if config::CONFIG.executable_app_memory {
+        mpu::Permissions::ReadWriteExecute
+    } else {
+        mpu::Permissions::ReadWriteOnly
+    };
+
     pub(crate) unsafe fn create(
         kernel: &'static Kernel,
         chip: &'static C,
@@ -1720,6 +1766,9 @@ impl<C: 'static + Chip> Process<'_, C> {
         // Minimum memory size for the process.
         let min_total_memory_size = min_app_ram_size + initial_kernel_memory_size;
 
+        // Memory skipped before the process's memory (see `memory_padding`).
+        let unallocated_memory_start = remaining_memory.as_ptr() as usize;
+
         // Check if this process requires a fixed memory start address. If so,
         // try to adjust the memory region to work for this process.
         //
@@ -1773,7 +1822,7 @@ impl<C: 'static + Chip> Process<'_, C> {
             min_total_memory_size,
             Self::INITIAL_APP_MEMORY_SIZE,
             initial_kernel_memory_size,
-            mpu::Permissions::ReadWriteOnly,
+            Self::APP_MEMORY_PERMISSIONS,
             &mut mpu_config,
         ) {
             Some((memory_start, memory_size)) => (memory_start, memory_size),
@@ -1939,6 +1988,8 @@ impl<C: 'static + Chip> Process<'_, C> {
             last_syscall: None,
             dropped_callback_count: 0,
             timeslice_expiration_count: 0,
+            memory_requested: min_total_memory_size,
+            memory_padding: app_memory_start as usize - unallocated_memory_start,
         });
 
         let flash_protected_size = process.header.get_protected_size() as usize;
@@ -2110,13 +2161,17 @@ impl<C: 'static + Chip> Process<'_, C> {
                 self.memory.len(), //we want exactly as much as we had before restart
                 Self::INITIAL_APP_MEMORY_SIZE,
                 initial_kernel_memory_size,
-                mpu::Permissions::ReadWriteOnly,
+                Self::APP_MEMORY_PERMISSIONS,
                 &mut mpu_config,
             )
             .is_some();
 
-        // Drop the old config and use the clean one
+        // Drop the old config and use the clean one, along with the regions
+        // added to it.
         self.mpu_config.replace(mpu_config);
+        for region in self.mpu_regions.iter() {
+            region.set(None);
+        }
 
         match (app_mpu_flash_success, app_mpu_mem_success) {
             (true, true) => {}